@@ -108,6 +108,10 @@ int transientPeriods = 0;
 // Enable one of the algorithm of multicast relaying; turnoff if it is zero
 int multicastRelaying = 0;
 
+// Fragmentation session sent to the multicast groups; turnoff if nbFrag is zero
+int nbFrag = 0; // Number of data fragments of the image
+int nbParity = 0; // Number of parity fragments sent after the data fragments
+
 // Output control
 bool print = true;  // whether to print other informations such as buildings placed in the simulation, enddevices and gateways locations
 bool append = false; // append the new simulation file to existing file
@@ -172,6 +176,12 @@ int main (int argc, char *argv[])
   cmd.AddValue ("multicastRelaying",
                 "Enable one of the algorithm of multicast relaying; turnoff if it is zero. (Warning: this is part of the modified protocol which does not exist in the LoRaWAN Specification)",
                  multicastRelaying);
+  cmd.AddValue ("nbFrag",
+                "Number of data fragments of the image sent to the multicast groups; turnoff if it is zero",
+                nbFrag);
+  cmd.AddValue ("nbParity",
+                "Number of parity fragments sent after the data fragments of the image",
+                nbParity);
   
   
   //Also add argument of class B paramters
@@ -554,6 +564,11 @@ int main (int argc, char *argv[])
   //Uncomment bellow for Enable Fragmented data reception 
   //appHelper.EnableFragmentedDataReception (0);
   
+  if (nbFrag > 0)
+    {
+      appHelper.EnableFragmentationSession (nbFrag, nbParity);
+    }
+  
   ApplicationContainer appContainer = appHelper.Install (endDevices);
   NS_LOG_DEBUG ("Installed!");
   appContainer.Start (Seconds (0));
@@ -587,6 +602,10 @@ int main (int argc, char *argv[])
   //Enable Fragmented Data Generation 
   //nsHelper.EnableSequencedPacketGeneration (true);
   
+  //Send the image in a fragmentation session, the time to complete it is 
+  //reported by the analyzer
+  nsHelper.EnableFragmentationSession (nbFrag, nbParity);
+  
   // Create a NS for the network
   nsHelper.SetEndDevices (endDevices);
   nsHelper.SetGateways (gateways);
@@ -3,6 +3,10 @@
  * with a single gateway. It allows for formation of multicast groups based on
  * the number of multicast groups and number of end-devices.
  *
+ * Class A devices sending confirmed uplinks can be added next to the class B
+ * ones, in which case the network server shares the gateways between the
+ * class A replies, the beacons and the ping slot downlinks.
+ *
  * Note that this just test the basic functionalites.
  */ 
 
@@ -22,6 +26,7 @@
 #include "ns3/double.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/end-device-class-b-app-helper.h"
+#include "ns3/periodic-sender-helper.h"
 #include "ns3/command-line.h"
 #include "ns3/network-server-helper.h"
 #include "ns3/correlated-shadowing-propagation-loss-model.h"
@@ -43,6 +48,8 @@ NS_LOG_COMPONENT_DEFINE ("ClassBLorawanNetworkExample");
 int nMcDevices = 6;//6;//20;
 int nMcDevicesPerGroup = 6;//3;//2;
 
+int nClassADevices = 0; // Number of class A devices sending confirmed uplinks next to the class B devices
+
 bool mixOfDrs = false; //Whether to have mixed Dr in simulation for different multicast groups
 
 int dr = 3; //Dr to be used for all the multicast groups created, if mixOfDrs = false
@@ -106,6 +113,9 @@ int main (int argc, char *argv[])
   cmd.AddValue ("nMcDevicesPerGroup",
                 "Number of multicast end devices per multicast group",
                 nMcDevicesPerGroup);  
+  cmd.AddValue ("nClassADevices",
+                "Number of class A end devices, sending confirmed uplinks every appPeriod, to include in the simulation",
+                nClassADevices);
   cmd.AddValue ("mixOfDrs",
                 "Whether to have mixed Dr in simulation for different multicast groups, default = false",
                 mixOfDrs);
@@ -274,6 +284,15 @@ int main (int argc, char *argv[])
       endDevices.Add (mcTotalEndDevices);    
     }  
 
+  // Class A devices that share the gateways with the class B devices
+  NodeContainer classADevices;
+  
+  if (nClassADevices > 0)
+    {
+      classADevices.Create (nClassADevices);
+      endDevices.Add (classADevices);
+    }
+
 //  // Uncomment this if the manual multicast group creation is uncommented
 //  endDevices.Add (mcEndDevices);
 //  endDevices.Add (mcEndDevices2);
@@ -307,6 +326,14 @@ int main (int argc, char *argv[])
 
   // Now end devices are connected to the channel
 
+  // The class A devices ask for a reply to each of their uplinks
+  for (NodeContainer::Iterator j = classADevices.Begin ();
+       j != classADevices.End (); ++j)
+    {
+      Ptr<LoraNetDevice> loraNetDevice = (*j)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      loraNetDevice->GetMac ()->GetObject<EndDeviceLoraMac> ()->SetMType (LoraMacHeader::CONFIRMED_DATA_UP);
+    }
+
   // Connect trace sources
   for (NodeContainer::Iterator j = endDevices.Begin ();
        j != endDevices.End (); ++j)
@@ -466,11 +493,18 @@ int main (int argc, char *argv[])
   //Uncomment bellow for Enable Fragmented data reception 
   //appHelper.EnableFragmentedDataReception (0);
   
-  ApplicationContainer appContainer = appHelper.Install (endDevices);
+  ApplicationContainer appContainer = appHelper.Install (mcTotalEndDevices);
   NS_LOG_DEBUG ("Installed!");
   appContainer.Start (Seconds (0));
   appContainer.Stop (appStopTime);
   
+  //class A App
+  PeriodicSenderHelper classAAppHelper = PeriodicSenderHelper ();
+  classAAppHelper.SetPeriod (Seconds (appPeriodSeconds));
+  ApplicationContainer classAAppContainer = classAAppHelper.Install (classADevices);
+  classAAppContainer.Start (Seconds (0));
+  classAAppContainer.Stop (appStopTime);
+  
   
   NS_LOG_DEBUG ("Completed Installing Class B application on the end device");
     
@@ -550,7 +584,7 @@ int main (int argc, char *argv[])
   // maxRunLength-<groupIndex>-<dr>-<ping-slot periodicty>-<numberofnodes>-<filePostFix>.csv,
   // avgRunLength-<groupIndex>-<dr>-<ping-slot periodicty>-<numberofnodes>-<filePostFix>.csv
   std::string verboseLocation = "ClassBResults/Basic/";
-  LoraClassBAnalyzer classBAnalyzer(outputFileNameNs, outputFileNameEd, verboseLocation, append, endDevices, gateways, networkServer); 
+  LoraClassBAnalyzer classBAnalyzer(outputFileNameNs, outputFileNameEd, verboseLocation, append, mcTotalEndDevices, gateways, networkServer); 
   
   /**********************
    * Print output files *
@@ -579,6 +613,7 @@ int main (int argc, char *argv[])
   //helper.PrintPerformance (transientPeriods * appPeriod, appStopTime);
   std::ostringstream simulationSetup;
   simulationSetup << "Number of unicast devices = " << 0 << std::endl
+                  << "Number of class A devices = " << nClassADevices << std::endl
                   << "Number of multicast devices = " << nMcDevices << std::endl 
                   << "Number of multicast groups = " << std::ceil ((double)nMcDevices/nMcDevicesPerGroup) << std::endl
                   << "Dr used if all multicast groups have same = " << dr << std::endl 
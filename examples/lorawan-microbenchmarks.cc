@@ -0,0 +1,404 @@
+/*
+ * This script times the kernels of the lorawan module that sit on the hot
+ * paths of large simulations, in isolation from the rest of the simulator:
+ *   - LoraInterferenceHelper::IsDestroyedByInterference, for a growing number
+ *     of events in the interference list,
+ *   - LoraPhy::GetOnAirTime,
+ *   - NetworkScheduler::GetPingOffset, which runs one AES encryption,
+ *   - EndDeviceStatus::InsertReceivedPacket, for a growing number of packets
+ *     already received from the device,
+ *   - the serialization and deserialization of LoraFrameHeader,
+ *   - reading the MAC and frame headers of a packet, from a copy with
+ *     RemoveHeader as the hot paths used to do and with LoraHeaderView,
+ *   - writing and reading the SequenceHeader of a sequenced ping downlink,
+ *   - reading the LoraTag of a packet, by removing and adding it back as the
+ *     hot paths used to do and by peeking at it,
+ *   - CorrelatedShadowingPropagationLossModel::DoCalcRxPower, through
+ *     CalcRxPower, with a growing number of receiver positions.
+ *
+ * For every benchmark one CSV line is written with the number of operations,
+ * the wall time in ns per operation and the heap allocations per operation.
+ * Allocations are counted by replacing the global operator new of this
+ * program, hence they include the allocations made inside the ns-3 libraries.
+ *
+ * Example:
+ *   ./waf --run "lorawan-microbenchmarks --iterations=100000"
+ */
+
+#include "ns3/log.h"
+#include "ns3/command-line.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/lora-interference-helper.h"
+#include "ns3/lora-phy.h"
+#include "ns3/lora-tag.h"
+#include "ns3/lora-mac-header.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lora-header-view.h"
+#include "ns3/sequence-header.h"
+#include "ns3/network-scheduler.h"
+#include "ns3/end-device-status.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/rng-seed-manager.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("LorawanMicrobenchmarks");
+
+// Number of heap allocations made by the process so far
+static uint64_t allocations = 0;
+
+void*
+operator new (std::size_t size)
+{
+  allocations++;
+  void* pointer = std::malloc (size == 0 ? 1 : size);
+  if (pointer == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return pointer;
+}
+
+void*
+operator new[] (std::size_t size)
+{
+  return operator new (size);
+}
+
+void
+operator delete (void* pointer) noexcept
+{
+  std::free (pointer);
+}
+
+void
+operator delete[] (void* pointer) noexcept
+{
+  std::free (pointer);
+}
+
+void
+operator delete (void* pointer, std::size_t size) noexcept
+{
+  std::free (pointer);
+}
+
+void
+operator delete[] (void* pointer, std::size_t size) noexcept
+{
+  std::free (pointer);
+}
+
+// Settings
+uint32_t iterations = 100000;
+
+// Keeps the results of the kernels alive, so that they are not optimized out
+double sink = 0;
+
+/**
+ * Time a kernel and write its CSV line
+ *
+ * \param name the name of the benchmark
+ * \param parameter the size parameter of the benchmark, 0 if none
+ * \param n the number of calls of the kernel
+ * \param kernel the kernel, called with the index of the call
+ */
+template <typename Kernel>
+void
+Benchmark (std::string name, uint32_t parameter, uint32_t n, Kernel kernel)
+{
+  // Warm up the caches and the lazily initialized state
+  for (uint32_t i = 0; i < std::min<uint32_t> (n, 100); i++)
+    {
+      kernel (i);
+    }
+
+  uint64_t allocationsBefore = allocations;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      kernel (i);
+    }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+  uint64_t allocationsAfter = allocations;
+
+  double nanoseconds = std::chrono::duration<double, std::nano> (end - start).count ();
+  std::cout << name << ","
+            << parameter << ","
+            << n << ","
+            << nanoseconds / n << ","
+            << double (allocationsAfter - allocationsBefore) / n << std::endl;
+}
+
+void
+BenchmarkInterference (void)
+{
+  uint32_t eventCounts[] = {1, 10, 100, 1000};
+  for (uint32_t eventCount : eventCounts)
+    {
+      LoraInterferenceHelper interferenceHelper;
+      Ptr<LoraInterferenceHelper::Event> event;
+      for (uint32_t i = 0; i < eventCount; i++)
+        {
+          // Half of the interferers on the same frequency, with mixed SFs
+          event = interferenceHelper.Add (Seconds (1), -100 - (i % 20),
+                                          7 + i % 6, 0, i % 2 ? 868.1 : 868.3);
+        }
+      event = interferenceHelper.Add (Seconds (1), -90, 7, 0, 868.1);
+
+      Benchmark ("IsDestroyedByInterference", eventCount, iterations / eventCount + 1,
+                 [&] (uint32_t i) { sink += interferenceHelper.IsDestroyedByInterference (event); });
+    }
+}
+
+void
+BenchmarkOnAirTime (void)
+{
+  Ptr<Packet> packet = Create<Packet> (23);
+  LoraTxParameters txParams;
+  Benchmark ("GetOnAirTime", 0, iterations,
+             [&] (uint32_t i)
+             {
+               txParams.sf = 7 + i % 6;
+               txParams.lowDataRateOptimizationEnabled = txParams.sf > 10;
+               sink += LoraPhy::GetOnAirTime (packet, txParams).GetSeconds ();
+             });
+}
+
+void
+BenchmarkPingOffset (void)
+{
+  Ptr<NetworkScheduler> scheduler = CreateObject<NetworkScheduler> ();
+  Benchmark ("GetPingOffset", 0, iterations,
+             [&] (uint32_t i)
+             {
+               sink += scheduler->GetPingOffset (128 * i, LoraDeviceAddress (i), 32);
+             });
+}
+
+void
+BenchmarkInsertReceivedPacket (void)
+{
+  uint32_t historyLengths[] = {1, 10, 100};
+  for (uint32_t historyLength : historyLengths)
+    {
+      Ptr<EndDeviceStatus> status = CreateObject<EndDeviceStatus> ();
+      Address gwAddress;
+
+      std::vector<Ptr<Packet> > packets;
+      for (uint32_t i = 0; i < historyLength; i++)
+        {
+          Ptr<Packet> packet = Create<Packet> (23);
+
+          LoraFrameHeader frameHdr;
+          frameHdr.SetAsUplink ();
+          frameHdr.SetFCnt (i);
+          packet->AddHeader (frameHdr);
+
+          LoraMacHeader macHdr;
+          macHdr.SetMType (LoraMacHeader::UNCONFIRMED_DATA_UP);
+          packet->AddHeader (macHdr);
+
+          LoraTag tag;
+          tag.SetSpreadingFactor (7);
+          tag.SetFrequency (868.1);
+          tag.SetReceivePower (-110);
+          packet->AddPacketTag (tag);
+
+          status->InsertReceivedPacket (packet, gwAddress);
+          packets.push_back (packet);
+        }
+
+      // The oldest packet received again walks the whole history
+      Ptr<Packet> oldest = packets.front ();
+      Benchmark ("InsertReceivedPacket", historyLength, iterations / historyLength + 1,
+                 [&] (uint32_t i) { status->InsertReceivedPacket (oldest, gwAddress); });
+    }
+}
+
+void
+BenchmarkFrameHeader (void)
+{
+  LoraFrameHeader header;
+  header.SetAsDownlink ();
+  header.SetAddress (LoraDeviceAddress (54, 1864));
+  header.SetFCnt (42);
+  header.SetAck (true);
+  header.AddLinkCheckAns (10, 1);
+
+  Buffer buffer;
+  buffer.AddAtStart (header.GetSerializedSize ());
+
+  Benchmark ("LoraFrameHeaderSerialize", 0, iterations,
+             [&] (uint32_t i) { header.Serialize (buffer.Begin ()); });
+
+  Benchmark ("LoraFrameHeaderDeserialize", 0, iterations,
+             [&] (uint32_t i)
+             {
+               LoraFrameHeader deserialized;
+               deserialized.SetAsDownlink ();
+               sink += deserialized.Deserialize (buffer.Begin ());
+             });
+}
+
+void
+BenchmarkHeaderPeek (void)
+{
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (LoraDeviceAddress (54, 1864));
+  frameHdr.SetFCnt (42);
+  LoraMacHeader macHdr;
+  macHdr.SetMType (LoraMacHeader::UNCONFIRMED_DATA_UP);
+
+  Ptr<Packet> packet = Create<Packet> (23);
+  packet->AddHeader (frameHdr);
+  packet->AddHeader (macHdr);
+
+  // The allocations per operation are the copies made to read the headers
+  Benchmark ("HeadersCopyRemove", 0, iterations,
+             [&] (uint32_t i)
+             {
+               Ptr<Packet> copy = packet->Copy ();
+               LoraMacHeader readMacHdr;
+               LoraFrameHeader readFrameHdr;
+               readFrameHdr.SetAsUplink ();
+               copy->RemoveHeader (readMacHdr);
+               copy->RemoveHeader (readFrameHdr);
+               sink += readFrameHdr.GetFCnt ();
+             });
+
+  Benchmark ("HeadersPeek", 0, iterations,
+             [&] (uint32_t i)
+             {
+               LoraMacHeader readMacHdr;
+               LoraFrameHeader readFrameHdr;
+               LoraHeaderView::Peek (packet, readMacHdr, readFrameHdr);
+               sink += readFrameHdr.GetFCnt ();
+             });
+}
+
+void
+BenchmarkSequenceHeader (void)
+{
+  // As the network scheduler does, copy a template payload and add the header
+  Ptr<Packet> payload = Create<Packet> (51 - SequenceHeader::MAX_SIZE);
+  Ptr<Packet> packet;
+
+  Benchmark ("SequencedPacketCreate", 0, iterations,
+             [&] (uint32_t i)
+             {
+               SequenceHeader header;
+               header.SetSize (51);
+               header.SetSequence (i);
+               packet = payload->Copy ();
+               packet->AddHeader (header);
+             });
+
+  Benchmark ("SequencedPacketDecode", 0, iterations,
+             [&] (uint32_t i)
+             {
+               SequenceHeader header;
+               header.SetSize (packet->GetSize ());
+               packet->PeekHeader (header);
+               sink += header.GetSequence ();
+             });
+}
+
+void
+BenchmarkLoraTag (void)
+{
+  Ptr<Packet> packet = Create<Packet> (23);
+  LoraTag tag (7);
+  tag.SetFrequency (868.1);
+  tag.SetReceivePower (-110);
+  packet->AddPacketTag (tag);
+
+  Benchmark ("LoraTagRemoveAdd", 0, iterations,
+             [&] (uint32_t i)
+             {
+               LoraTag readTag;
+               packet->RemovePacketTag (readTag);
+               sink += readTag.GetReceivePower ();
+               packet->AddPacketTag (readTag);
+             });
+
+  Benchmark ("LoraTagPeek", 0, iterations,
+             [&] (uint32_t i)
+             {
+               LoraTag readTag;
+               packet->PeekPacketTag (readTag);
+               sink += readTag.GetReceivePower ();
+             });
+}
+
+void
+BenchmarkShadowing (void)
+{
+  uint32_t positionCounts[] = {1, 100, 10000};
+  for (uint32_t positionCount : positionCounts)
+    {
+      Ptr<CorrelatedShadowingPropagationLossModel> shadowing =
+        CreateObject<CorrelatedShadowingPropagationLossModel> ();
+
+      Ptr<ConstantPositionMobilityModel> gateway = CreateObject<ConstantPositionMobilityModel> ();
+      gateway->SetPosition (Vector (0, 0, 15));
+
+      // Receivers on a square grid with 50 m spacing
+      std::vector<Ptr<ConstantPositionMobilityModel> > devices;
+      uint32_t side = std::ceil (std::sqrt (positionCount));
+      for (uint32_t i = 0; i < positionCount; i++)
+        {
+          Ptr<ConstantPositionMobilityModel> device = CreateObject<ConstantPositionMobilityModel> ();
+          device->SetPosition (Vector (50.0 * (i % side), 50.0 * (i / side), 1.2));
+          devices.push_back (device);
+        }
+
+      Benchmark ("CorrelatedShadowingCalcRxPower", positionCount, iterations,
+                 [&] (uint32_t i)
+                 {
+                   sink += shadowing->CalcRxPower (14, devices[i % positionCount], gateway);
+                 });
+    }
+}
+
+int main (int argc, char *argv[])
+{
+
+  CommandLine cmd;
+  cmd.AddValue ("iterations",
+                "Number of operations of each benchmark, divided by the size for the ones that scale",
+                iterations);
+  cmd.Parse (argc, argv);
+
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  std::cout << "benchmark,parameter,operations,nsPerOp,allocsPerOp" << std::endl;
+
+  BenchmarkInterference ();
+  BenchmarkOnAirTime ();
+  BenchmarkPingOffset ();
+  BenchmarkInsertReceivedPacket ();
+  BenchmarkFrameHeader ();
+  BenchmarkHeaderPeek ();
+  BenchmarkSequenceHeader ();
+  BenchmarkLoraTag ();
+  BenchmarkShadowing ();
+
+  Simulator::Destroy ();
+
+  NS_LOG_INFO ("Checksum of the results: " << sink);
+
+  return 0;
+}
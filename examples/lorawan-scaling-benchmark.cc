@@ -0,0 +1,447 @@
+/*
+ * This script measures how the cost of the simulation scales with the size of
+ * the network. It is meant to be run on every commit that touches a hot path,
+ * so that scaling regressions are noticed.
+ *
+ * The topology is the one of complete-network-example.cc (class A devices
+ * with a periodic sender on a disc) to which the class B multicast groups of
+ * class-b-network-example-multicast-performance.cc can be added.
+ *
+ * The script sweeps over all the combinations of the comma separated lists
+ * given for the number of devices, the number of gateways, the application
+ * period and the size of the class B multicast groups (0 disables class B).
+ * For each combination, a fresh simulation is built with the same seed and
+ * run number, and one CSV line is written with:
+ *   - the wall time of Simulator::Run,
+ *   - the number of executed events and events per second of wall time,
+ *   - the number of transmissions on the channel (uplinks, downlinks and
+ *     beacons) and the events per transmission,
+ *   - the peak resident set size of the process during the run, in kB.
+ *
+ * With --beaconClock=1 the class B devices schedule their beacon period
+ * events through a shared BeaconClock instead of one event per device.
+ *
+ * The wall time of the installation of the end devices' NetDevices is also
+ * written; with --bulkInstall=1 they are installed with
+ * LoraHelper::InstallBulk instead of LoraHelper::Install.
+ *
+ * The peak RSS is reset before each run where the kernel allows it (Linux
+ * /proc/self/clear_refs), otherwise it is the peak of the whole process and
+ * only the first line, or a single point per invocation, is meaningful.
+ *
+ * Example:
+ *   ./waf --run "lorawan-scaling-benchmark --nDevices=100,1000,10000 --nGateways=1,4 --output=scaling.csv"
+ */
+
+#include "ns3/end-device-lora-phy.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/end-device-lora-mac.h"
+#include "ns3/gateway-lora-mac.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/pointer.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/lora-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/position-allocator.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/end-device-class-b-app-helper.h"
+#include "ns3/command-line.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/forwarder-helper.h"
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/resource.h>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("LorawanScalingBenchmark");
+
+// Sweep settings, comma separated lists
+std::string nDevicesList = "100,1000";
+std::string nGatewaysList = "1,4";
+std::string appPeriodList = "600";
+std::string mcGroupSizeList = "0,8";
+
+// Fixed settings
+int nMcDevices = 32;  // Number of class B devices, if the group size is not 0
+double radius = 7500;
+double simulationTime = 1200;
+uint32_t seed = 1;
+uint32_t run = 1;
+bool beaconClock = false;  // Schedule the class B beacon period events through a shared BeaconClock
+bool bulkInstall = false;  // Install the end devices with LoraHelper::InstallBulk
+
+// Output control
+std::string output = "";  // Standard output if empty
+
+// Number of transmissions of the current run
+uint64_t transmissions = 0;
+
+void
+OnTransmissionStarted (Ptr<const Packet> packet, uint8_t sf, double frequencyMHz, Time duration)
+{
+  transmissions++;
+}
+
+std::vector<int>
+ParseList (std::string list)
+{
+  std::vector<int> values;
+  std::istringstream stream (list);
+  std::string value;
+  while (std::getline (stream, value, ','))
+    {
+      if (!value.empty ())
+        {
+          values.push_back (std::stoi (value));
+        }
+    }
+  return values;
+}
+
+/**
+ * Reset the peak RSS of the process, return false if not supported
+ */
+bool
+ResetPeakRss (void)
+{
+  std::ofstream clearRefs ("/proc/self/clear_refs");
+  if (!clearRefs.is_open ())
+    {
+      return false;
+    }
+  clearRefs << "5";
+  clearRefs.close ();
+  return !clearRefs.fail ();
+}
+
+/**
+ * Get the peak RSS of the process in kB
+ */
+long
+GetPeakRssKb (void)
+{
+  std::ifstream status ("/proc/self/status");
+  std::string line;
+  while (std::getline (status, line))
+    {
+      if (line.compare (0, 6, "VmHWM:") == 0)
+        {
+          return std::stol (line.substr (6));
+        }
+    }
+
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+/**
+ * Build the network of a point of the sweep, run it and write its CSV line
+ */
+void
+RunPoint (std::ostream& os, int nDevices, int nGateways, int appPeriodSeconds, int mcGroupSize)
+{
+  RngSeedManager::SetSeed (seed);
+  RngSeedManager::SetRun (run);
+  transmissions = 0;
+
+  /***********
+   *  Setup  *
+   ***********/
+
+  // Mobility
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator",
+                                 "rho", DoubleValue (radius),
+                                 "X", DoubleValue (0.0),
+                                 "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  /************************
+   *  Create the channel  *
+   ************************/
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+  channel->TraceConnectWithoutContext ("TransmissionStarted",
+                                       MakeCallback (&OnTransmissionStarted));
+
+  /************************
+   *  Create the helpers  *
+   ************************/
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+
+  LoraMacHelper macHelper = LoraMacHelper ();
+
+  LoraHelper helper = LoraHelper ();
+
+  NetworkServerHelper nsHelper = NetworkServerHelper ();
+
+  ForwarderHelper forHelper = ForwarderHelper ();
+
+  /************************
+   *  Create End Devices  *
+   ************************/
+
+  bool classB = mcGroupSize > 0 && nMcDevices > 0;
+
+  NodeContainer endDevices;
+
+  NodeContainer classAEndDevices;
+  classAEndDevices.Create (nDevices);
+  endDevices.Add (classAEndDevices);
+
+  NodeContainer mcEndDevices;
+  if (classB)
+    {
+      mcEndDevices.Create (nMcDevices);
+      endDevices.Add (mcEndDevices);
+    }
+
+  mobility.Install (endDevices);
+
+  // Make it so that nodes are at a certain height > 0
+  for (NodeContainer::Iterator j = endDevices.Begin ();
+       j != endDevices.End (); ++j)
+    {
+      Ptr<MobilityModel> mobility = (*j)->GetObject<MobilityModel> ();
+      Vector position = mobility->GetPosition ();
+      position.z = 1.2;
+      mobility->SetPosition (position);
+    }
+
+  uint8_t nwkId = 54;
+  uint32_t nwkAddr = 1864;
+  Ptr<LoraDeviceAddressGenerator> addrGen = CreateObject<LoraDeviceAddressGenerator> (nwkId,nwkAddr);
+
+  macHelper.SetAddressGenerator (addrGen);
+  if (beaconClock)
+    {
+      macHelper.SetBeaconClock (CreateObject<BeaconClock> ());
+    }
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LoraMacHelper::ED);
+  double setupSeconds;
+  if (bulkInstall)
+    {
+      helper.InstallBulk (phyHelper, macHelper, endDevices);
+      setupSeconds = helper.GetLastSetupReport ().wallSeconds;
+    }
+  else
+    {
+      std::chrono::steady_clock::time_point setupStart = std::chrono::steady_clock::now ();
+      helper.Install (phyHelper, macHelper, endDevices);
+      std::chrono::steady_clock::time_point setupEnd = std::chrono::steady_clock::now ();
+      setupSeconds = std::chrono::duration<double> (setupEnd - setupStart).count ();
+    }
+
+  /*********************
+   *  Create Gateways  *
+   *********************/
+
+  NodeContainer gateways;
+  gateways.Create (nGateways);
+
+  // The first gateway is at the center, the others on a circle of half the radius
+  Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator> ();
+  allocator->Add (Vector (0.0, 0.0, 15.0));
+  for (int i = 1; i < nGateways; i++)
+    {
+      double angle = 2 * M_PI * (i - 1) / (nGateways - 1);
+      allocator->Add (Vector (radius / 2 * std::cos (angle), radius / 2 * std::sin (angle), 15.0));
+    }
+  mobility.SetPositionAllocator (allocator);
+  mobility.Install (gateways);
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LoraMacHelper::GW);
+  helper.Install (phyHelper, macHelper, gateways);
+
+  if (classB)
+    {
+      macHelper.EnableBeaconTransmission (gateways);
+      macHelper.EnableClassBDownlinkTransmission (gateways);
+      macHelper.CreateNMulticastGroup (mcEndDevices, gateways, mcGroupSize, 3, 0, 0);
+    }
+
+  /**********************************************
+   *  Set up the end device's spreading factor  *
+   **********************************************/
+
+  macHelper.SetSpreadingFactorsUp (endDevices, gateways, channel);
+
+  /*********************************************
+   *  Install applications on the end devices  *
+   *********************************************/
+
+  Time appStopTime = Seconds (simulationTime);
+
+  PeriodicSenderHelper appHelper = PeriodicSenderHelper ();
+  appHelper.SetPeriod (Seconds (appPeriodSeconds));
+  appHelper.SetPacketSize (23);
+  ApplicationContainer appContainer = appHelper.Install (classAEndDevices);
+
+  if (classB)
+    {
+      EndDeviceClassBAppHelper classBAppHelper = EndDeviceClassBAppHelper ();
+      classBAppHelper.SetSendingPeriod (Seconds (appPeriodSeconds));
+      classBAppHelper.SetPacketSize (23);
+      appContainer.Add (classBAppHelper.Install (mcEndDevices));
+    }
+
+  appContainer.Start (Seconds (0));
+  appContainer.Stop (appStopTime);
+
+  /**************************
+   *  Create Network Server  *
+   ***************************/
+
+  NodeContainer networkServer;
+  networkServer.Create (1);
+
+  if (classB)
+    {
+      nsHelper.EnableBeaconTransmission (true);
+      nsHelper.SetPingDownlinkPacketSize (51);
+    }
+
+  nsHelper.SetEndDevices (endDevices);
+  nsHelper.SetGateways (gateways);
+  nsHelper.Install (networkServer);
+
+  forHelper.Install (gateways);
+
+  ////////////////
+  // Simulation //
+  ////////////////
+
+  Simulator::Stop (appStopTime);
+
+  bool rssReset = ResetPeakRss ();
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+  Simulator::Run ();
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now ();
+
+  double wallSeconds = std::chrono::duration<double> (end - start).count ();
+  uint64_t events = Simulator::GetEventCount ();
+  long peakRssKb = GetPeakRssKb ();
+
+  Simulator::Destroy ();
+
+  os << nDevices << ","
+     << nGateways << ","
+     << appPeriodSeconds << ","
+     << mcGroupSize << ","
+     << (classB ? nMcDevices : 0) << ","
+     << simulationTime << ","
+     << seed << ","
+     << run << ","
+     << beaconClock << ","
+     << bulkInstall << ","
+     << setupSeconds << ","
+     << wallSeconds << ","
+     << events << ","
+     << (wallSeconds > 0 ? events / wallSeconds : 0) << ","
+     << transmissions << ","
+     << (transmissions > 0 ? double (events) / transmissions : 0) << ","
+     << peakRssKb << ","
+     << rssReset << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+
+  CommandLine cmd;
+  cmd.AddValue ("nDevices",
+                "Comma separated list of the numbers of class A end devices to sweep",
+                nDevicesList);
+  cmd.AddValue ("nGateways",
+                "Comma separated list of the numbers of gateways to sweep",
+                nGatewaysList);
+  cmd.AddValue ("appPeriod",
+                "Comma separated list of the application periods in seconds to sweep",
+                appPeriodList);
+  cmd.AddValue ("mcGroupSize",
+                "Comma separated list of the class B multicast group sizes to sweep, 0 disables class B",
+                mcGroupSizeList);
+  cmd.AddValue ("nMcDevices",
+                "Number of class B end devices, split in groups of mcGroupSize",
+                nMcDevices);
+  cmd.AddValue ("radius",
+                "The radius of the area to simulate",
+                radius);
+  cmd.AddValue ("simulationTime",
+                "The time for which to simulate each point",
+                simulationTime);
+  cmd.AddValue ("seed",
+                "The seed of the random number generator, the same for all the points",
+                seed);
+  cmd.AddValue ("run",
+                "The run number of the random number generator, the same for all the points",
+                run);
+  cmd.AddValue ("beaconClock",
+                "Whether the class B devices share a BeaconClock",
+                beaconClock);
+  cmd.AddValue ("bulkInstall",
+                "Whether the end devices are installed with LoraHelper::InstallBulk",
+                bulkInstall);
+  cmd.AddValue ("output",
+                "The CSV file to write the results to, the standard output if empty",
+                output);
+  cmd.Parse (argc, argv);
+
+  std::ofstream outputFile;
+  if (!output.empty ())
+    {
+      outputFile.open (output.c_str ());
+      NS_ABORT_MSG_IF (!outputFile.is_open (), "Could not open " << output);
+    }
+  std::ostream& os = output.empty () ? std::cout : outputFile;
+
+  os << "nDevices,nGateways,appPeriod,mcGroupSize,nMcDevices,simulationTime,seed,run,beaconClock,"
+     << "bulkInstall,setupSeconds,wallSeconds,events,eventsPerSecond,transmissions,eventsPerTransmission,"
+     << "peakRssKb,peakRssReset" << std::endl;
+
+  std::vector<int> nDevicesValues = ParseList (nDevicesList);
+  std::vector<int> nGatewaysValues = ParseList (nGatewaysList);
+  std::vector<int> appPeriodValues = ParseList (appPeriodList);
+  std::vector<int> mcGroupSizeValues = ParseList (mcGroupSizeList);
+
+  for (std::vector<int>::iterator d = nDevicesValues.begin (); d != nDevicesValues.end (); ++d)
+    {
+      for (std::vector<int>::iterator g = nGatewaysValues.begin (); g != nGatewaysValues.end (); ++g)
+        {
+          for (std::vector<int>::iterator p = appPeriodValues.begin (); p != appPeriodValues.end (); ++p)
+            {
+              for (std::vector<int>::iterator m = mcGroupSizeValues.begin (); m != mcGroupSizeValues.end (); ++m)
+                {
+                  NS_LOG_INFO ("Running nDevices=" << *d << " nGateways=" << *g
+                                                   << " appPeriod=" << *p << " mcGroupSize=" << *m);
+                  RunPoint (os, *d, *g, *p, *m);
+                }
+            }
+        }
+    }
+
+  return 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * This script precomputes the correlated shadowing over a square area and
+ * writes it as a raster that RasterShadowingPropagationLossModel maps, so
+ * that many runs can share the same environment without regenerating it.
+ *
+ * The area is centered on the origin, like the disc of
+ * complete-network-example.cc, and the raster covers the square around a
+ * disc of the given radius.
+ *
+ * Example:
+ *   ./waf --run "shadowing-raster-generator --radius=6400 --output=shadowing.lsr"
+ * and then, in the simulation:
+ *   Ptr<RasterShadowingPropagationLossModel> shadowing =
+ *     CreateObject<RasterShadowingPropagationLossModel> ();
+ *   shadowing->SetAttribute ("FileName", StringValue ("shadowing.lsr"));
+ *   loss->SetNext (shadowing);
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/shadowing-raster-helper.h"
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("ShadowingRasterGenerator");
+
+// Settings
+double radius = 6400;
+double correlationDistance = 110;
+double resolution = 0;
+uint32_t seed = 1;
+uint32_t run = 1;
+std::string output = "shadowing.lsr";
+
+int main (int argc, char *argv[])
+{
+
+  CommandLine cmd;
+  cmd.AddValue ("radius",
+                "Half of the side of the square area to cover",
+                radius);
+  cmd.AddValue ("correlationDistance",
+                "The correlation distance of the shadowing",
+                correlationDistance);
+  cmd.AddValue ("resolution",
+                "The distance between two values of the raster, the correlation distance if 0",
+                resolution);
+  cmd.AddValue ("seed",
+                "The seed of the random number generator",
+                seed);
+  cmd.AddValue ("run",
+                "The run number of the random number generator",
+                run);
+  cmd.AddValue ("output",
+                "The raster file to write",
+                output);
+  cmd.Parse (argc, argv);
+
+  RngSeedManager::SetSeed (seed);
+  RngSeedManager::SetRun (run);
+
+  ShadowingRasterHelper helper;
+  helper.SetArea (-radius, -radius, radius, radius);
+  helper.SetCorrelationDistance (correlationDistance);
+  helper.SetResolution (resolution);
+
+  NS_ABORT_MSG_IF (!helper.Write (output), "Could not write " << output);
+
+  return 0;
+}
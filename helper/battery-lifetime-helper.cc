@@ -0,0 +1,444 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/battery-lifetime-helper.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/energy-source-container.h"
+#include "ns3/lora-net-device.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("BatteryLifetimeHelper");
+
+BatteryLifetimeHelper::BatteryLifetimeHelper () :
+  m_period (Seconds (128)),
+  m_warmupPeriods (2),
+  m_confidenceLevel (0.95),
+  m_tolerance (0.05),
+  m_batteryEnergy (0),
+  m_beaconlessFraction (-1),
+  m_relayFraction (-1),
+  m_sampledPeriods (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BatteryLifetimeHelper::~BatteryLifetimeHelper ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_sampleEvent);
+}
+
+void
+BatteryLifetimeHelper::SetBeaconPeriod (Time period)
+{
+  NS_ASSERT_MSG (period > Seconds (0), "The beacon period has to be positive");
+  m_period = period;
+}
+
+void
+BatteryLifetimeHelper::SetWarmupPeriods (uint32_t periods)
+{
+  m_warmupPeriods = periods;
+}
+
+void
+BatteryLifetimeHelper::SetConfidenceLevel (double level)
+{
+  NS_ASSERT_MSG (level > 0 && level < 1, "The confidence level has to be in (0, 1)");
+  m_confidenceLevel = level;
+}
+
+void
+BatteryLifetimeHelper::SetTolerance (double tolerance)
+{
+  m_tolerance = tolerance;
+}
+
+void
+BatteryLifetimeHelper::SetBatteryEnergy (double energy)
+{
+  m_batteryEnergy = energy;
+}
+
+void
+BatteryLifetimeHelper::SetBeaconlessFraction (double fraction)
+{
+  m_beaconlessFraction = fraction;
+}
+
+void
+BatteryLifetimeHelper::SetRelayFraction (double fraction)
+{
+  m_relayFraction = fraction;
+}
+
+void
+BatteryLifetimeHelper::Install (NodeContainer endDevices)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (NodeContainer::Iterator i = endDevices.Begin (); i != endDevices.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+
+      struct DeviceRecord& device = m_devices[node->GetId ()];
+
+      Ptr<EnergySourceContainer> sources = node->GetObject<EnergySourceContainer> ();
+      NS_ASSERT_MSG (sources != 0, "No energy source on node " << node->GetId ());
+      for (EnergySourceContainer::Iterator s = sources->Begin (); s != sources->End (); ++s)
+        {
+          DeviceEnergyModelContainer models = (*s)->FindDeviceEnergyModels ("ns3::LoraRadioEnergyModel");
+          if (models.GetN () > 0)
+            {
+              device.model = models.Get (0)->GetObject<LoraRadioEnergyModel> ();
+              device.source = *s;
+              break;
+            }
+        }
+      NS_ASSERT_MSG (device.model != 0, "No LoraRadioEnergyModel on node " << node->GetId ());
+
+      Ptr<LoraNetDevice> loraNetDevice = node->GetDevice (0)->GetObject<LoraNetDevice> ();
+      NS_ASSERT (loraNetDevice != 0);
+      Ptr<EndDeviceLoraMac> mac = loraNetDevice->GetMac ()->GetObject<EndDeviceLoraMac> ();
+      NS_ASSERT (mac != 0);
+
+      bool success = mac->TraceConnectWithoutContext ("BeaconState",
+                                                      MakeBoundCallback
+                                                        (&BatteryLifetimeHelper::BeaconState, &device));
+      NS_ASSERT (success == true);
+
+      success = mac->TraceConnectWithoutContext ("MissedBeaconCount",
+                                                 MakeBoundCallback
+                                                   (&BatteryLifetimeHelper::MissedBeaconCount, &device));
+      NS_ASSERT (success == true);
+    }
+}
+
+void
+BatteryLifetimeHelper::Start (Time start)
+{
+  NS_LOG_FUNCTION (this << start);
+
+  Simulator::Cancel (m_sampleEvent);
+  m_sampledPeriods = 0;
+  for (std::map<uint32_t, struct DeviceRecord>::iterator it = m_devices.begin (); it != m_devices.end (); ++it)
+    {
+      for (int type = 0; type < NUMBER_OF_PERIOD_TYPES; type++)
+        {
+          it->second.energy[type].clear ();
+        }
+    }
+
+  Simulator::Schedule (start, &BatteryLifetimeHelper::StartPeriod, this);
+  m_sampleEvent = Simulator::Schedule (start + m_period, &BatteryLifetimeHelper::Sample, this);
+}
+
+void
+BatteryLifetimeHelper::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_sampleEvent);
+}
+
+////////////////
+// Trace sinks //
+////////////////
+
+void
+BatteryLifetimeHelper::BeaconState (struct DeviceRecord* device,
+                                    EndDeviceLoraMac::BeaconState oldValue,
+                                    EndDeviceLoraMac::BeaconState newValue)
+{
+  device->inBeaconless = (newValue == EndDeviceLoraMac::BEACONLESS);
+  device->beaconless |= device->inBeaconless;
+}
+
+void
+BatteryLifetimeHelper::MissedBeaconCount (struct DeviceRecord* device, uint32_t oldValue, uint32_t newValue)
+{
+  device->beaconless = true;
+}
+
+/////////////
+// Sampling //
+/////////////
+
+void
+BatteryLifetimeHelper::StartPeriod (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  for (std::map<uint32_t, struct DeviceRecord>::iterator it = m_devices.begin (); it != m_devices.end (); ++it)
+    {
+      struct DeviceRecord& device = it->second;
+      device.beaconless = device.inBeaconless;
+      device.lastEnergy = GetTotalEnergy (device.model);
+      device.lastRelayEnergy = device.model->GetActivityEnergy (LoraRadioEnergyModel::ACTIVITY_RELAY);
+    }
+}
+
+void
+BatteryLifetimeHelper::Sample (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_sampledPeriods++;
+  if (m_sampledPeriods > m_warmupPeriods)
+    {
+      for (std::map<uint32_t, struct DeviceRecord>::iterator it = m_devices.begin (); it != m_devices.end (); ++it)
+        {
+          struct DeviceRecord& device = it->second;
+          double energy = GetTotalEnergy (device.model) - device.lastEnergy;
+          double relayEnergy = device.model->GetActivityEnergy (LoraRadioEnergyModel::ACTIVITY_RELAY)
+            - device.lastRelayEnergy;
+
+          enum PeriodType type = NORMAL_PERIOD;
+          if (device.beaconless)
+            {
+              type = BEACONLESS_PERIOD;
+            }
+          else if (relayEnergy > 0)
+            {
+              type = RELAY_PERIOD;
+            }
+          device.energy[type].push_back (energy);
+        }
+    }
+
+  StartPeriod ();
+  m_sampleEvent = Simulator::Schedule (m_period, &BatteryLifetimeHelper::Sample, this);
+}
+
+///////////////
+// Projection //
+///////////////
+
+double
+BatteryLifetimeHelper::GetTotalEnergy (Ptr<LoraRadioEnergyModel> model)
+{
+  // Unlike GetTotalEnergyConsumption, this includes the current state
+  double energy = 0;
+  for (int activity = 0; activity < LoraRadioEnergyModel::NUMBER_OF_ACTIVITIES; activity++)
+    {
+      energy += model->GetActivityEnergy (LoraRadioEnergyModel::Activity (activity));
+    }
+  return energy;
+}
+
+double
+BatteryLifetimeHelper::GetNormalQuantile (double probability)
+{
+  // Bisection on the cumulative distribution, which is monotonic
+  double low = -10;
+  double high = 10;
+  for (int i = 0; i < 64; i++)
+    {
+      double middle = (low + high) / 2;
+      if (0.5 * std::erfc (-middle / std::sqrt (2.0)) < probability)
+        {
+          low = middle;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  return (low + high) / 2;
+}
+
+Time
+BatteryLifetimeHelper::GetLifetime (double seconds)
+{
+  if (!(seconds < Time::Max ().GetSeconds ()))
+    {
+      return Time::Max ();
+    }
+  return Seconds (std::max (seconds, 0.0));
+}
+
+struct BatteryLifetimeHelper::Projection
+BatteryLifetimeHelper::Project (const struct DeviceRecord& device) const
+{
+  struct Projection projection;
+  projection.beaconlessPeriods = device.energy[BEACONLESS_PERIOD].size ();
+  projection.relayPeriods = device.energy[RELAY_PERIOD].size ();
+  projection.periods = device.energy[NORMAL_PERIOD].size ()
+    + projection.beaconlessPeriods + projection.relayPeriods;
+  if (projection.periods == 0)
+    {
+      return projection;
+    }
+
+  // Fraction of the periods of each class, observed or set
+  double fraction[NUMBER_OF_PERIOD_TYPES];
+  fraction[BEACONLESS_PERIOD] = m_beaconlessFraction >= 0 ? m_beaconlessFraction
+    : double (projection.beaconlessPeriods) / projection.periods;
+  fraction[RELAY_PERIOD] = m_relayFraction >= 0 ? m_relayFraction
+    : double (projection.relayPeriods) / projection.periods;
+  fraction[NORMAL_PERIOD] = std::max (1 - fraction[BEACONLESS_PERIOD] - fraction[RELAY_PERIOD], 0.0);
+
+  // Mean and variance of each class
+  double mean[NUMBER_OF_PERIOD_TYPES];
+  double variance[NUMBER_OF_PERIOD_TYPES];
+  bool converged = true;
+  for (int type = 0; type < NUMBER_OF_PERIOD_TYPES; type++)
+    {
+      const std::vector<double>& samples = device.energy[type];
+      mean[type] = 0;
+      variance[type] = 0;
+      for (std::size_t i = 0; i < samples.size (); i++)
+        {
+          mean[type] += samples[i];
+        }
+      if (!samples.empty ())
+        {
+          mean[type] /= samples.size ();
+        }
+      for (std::size_t i = 0; i < samples.size (); i++)
+        {
+          variance[type] += (samples[i] - mean[type]) * (samples[i] - mean[type]);
+        }
+      if (samples.size () > 1)
+        {
+          variance[type] /= samples.size () - 1;
+        }
+      if (fraction[type] > 0 && samples.size () < 2)
+        {
+          converged = false;
+        }
+    }
+
+  // A class that was not observed costs at least as much as a normal period
+  for (int type = 0; type < NUMBER_OF_PERIOD_TYPES; type++)
+    {
+      if (device.energy[type].empty ())
+        {
+          mean[type] = mean[NORMAL_PERIOD];
+        }
+    }
+
+  double energyVariance = 0;
+  for (int type = 0; type < NUMBER_OF_PERIOD_TYPES; type++)
+    {
+      projection.energyPerPeriod += fraction[type] * mean[type];
+      if (!device.energy[type].empty ())
+        {
+          energyVariance += fraction[type] * fraction[type] * variance[type] / device.energy[type].size ();
+        }
+    }
+  projection.energyPerPeriodError = std::sqrt (energyVariance);
+
+  // The normal periods have to be stationary over the window
+  const std::vector<double>& normal = device.energy[NORMAL_PERIOD];
+  std::size_t half = normal.size () / 2;
+  if (half > 0)
+    {
+      double firstHalf = 0;
+      double secondHalf = 0;
+      for (std::size_t i = 0; i < half; i++)
+        {
+          firstHalf += normal[i];
+          secondHalf += normal[normal.size () - half + i];
+        }
+      if (std::fabs (firstHalf - secondHalf) > m_tolerance * std::fabs (firstHalf + secondHalf) / 2)
+        {
+          converged = false;
+        }
+    }
+
+  // Energy available before the low battery threshold of the source
+  DoubleValue threshold (0);
+  device.source->GetAttributeFailSafe ("BasicEnergyLowBatteryThreshold", threshold);
+  double available;
+  double elapsed;
+  if (m_batteryEnergy > 0)
+    {
+      available = m_batteryEnergy * (1 - threshold.Get ());
+      elapsed = 0;
+    }
+  else
+    {
+      available = device.source->GetRemainingEnergy ()
+        - threshold.Get () * device.source->GetInitialEnergy ();
+      elapsed = Simulator::Now ().GetSeconds ();
+    }
+  available = std::max (available, 0.0);
+
+  double z = GetNormalQuantile ((1 + m_confidenceLevel) / 2);
+  double halfWidth = z * projection.energyPerPeriodError;
+  if (halfWidth > m_tolerance * projection.energyPerPeriod)
+    {
+      converged = false;
+    }
+
+  double period = m_period.GetSeconds ();
+  double energy = projection.energyPerPeriod;
+  projection.lifetime = GetLifetime (elapsed + available / energy * period);
+  projection.lifetimeLow = GetLifetime (elapsed + available / (energy + halfWidth) * period);
+  projection.lifetimeHigh = energy > halfWidth ?
+    GetLifetime (elapsed + available / (energy - halfWidth) * period) : Time::Max ();
+  projection.converged = converged;
+
+  return projection;
+}
+
+struct BatteryLifetimeHelper::Projection
+BatteryLifetimeHelper::GetProjection (uint32_t nodeId) const
+{
+  std::map<uint32_t, struct DeviceRecord>::const_iterator it = m_devices.find (nodeId);
+  NS_ASSERT_MSG (it != m_devices.end (), "Node " << nodeId << " is not installed");
+
+  return Project (it->second);
+}
+
+void
+BatteryLifetimeHelper::Print (std::ostream& os) const
+{
+  os << "nodeId,periods,beaconlessPeriods,relayPeriods,energyPerPeriodJ,"
+     << "energyPerPeriodErrorJ,lifetimeDays,lifetimeLowDays,lifetimeHighDays,converged"
+     << std::endl;
+
+  for (std::map<uint32_t, struct DeviceRecord>::const_iterator it = m_devices.begin (); it != m_devices.end (); ++it)
+    {
+      struct Projection projection = Project (it->second);
+      os << it->first << ","
+         << projection.periods << ","
+         << projection.beaconlessPeriods << ","
+         << projection.relayPeriods << ","
+         << projection.energyPerPeriod << ","
+         << projection.energyPerPeriodError << ","
+         << projection.lifetime.GetDays () << ","
+         << projection.lifetimeLow.GetDays () << ","
+         << projection.lifetimeHigh.GetDays () << ","
+         << projection.converged << std::endl;
+    }
+}
+
+}
+}
@@ -0,0 +1,234 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef BATTERY_LIFETIME_HELPER_H
+#define BATTERY_LIFETIME_HELPER_H
+
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/node-container.h"
+#include "ns3/energy-source.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/end-device-lora-mac.h"
+
+#include <map>
+#include <ostream>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Projects the battery lifetime of end devices from a short simulation
+ *
+ * The energy consumed by the LoraRadioEnergyModel of each device is sampled
+ * at the end of every beacon period. After some warm-up periods, each period
+ * is classified as:
+ *  - beacon-less, if the MAC missed a beacon or was in beacon-less operation
+ *    during the period,
+ *  - relay, if the device relayed a packet in one of its ping slots,
+ *  - normal, otherwise.
+ *
+ * The energy per period is the mean of each class weighted by its fraction
+ * of the periods. The fractions are the ones observed in the simulation,
+ * unless the long-run fraction of beacon-less or relay periods is set, since
+ * a few simulated hours rarely see as many of them as the years the
+ * projection is for. The lifetime is the energy available before the low
+ * battery threshold of the source divided by the energy per period, and its
+ * confidence interval follows from the standard error of the class means.
+ *
+ * A projection is flagged as converged when the mean of the normal periods
+ * in the first and second half of the window differ by less than the
+ * tolerance, the relative half-width of the confidence interval of the
+ * energy per period is below the tolerance, and every class with a positive
+ * fraction has been observed at least twice.
+ *
+ * The sampling should start at a multiple of the beacon period, so that
+ * each sample covers one beacon period of the MACs.
+ */
+class BatteryLifetimeHelper
+{
+public:
+  /// The lifetime projection of a device
+  struct Projection
+  {
+    uint32_t periods = 0;             ///< Sampled periods, after the warm-up
+    uint32_t beaconlessPeriods = 0;   ///< Of which beacon-less
+    uint32_t relayPeriods = 0;        ///< Of which with relaying
+    double energyPerPeriod = 0;       ///< Projected energy per beacon period, in J
+    double energyPerPeriodError = 0;  ///< Its standard error, in J
+    Time lifetime;                    ///< Projected lifetime
+    Time lifetimeLow;                 ///< Lower bound of the confidence interval
+    Time lifetimeHigh;                ///< Upper bound of the confidence interval
+    bool converged = false;           ///< Whether the steady state was reached
+  };
+
+  BatteryLifetimeHelper ();
+  ~BatteryLifetimeHelper ();
+
+  /**
+   * Set the beacon period, 128 s by default
+   */
+  void SetBeaconPeriod (Time period);
+
+  /**
+   * Set the number of periods that are not used for the projection, 2 by
+   * default
+   */
+  void SetWarmupPeriods (uint32_t periods);
+
+  /**
+   * Set the level of the confidence intervals, 0.95 by default
+   */
+  void SetConfidenceLevel (double level);
+
+  /**
+   * Set the relative tolerance of the convergence check, 0.05 by default
+   */
+  void SetTolerance (double tolerance);
+
+  /**
+   * Set the energy of a full battery, in J
+   *
+   * If set, the lifetime is the one of a full battery in steady state.
+   * Otherwise it is counted from the start of the simulation, with the
+   * remaining energy of the source at the time of the projection.
+   */
+  void SetBatteryEnergy (double energy);
+
+  /**
+   * Set the long-run fraction of beacon-less periods, negative (the default)
+   * to use the one observed
+   */
+  void SetBeaconlessFraction (double fraction);
+
+  /**
+   * Set the long-run fraction of periods with relaying, negative (the
+   * default) to use the one observed
+   */
+  void SetRelayFraction (double fraction);
+
+  /**
+   * Find the energy models and the MACs of the end devices
+   *
+   * \param endDevices the end devices, with a LoraRadioEnergyModel installed
+   *        and an EndDeviceLoraMac on their first device
+   */
+  void Install (NodeContainer endDevices);
+
+  /**
+   * Start sampling at the given time
+   *
+   * \param start the delay after which the first period starts
+   */
+  void Start (Time start);
+
+  /**
+   * Stop sampling, the current partial period is dropped
+   */
+  void Stop (void);
+
+  /**
+   * \param nodeId the id of an installed end device
+   * \return the projection of the device with the periods sampled so far
+   */
+  struct Projection GetProjection (uint32_t nodeId) const;
+
+  /**
+   * Print one comma separated line with the projection of each device,
+   * preceded by a header line
+   */
+  void Print (std::ostream& os) const;
+
+private:
+  /// Classes of the beacon periods
+  enum PeriodType
+  {
+    NORMAL_PERIOD,
+    BEACONLESS_PERIOD,
+    RELAY_PERIOD,
+    NUMBER_OF_PERIOD_TYPES
+  };
+
+  /// Samples of a single device
+  struct DeviceRecord
+  {
+    Ptr<LoraRadioEnergyModel> model;
+    Ptr<EnergySource> source;
+    bool inBeaconless = false;    ///< Whether the MAC is in beacon-less operation
+    bool beaconless = false;      ///< Whether the current period is beacon-less
+    double lastEnergy = 0;        ///< Energy consumed at the start of the period
+    double lastRelayEnergy = 0;   ///< Relay energy at the start of the period
+    std::vector<double> energy[NUMBER_OF_PERIOD_TYPES]; ///< Energy of the periods of each class
+  };
+
+  // Trace sinks
+  static void BeaconState (struct DeviceRecord* device,
+                           EndDeviceLoraMac::BeaconState oldValue,
+                           EndDeviceLoraMac::BeaconState newValue);
+  static void MissedBeaconCount (struct DeviceRecord* device, uint32_t oldValue, uint32_t newValue);
+
+  /**
+   * \return the total energy consumed by a model up to now
+   */
+  static double GetTotalEnergy (Ptr<LoraRadioEnergyModel> model);
+
+  /**
+   * \return the quantile of the standard normal distribution
+   */
+  static double GetNormalQuantile (double probability);
+
+  /**
+   * Convert a duration in seconds to a Time, saturating at Time::Max
+   */
+  static Time GetLifetime (double seconds);
+
+  /**
+   * Start a new period for all the devices
+   */
+  void StartPeriod (void);
+
+  /**
+   * Record the period that ends now and start the next one
+   */
+  void Sample (void);
+
+  /**
+   * Compute the projection of a device
+   */
+  struct Projection Project (const struct DeviceRecord& device) const;
+
+  Time m_period;
+  uint32_t m_warmupPeriods;
+  double m_confidenceLevel;
+  double m_tolerance;
+  double m_batteryEnergy;
+  double m_beaconlessFraction;
+  double m_relayFraction;
+
+  EventId m_sampleEvent;
+  uint32_t m_sampledPeriods;  ///< Periods ended since Start, including the warm-up
+
+  std::map<uint32_t, struct DeviceRecord> m_devices; ///< Indexed by node id, a map keeps the addresses stable
+};
+
+}
+}
+#endif /* BATTERY_LIFETIME_HELPER_H */
@@ -56,6 +56,8 @@ EndDeviceClassBAppHelper::EndDeviceClassBAppHelper ()
   m_fragmentEnable = false;
   m_fragment_first = 0;
   m_fragment_last = 0;
+  m_fragmentationNbFrag = 0;
+  m_fragmentationNbParity = 0;
 }
 
 EndDeviceClassBAppHelper::~EndDeviceClassBAppHelper ()
@@ -105,6 +107,11 @@ EndDeviceClassBAppHelper::InstallPriv (Ptr<Node> node) const
       app->EnableFragmentedDataReception (m_fragment_first, m_fragment_last);
     }
   
+  if (m_fragmentationNbFrag > 0)
+    {
+      app->EnableFragmentationSession (m_fragmentationNbFrag, m_fragmentationNbParity);
+    }
+  
   
   if (m_uplinkEnabled)
     {
@@ -203,6 +210,21 @@ EndDeviceClassBAppHelper::EnableFragmentedDataReception (uint32_t first, uint32_
   m_fragment_last = last;
 }
 
+void
+EndDeviceClassBAppHelper::EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity)
+{
+  m_fragmentationNbFrag = nbFrag;
+  m_fragmentationNbParity = nbParity;
+}
+
+int64_t
+EndDeviceClassBAppHelper::AssignStreams (int64_t stream)
+{
+  m_sendingInitialDelay->SetStream (stream);
+  m_sendingIntervalProb->SetStream (stream + 1);
+  return 2;
+}
+
 
 }
 } // namespace ns3
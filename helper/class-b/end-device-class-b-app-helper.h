@@ -100,6 +100,23 @@ public:
    *  
    */
   void EnableFragmentedDataReception (uint32_t first, uint32_t last=0);
+  
+  /**
+   * To Enable the reception of the fragmentation session of the network server
+   * 
+   * \param nbFrag the number of data fragments of the image
+   * \param nbParity the number of parity fragments sent after them
+   */
+  void EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * that draw the sending delays and periods of the installed applications
+   * 
+   * \param stream the first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
 
 private:
   Ptr<Application> InstallPriv (Ptr<Node> node) const;
@@ -131,6 +148,9 @@ private:
   bool m_fragmentEnable; ///< Whether it is enabled or not
   uint32_t m_fragment_first; ///< The first fragment sequence number
   uint32_t m_fragment_last; ///< The last fragment sequence number
+  
+  uint16_t m_fragmentationNbFrag; ///< Data fragments of the session, 0 if disabled
+  uint16_t m_fragmentationNbParity; ///< Parity fragments of the session
 
 };
 
@@ -35,7 +35,7 @@
 #include "ns3/trace-source-accessor.h"
 
 #include <iostream>
-#include <fstream>
+#include <sstream>
 
 namespace ns3 {
 namespace lorawan{
@@ -59,26 +59,16 @@ LoraClassBAnalyzer::LoraClassBAnalyzer (std::string filenameNs, std::string file
 
 { 
   //Create two file: one for Network Server and one of the End Devices
-  std::ofstream nsLogFile;
-  std::ofstream edLogFile;
-  if (append) 
-    {
-      nsLogFile.open (m_nsLogFileName, std::ofstream::out | std::ofstream::app); 
-      edLogFile.open (m_edLogFileName, std::ofstream::out | std::ofstream::app);
-    }
-  else 
-    {
-      nsLogFile.open (m_nsLogFileName, std::ofstream::out | std::ofstream::trunc);
-      edLogFile.open (m_edLogFileName, std::ofstream::out | std::ofstream::trunc);      
-    }
+  //They are kept open by the writer until the analyzer is destroyed
+  m_logWriter.Open (m_nsLogFileName, append);
+  m_logWriter.Open (m_edLogFileName, append);
   
-  nsLogFile.close ();
-  edLogFile.close ();
+  // The containers have to exist before connecting, as the end-device trace
+  // sinks are bound to the records of each device
+  CreateInformationContainers (endDevices, gateways, networkServer);
   
   ConnectAllTraceSinks (endDevices, gateways, networkServer);
   
-  CreateInformationContainers (endDevices, gateways, networkServer);
-  
 }
 
 LoraClassBAnalyzer::~LoraClassBAnalyzer ()
@@ -101,9 +91,15 @@ LoraClassBAnalyzer::ConnectAllTraceSinks (NodeContainer endDevices, NodeContaine
       Ptr<EndDeviceLoraMac> mac = loraNetDevice->GetMac ()->GetObject<EndDeviceLoraMac> ();
       NS_ASSERT (mac != 0);      
       
+      // Resolve the records of the device once, so that the sinks do not 
+      // have to look them up for every event
+      m_edPerformanceRecords.push_back (FindEdPerformanceRecord (mac->GetMulticastDeviceAddress (),
+                                                                 mac->GetDeviceAddress ()));
+      struct EdPerformanceRecord* record = &m_edPerformanceRecords.back ();
+      
       success = mac->TraceConnectWithoutContext ("ReceivedPingMessages",
-                                                  MakeCallback 
-                                                    (&LoraClassBAnalyzer::ReceivedPingPacket, this));
+                                                  MakeBoundCallback 
+                                                    (&LoraClassBAnalyzer::ReceivedPingPacketSink, record));
       NS_ASSERT (success == true);
 
       success = mac->TraceConnectWithoutContext ("DeviceClass",
@@ -112,23 +108,23 @@ LoraClassBAnalyzer::ConnectAllTraceSinks (NodeContainer endDevices, NodeContaine
       NS_ASSERT (success == true);
       
       success =mac->TraceConnectWithoutContext ("TotalSuccessfulBeaconPacketsTracedCallback",
-                                                 MakeCallback
-                                                   (&LoraClassBAnalyzer::BeaconReceived, this));
+                                                 MakeBoundCallback
+                                                   (&LoraClassBAnalyzer::BeaconReceivedSink, record));
       NS_ASSERT (success == true);
       
       success =mac->TraceConnectWithoutContext ("MissedBeaconTracedCallback",
-                                                 MakeCallback
-                                                   (&LoraClassBAnalyzer::BeaconMissed, this));
+                                                 MakeBoundCallback
+                                                   (&LoraClassBAnalyzer::BeaconMissedSink, record));
       NS_ASSERT (success == true);
       
       success =mac->TraceConnectWithoutContext ("CurrentConsecutiveBeaconsMissedTracedCallback",
-                                                 MakeCallback
-                                                   (&LoraClassBAnalyzer::CurrentBeaconMissedRunLength, this));
+                                                 MakeBoundCallback
+                                                   (&LoraClassBAnalyzer::CurrentBeaconMissedRunLengthSink, record));
       NS_ASSERT (success == true);      
       
       success =mac->TraceConnectWithoutContext ("NumberOfOverhearedPackets",
-                                                 MakeCallback
-                                                   (&LoraClassBAnalyzer::NumberOfOverhearedPackets, this));
+                                                 MakeBoundCallback
+                                                   (&LoraClassBAnalyzer::NumberOfOverhearedPacketsSink, record));
       NS_ASSERT (success == true);  
       
       success = mac->TraceConnectWithoutContext ("FailedPings", MakeCallback 
@@ -147,6 +143,11 @@ LoraClassBAnalyzer::ConnectAllTraceSinks (NodeContainer endDevices, NodeContaine
                                                    MakeCallback
                                                      (&LoraClassBAnalyzer::FragmentsMissed, this));
       NS_ASSERT (success == true);
+      
+      success = edApp->TraceConnectWithoutContext ("ImageComplete",
+                                                   MakeBoundCallback
+                                                     (&LoraClassBAnalyzer::ImageCompleteSink, record));
+      NS_ASSERT (success == true);
     }
   
   for (NodeContainer::Iterator i = networkServer.Begin () ; i != networkServer.End (); ++i)
@@ -280,6 +281,41 @@ LoraClassBAnalyzer::CreateInformationContainers (NodeContainer endDevices, NodeC
     }
 }
 
+struct LoraClassBAnalyzer::EdPerformanceRecord
+LoraClassBAnalyzer::FindEdPerformanceRecord (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress)
+{
+  struct EdPerformanceRecord record;
+  record.analyzer = this;
+  record.mcAddress = mcAddress;
+  record.ucAddress = ucAddress;
+  
+  std::map<LoraDeviceAddress, struct McEdDownlinkRelatedPerformance>::iterator mcDownlink = 
+    m_mcEdDownlinkRelatedPerformance.find (mcAddress);
+  if (mcDownlink != m_mcEdDownlinkRelatedPerformance.end ())
+    {
+      std::map<LoraDeviceAddress, struct EdDownlinkRelatedPerformance>::iterator edDownlink = 
+        mcDownlink->second.edDownlinkRelatedPerformance.find (ucAddress);
+      if (edDownlink != mcDownlink->second.edDownlinkRelatedPerformance.end ())
+        {
+          record.downlink = &edDownlink->second;
+        }
+    }
+  
+  std::map<LoraDeviceAddress, struct McEdBeaconRelatedPerformance>::iterator mcBeacon = 
+    m_mcEdBeaconRelatedPerformance.find (mcAddress);
+  if (mcBeacon != m_mcEdBeaconRelatedPerformance.end ())
+    {
+      std::map<LoraDeviceAddress, struct EdBeaconRelatedPerformance>::iterator edBeacon = 
+        mcBeacon->second.edBeaconRelatedPerformance.find (ucAddress);
+      if (edBeacon != mcBeacon->second.edBeaconRelatedPerformance.end ())
+        {
+          record.beacon = &edBeacon->second;
+        }
+    }
+  
+  return record;
+}
+
 
 
 ///////////////////////////////////////////
@@ -293,15 +329,19 @@ LoraClassBAnalyzer::McPingSentCallback (LoraDeviceAddress mcAddress, uint8_t num
   
   NS_LOG_DEBUG ("Packet Sent UID : " << packet->GetUid ());
   
-  if (m_mcNsDownlinkRelatedPerformance.find (mcAddress) == m_mcNsDownlinkRelatedPerformance.end ())
+  std::map<LoraDeviceAddress, struct NsDownlinkRelatedPerformance>::iterator it = 
+    m_mcNsDownlinkRelatedPerformance.find (mcAddress);
+  if (it == m_mcNsDownlinkRelatedPerformance.end ())
     {
       NS_ASSERT_MSG (false, "Multicast address not found");
+      return;
     }
+  struct NsDownlinkRelatedPerformance& nsPerformance = it->second;
   
   // Check about the reception of the previous packet that is sent before updating
   // to find lost packets and update information accordingly
   // if it is the first packet that is being sent, skip processing
-  if (m_mcNsDownlinkRelatedPerformance.at (mcAddress).totalBytesSent != 0)
+  if (nsPerformance.totalBytesSent != 0)
     {
       ProcessPreviousPacketStatus (mcAddress);  
     }
@@ -313,28 +353,29 @@ LoraClassBAnalyzer::McPingSentCallback (LoraDeviceAddress mcAddress, uint8_t num
   m_totalFragementsSentbyNs++;
   
   // Add the new packet to the list
-  m_mcNsDownlinkRelatedPerformance.at (mcAddress).latestPacketSent = packet->Copy ();
-  m_mcNsDownlinkRelatedPerformance.at (mcAddress).totalBytesSent += size;
-  m_mcNsDownlinkRelatedPerformance.at (mcAddress).numberOfFragmentsSentbyNs += 1;
-  m_mcNsDownlinkRelatedPerformance.at (mcAddress).cummulativeNumberOfGwsForAllTransmissions += numberOfGateways;
-  m_mcNsDownlinkRelatedPerformance.at (mcAddress).avarageNumberOfGwsUsed = 
-    m_mcNsDownlinkRelatedPerformance.at (mcAddress).cummulativeNumberOfGwsForAllTransmissions /
-    m_mcNsDownlinkRelatedPerformance.at (mcAddress).numberOfFragmentsSentbyNs;
-  uint8_t currentMinimumGwsUsed = m_mcNsDownlinkRelatedPerformance.at (mcAddress).minimumNumberOfGwsUsed;
+  nsPerformance.latestPacketSentUid = packet->GetUid ();
+  nsPerformance.latestPacketSentSize = size;
+  nsPerformance.totalBytesSent += size;
+  nsPerformance.numberOfFragmentsSentbyNs += 1;
+  nsPerformance.cummulativeNumberOfGwsForAllTransmissions += numberOfGateways;
+  nsPerformance.avarageNumberOfGwsUsed = 
+    nsPerformance.cummulativeNumberOfGwsForAllTransmissions /
+    nsPerformance.numberOfFragmentsSentbyNs;
+  uint8_t currentMinimumGwsUsed = nsPerformance.minimumNumberOfGwsUsed;
   
   // if it is still zero that means that this is being called for the first time
   if (currentMinimumGwsUsed == 0)
     {
       currentMinimumGwsUsed = std::numeric_limits<uint8_t>::max ();
     }
-  uint8_t currentMaximumGwsUsed = m_mcNsDownlinkRelatedPerformance.at (mcAddress).maximumNumberOfGwsUsed;
-  m_mcNsDownlinkRelatedPerformance.at (mcAddress).minimumNumberOfGwsUsed = std::min (currentMinimumGwsUsed, numberOfGateways);
-  m_mcNsDownlinkRelatedPerformance.at (mcAddress).maximumNumberOfGwsUsed = std::max (currentMaximumGwsUsed, numberOfGateways);
+  uint8_t currentMaximumGwsUsed = nsPerformance.maximumNumberOfGwsUsed;
+  nsPerformance.minimumNumberOfGwsUsed = std::min (currentMinimumGwsUsed, numberOfGateways);
+  nsPerformance.maximumNumberOfGwsUsed = std::max (currentMaximumGwsUsed, numberOfGateways);
   
   // Network throughput calculation
   // Throughput calculation for each multicast group
-  m_mcNsDownlinkRelatedPerformance.at (mcAddress).nSThroughput = (double)(m_mcNsDownlinkRelatedPerformance.at (mcAddress).totalBytesSent * 8)/
-                                                                  (Simulator::Now ().GetSeconds () - m_startTime.GetSeconds ());
+  nsPerformance.nSThroughput = (double)(nsPerformance.totalBytesSent * 8)/
+                                 (Simulator::Now ().GetSeconds () - m_startTime.GetSeconds ());
   
   // Overall NS performance
   m_aggregateNsThroughput = (double)(m_totalBytesSentbyNs*8)/(Simulator::Now ().GetSeconds () - m_startTime.GetSeconds ());
@@ -453,13 +494,46 @@ LoraClassBAnalyzer::DeviceClassChangeCallback (EndDeviceLoraMac::DeviceClass old
 void
 LoraClassBAnalyzer::ReceivedPingPacket (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, Ptr<const Packet> packet, uint8_t slotIndex)
 {
-  NS_LOG_FUNCTION (this << mcAddress << ucAddress << packet << slotIndex);
+  struct EdPerformanceRecord record = FindEdPerformanceRecord (mcAddress, ucAddress);
+  ReceivedPingPacketSink (&record, mcAddress, ucAddress, packet, slotIndex);
+}
+
+void
+LoraClassBAnalyzer::BeaconReceived (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, uint32_t numberOfBeaconsReceived)
+{
+  struct EdPerformanceRecord record = FindEdPerformanceRecord (mcAddress, ucAddress);
+  BeaconReceivedSink (&record, mcAddress, ucAddress, numberOfBeaconsReceived);
+}
+
+void
+LoraClassBAnalyzer::BeaconMissed (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, uint32_t currentMissedBeacons)
+{
+  struct EdPerformanceRecord record = FindEdPerformanceRecord (mcAddress, ucAddress);
+  BeaconMissedSink (&record, mcAddress, ucAddress, currentMissedBeacons);
+}
+
+void
+LoraClassBAnalyzer::CurrentBeaconMissedRunLength (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, uint8_t currentBeaconMissedRunLength)
+{
+  struct EdPerformanceRecord record = FindEdPerformanceRecord (mcAddress, ucAddress);
+  CurrentBeaconMissedRunLengthSink (&record, mcAddress, ucAddress, currentBeaconMissedRunLength);
+}
+
+void
+LoraClassBAnalyzer::NumberOfOverhearedPackets (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, uint32_t numberOfOverheardPacket)
+{
+  struct EdPerformanceRecord record = FindEdPerformanceRecord (mcAddress, ucAddress);
+  NumberOfOverhearedPacketsSink (&record, mcAddress, ucAddress, numberOfOverheardPacket);
+}
+
+void
+LoraClassBAnalyzer::ReceivedPingPacketSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                            LoraDeviceAddress ucAddress, Ptr<const Packet> packet, uint8_t slotIndex)
+{
+  NS_LOG_FUNCTION (record->analyzer << mcAddress << ucAddress << packet << slotIndex);
   NS_LOG_DEBUG ("Ping Packet Received UID : " << packet->GetUid ());
   
-  uint32_t size = packet->GetSize ();
-  
-  
-  if (m_mcEdDownlinkRelatedPerformance.find (mcAddress) == m_mcEdDownlinkRelatedPerformance.end ())
+  if (record->downlink == 0)
     {
       if (mcAddress == 1)
         {
@@ -468,36 +542,22 @@ LoraClassBAnalyzer::ReceivedPingPacket (LoraDeviceAddress mcAddress, LoraDeviceA
           NS_LOG_WARN ("Unicast devices not analyzed for now! Future update");
           return;
         }
-      
-       NS_ASSERT_MSG (false, "Multicast address not found");
-    }
-  
-  if (m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance
-        .find (ucAddress) ==  m_mcEdDownlinkRelatedPerformance.at (mcAddress)
-                                .edDownlinkRelatedPerformance.end())
-    {
-       NS_ASSERT_MSG (false, "Device not found");  
+      NS_ASSERT_MSG (false, "Multicast address not found");
+      return;
     }
-  //Add the received packet to the device
-  m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance
-      .at (ucAddress).latestPacketReceived = packet->Copy ();
+  NS_ASSERT_MSG (mcAddress == record->mcAddress && ucAddress == record->ucAddress, 
+                 "Multicast address of the device changed after connecting the analyzer");
   
-  //May be member function of the structure that will help in inserting and searching
-  
-  uint32_t currentTotalBytes = m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance
-                                .at (ucAddress).totalBytesReceived += size;  
-  m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance
-      .at (ucAddress).totalNumberOfFragmentsReceived += 1;
-  m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance
-        .at (ucAddress).throughput = (double)(currentTotalBytes*8)/ (Simulator::Now ().GetSeconds () - m_startTime.GetSeconds ()); 
+  record->analyzer->DoReceivedPingPacket (*record->downlink, packet);
 }
 
 void
-LoraClassBAnalyzer::BeaconReceived (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, uint32_t numberOfBeaconsReceived)
+LoraClassBAnalyzer::BeaconReceivedSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                        LoraDeviceAddress ucAddress, uint32_t numberOfBeaconsReceived)
 {
-  NS_LOG_FUNCTION (this << mcAddress << ucAddress << numberOfBeaconsReceived);  
+  NS_LOG_FUNCTION (record->analyzer << mcAddress << ucAddress << numberOfBeaconsReceived);
   
-  if (m_mcEdBeaconRelatedPerformance.find (mcAddress) == m_mcEdBeaconRelatedPerformance.end())
+  if (record->beacon == 0)
     {
       if (mcAddress == 1)
         {
@@ -505,31 +565,21 @@ LoraClassBAnalyzer::BeaconReceived (LoraDeviceAddress mcAddress, LoraDeviceAddre
           //\TODO  In the future add it to the unicast list 
           NS_LOG_WARN ("Unicast devices not analyzed for now! Future update");
           return;
-        }    
+        }
       NS_ASSERT_MSG (false, "Multicast address not found");
+      return;
     }
-  if (m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance
-        .find (ucAddress) == m_mcEdBeaconRelatedPerformance.at (mcAddress)
-                              .edBeaconRelatedPerformance.end ())
-    {
-      NS_ASSERT_MSG (false, "Device not found");
-    }
-
-m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).totalBeaconReceived++;
-
-m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).brr = 
-   m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).totalBeaconReceived / 
-    (m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).totalBeaconReceived +
-     m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).totalBeaconLost);
   
+  record->analyzer->DoBeaconReceived (*record->beacon);
 }
 
 void
-LoraClassBAnalyzer::BeaconMissed (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, uint32_t currentMissedBeacons)
+LoraClassBAnalyzer::BeaconMissedSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                      LoraDeviceAddress ucAddress, uint32_t currentMissedBeacons)
 {
-  NS_LOG_FUNCTION (this << mcAddress << ucAddress << currentMissedBeacons);
+  NS_LOG_FUNCTION (record->analyzer << mcAddress << ucAddress << currentMissedBeacons);
   
-  if (m_mcEdBeaconRelatedPerformance.find (mcAddress) == m_mcEdBeaconRelatedPerformance.end())
+  if (record->beacon == 0)
     {
       if (mcAddress == 1)
         {
@@ -539,30 +589,19 @@ LoraClassBAnalyzer::BeaconMissed (LoraDeviceAddress mcAddress, LoraDeviceAddress
           return;
         }
       NS_ASSERT_MSG (false, "Multicast address not found");
+      return;
     }
-  if (m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance
-        .find (ucAddress) == m_mcEdBeaconRelatedPerformance.at (mcAddress)
-                              .edBeaconRelatedPerformance.end ())
-    {
-      NS_ASSERT_MSG (false, "Device not found");
-    }  
-  
-  m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).totalBeaconLost++;
-  m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).brr = 
-     m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).totalBeaconReceived / 
-      (m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).totalBeaconReceived +
-       m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance.at (ucAddress).totalBeaconLost);
-  
   
+  record->analyzer->DoBeaconMissed (*record->beacon);
 }
 
 void
-LoraClassBAnalyzer::CurrentBeaconMissedRunLength (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, uint8_t currentBeaconMissedRunLength)
+LoraClassBAnalyzer::CurrentBeaconMissedRunLengthSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                                      LoraDeviceAddress ucAddress, uint8_t currentBeaconMissedRunLength)
 {
-  NS_LOG_FUNCTION (this << mcAddress << ucAddress << currentBeaconMissedRunLength);
-  
+  NS_LOG_FUNCTION (record->analyzer << mcAddress << ucAddress << currentBeaconMissedRunLength);
   
-  if (m_mcEdBeaconRelatedPerformance.find (mcAddress) == m_mcEdBeaconRelatedPerformance.end())
+  if (record->beacon == 0)
     {
       if (mcAddress == 1)
         {
@@ -570,85 +609,21 @@ LoraClassBAnalyzer::CurrentBeaconMissedRunLength (LoraDeviceAddress mcAddress, L
           //\TODO  In the future add it to the unicast list 
           NS_LOG_WARN ("Unicast devices not analyzed for now! Future update");
           return;
-        }    
+        }
       NS_ASSERT_MSG (false, "Multicast address not found");
-    }
-  if (m_mcEdBeaconRelatedPerformance.at (mcAddress).edBeaconRelatedPerformance
-        .find (ucAddress) == m_mcEdBeaconRelatedPerformance.at (mcAddress)
-                              .edBeaconRelatedPerformance.end ())
-    {
-      NS_ASSERT_MSG (false, "Device not found");
-    }
-
-  if (m_mcEdBeaconRelatedPerformance
-        .at (mcAddress).edBeaconRelatedPerformance
-                          .at (ucAddress).lastBeaconLossRunLength != 0
-      &&
-      currentBeaconMissedRunLength == 0)
-    {
-      //  Selecting the maximum beaconless operation mode
-      m_mcEdBeaconRelatedPerformance
-        .at (mcAddress).edBeaconRelatedPerformance
-                          .at (ucAddress).maximumBeaconLostInBeaconlessOperationMode = 
-        std::max (m_mcEdBeaconRelatedPerformance
-                    .at (mcAddress).edBeaconRelatedPerformance
-                                      .at (ucAddress).maximumBeaconLostInBeaconlessOperationMode,
-                  m_mcEdBeaconRelatedPerformance
-                    .at (mcAddress).edBeaconRelatedPerformance
-                                      .at (ucAddress).lastBeaconLossRunLength);
-      
-      //  Selecting the minimum beaconless operation mode
-      m_mcEdBeaconRelatedPerformance
-        .at (mcAddress).edBeaconRelatedPerformance
-                          .at (ucAddress).minimumBeaconLostInBeaconlessOperationMode = 
-        m_mcEdBeaconRelatedPerformance
-                    .at (mcAddress).edBeaconRelatedPerformance
-                                      .at (ucAddress).minimumBeaconLostInBeaconlessOperationMode == 0 ?
-                                        m_mcEdBeaconRelatedPerformance
-                                          .at (mcAddress).edBeaconRelatedPerformance
-                                                            .at (ucAddress).lastBeaconLossRunLength :                                
-                                        std::min (m_mcEdBeaconRelatedPerformance
-                                                    .at (mcAddress).edBeaconRelatedPerformance
-                                                                      .at (ucAddress).minimumBeaconLostInBeaconlessOperationMode,
-                                                  m_mcEdBeaconRelatedPerformance
-                                                    .at (mcAddress).edBeaconRelatedPerformance
-                                                                      .at (ucAddress).lastBeaconLossRunLength);      
-      //  Calculating the average beaconless operation mode                        
-      m_mcEdBeaconRelatedPerformance
-        .at (mcAddress).edBeaconRelatedPerformance
-                          .at (ucAddress).totalBeaconLostInBeaconlessOperationMode +=
-                            m_mcEdBeaconRelatedPerformance
-                              .at (mcAddress).edBeaconRelatedPerformance
-                                                .at (ucAddress).lastBeaconLossRunLength;
-      
-      m_mcEdBeaconRelatedPerformance
-      .at (mcAddress).edBeaconRelatedPerformance
-                        .at (ucAddress).numberOfSwitchToBeaconLessOperationModes++;  
-      
-      m_mcEdBeaconRelatedPerformance
-        .at (mcAddress).edBeaconRelatedPerformance
-                          .at (ucAddress).averageBeaconLostInBeaconlessOperationMode = 
-                          (double)m_mcEdBeaconRelatedPerformance
-                                    .at (mcAddress).edBeaconRelatedPerformance
-                                                      .at (ucAddress).totalBeaconLostInBeaconlessOperationMode /
-                                  m_mcEdBeaconRelatedPerformance
-                                    .at (mcAddress).edBeaconRelatedPerformance
-                                                      .at (ucAddress).numberOfSwitchToBeaconLessOperationModes;
-        
+      return;
     }
   
-  m_mcEdBeaconRelatedPerformance
-    .at (mcAddress).edBeaconRelatedPerformance
-                      .at (ucAddress).lastBeaconLossRunLength =   currentBeaconMissedRunLength;
-                          
+  record->analyzer->DoCurrentBeaconMissedRunLength (*record->beacon, currentBeaconMissedRunLength);
 }
 
 void
-LoraClassBAnalyzer::NumberOfOverhearedPackets (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, uint32_t numberOfOverheardPacket)
+LoraClassBAnalyzer::NumberOfOverhearedPacketsSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                                   LoraDeviceAddress ucAddress, uint32_t numberOfOverheardPacket)
 {
-  NS_LOG_FUNCTION (this << mcAddress << ucAddress << numberOfOverheardPacket);
+  NS_LOG_FUNCTION (record->analyzer << mcAddress << ucAddress << numberOfOverheardPacket);
   
-  if (m_mcEdDownlinkRelatedPerformance.find (mcAddress) == m_mcEdDownlinkRelatedPerformance.end ())
+  if (record->downlink == 0)
     {
       if (mcAddress == 1)
         {
@@ -657,20 +632,84 @@ LoraClassBAnalyzer::NumberOfOverhearedPackets (LoraDeviceAddress mcAddress, Lora
           NS_LOG_WARN ("Unicast devices not analyzed for now! Future update");
           return;
         }
-      
-       NS_ASSERT_MSG (false, "Multicast address not found");
+      NS_ASSERT_MSG (false, "Multicast address not found");
+      return;
     }
   
-  if (m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance
-        .find (ucAddress) ==  m_mcEdDownlinkRelatedPerformance.at (mcAddress)
-                                .edDownlinkRelatedPerformance.end())
+  //Update number of overheard packet
+  record->downlink->numberOfOverhearedPackets = numberOfOverheardPacket;
+}
+
+void
+LoraClassBAnalyzer::ImageCompleteSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress,
+                                       LoraDeviceAddress ucAddress, Time timeToComplete, uint32_t fragmentsReceived)
+{
+  NS_LOG_FUNCTION (record->analyzer << mcAddress << ucAddress << timeToComplete << fragmentsReceived);
+  
+  if (record->downlink == 0)
     {
-       NS_ASSERT_MSG (false, "Device not found");  
+      NS_LOG_WARN ("Unicast devices not analyzed for now! Future update");
+      return;
     }
   
-  //Update number of overheard packet
-  m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance
-      .at (ucAddress).numberOfOverhearedPackets = numberOfOverheardPacket;
+  record->downlink->imageComplete = true;
+  record->downlink->timeToCompleteImage = timeToComplete;
+  record->downlink->fragmentsToCompleteImage = fragmentsReceived;
+}
+
+void
+LoraClassBAnalyzer::DoReceivedPingPacket (struct EdDownlinkRelatedPerformance& record, Ptr<const Packet> packet)
+{
+  uint32_t size = packet->GetSize ();
+  
+  //Add the received packet to the device
+  record.anyPacketReceived = true;
+  record.latestPacketReceivedUid = packet->GetUid ();
+  
+  record.totalBytesReceived += size;
+  record.totalNumberOfFragmentsReceived += 1;
+  record.throughput = (double)(record.totalBytesReceived*8)/ (Simulator::Now ().GetSeconds () - m_startTime.GetSeconds ()); 
+}
+
+void
+LoraClassBAnalyzer::DoBeaconReceived (struct EdBeaconRelatedPerformance& record)
+{
+  record.totalBeaconReceived++;
+  record.brr = record.totalBeaconReceived / (record.totalBeaconReceived + record.totalBeaconLost);
+}
+
+void
+LoraClassBAnalyzer::DoBeaconMissed (struct EdBeaconRelatedPerformance& record)
+{
+  record.totalBeaconLost++;
+  record.brr = record.totalBeaconReceived / (record.totalBeaconReceived + record.totalBeaconLost);
+}
+
+void
+LoraClassBAnalyzer::DoCurrentBeaconMissedRunLength (struct EdBeaconRelatedPerformance& record, uint8_t currentBeaconMissedRunLength)
+{
+  if (record.lastBeaconLossRunLength != 0 && currentBeaconMissedRunLength == 0)
+    {
+      //  Selecting the maximum beaconless operation mode
+      record.maximumBeaconLostInBeaconlessOperationMode = 
+        std::max (record.maximumBeaconLostInBeaconlessOperationMode, record.lastBeaconLossRunLength);
+      
+      //  Selecting the minimum beaconless operation mode
+      record.minimumBeaconLostInBeaconlessOperationMode = 
+        record.minimumBeaconLostInBeaconlessOperationMode == 0 ?
+          record.lastBeaconLossRunLength :
+          std::min (record.minimumBeaconLostInBeaconlessOperationMode, record.lastBeaconLossRunLength);
+      
+      //  Calculating the average beaconless operation mode                        
+      record.totalBeaconLostInBeaconlessOperationMode += record.lastBeaconLossRunLength;
+      
+      record.numberOfSwitchToBeaconLessOperationModes++;  
+      
+      record.averageBeaconLostInBeaconlessOperationMode = 
+        (double)record.totalBeaconLostInBeaconlessOperationMode / record.numberOfSwitchToBeaconLessOperationModes;
+    }
+  
+  record.lastBeaconLossRunLength = currentBeaconMissedRunLength;
 }
 
 void
@@ -766,23 +805,27 @@ LoraClassBAnalyzer::ProcessPreviousPacketStatus (LoraDeviceAddress mcAddress)
 {
   NS_LOG_FUNCTION (this << mcAddress);
   
-  Ptr<Packet> packetSent = m_mcNsDownlinkRelatedPerformance.at (mcAddress).latestPacketSent;
+  const struct NsDownlinkRelatedPerformance& nsPerformance = m_mcNsDownlinkRelatedPerformance.at (mcAddress);
+  uint64_t packetSentUid = nsPerformance.latestPacketSentUid;
+  uint32_t packetSentSize = nsPerformance.latestPacketSentSize;
+  
+  std::map<LoraDeviceAddress, struct EdDownlinkRelatedPerformance>& edPerformance = 
+    m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance;
   
-  for (std::map<LoraDeviceAddress, struct EdDownlinkRelatedPerformance>::iterator it = 
-         m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance.begin (); 
-       it != m_mcEdDownlinkRelatedPerformance.at (mcAddress).edDownlinkRelatedPerformance.end ();
+  for (std::map<LoraDeviceAddress, struct EdDownlinkRelatedPerformance>::iterator it = edPerformance.begin (); 
+       it != edPerformance.end ();
        ++it)
     {
-      if ((*it).second.latestPacketReceived == 0 || ((*it).second.latestPacketReceived->GetUid () != packetSent->GetUid ()))
+      if (!(*it).second.anyPacketReceived || (*it).second.latestPacketReceivedUid != packetSentUid)
         {
           // the packet success run length has ended
-          NS_LOG_DEBUG ("Packet " << packetSent->GetUid () << " Not received by " << mcAddress << "(McAddress) and " << (*it).first << "(UnicastAdress)");
-          //NS_LOG_DEBUG ("LastPacketReceived "<<(*it).second.latestPacketReceived->GetUid ());
+          NS_LOG_DEBUG ("Packet " << packetSentUid << " Not received by " << mcAddress << "(McAddress) and " << (*it).first << "(UnicastAdress)");
+          //NS_LOG_DEBUG ("LastPacketReceived "<<(*it).second.latestPacketReceivedUid);
           // calculate information related to byte loss run-length
           if ( ((*it).second.currentByteSuccessRunLength != 0 &&
                 (*it).second.currentPacketSuccessRunLength != 0) 
                                   || 
-               ((*it).second.latestPacketReceived == 0 &&   //Check if packet reception start with a packet loss
+               (!(*it).second.anyPacketReceived &&   //Check if packet reception start with a packet loss
                 (*it).second.currentByteLossRunLength == 0) )
             {
               (*it).second.numberOfDiscontinuties++;
@@ -793,9 +836,9 @@ LoraClassBAnalyzer::ProcessPreviousPacketStatus (LoraDeviceAddress mcAddress)
             }
           
           // update information upon packet lost
-          (*it).second.currentByteLossRunLength += packetSent->GetSize ();
+          (*it).second.currentByteLossRunLength += packetSentSize;
           (*it).second.currentPacketLossRunLength += 1;
-          (*it).second.totalBytesLost += packetSent->GetSize ();
+          (*it).second.totalBytesLost += packetSentSize;
           (*it).second.totalNumberOfFragmentsLost += 1;    
           (*it).second.prr = (double)(*it).second.totalNumberOfFragmentsReceived /
                                ( (*it).second.totalNumberOfFragmentsLost + 
@@ -850,7 +893,7 @@ LoraClassBAnalyzer::ProcessPreviousPacketStatus (LoraDeviceAddress mcAddress)
             (*it).second.currentPacketLossRunLength = 0;
           }
         
-          (*it).second.currentByteSuccessRunLength += packetSent->GetSize ();
+          (*it).second.currentByteSuccessRunLength += packetSentSize;
           (*it).second.currentPacketSuccessRunLength += 1;
           
           (*it).second.prr = (double)(*it).second.totalNumberOfFragmentsReceived /
@@ -903,20 +946,15 @@ LoraClassBAnalyzer::FinalizeNsBeaconRelatedInformation (std::ostream& output, bo
   uint8_t pingDownlinkPacketSize = m_nSBeaconRelatedPerformance.networkScheduler->GetPingDownlinkPacketSize ();
   
   // All file name will have drAverage-periodicityAverage-pingDownlinkPacket-numberOfMulticastGroups format
-  std::ofstream beaconLog; //std::to_string(groupIndex)+
+  std::ostringstream beaconLog; //std::to_string(groupIndex)+
   std::string beaconLogLoc = m_verboseLocation+"NSBeaconLog"+std::to_string ((int)drAverage)+"-"
         +std::to_string ((int)periodicityAverage)+"-"+std::to_string ((int)pingDownlinkPacketSize) //packet size
         +"-"+std::to_string (numberOfMulticastGroups)+".csv";
   
   if (verbose)
     {
-      if (m_appendInformation)
+      if (!m_appendInformation)
         {
-          beaconLog.open (beaconLogLoc, std::ofstream::out | std::ofstream::app);
-        }
-      else
-        {
-          beaconLog.open (beaconLogLoc, std::ofstream::out | std::ofstream::trunc);
           //Add discription of the columns at the top of the csv
           beaconLog << "numberOfBeaconSent, numberOfBeaconSkipped, fractionOfBeaconSkipped, averageBeaconSkippedRunLength, maximumBeaconSkippedRunLength, minimumBeaconSkippedRunLength\n";
         }
@@ -930,7 +968,9 @@ LoraClassBAnalyzer::FinalizeNsBeaconRelatedInformation (std::ostream& output, bo
       beaconLog << m_nSBeaconRelatedPerformance.averageNumberOfContinuousBeaconsSkippedByNs << ", ";
       beaconLog << m_nSBeaconRelatedPerformance.maximumNumberOfContinuousBeaconsSkippedByNs << ", ";
       beaconLog << m_nSBeaconRelatedPerformance.minimumNumberOfContinuousBeaconsSkippedByNs << "\n";
-      beaconLog.close ();      
+      
+      m_logWriter.Open (beaconLogLoc, m_appendInformation);
+      m_logWriter.Write (beaconLogLoc, beaconLog.str ());
     }
   
 }
@@ -943,6 +983,25 @@ LoraClassBAnalyzer::FinalizeNsDownlinkRelatedInformation (std::ostream& output,
   output << "Total fragments sent by NS : "<< m_totalFragementsSentbyNs << std::endl;
   output << "Total bytes send by Ns : " << m_totalBytesSentbyNs << std::endl;
   output << "Aggregate Network Throughput (bits/Sec) : " << m_aggregateNsThroughput << std::endl;
+  
+  //The downlinks of all the classes share the gateways
+  Ptr<NetworkScheduler> networkScheduler = m_nSBeaconRelatedPerformance.networkScheduler;
+  if (networkScheduler != 0)
+    {
+      std::vector<std::pair<GatewayStatus::DownlinkClass, std::string> > downlinkClasses = 
+        {{GatewayStatus::BEACON, "Beacons"}, 
+         {GatewayStatus::CLASS_A_REPLY, "Class A replies"},
+         {GatewayStatus::CLASS_B_UNICAST, "Class B unicast pings"},
+         {GatewayStatus::CLASS_B_MULTICAST, "Class B multicast pings"}};
+      output << "Downlinks sent per class (sent/tried, success rate) :" << std::endl;
+      for (auto& downlinkClass : downlinkClasses)
+        {
+          output << "   " << downlinkClass.second << " : " 
+                 << networkScheduler->GetNSentDownlinks (downlinkClass.first) << "/" 
+                 << networkScheduler->GetNDownlinks (downlinkClass.first) << ", " 
+                 << networkScheduler->GetDownlinkSuccessRate (downlinkClass.first) << std::endl;
+        }
+    }
 }
 
 
@@ -1068,29 +1127,19 @@ LoraClassBAnalyzer::FinalizeEdsDownlinkRelatedInformation (std::ostream& output,
       
       //Logging total number of overheard packets and correctly received packets
       // All file name will have drAverage-periodicityAverage-pingDownlinkPacket-numberOfMulticastGroups format
-      std::ofstream overhearingLog; //std::to_string(groupIndex)+
+      std::ostringstream overhearingLog; //std::to_string(groupIndex)+
       std::string overhearingLogLoc = m_verboseLocation+"OverhearingLog-"+std::to_string ((int)drAverage)+"-"
             +std::to_string ((int)periodicityAverage)+"-"+std::to_string (numberOfMulticastGroups)+".csv";
 
-      std::ofstream packetReceivedLog; //std::to_string(groupIndex)+
+      std::ostringstream packetReceivedLog; //std::to_string(groupIndex)+
       std::string packetReceivedLogLoc = m_verboseLocation+"PacketReceivedLog-"+std::to_string ((int)drAverage)+"-"
             +std::to_string ((int)periodicityAverage)+"-"+std::to_string (numberOfMulticastGroups)+".csv";   
       
-      std::ofstream throughputLog; //std::to_string(groupIndex)+
+      std::ostringstream throughputLog; //std::to_string(groupIndex)+
       std::string throughputLogLoc = m_verboseLocation+"throughputLog-"+std::to_string ((int)drAverage)+"-"
             +std::to_string ((int)periodicityAverage)+"-"+"-"+std::to_string (numberOfMulticastGroups)+".csv";        
-      if (m_appendInformation)
-        {
-          overhearingLog.open (overhearingLogLoc, std::ofstream::out | std::ofstream::app);
-          packetReceivedLog.open (packetReceivedLogLoc, std::ofstream::out | std::ofstream::app);
-          throughputLog.open (throughputLogLoc, std::ofstream::out | std::ofstream::app);
-        }
-      else
+      if (!m_appendInformation)
         {
-          overhearingLog.open (overhearingLogLoc, std::ofstream::out | std::ofstream::trunc);
-          packetReceivedLog.open (packetReceivedLogLoc, std::ofstream::out | std::ofstream::trunc);    
-          throughputLog.open (throughputLogLoc, std::ofstream::out | std::ofstream::trunc);
-          
           //Add discription of the column at the top of the csv files
           int multicastGroupIndex = 0;
           for (auto& mcGroup : m_mcEdDownlinkRelatedPerformance)
@@ -1159,6 +1208,13 @@ LoraClassBAnalyzer::FinalizeEdsDownlinkRelatedInformation (std::ostream& output,
           overhearingLog << "\n";
           packetReceivedLog << "\n";
           throughputLog << "\n";
+          
+          m_logWriter.Open (overhearingLogLoc, m_appendInformation);
+          m_logWriter.Open (packetReceivedLogLoc, m_appendInformation);
+          m_logWriter.Open (throughputLogLoc, m_appendInformation);
+          m_logWriter.Write (overhearingLogLoc, overhearingLog.str ());
+          m_logWriter.Write (packetReceivedLogLoc, packetReceivedLog.str ());
+          m_logWriter.Write (throughputLogLoc, throughputLog.str ());
     }           
   
   
@@ -1219,30 +1275,35 @@ LoraClassBAnalyzer::FinalizeEdsDownlinkRelatedInformation (std::ostream& output,
       double sdNonZeroPrr = 0;
       std::list<double> nonZeroPrrs;
       
+      //Time to complete the image of the fragmentation session, if any
+      uint32_t numberOfCompleteImages = 0;
+      double averageTimeToCompleteImage = 0;
+      double maxTimeToCompleteImage = 0;
+      
       
       // Logging prr, throughput, maximum packet loss run lenghth, average packet loss run length
       // for each member in a multicast group (indicated by a groupIndex).
       // Each column in a file is for each member that belong to the multicast group.
       // All file name will have groupIndex-dr-periodicity-numberOfEds format
-      std::ofstream prr; 
+      std::ostringstream prr; 
       std::string prrLoc = m_verboseLocation+"prr"+std::to_string(groupIndex)+"-"
         +std::to_string ((int)mcGroup.second.dr)+"-"+std::to_string ((int)mcGroup.second.periodicity)
         +"-"+std::to_string (mcGroup.second.numberOfEds)+".csv";
-      std::ofstream throughput;
+      std::ostringstream throughput;
       std::string throughputLoc = m_verboseLocation+"throughput"+std::to_string(groupIndex)+"-"
         +std::to_string ((int)mcGroup.second.dr)+"-"+std::to_string ((int)mcGroup.second.periodicity)
         +"-"+std::to_string (mcGroup.second.numberOfEds)+".csv";
-      std::ofstream maxPacketLossRunLength;
+      std::ostringstream maxPacketLossRunLength;
       std::string maxPacketLossRunLengthLoc = m_verboseLocation+"maxPacketLossRunLength"+std::to_string(groupIndex)+"-"
         +std::to_string ((int)mcGroup.second.dr)+"-"+std::to_string ((int)mcGroup.second.periodicity)
         +"-"+std::to_string (mcGroup.second.numberOfEds)+".csv";
-      std::ofstream avgPacketLossRunLength;
+      std::ostringstream avgPacketLossRunLength;
       std::string avgPacketLossRunLengthLoc = m_verboseLocation+"avgPacketLossRunLength"+std::to_string(groupIndex)+"-"
         +std::to_string ((int)mcGroup.second.dr)+"-"+std::to_string ((int)mcGroup.second.periodicity)
         +"-"+std::to_string (mcGroup.second.numberOfEds)+".csv";        
       
       //Average of PRRs,Average of PRR (without considering Eds with 0 PRRs), SDs (without considering Eds with 0 PRRs) of PRR
-      std::ofstream prrAvgSd;
+      std::ostringstream prrAvgSd;
       std::string prrAvgSdLoc = m_verboseLocation+"/summary"+"prr-prr-sd"+std::to_string(groupIndex)+"-"
         +std::to_string ((int)mcGroup.second.dr)+"-"+std::to_string ((int)mcGroup.second.periodicity)
         +"-"+std::to_string (mcGroup.second.numberOfEds)+".csv";    
@@ -1251,24 +1312,8 @@ LoraClassBAnalyzer::FinalizeEdsDownlinkRelatedInformation (std::ostream& output,
       
       if (verbose)
         {
-          if (m_appendInformation)
-            {  
-              // performance per member in a group
-              prr.open (prrLoc, std::ofstream::out | std::ofstream::app); 
-              throughput.open (throughputLoc, std::ofstream::out | std::ofstream::app); 
-              maxPacketLossRunLength.open (maxPacketLossRunLengthLoc, std::ofstream::out | std::ofstream::app); 
-              avgPacketLossRunLength.open (avgPacketLossRunLengthLoc, std::ofstream::out | std::ofstream::app);
-              prrAvgSd.open (prrAvgSdLoc, std::ofstream::out | std::ofstream::app);            
-            }
-          else 
+          if (!m_appendInformation)
             {
-              // performance per member in a group
-              prr.open (prrLoc, std::ofstream::out | std::ofstream::trunc); 
-              throughput.open (throughputLoc, std::ofstream::out | std::ofstream::trunc); 
-              maxPacketLossRunLength.open (maxPacketLossRunLengthLoc, std::ofstream::out | std::ofstream::trunc); 
-              avgPacketLossRunLength.open (avgPacketLossRunLengthLoc, std::ofstream::out | std::ofstream::trunc);
-              prrAvgSd.open (prrAvgSdLoc, std::ofstream::out | std::ofstream::trunc);      
-                    
               //Add discription of the column at the top of the csv files
               int multicastGroupIndex = 0;
               for (auto& mcGroup : m_mcEdDownlinkRelatedPerformance)
@@ -1316,6 +1361,20 @@ LoraClassBAnalyzer::FinalizeEdsDownlinkRelatedInformation (std::ostream& output,
               output << "       AveragePacketLostRunLength : " << device.second.averageNumberOfSequentialFragmentsLost << std::endl;
               output << "       MaximumPacketLostRunLength : " << device.second.maximumNumberOfSequentialFragmentsLost << std::endl;
               output << "       MinimumPacketLostRunLength : " << device.second.minimumNumberOfSequentialFragmentsLost << std::endl; 
+              
+              if (device.second.imageComplete)
+                {
+                  output << "       TimeToCompleteImage(s) : " << device.second.timeToCompleteImage.GetSeconds () << std::endl;
+                  output << "       FragmentsToCompleteImage : " << device.second.fragmentsToCompleteImage << std::endl;
+                }
+            }
+          
+          if (device.second.imageComplete)
+            {
+              numberOfCompleteImages++;
+              averageTimeToCompleteImage += device.second.timeToCompleteImage.GetSeconds ();
+              maxTimeToCompleteImage = std::max (maxTimeToCompleteImage,
+                                                 device.second.timeToCompleteImage.GetSeconds ());
             }
 
           numberOfDevices++;
@@ -1388,7 +1447,7 @@ LoraClassBAnalyzer::FinalizeEdsDownlinkRelatedInformation (std::ostream& output,
           
       }
       
-      // close the file if verbose
+      // hand the rows over to the writer if verbose
       if (verbose)
         {
           prr << "\n";
@@ -1396,11 +1455,14 @@ LoraClassBAnalyzer::FinalizeEdsDownlinkRelatedInformation (std::ostream& output,
           maxPacketLossRunLength << "\n";
           avgPacketLossRunLength << "\n";
         
-          
-          prr.close (); 
-          throughput.close (); 
-          maxPacketLossRunLength.close (); 
-          avgPacketLossRunLength.close ();           
+          m_logWriter.Open (prrLoc, m_appendInformation);
+          m_logWriter.Open (throughputLoc, m_appendInformation);
+          m_logWriter.Open (maxPacketLossRunLengthLoc, m_appendInformation);
+          m_logWriter.Open (avgPacketLossRunLengthLoc, m_appendInformation);
+          m_logWriter.Write (prrLoc, prr.str ());
+          m_logWriter.Write (throughputLoc, throughput.str ());
+          m_logWriter.Write (maxPacketLossRunLengthLoc, maxPacketLossRunLength.str ());
+          m_logWriter.Write (avgPacketLossRunLengthLoc, avgPacketLossRunLength.str ());
         }
       
       NS_ASSERT_MSG (mcGroup.second.numberOfEds == numberOfDevices, "Counting of the number of Eds is not consistent");
@@ -1431,6 +1493,9 @@ LoraClassBAnalyzer::FinalizeEdsDownlinkRelatedInformation (std::ostream& output,
         {
           // Add to file
           prrAvgSd << averagePrr <<", " << averageNonZeroPrr << ", " << sdNonZeroPrr << "\n";
+          
+          m_logWriter.Open (prrAvgSdLoc, m_appendInformation);
+          m_logWriter.Write (prrAvgSdLoc, prrAvgSd.str ());
         }
 
       output << std::endl;  
@@ -1458,6 +1523,14 @@ LoraClassBAnalyzer::FinalizeEdsDownlinkRelatedInformation (std::ostream& output,
       output << "averageByteLostRunLength:" << averageByteLostRunLength << std::endl;
 //      output << "minByteLostRunLength:" << minByteLostRunLength << std::endl; ///< requires adjustment, gives zero if no packet is received, because run length not terminated by success is not includded
       output << "maxByteLostRunLength:" << maxByteLostRunLength << std::endl;
+      
+      if (numberOfCompleteImages > 0)
+        {
+          averageTimeToCompleteImage /= numberOfCompleteImages;
+          output << "completeImages:" << numberOfCompleteImages << std::endl;
+          output << "averageTimeToCompleteImage:" << averageTimeToCompleteImage << std::endl;
+          output << "maxTimeToCompleteImage:" << maxTimeToCompleteImage << std::endl;
+        }
     
       groupIndex++;
     }
@@ -1493,10 +1566,7 @@ LoraClassBAnalyzer::Analayze (Time appStopTime, std::ostringstream& simulationSe
   
   std::cout << nsOutput.str ();
   
-  std::ofstream nsfile;
-  nsfile.open (m_nsLogFileName, std::ofstream::out | std::ofstream::app);
-  nsfile << nsOutput.str ();
-  nsfile.close ();
+  m_logWriter.Write (m_nsLogFileName, nsOutput.str ());
 
   ///////////////////////////  
   std::stringstream edOutput;
@@ -1510,12 +1580,15 @@ LoraClassBAnalyzer::Analayze (Time appStopTime, std::ostringstream& simulationSe
   
   std::cout << edOutput.str ();
   
-  std::ofstream edfile;
-  edfile.open (m_edLogFileName, std::ofstream::out | std::ofstream::app);
-  edfile << edOutput.str ();
-  edfile.close ();
+  m_logWriter.Write (m_edLogFileName, edOutput.str ());
   
   ///////////////////////////
+  
+  // Make sure everything is on disk before returning
+  if (!m_logWriter.Flush ())
+    {
+      NS_LOG_ERROR ("Some of the analyzer logs could not be written");
+    }
 }
 
 
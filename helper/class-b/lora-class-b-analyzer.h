@@ -28,8 +28,10 @@
 #include "ns3/lora-device-address.h"
 #include "ns3/node-container.h"
 #include "ns3/end-device-class-b-app.h"
+#include "ns3/lora-log-writer.h"
 #include "src/lorawan/model/network-scheduler.h"
 #include <map>
+#include <list>
 #include <string>
 
 namespace ns3 {
@@ -220,6 +222,9 @@ public:
   /**
    * To analyze different metrics and log
    * 
+   * The logs are written in the background, this call returns only after
+   * they are all flushed to the files.
+   * 
    * \param appStopTime is the time where the application stop
    * \param simulationSetup information about the simulation setup of append before the output
    * \param nsVerbose enable verbose logging for the network server
@@ -227,7 +232,6 @@ public:
    */
   void Analayze (Time appStopTime, std::ostringstream& simulationSetup, bool nsVerbose, bool edVerbose);
   
-  
 private:
   
   std::string m_nsLogFileName;
@@ -247,6 +251,8 @@ private:
   
   bool m_appendInformation; ///< Whether to append to files when writting 
   
+  LoraLogWriter m_logWriter; ///< Background writer for all the log files of a run
+  
   Time m_startTime; ///< Time from which we start to analyze the performance including throughput 
   Time m_endTime;  ///<Time on which we end to analyze the performance including throughput
   
@@ -316,7 +322,8 @@ private:
     uint32_t avarageNumberOfGwsUsed = 0; ///< cummulativeNumberOfGwsForAllTransmissions/numberOfFragmentsSentbyNs
     uint32_t minimumNumberOfGwsUsed = 0; ///< Minimum number of Gws used per transmission
     
-    Ptr<Packet> latestPacketSent = 0; ///< The latest packet that is sent 
+    uint64_t latestPacketSentUid = 0; ///< The UID of the latest packet that is sent
+    uint32_t latestPacketSentSize = 0; ///< The size of the latest packet that is sent
   };
   
   std::map<LoraDeviceAddress, struct NsDownlinkRelatedPerformance> m_mcNsDownlinkRelatedPerformance; ///< Multicast Related Network Server Downlink Performance  
@@ -398,9 +405,14 @@ private:
     
     double prr = 0; ///<Packet reception ratio;
     
-    Ptr<Packet> latestPacketReceived = 0; ///< the latest packet that is received; this can be used to check lost packets from sent packets. 
+    bool anyPacketReceived = false; ///< Whether the device has received any packet yet
+    uint64_t latestPacketReceivedUid = 0; ///< the UID of the latest packet that is received; this is used to check lost packets from sent packets.
     
     uint32_t numberOfOverhearedPackets = 0; ///< Number of packets an end-device has overheared
+    
+    bool imageComplete = false; ///< Whether the image of the fragmentation session is decoded
+    Time timeToCompleteImage = Seconds (0); ///< From the first fragment received to the decoded image
+    uint32_t fragmentsToCompleteImage = 0; ///< Fragments received until the image is decoded
   };
   
   struct McEdDownlinkRelatedPerformance
@@ -450,6 +462,57 @@ private:
   
   uint32_t m_failedPings; // Total number of failed ping downlinks
   
+  /////////////////////////////////////////
+  // Pre-resolved end-device trace sinks //
+  ////////////////////////////////////////
+  
+  /**
+   * The performance records of a single multicast member, resolved once when
+   * the trace sinks are connected and bound to the sinks of that device.
+   * 
+   * downlink and beacon are left to 0 for devices that are not analyzed 
+   * (i.e. unicast devices).
+   */
+  struct EdPerformanceRecord
+  {
+    LoraClassBAnalyzer* analyzer = 0;
+    LoraDeviceAddress mcAddress;
+    LoraDeviceAddress ucAddress;
+    struct EdDownlinkRelatedPerformance* downlink = 0;
+    struct EdBeaconRelatedPerformance* beacon = 0;
+  };
+  
+  std::list<struct EdPerformanceRecord> m_edPerformanceRecords; ///< A list to keep the address of the records stable
+  
+  /**
+   * Look up the performance records of a device
+   * 
+   * \param mcAddress the multicast address of the device
+   * \param ucAddress the unicast address of the device
+   * \return the records, with null downlink and beacon records if the device is not analyzed
+   */
+  struct EdPerformanceRecord FindEdPerformanceRecord (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress);
+  
+  // Updates done on the pre-resolved records
+  void DoReceivedPingPacket (struct EdDownlinkRelatedPerformance& record, Ptr<const Packet> packet);
+  void DoBeaconReceived (struct EdBeaconRelatedPerformance& record);
+  void DoBeaconMissed (struct EdBeaconRelatedPerformance& record);
+  void DoCurrentBeaconMissedRunLength (struct EdBeaconRelatedPerformance& record, uint8_t currentBeaconMissedRunLength);
+  
+  // Trace sinks bound to the pre-resolved records of each device
+  static void ReceivedPingPacketSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                      LoraDeviceAddress ucAddress, Ptr<const Packet> packet, uint8_t slotIndex);
+  static void BeaconReceivedSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                  LoraDeviceAddress ucAddress, uint32_t numberOfBeaconsReceived);
+  static void BeaconMissedSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                LoraDeviceAddress ucAddress, uint32_t currentMissedBeacons);
+  static void CurrentBeaconMissedRunLengthSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                                LoraDeviceAddress ucAddress, uint8_t currentBeaconMissedRunLength);
+  static void NumberOfOverhearedPacketsSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress, 
+                                             LoraDeviceAddress ucAddress, uint32_t numberOfOverheardPacket);
+  static void ImageCompleteSink (struct EdPerformanceRecord* record, LoraDeviceAddress mcAddress,
+                                 LoraDeviceAddress ucAddress, Time timeToComplete, uint32_t fragmentsReceived);
+  
 };
 
 }
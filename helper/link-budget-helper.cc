@@ -0,0 +1,173 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/link-budget-helper.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/log.h"
+#include "ns3/object-factory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LinkBudgetHelper");
+
+LinkBudgetHelper::LinkBudgetHelper () :
+  m_nThreads (0)
+{
+}
+
+void
+LinkBudgetHelper::SetNThreads (uint32_t nThreads)
+{
+  m_nThreads = nThreads;
+}
+
+Ptr<LinkBudgetMatrix>
+LinkBudgetHelper::Compute (NodeContainer endDevices, NodeContainer gateways,
+                           Ptr<PropagationLossModel> loss) const
+{
+  NS_LOG_FUNCTION (this << endDevices.GetN () << gateways.GetN () << loss);
+
+  // Copy the ids and positions of the nodes, so that the workers don't touch
+  // the simulation objects
+  std::vector<uint32_t> deviceIds;
+  std::vector<Vector> devicePositions;
+  for (NodeContainer::Iterator it = endDevices.Begin (); it != endDevices.End (); ++it)
+    {
+      Ptr<MobilityModel> mobility = (*it)->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      deviceIds.push_back ((*it)->GetId ());
+      devicePositions.push_back (mobility->GetPosition ());
+    }
+
+  std::vector<uint32_t> gatewayIds;
+  std::vector<Vector> gatewayPositions;
+  for (NodeContainer::Iterator it = gateways.Begin (); it != gateways.End (); ++it)
+    {
+      Ptr<MobilityModel> mobility = (*it)->GetObject<MobilityModel> ();
+      NS_ASSERT (mobility != 0);
+      gatewayIds.push_back ((*it)->GetId ());
+      gatewayPositions.push_back (mobility->GetPosition ());
+    }
+
+  Ptr<LinkBudgetMatrix> matrix = Create<LinkBudgetMatrix> (deviceIds, gatewayIds);
+
+  uint32_t nThreads = m_nThreads;
+  if (nThreads == 0)
+    {
+      nThreads = std::max (1u, std::thread::hardware_concurrency ());
+    }
+  nThreads = std::max<uint32_t> (1, std::min<std::size_t> (nThreads, deviceIds.size ()));
+
+  // Each worker gets its own pair of mobility models and its own loss model,
+  // created here since object creation is not thread safe. The first worker
+  // runs on this thread and uses the given model.
+  std::vector<Ptr<ConstantPositionMobilityModel> > senders;
+  std::vector<Ptr<ConstantPositionMobilityModel> > receivers;
+  std::vector<Ptr<PropagationLossModel> > lossModels;
+  for (uint32_t t = 0; t < nThreads; t++)
+    {
+      senders.push_back (CreateObject<ConstantPositionMobilityModel> ());
+      receivers.push_back (CreateObject<ConstantPositionMobilityModel> ());
+      lossModels.push_back (t == 0 ? loss : CloneLossModel (loss));
+    }
+
+  // The end devices still to be done are taken from this counter
+  std::atomic<uint32_t> nextDevice (0);
+  LinkBudgetMatrix* losses = PeekPointer (matrix);
+
+  auto worker = [&] (uint32_t t)
+    {
+      Ptr<ConstantPositionMobilityModel> sender = senders[t];
+      Ptr<ConstantPositionMobilityModel> receiver = receivers[t];
+      PropagationLossModel* lossModel = PeekPointer (lossModels[t]);
+      for (uint32_t d = nextDevice++; d < devicePositions.size (); d = nextDevice++)
+        {
+          sender->SetPosition (devicePositions[d]);
+          for (uint32_t g = 0; g < gatewayPositions.size (); g++)
+            {
+              receiver->SetPosition (gatewayPositions[g]);
+              losses->SetLoss (d, g, -lossModel->CalcRxPower (0, sender, receiver));
+            }
+        }
+    };
+
+  std::vector<std::thread> threads;
+  for (uint32_t t = 1; t < nThreads; t++)
+    {
+      threads.push_back (std::thread (worker, t));
+    }
+  worker (0);
+  for (std::thread& thread : threads)
+    {
+      thread.join ();
+    }
+
+  NS_LOG_INFO ("Computed the losses of " << deviceIds.size () << " end devices to "
+                                         << gatewayIds.size () << " gateways with "
+                                         << nThreads << " threads");
+  return matrix;
+}
+
+Ptr<PropagationLossModel>
+LinkBudgetHelper::CloneLossModel (Ptr<PropagationLossModel> loss) const
+{
+  NS_LOG_FUNCTION (this << loss);
+
+  ObjectFactory factory;
+  TypeId tid = loss->GetInstanceTypeId ();
+  factory.SetTypeId (tid);
+
+  // Copy the attributes of the model and of its parents
+  for (TypeId current = tid; ; current = current.GetParent ())
+    {
+      for (uint32_t i = 0; i < current.GetAttributeN (); i++)
+        {
+          struct TypeId::AttributeInformation info = current.GetAttribute (i);
+          if (!(info.flags & TypeId::ATTR_GET) || !(info.flags & TypeId::ATTR_CONSTRUCT))
+            {
+              continue;
+            }
+          Ptr<AttributeValue> value = info.checker->Create ();
+          loss->GetAttribute (info.name, *value);
+          factory.Set (info.name, *value);
+        }
+      if (current.GetParent () == current)
+        {
+          break;
+        }
+    }
+
+  Ptr<PropagationLossModel> clone = factory.Create<PropagationLossModel> ();
+  Ptr<PropagationLossModel> next = loss->GetNext ();
+  if (next != 0)
+    {
+      clone->SetNext (CloneLossModel (next));
+    }
+  return clone;
+}
+
+}
+}
@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef LINK_BUDGET_HELPER_H
+#define LINK_BUDGET_HELPER_H
+
+#include "ns3/node-container.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/link-budget-matrix.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Computes the LinkBudgetMatrix between end devices and gateways
+ *
+ * The losses are computed in parallel by a pool of worker threads, each one
+ * taking the next end device that still has to be done. The workers only
+ * see copies of the positions of the nodes, and since the ns-3 loss models
+ * are not thread safe each extra worker gets its own clone of the loss
+ * model, built from the attributes of each model of the chain. Hence the
+ * model must be the deterministic part of the channel's chain (for instance
+ * a LogDistancePropagationLossModel) and be fully configured through its
+ * attributes, and logging must be disabled for it. Random or caching models,
+ * like the shadowing ones, are left out of the matrix and can be given to
+ * LoraChannel::SetLinkBudget as the residual model instead.
+ */
+class LinkBudgetHelper
+{
+public:
+  LinkBudgetHelper ();
+
+  /**
+   * Set the number of worker threads, the number of cores if 0 (the
+   * default)
+   */
+  void SetNThreads (uint32_t nThreads);
+
+  /**
+   * Compute the loss between each end device and each gateway
+   *
+   * \param endDevices the end devices, each one with a MobilityModel
+   * \param gateways the gateways, each one with a MobilityModel
+   * \param loss the deterministic loss model
+   * \return the matrix of the losses
+   */
+  Ptr<LinkBudgetMatrix> Compute (NodeContainer endDevices, NodeContainer gateways,
+                                 Ptr<PropagationLossModel> loss) const;
+
+private:
+  /**
+   * Create a copy of a loss model and of the models chained after it
+   *
+   * \param loss the loss model to copy
+   * \return a new model with the same type and attributes
+   */
+  Ptr<PropagationLossModel> CloneLossModel (Ptr<PropagationLossModel> loss) const;
+
+  uint32_t m_nThreads;
+};
+
+}
+}
+
+#endif /* LINK_BUDGET_HELPER_H */
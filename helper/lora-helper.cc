@@ -21,6 +21,8 @@
 #include "ns3/lora-helper.h"
 #include "ns3/log.h"
 
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 
 namespace ns3 {
@@ -30,6 +32,9 @@ NS_LOG_COMPONENT_DEFINE ("LoraHelper");
 
 LoraHelper::LoraHelper ()
 {
+  m_lastSetup.nDevices = 0;
+  m_lastSetup.nBatches = 0;
+  m_lastSetup.wallSeconds = 0;
 }
 
 LoraHelper::~LoraHelper ()
@@ -143,6 +148,148 @@ LoraHelper::Install ( const LoraPhyHelper &phy,
   return Install (phy, mac, NodeContainer (node));
 }
 
+NetDeviceContainer
+LoraHelper::InstallBulk (const LoraPhyHelper &phyHelper,
+                         const LoraMacHelper &macHelper,
+                         NodeContainer c, uint32_t batchSize)
+{
+  NS_LOG_FUNCTION (this << c.GetN () << batchSize);
+
+  NS_ASSERT (batchSize > 0);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+  // Resolve what does not depend on the node once
+  std::vector<TraceConnection> phyTraces;
+  std::vector<TraceConnection> macTraces;
+  if (m_packetTracker)
+    {
+      GetTrackerTraces (phyHelper.GetDeviceType (), phyTraces, macTraces);
+    }
+
+  NetDeviceContainer devices;
+  std::vector<Ptr<LoraNetDevice> > batchDevices;
+  std::vector<Ptr<LoraPhy> > batchPhys;
+  batchDevices.reserve (std::min (batchSize, c.GetN ()));
+  batchPhys.reserve (std::min (batchSize, c.GetN ()));
+
+  m_lastSetup.nDevices = 0;
+  m_lastSetup.nBatches = 0;
+
+  for (uint32_t first = 0; first < c.GetN (); first += batchSize)
+    {
+      uint32_t end = std::min (first + batchSize, c.GetN ());
+      batchDevices.clear ();
+      batchPhys.clear ();
+
+      for (uint32_t i = first; i < end; i++)
+        {
+          batchDevices.push_back (CreateObject<LoraNetDevice> ());
+        }
+
+      for (uint32_t i = first; i < end; i++)
+        {
+          Ptr<LoraNetDevice> device = batchDevices[i - first];
+          Ptr<LoraPhy> phy = phyHelper.Create (c.Get (i), device);
+          NS_ASSERT (phy != 0);
+          device->SetPhy (phy);
+          ConnectTraces (phy, phyTraces);
+          batchPhys.push_back (phy);
+        }
+
+      for (uint32_t i = first; i < end; i++)
+        {
+          Ptr<LoraNetDevice> device = batchDevices[i - first];
+          Ptr<LoraMac> mac = macHelper.Create (c.Get (i), device);
+          NS_ASSERT (mac != 0);
+          mac->SetPhy (batchPhys[i - first]);
+          device->SetMac (mac);
+          ConnectTraces (mac, macTraces);
+        }
+
+      for (uint32_t i = first; i < end; i++)
+        {
+          c.Get (i)->AddDevice (batchDevices[i - first]);
+          devices.Add (batchDevices[i - first]);
+        }
+
+      m_lastSetup.nDevices += end - first;
+      m_lastSetup.nBatches++;
+    }
+
+  std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now ();
+  m_lastSetup.wallSeconds = std::chrono::duration<double> (stop - start).count ();
+
+  NS_LOG_INFO ("Installed " << m_lastSetup.nDevices << " devices in " <<
+               m_lastSetup.nBatches << " batches in " << m_lastSetup.wallSeconds << " s");
+
+  return devices;
+}
+
+const LoraHelper::SetupReport&
+LoraHelper::GetLastSetupReport (void) const
+{
+  return m_lastSetup;
+}
+
+void
+LoraHelper::GetTrackerTraces (TypeId phyType, std::vector<TraceConnection> &phyTraces,
+                              std::vector<TraceConnection> &macTraces) const
+{
+  TraceConnection trace;
+  if (phyType == SimpleEndDeviceLoraPhy::GetTypeId ())
+    {
+      trace.name = "StartSending";
+      trace.callback = MakeCallback (&LoraPacketTracker::TransmissionCallback, m_packetTracker);
+      phyTraces.push_back (trace);
+
+      trace.name = "SentNewPacket";
+      trace.callback = MakeCallback (&LoraPacketTracker::MacTransmissionCallback, m_packetTracker);
+      macTraces.push_back (trace);
+      trace.name = "RequiredTransmissions";
+      trace.callback = MakeCallback (&LoraPacketTracker::RequiredTransmissionsCallback,
+                                     m_packetTracker);
+      macTraces.push_back (trace);
+    }
+  else if (phyType == SimpleGatewayLoraPhy::GetTypeId ())
+    {
+      trace.name = "ReceivedPacket";
+      trace.callback = MakeCallback (&LoraPacketTracker::PacketReceptionCallback, m_packetTracker);
+      phyTraces.push_back (trace);
+      trace.name = "LostPacketBecauseInterference";
+      trace.callback = MakeCallback (&LoraPacketTracker::InterferenceCallback, m_packetTracker);
+      phyTraces.push_back (trace);
+      trace.name = "LostPacketBecauseNoMoreReceivers";
+      trace.callback = MakeCallback (&LoraPacketTracker::NoMoreReceiversCallback, m_packetTracker);
+      phyTraces.push_back (trace);
+      trace.name = "LostPacketBecauseUnderSensitivity";
+      trace.callback = MakeCallback (&LoraPacketTracker::UnderSensitivityCallback,
+                                     m_packetTracker);
+      phyTraces.push_back (trace);
+      trace.name = "NoReceptionBecauseTransmitting";
+      trace.callback = MakeCallback (&LoraPacketTracker::LostBecauseTxCallback, m_packetTracker);
+      phyTraces.push_back (trace);
+
+      trace.name = "ReceivedPacket";
+      trace.callback = MakeCallback (&LoraPacketTracker::MacGwReceptionCallback, m_packetTracker);
+      macTraces.push_back (trace);
+    }
+}
+
+void
+LoraHelper::ConnectTraces (Ptr<Object> object, std::vector<TraceConnection> &traces)
+{
+  for (std::vector<TraceConnection>::iterator it = traces.begin (); it != traces.end (); ++it)
+    {
+      if (it->accessor == 0)
+        {
+          it->accessor = object->GetInstanceTypeId ().LookupTraceSourceByName (it->name);
+          NS_ASSERT_MSG (it->accessor != 0, "No trace source " << it->name);
+        }
+      it->accessor->ConnectWithoutContext (PeekPointer (object), it->callback);
+    }
+}
+
 void
 LoraHelper::EnablePacketTracking (std::string filename)
 {
@@ -28,8 +28,11 @@
 #include "ns3/net-device.h"
 #include "ns3/lora-net-device.h"
 #include "ns3/lora-packet-tracker.h"
+#include "ns3/trace-source-accessor.h"
 
 #include <ctime>
+#include <string>
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
@@ -73,6 +76,45 @@ public:
                                       const LoraMacHelper &macHelper,
                                       Ptr<Node> node) const;
 
+  /**
+   * The outcome of the last InstallBulk call
+   */
+  struct SetupReport
+  {
+    uint32_t nDevices;    ///< The number of installed devices
+    uint32_t nBatches;    ///< The number of batches they were created in
+    double wallSeconds;   ///< The wall time of the installation
+  };
+
+  /**
+   * Install LoraNetDevices on a large set of nodes
+   *
+   * The devices are the same as the ones of Install, but the work that does
+   * not depend on the node is only done once: the kind of device is resolved
+   * before the first node, and the trace sources of the packet tracker are
+   * looked up on the first PHY and MAC and then connected through their
+   * accessors. The nodes are processed in batches, where each step (the
+   * NetDevices, the PHYs, the MACs and the aggregation to the nodes) is run
+   * over the whole batch. The MACs are still created in the order of the
+   * nodes, so they draw the same random streams and addresses as with
+   * Install.
+   *
+   * \param phyHelper the PHY helper to create PHY objects
+   * \param macHelper the MAC helper to create MAC objects
+   * \param c the set of nodes on which a lora device must be created
+   * \param batchSize the number of nodes of a batch
+   * \returns a device container which contains all the devices created by this
+   * method.
+   */
+  NetDeviceContainer InstallBulk (const LoraPhyHelper &phyHelper,
+                                  const LoraMacHelper &macHelper,
+                                  NodeContainer c, uint32_t batchSize = 4096);
+
+  /**
+   * \return the outcome of the last InstallBulk call
+   */
+  const SetupReport& GetLastSetupReport (void) const;
+
   /**
    * Enable tracking of packets via trace sources
    *
@@ -95,6 +137,33 @@ public:
   LoraPacketTracker *m_packetTracker = 0;
 
   time_t m_oldtime;
+
+private:
+  /**
+   * A trace source of the packet tracker, with its accessor once resolved
+   */
+  struct TraceConnection
+  {
+    std::string name;
+    CallbackBase callback;
+    Ptr<const TraceSourceAccessor> accessor;
+  };
+
+  /**
+   * The trace sources of the packet tracker for the PHYs and MACs of the
+   * given kind of device
+   */
+  void GetTrackerTraces (TypeId phyType, std::vector<TraceConnection> &phyTraces,
+                         std::vector<TraceConnection> &macTraces) const;
+
+  /**
+   * Connect an object to the traces, resolving their accessors on the first
+   * call
+   */
+  static void ConnectTraces (Ptr<Object> object,
+                             std::vector<TraceConnection> &traces);
+
+  SetupReport m_lastSetup;
 };
 
 } //namespace ns3
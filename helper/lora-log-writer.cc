@@ -0,0 +1,249 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/lora-log-writer.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+// The writer thread never logs, since ns-3 logging is not thread safe
+NS_LOG_COMPONENT_DEFINE ("LoraLogWriter");
+
+LoraLogWriter::LoraLogWriter (uint32_t bufferSize) :
+  m_bufferSize (bufferSize),
+  m_submitted (0),
+  m_handled (0),
+  m_stop (false)
+{
+  NS_LOG_FUNCTION (this << bufferSize);
+
+  m_thread = std::thread (&LoraLogWriter::Run, this);
+}
+
+LoraLogWriter::~LoraLogWriter ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Close ();
+
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_stop = true;
+  }
+  m_requestCondition.notify_one ();
+  m_thread.join ();
+}
+
+void
+LoraLogWriter::Open (std::string fileName, bool append)
+{
+  NS_LOG_FUNCTION (this << fileName << append);
+
+  Request request;
+  request.type = Request::OPEN;
+  request.fileName = fileName;
+  request.append = append;
+  Submit (std::move (request));
+}
+
+void
+LoraLogWriter::Write (std::string fileName, std::string data)
+{
+  NS_LOG_FUNCTION (this << fileName << data.size ());
+
+  if (data.empty ())
+    {
+      return;
+    }
+
+  Request request;
+  request.type = Request::WRITE;
+  request.fileName = fileName;
+  request.data = std::move (data);
+  request.append = true;
+  Submit (std::move (request));
+}
+
+bool
+LoraLogWriter::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Request request;
+  request.type = Request::FLUSH;
+  request.append = true;
+  SubmitAndWait (std::move (request));
+
+  std::vector<std::string> failedFiles = GetFailedFiles ();
+  for (std::vector<std::string>::iterator it = failedFiles.begin (); it != failedFiles.end (); ++it)
+    {
+      NS_LOG_ERROR ("Failed to write to " << *it);
+    }
+  return failedFiles.empty ();
+}
+
+void
+LoraLogWriter::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Request request;
+  request.type = Request::CLOSE;
+  request.append = true;
+  SubmitAndWait (std::move (request));
+}
+
+std::vector<std::string>
+LoraLogWriter::GetFailedFiles (void)
+{
+  std::lock_guard<std::mutex> lock (m_mutex);
+  return m_failedFiles;
+}
+
+uint64_t
+LoraLogWriter::Submit (Request request)
+{
+  uint64_t sequenceNumber;
+  {
+    std::lock_guard<std::mutex> lock (m_mutex);
+    m_requests.push_back (std::move (request));
+    sequenceNumber = ++m_submitted;
+  }
+  m_requestCondition.notify_one ();
+  return sequenceNumber;
+}
+
+void
+LoraLogWriter::SubmitAndWait (Request request)
+{
+  uint64_t sequenceNumber = Submit (std::move (request));
+
+  std::unique_lock<std::mutex> lock (m_mutex);
+  m_doneCondition.wait (lock, [this, sequenceNumber] { return m_handled >= sequenceNumber; });
+}
+
+void
+LoraLogWriter::Run (void)
+{
+  std::deque<Request> batch;
+
+  while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_requestCondition.wait (lock, [this] { return m_stop || !m_requests.empty (); });
+        if (m_requests.empty () && m_stop)
+          {
+            return;
+          }
+        // Take everything that is pending, so that the submitters are only
+        // blocked for the time of a swap
+        batch.swap (m_requests);
+      }
+
+      for (std::deque<Request>::iterator it = batch.begin (); it != batch.end (); ++it)
+        {
+          Handle (*it);
+        }
+
+      {
+        std::lock_guard<std::mutex> lock (m_mutex);
+        m_handled += batch.size ();
+      }
+      m_doneCondition.notify_all ();
+      batch.clear ();
+    }
+}
+
+void
+LoraLogWriter::Handle (Request& request)
+{
+  switch (request.type)
+    {
+    case Request::OPEN:
+      GetFile (request.fileName, request.append);
+      break;
+    case Request::WRITE:
+      {
+        OpenFile* file = GetFile (request.fileName, true);
+        if (file != 0)
+          {
+            file->stream.write (request.data.data (), request.data.size ());
+          }
+        break;
+      }
+    case Request::FLUSH:
+    case Request::CLOSE:
+      for (std::map<std::string, std::unique_ptr<OpenFile> >::iterator it = m_files.begin ();
+           it != m_files.end (); ++it)
+        {
+          it->second->stream.flush ();
+          if (!it->second->stream.good ())
+            {
+              std::lock_guard<std::mutex> lock (m_mutex);
+              if (std::find (m_failedFiles.begin (), m_failedFiles.end (), it->first) == m_failedFiles.end ())
+                {
+                  m_failedFiles.push_back (it->first);
+                }
+            }
+        }
+      if (request.type == Request::CLOSE)
+        {
+          m_files.clear ();
+        }
+      break;
+    }
+}
+
+LoraLogWriter::OpenFile*
+LoraLogWriter::GetFile (const std::string& fileName, bool append)
+{
+  std::map<std::string, std::unique_ptr<OpenFile> >::iterator it = m_files.find (fileName);
+  if (it != m_files.end ())
+    {
+      return it->second.get ();
+    }
+
+  std::unique_ptr<OpenFile> file (new OpenFile ());
+  // The buffer has to be installed before opening the file
+  file->buffer.resize (m_bufferSize);
+  file->stream.rdbuf ()->pubsetbuf (file->buffer.data (), file->buffer.size ());
+  file->stream.open (fileName, std::ofstream::out | (append ? std::ofstream::app : std::ofstream::trunc));
+
+  if (!file->stream.is_open ())
+    {
+      std::lock_guard<std::mutex> lock (m_mutex);
+      if (std::find (m_failedFiles.begin (), m_failedFiles.end (), fileName) == m_failedFiles.end ())
+        {
+          m_failedFiles.push_back (fileName);
+        }
+      return 0;
+    }
+
+  OpenFile* openFile = file.get ();
+  m_files[fileName] = std::move (file);
+  return openFile;
+}
+
+}
+}
@@ -0,0 +1,175 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef LORA_LOG_WRITER_H
+#define LORA_LOG_WRITER_H
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Asynchronous, buffered writer for the log files of the analyzers
+ *
+ * The caller formats a whole block of output in memory and hands it over with
+ * Write. The blocks are written by a background thread, in the order in which
+ * they were submitted, to files that are opened only once per writer and that
+ * use a large stream buffer. Nothing is guaranteed to be on disk before Flush
+ * returns.
+ *
+ * The writer is not an ns-3 Object and it doesn't interact with the
+ * simulator, hence it can be used from any point of the simulation script.
+ */
+class LoraLogWriter
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param bufferSize the size in bytes of the stream buffer of each file
+   */
+  LoraLogWriter (uint32_t bufferSize = 1 << 20);
+
+  /**
+   * Flush everything that is pending, close the files and stop the writer
+   * thread.
+   */
+  ~LoraLogWriter ();
+
+  /**
+   * Register a file to write to
+   *
+   * The file is opened once, the first time it is registered: later calls
+   * with the same name are ignored until the writer is closed.
+   *
+   * \param fileName the name of the file
+   * \param append append to the file if true, truncate it if false
+   */
+  void Open (std::string fileName, bool append);
+
+  /**
+   * Queue a block of output for a file
+   *
+   * If the file was never registered with Open it is opened in append mode.
+   *
+   * \param fileName the name of the file
+   * \param data the formatted output
+   */
+  void Write (std::string fileName, std::string data);
+
+  /**
+   * Block until all the output queued so far is written to the files and
+   * the file buffers are flushed to the operating system.
+   *
+   * \return false if opening or writing any of the files failed
+   */
+  bool Flush (void);
+
+  /**
+   * Flush and close all the files. Files that are opened again after this
+   * call will be truncated or appended to depending on their new Open call.
+   */
+  void Close (void);
+
+  /**
+   * \return the names of the files that could not be opened or written
+   */
+  std::vector<std::string> GetFailedFiles (void);
+
+private:
+  /// Queued request for the writer thread
+  struct Request
+  {
+    enum Type
+    {
+      OPEN,
+      WRITE,
+      FLUSH,
+      CLOSE
+    } type;
+    std::string fileName;
+    std::string data;
+    bool append;
+  };
+
+  /// A file opened by the writer thread, along with its stream buffer
+  struct OpenFile
+  {
+    std::ofstream stream;
+    std::vector<char> buffer;
+  };
+
+  /**
+   * Queue a request and wake up the writer thread
+   *
+   * \return the sequence number of the request
+   */
+  uint64_t Submit (Request request);
+
+  /**
+   * Queue a request and wait for the writer thread to handle it
+   */
+  void SubmitAndWait (Request request);
+
+  /**
+   * The loop of the writer thread: it takes all the pending requests at once
+   * and handles them without holding the lock.
+   */
+  void Run (void);
+
+  /**
+   * Handle a single request, called by the writer thread only
+   */
+  void Handle (Request& request);
+
+  /**
+   * Get the file with the given name, opening it if needed. Called by the
+   * writer thread only.
+   */
+  OpenFile* GetFile (const std::string& fileName, bool append);
+
+  uint32_t m_bufferSize; ///< The stream buffer size of each file
+
+  std::mutex m_mutex; ///< Protects the members below, up to m_failedFiles
+  std::condition_variable m_requestCondition; ///< Signals new requests
+  std::condition_variable m_doneCondition; ///< Signals handled requests
+  std::deque<Request> m_requests; ///< Requests not taken by the writer thread yet
+  uint64_t m_submitted; ///< Sequence number of the last submitted request
+  uint64_t m_handled; ///< Sequence number of the last handled request
+  bool m_stop; ///< Whether the writer thread should exit
+  std::vector<std::string> m_failedFiles; ///< Files that could not be opened or written
+
+  std::map<std::string, std::unique_ptr<OpenFile> > m_files; ///< Owned by the writer thread
+
+  std::thread m_thread; ///< The writer thread
+};
+
+}
+}
+#endif /* LORA_LOG_WRITER_H */
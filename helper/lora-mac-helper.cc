@@ -64,6 +64,14 @@ LoraMacHelper::SetAddressGenerator (Ptr<LoraDeviceAddressGenerator> addrGen)
   m_addrGen = addrGen;
 }
 
+void
+LoraMacHelper::SetBeaconClock (Ptr<BeaconClock> beaconClock)
+{
+  NS_LOG_FUNCTION (this << beaconClock);
+
+  m_beaconClock = beaconClock;
+}
+
 void
 LoraMacHelper::SetRegion (enum LoraMacHelper::Regions region)
 {
@@ -88,6 +96,7 @@ LoraMacHelper::Create (Ptr<Node> node, Ptr<NetDevice> device) const
   if (m_deviceType == ED)
     {
       Ptr<EndDeviceLoraMac> edMac = mac->GetObject<EndDeviceLoraMac> ();
+      edMac->SetBeaconClock (m_beaconClock);
       switch (m_region)
         {
         case LoraMacHelper::EU:
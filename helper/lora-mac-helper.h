@@ -79,6 +79,12 @@ public:
    */
   void SetAddressGenerator (Ptr<LoraDeviceAddressGenerator> addrGen);
 
+  /**
+   * Set the clock through which the end device MACs created from now on
+   * schedule their beacon period events, 0 (the default) for none.
+   */
+  void SetBeaconClock (Ptr<BeaconClock> beaconClock);
+
   /**
    * Set the kind of MAC this helper will create.
    *
@@ -257,6 +263,7 @@ private:
   Ptr<LoraDeviceAddressGenerator> m_addrGen; //!< Pointer to the address generator to use
   enum DeviceType m_deviceType; //!< The kind of device to install
   enum Regions m_region; //!< The region in which the device will operate
+  Ptr<BeaconClock> m_beaconClock; //!< The clock shared by the end devices, if any
 };
 
 } //namespace ns3
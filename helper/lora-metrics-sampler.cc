@@ -0,0 +1,415 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/lora-metrics-sampler.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/gateway-lora-phy.h"
+#include "ns3/network-server.h"
+#include "ns3/network-scheduler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraMetricsSampler");
+
+LoraMetricsSampler::LoraMetricsSampler (std::string fileName, Time interval, enum OutputFormat format) :
+  m_fileName (fileName),
+  m_interval (interval),
+  m_format (format),
+  m_running (false),
+  m_pendingReplies (0),
+  m_maxPendingReplies (0),
+  m_beaconsSent (0),
+  m_beaconsBlocked (0)
+{
+  NS_LOG_FUNCTION (this << fileName << interval << format);
+
+  NS_ASSERT_MSG (interval > Seconds (0), "The sampling interval has to be positive");
+}
+
+LoraMetricsSampler::~LoraMetricsSampler ()
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_sampleEvent);
+}
+
+void
+LoraMetricsSampler::AddFrequency (double frequencyMHz)
+{
+  NS_LOG_FUNCTION (this << frequencyMHz);
+
+  NS_ASSERT_MSG (m_load.empty (), "Frequencies have to be added before Install");
+
+  if (std::find (m_frequencies.begin (), m_frequencies.end (), frequencyMHz) == m_frequencies.end ())
+    {
+      m_frequencies.push_back (frequencyMHz);
+    }
+}
+
+void
+LoraMetricsSampler::Install (NodeContainer gateways, NodeContainer networkServer)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_frequencies.empty ())
+    {
+      AddFrequency (868.1);
+      AddFrequency (868.3);
+      AddFrequency (868.5);
+      AddFrequency (869.525);
+    }
+  // One group of spreading factors per frequency, plus the "other" group
+  m_load.assign ((m_frequencies.size () + 1) * m_numberOfSfs, LoadCounter ());
+
+  bool success = false;
+  Ptr<LoraChannel> channel = 0;
+
+  for (NodeContainer::Iterator i = gateways.Begin (); i != gateways.End (); ++i)
+    {
+      Ptr<LoraNetDevice> loraNetDevice = (*i)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      NS_ASSERT (loraNetDevice != 0);
+
+      Ptr<GatewayLoraPhy> phy = loraNetDevice->GetPhy ()->GetObject<GatewayLoraPhy> ();
+      NS_ASSERT (phy != 0);
+
+      m_gateways.push_back (GatewayCounters ());
+      struct GatewayCounters* gateway = &m_gateways.back ();
+      gateway->sampler = this;
+      gateway->nodeId = (*i)->GetId ();
+
+      success = phy->TraceConnectWithoutContext ("OccupiedReceptionPaths",
+                                                 MakeBoundCallback
+                                                   (&LoraMetricsSampler::OccupiedReceptionPaths, gateway));
+      NS_ASSERT (success == true);
+
+      success = phy->TraceConnectWithoutContext ("LostPacketBecauseInterference",
+                                                 MakeBoundCallback
+                                                   (&LoraMetricsSampler::Interfered, gateway));
+      NS_ASSERT (success == true);
+
+      success = phy->TraceConnectWithoutContext ("LostPacketBecauseNoMoreReceivers",
+                                                 MakeBoundCallback
+                                                   (&LoraMetricsSampler::NoMoreReceivers, gateway));
+      NS_ASSERT (success == true);
+
+      success = phy->TraceConnectWithoutContext ("LostPacketBecauseUnderSensitivity",
+                                                 MakeBoundCallback
+                                                   (&LoraMetricsSampler::UnderSensitivity, gateway));
+      NS_ASSERT (success == true);
+
+      // All the PHYs share the same channel
+      if (channel == 0)
+        {
+          channel = phy->GetChannel ();
+        }
+    }
+
+  if (channel != 0)
+    {
+      success = channel->TraceConnectWithoutContext ("TransmissionStarted",
+                                                     MakeCallback
+                                                       (&LoraMetricsSampler::TransmissionStarted, this));
+      NS_ASSERT (success == true);
+    }
+  else
+    {
+      NS_LOG_WARN ("No gateway given, the channel load will not be sampled");
+    }
+
+  for (NodeContainer::Iterator i = networkServer.Begin (); i != networkServer.End (); ++i)
+    {
+      //We assume the NetworkServer application to be the first application
+      Ptr<NetworkServer> ns = (*i)->GetApplication (0)->GetObject<NetworkServer> ();
+      NS_ASSERT (ns != 0);
+
+      Ptr<NetworkScheduler> scheduler = ns->GetNetworkScheduler ();
+      NS_ASSERT (scheduler != 0);
+
+      success = scheduler->TraceConnectWithoutContext ("PendingReplies",
+                                                       MakeCallback
+                                                         (&LoraMetricsSampler::PendingReplies, this));
+      NS_ASSERT (success == true);
+
+      success = scheduler->TraceConnectWithoutContext ("TotalBeaconsBroadcasted",
+                                                       MakeCallback
+                                                         (&LoraMetricsSampler::TotalBeaconsBroadcasted, this));
+      NS_ASSERT (success == true);
+
+      success = scheduler->TraceConnectWithoutContext ("TotalBeaconsBlocked",
+                                                       MakeCallback
+                                                         (&LoraMetricsSampler::TotalBeaconsBlocked, this));
+      NS_ASSERT (success == true);
+    }
+}
+
+void
+LoraMetricsSampler::Start (Time start)
+{
+  NS_LOG_FUNCTION (this << start);
+
+  NS_ASSERT_MSG (!m_load.empty (), "Install the sampler before starting it");
+
+  m_writer.Open (m_fileName, false);
+  WriteHeader ();
+
+  m_running = true;
+  m_intervalStart = Simulator::Now () + start;
+  for (std::list<struct GatewayCounters>::iterator it = m_gateways.begin (); it != m_gateways.end (); ++it)
+    {
+      it->lastChange = m_intervalStart;
+    }
+
+  m_sampleEvent = Simulator::Schedule (start + m_interval, &LoraMetricsSampler::Sample, this);
+}
+
+void
+LoraMetricsSampler::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (!m_running)
+    {
+      return;
+    }
+
+  Simulator::Cancel (m_sampleEvent);
+  if (Simulator::Now () > m_intervalStart)
+    {
+      Sample ();
+      Simulator::Cancel (m_sampleEvent);
+    }
+  m_running = false;
+
+  m_writer.Flush ();
+}
+
+////////////////
+// Trace sinks //
+////////////////
+
+void
+LoraMetricsSampler::TransmissionStarted (Ptr<const Packet> packet, uint8_t sf, double frequencyMHz, Time duration)
+{
+  if (!m_running || Simulator::Now () < m_intervalStart || sf < m_minSf || sf >= m_minSf + m_numberOfSfs)
+    {
+      return;
+    }
+
+  // The list of frequencies is short, a linear search is cheaper than a map
+  std::size_t frequencyIndex = std::find (m_frequencies.begin (), m_frequencies.end (), frequencyMHz)
+    - m_frequencies.begin ();
+  struct LoadCounter& load = m_load[frequencyIndex * m_numberOfSfs + sf - m_minSf];
+
+  // Only the part of the air time that falls in this interval is counted now
+  double airTime = duration.GetSeconds ();
+  double remaining = (m_intervalStart + m_interval - Simulator::Now ()).GetSeconds ();
+  double inThisInterval = std::min (airTime, std::max (remaining, 0.0));
+  load.busySeconds += inThisInterval;
+  load.carrySeconds += airTime - inThisInterval;
+}
+
+void
+LoraMetricsSampler::PendingReplies (uint32_t oldValue, uint32_t newValue)
+{
+  m_pendingReplies = newValue;
+  m_maxPendingReplies = std::max (m_maxPendingReplies, newValue);
+}
+
+void
+LoraMetricsSampler::TotalBeaconsBroadcasted (uint32_t oldValue, uint32_t newValue)
+{
+  m_beaconsSent += newValue - oldValue;
+}
+
+void
+LoraMetricsSampler::TotalBeaconsBlocked (uint32_t oldValue, uint32_t newValue)
+{
+  m_beaconsBlocked += newValue - oldValue;
+}
+
+void
+LoraMetricsSampler::OccupiedReceptionPaths (struct GatewayCounters* gateway, int oldValue, int newValue)
+{
+  Time now = Simulator::Now ();
+  if (gateway->sampler->m_running && now > gateway->lastChange)
+    {
+      gateway->occupiedPathSeconds += oldValue * (now - gateway->lastChange).GetSeconds ();
+      gateway->lastChange = now;
+    }
+  gateway->occupiedPaths = newValue;
+  gateway->maxOccupiedPaths = std::max (gateway->maxOccupiedPaths, newValue);
+}
+
+void
+LoraMetricsSampler::Interfered (struct GatewayCounters* gateway, Ptr<const Packet> packet, uint32_t nodeId)
+{
+  gateway->interfered++;
+}
+
+void
+LoraMetricsSampler::NoMoreReceivers (struct GatewayCounters* gateway, Ptr<const Packet> packet, uint32_t nodeId)
+{
+  gateway->noMoreReceivers++;
+}
+
+void
+LoraMetricsSampler::UnderSensitivity (struct GatewayCounters* gateway, Ptr<const Packet> packet, uint32_t nodeId)
+{
+  gateway->underSensitivity++;
+}
+
+/////////////
+// Output //
+///////////
+
+void
+LoraMetricsSampler::WriteHeader (void)
+{
+  std::vector<std::string> columns;
+  columns.push_back ("time");
+
+  for (std::size_t f = 0; f <= m_frequencies.size (); f++)
+    {
+      std::ostringstream frequency;
+      if (f < m_frequencies.size ())
+        {
+          frequency << m_frequencies[f];
+        }
+      else
+        {
+          frequency << "other";
+        }
+      for (uint8_t sf = m_minSf; sf < m_minSf + m_numberOfSfs; sf++)
+        {
+          columns.push_back ("load_" + frequency.str () + "_sf" + std::to_string (sf));
+        }
+    }
+
+  for (std::list<struct GatewayCounters>::iterator it = m_gateways.begin (); it != m_gateways.end (); ++it)
+    {
+      std::string prefix = "gw" + std::to_string (it->nodeId) + "_";
+      columns.push_back (prefix + "demodulatorsAvg");
+      columns.push_back (prefix + "demodulatorsMax");
+      columns.push_back (prefix + "interfered");
+      columns.push_back (prefix + "noMoreReceivers");
+      columns.push_back (prefix + "underSensitivity");
+    }
+
+  columns.push_back ("pendingReplies");
+  columns.push_back ("maxPendingReplies");
+  columns.push_back ("beaconsSent");
+  columns.push_back ("beaconsBlocked");
+
+  std::string header;
+  if (m_format == CSV)
+    {
+      for (std::size_t i = 0; i < columns.size (); i++)
+        {
+          header += (i == 0 ? "" : ",") + columns[i];
+        }
+      header += "\n";
+    }
+  else
+    {
+      uint32_t numberOfColumns = columns.size ();
+      header.append ("LMS1", 4);
+      header.append (reinterpret_cast<const char*> (&numberOfColumns), sizeof (numberOfColumns));
+      for (std::size_t i = 0; i < columns.size (); i++)
+        {
+          header.append (columns[i].c_str (), columns[i].size () + 1);
+        }
+    }
+  m_writer.Write (m_fileName, header);
+}
+
+void
+LoraMetricsSampler::Sample (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  double intervalSeconds = (now - m_intervalStart).GetSeconds ();
+
+  std::vector<double> row;
+  row.reserve (1 + m_load.size () + 5 * m_gateways.size () + 4);
+  row.push_back (now.GetSeconds ());
+
+  for (std::vector<struct LoadCounter>::iterator it = m_load.begin (); it != m_load.end (); ++it)
+    {
+      row.push_back (it->busySeconds / intervalSeconds);
+      // Move the air time of ongoing transmissions to the next interval
+      it->busySeconds = std::min (it->carrySeconds, m_interval.GetSeconds ());
+      it->carrySeconds -= it->busySeconds;
+    }
+
+  for (std::list<struct GatewayCounters>::iterator it = m_gateways.begin (); it != m_gateways.end (); ++it)
+    {
+      it->occupiedPathSeconds += it->occupiedPaths * (now - it->lastChange).GetSeconds ();
+      row.push_back (it->occupiedPathSeconds / intervalSeconds);
+      row.push_back (it->maxOccupiedPaths);
+      row.push_back (it->interfered);
+      row.push_back (it->noMoreReceivers);
+      row.push_back (it->underSensitivity);
+
+      it->occupiedPathSeconds = 0;
+      it->maxOccupiedPaths = it->occupiedPaths;
+      it->lastChange = now;
+      it->interfered = 0;
+      it->noMoreReceivers = 0;
+      it->underSensitivity = 0;
+    }
+
+  row.push_back (m_pendingReplies);
+  row.push_back (m_maxPendingReplies);
+  row.push_back (m_beaconsSent);
+  row.push_back (m_beaconsBlocked);
+  m_maxPendingReplies = m_pendingReplies;
+  m_beaconsSent = 0;
+  m_beaconsBlocked = 0;
+
+  if (m_format == CSV)
+    {
+      std::ostringstream line;
+      for (std::size_t i = 0; i < row.size (); i++)
+        {
+          line << (i == 0 ? "" : ",") << row[i];
+        }
+      line << "\n";
+      m_writer.Write (m_fileName, line.str ());
+    }
+  else
+    {
+      m_writer.Write (m_fileName, std::string (reinterpret_cast<const char*> (row.data ()),
+                                               row.size () * sizeof (double)));
+    }
+
+  m_intervalStart = now;
+  m_sampleEvent = Simulator::Schedule (m_interval, &LoraMetricsSampler::Sample, this);
+}
+
+}
+}
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef LORA_METRICS_SAMPLER_H
+#define LORA_METRICS_SAMPLER_H
+
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/node-container.h"
+#include "ns3/lora-channel.h"
+#include "ns3/lora-log-writer.h"
+
+#include <list>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Periodic sampler of the state of the network
+ *
+ * The sampler keeps plain per-interval counters that are updated by sinks
+ * connected to the existing trace sources, and emits one row per interval
+ * with:
+ *  - the load of the channel for each frequency and spreading factor, as the
+ *    fraction of the interval covered by transmissions,
+ *  - the average and maximum number of occupied demodulators of each gateway,
+ *  - the packets lost at the gateways because of interference, lack of
+ *    demodulators and sensitivity,
+ *  - the current and maximum number of class A replies pending at the
+ *    network server,
+ *  - the number of beacons sent and skipped by the network server.
+ *
+ * Nothing is connected and no event is scheduled until Install and Start are
+ * called, hence an unused sampler costs nothing.
+ *
+ * The binary output holds, in host byte order, the magic string "LMS1", the
+ * number of columns n as uint32_t, n zero-terminated column names and then
+ * one row of n doubles per interval. In both formats the first column is the
+ * end of the interval in seconds.
+ */
+class LoraMetricsSampler
+{
+public:
+  /// Format of the output file
+  enum OutputFormat
+  {
+    CSV,    ///< One comma separated line per interval, preceded by a header line
+    BINARY  ///< Column names followed by one row of doubles per interval
+  };
+
+  /**
+   * Constructor
+   *
+   * \param fileName the file to write the samples to, it is truncated
+   * \param interval the sampling interval
+   * \param format the format of the output
+   */
+  LoraMetricsSampler (std::string fileName, Time interval, enum OutputFormat format = CSV);
+  ~LoraMetricsSampler ();
+
+  /**
+   * Add a frequency for which to report the channel load. Transmissions on
+   * frequencies that are not added are accounted in a separate "other" group.
+   *
+   * If no frequency is added before Install, the three default EU868 channels
+   * and the 869.525 MHz downlink channel are used.
+   *
+   * \param frequencyMHz the frequency to add
+   */
+  void AddFrequency (double frequencyMHz);
+
+  /**
+   * Connect the sampler to the trace sources of the network
+   *
+   * \param gateways the gateways, whose first device is a LoraNetDevice
+   * \param networkServer the network servers, whose first application is a NetworkServer
+   */
+  void Install (NodeContainer gateways, NodeContainer networkServer);
+
+  /**
+   * Start sampling at the given time
+   *
+   * \param start the time at which the first interval starts
+   */
+  void Start (Time start);
+
+  /**
+   * Emit the row of the current, possibly partial, interval and stop sampling
+   */
+  void Stop (void);
+
+private:
+  /// Counters of a single gateway
+  struct GatewayCounters
+  {
+    LoraMetricsSampler* sampler = 0;
+    uint32_t nodeId = 0;
+    int occupiedPaths = 0;   ///< Current number of occupied demodulators
+    int maxOccupiedPaths = 0;  ///< Maximum in the current interval
+    double occupiedPathSeconds = 0; ///< Integral of the occupied demodulators over the interval
+    Time lastChange;   ///< Last time occupiedPaths changed, or the interval started
+    uint32_t interfered = 0;
+    uint32_t noMoreReceivers = 0;
+    uint32_t underSensitivity = 0;
+  };
+
+  /// Channel load of a frequency and spreading factor
+  struct LoadCounter
+  {
+    double busySeconds = 0; ///< Air time falling in the current interval
+    double carrySeconds = 0; ///< Air time falling in the next intervals
+  };
+
+  static const uint8_t m_minSf = 7;
+  static const uint8_t m_numberOfSfs = 6;
+
+  // Trace sinks
+  void TransmissionStarted (Ptr<const Packet> packet, uint8_t sf, double frequencyMHz, Time duration);
+  void PendingReplies (uint32_t oldValue, uint32_t newValue);
+  void TotalBeaconsBroadcasted (uint32_t oldValue, uint32_t newValue);
+  void TotalBeaconsBlocked (uint32_t oldValue, uint32_t newValue);
+  static void OccupiedReceptionPaths (struct GatewayCounters* gateway, int oldValue, int newValue);
+  static void Interfered (struct GatewayCounters* gateway, Ptr<const Packet> packet, uint32_t nodeId);
+  static void NoMoreReceivers (struct GatewayCounters* gateway, Ptr<const Packet> packet, uint32_t nodeId);
+  static void UnderSensitivity (struct GatewayCounters* gateway, Ptr<const Packet> packet, uint32_t nodeId);
+
+  /**
+   * Emit the row of the interval that ends now and reset the counters
+   */
+  void Sample (void);
+
+  /**
+   * Write the column names to the output
+   */
+  void WriteHeader (void);
+
+  std::string m_fileName;
+  Time m_interval;
+  enum OutputFormat m_format;
+
+  LoraLogWriter m_writer; ///< Writes the rows in the background
+  EventId m_sampleEvent;
+  Time m_intervalStart;
+  bool m_running;
+
+  std::vector<double> m_frequencies; ///< Frequencies with a load column
+  std::vector<struct LoadCounter> m_load; ///< Indexed by frequency index * m_numberOfSfs + sf - m_minSf, the last m_numberOfSfs are "other"
+
+  std::list<struct GatewayCounters> m_gateways; ///< A list to keep the address of the counters stable
+
+  uint32_t m_pendingReplies;
+  uint32_t m_maxPendingReplies;
+  uint32_t m_beaconsSent;
+  uint32_t m_beaconsBlocked;
+};
+
+}
+}
+#endif /* LORA_METRICS_SAMPLER_H */
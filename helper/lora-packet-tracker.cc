@@ -107,6 +107,11 @@ LoraPacketTracker::PacketReceptionCallback (Ptr<Packet const> packet, uint32_t s
   NS_LOG_INFO ("A packet was successfully received at gateway " << systemId);
 
   std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
+  if (it == m_packetTracker.end ())
+    {
+      // Not sent by a tracked device, like the packets of BackgroundTraffic
+      return;
+    }
   (*it).second.outcomes.at (0) = RECEIVED;
   (*it).second.outcomeNumber += 1;
 
@@ -119,6 +124,10 @@ LoraPacketTracker::InterferenceCallback (Ptr<Packet const> packet, uint32_t syst
   NS_LOG_INFO ("A packet was lost because of interference at gateway " << systemId);
 
   std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
+  if (it == m_packetTracker.end ())
+    {
+      return;
+    }
   (*it).second.outcomes.at (0) = INTERFERED;
   (*it).second.outcomeNumber += 1;
 
@@ -130,6 +139,10 @@ LoraPacketTracker::NoMoreReceiversCallback (Ptr<Packet const> packet, uint32_t s
 {
   NS_LOG_INFO ("A packet was lost because there were no more receivers at gateway " << systemId);
   std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
+  if (it == m_packetTracker.end ())
+    {
+      return;
+    }
   (*it).second.outcomes.at (0) = NO_MORE_RECEIVERS;
   (*it).second.outcomeNumber += 1;
 
@@ -142,6 +155,10 @@ LoraPacketTracker::UnderSensitivityCallback (Ptr<Packet const> packet, uint32_t
   NS_LOG_INFO ("A packet arrived at the gateway under sensitivity at gateway " << systemId);
 
   std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
+  if (it == m_packetTracker.end ())
+    {
+      return;
+    }
   (*it).second.outcomes.at (0) = UNDER_SENSITIVITY;
   (*it).second.outcomeNumber += 1;
 
@@ -154,6 +171,10 @@ LoraPacketTracker::LostBecauseTxCallback (Ptr<Packet const> packet, uint32_t sys
   NS_LOG_INFO ("A packet arrived at the gateway under sensitivity at gateway " << systemId);
 
   std::map<Ptr<Packet const>, PacketStatus>::iterator it = m_packetTracker.find (packet);
+  if (it == m_packetTracker.end ())
+    {
+      return;
+    }
   (*it).second.outcomes.at (0) = LOST_BECAUSE_TX;
   (*it).second.outcomeNumber += 1;
 
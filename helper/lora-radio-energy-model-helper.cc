@@ -21,6 +21,7 @@
 #include "ns3/lora-net-device.h"
 #include "ns3/lora-tx-current-model.h"
 #include "ns3/end-device-lora-phy.h"
+#include "ns3/end-device-lora-mac.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -69,6 +70,40 @@ LoraRadioEnergyModelHelper::SetTxCurrentModel (std::string name,
  * Private function starts here.
  */
 
+/*
+ * Account the energy of the model to the activity of the new MAC state
+ */
+static void
+MacStateToActivity (Ptr<LoraRadioEnergyModel> model,
+                    EndDeviceLoraMac::MacState oldState,
+                    EndDeviceLoraMac::MacState newState)
+{
+  switch (newState)
+    {
+    case EndDeviceLoraMac::MAC_TX:
+      model->SetActivity (LoraRadioEnergyModel::ACTIVITY_UPLINK_TX);
+      break;
+    case EndDeviceLoraMac::MAC_RX1:
+      model->SetActivity (LoraRadioEnergyModel::ACTIVITY_RX1);
+      break;
+    case EndDeviceLoraMac::MAC_RX2:
+      model->SetActivity (LoraRadioEnergyModel::ACTIVITY_RX2);
+      break;
+    case EndDeviceLoraMac::MAC_BEACON_GUARD:
+    case EndDeviceLoraMac::MAC_RX_BEACON_GUARD:
+    case EndDeviceLoraMac::MAC_PING_SLOT_BEACON_GUARD:
+    case EndDeviceLoraMac::MAC_BEACON_RESERVED:
+      model->SetActivity (LoraRadioEnergyModel::ACTIVITY_BEACON);
+      break;
+    case EndDeviceLoraMac::MAC_PING_SLOT:
+      model->SetActivity (LoraRadioEnergyModel::ACTIVITY_PING);
+      break;
+    default:
+      model->SetActivity (LoraRadioEnergyModel::ACTIVITY_IDLE);
+      break;
+    }
+}
+
 Ptr<DeviceEnergyModel>
 LoraRadioEnergyModelHelper::DoInstall (Ptr<NetDevice> device,
                                        Ptr<EnergySource> source) const
@@ -96,6 +131,14 @@ LoraRadioEnergyModelHelper::DoInstall (Ptr<NetDevice> device,
   // create and register energy model phy listener
   loraPhy->RegisterListener (model->GetPhyListener ());
 
+  // account the energy to the activities of the MAC
+  Ptr<EndDeviceLoraMac> loraMac = loraDevice->GetMac ()->GetObject<EndDeviceLoraMac> ();
+  if (loraMac != 0)
+    {
+      loraMac->TraceConnectWithoutContext ("MacState",
+                                           MakeBoundCallback (&MacStateToActivity, model));
+    }
+
   if (m_txCurrentModel.GetTypeId ().GetUid ())
     {
       Ptr<LoraTxCurrentModel> txcurrent = m_txCurrentModel.Create<LoraTxCurrentModel> ();
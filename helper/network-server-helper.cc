@@ -39,6 +39,8 @@ NetworkServerHelper::NetworkServerHelper ()
   m_classBEnabled = false;
   m_beaconEnabled = false;
   m_enableSequencedPacketGeneration = false;
+  m_fragmentationNbFrag = 0;
+  m_fragmentationNbParity = 0;
   m_pingDownlinkPacketSize = 255; // maximum packet size is used by default
 }
 
@@ -83,6 +85,13 @@ NetworkServerHelper::EnableSequencedPacketGeneration (bool enable)
   m_enableSequencedPacketGeneration = enable;
 }
 
+void 
+NetworkServerHelper::EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity)
+{
+  m_fragmentationNbFrag = nbFrag;
+  m_fragmentationNbParity = nbParity;
+}
+
 void
 NetworkServerHelper::SetPingDownlinkPacketSize (uint8_t pingDownlinkPacketSize)
 {
@@ -128,6 +137,7 @@ NetworkServerHelper::InstallPriv (Ptr<Node> node)
   app->EnableClassBDownlink (m_classBEnabled);
   app->EnableBeaconTransmission (m_beaconEnabled);
   app->EnableSequencedPacketGeneration (m_enableSequencedPacketGeneration);
+  app->EnableFragmentationSession (m_fragmentationNbFrag, m_fragmentationNbParity);
   app->SetPingDownlinkPacketSize (m_pingDownlinkPacketSize);
 
   // Cycle on each gateway
@@ -83,6 +83,15 @@ public:
    */
   void EnableSequencedPacketGeneration (bool enable);
   
+  /**
+   * Send a fragmentation session, with parity fragments, to the multicast
+   * groups in place of the sequenced packets
+   * 
+   * \param nbFrag the number of data fragments of the image, 0 to disable
+   * \param nbParity the number of parity fragments sent after them
+   */
+  void EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity);
+  
   /**
    * Set the packet size for the ping downlink
    * 
@@ -129,6 +138,12 @@ private:
    */
   bool m_enableSequencedPacketGeneration;
   
+  /**
+   * The fragmentation session to send, if m_fragmentationNbFrag is not 0
+   */
+  uint16_t m_fragmentationNbFrag;
+  uint16_t m_fragmentationNbParity;
+  
   /**
    * ping downlink packet size to be used for all multicast groups
    */
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/population-sender-helper.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("PopulationSenderHelper");
+
+PopulationSenderHelper::PopulationSenderHelper ()
+  : m_pattern (PopulationSender::PERIODIC),
+  m_period (Seconds (600)),
+  m_burstSize (1),
+  m_burstSpacing (Seconds (0)),
+  m_pktSize (10)
+{
+}
+
+PopulationSenderHelper::~PopulationSenderHelper ()
+{
+}
+
+ApplicationContainer
+PopulationSenderHelper::Install (NodeContainer c) const
+{
+  NS_LOG_FUNCTION (this);
+
+  if (c.GetN () == 0)
+    {
+      return ApplicationContainer ();
+    }
+
+  Ptr<PopulationSender> app = CreateObject<PopulationSender> ();
+  app->SetPattern (m_pattern);
+  app->SetInterval (m_period);
+  app->SetBurst (m_burstSize, m_burstSpacing);
+  app->SetPacketSize (m_pktSize);
+
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      // Assumes there's only one device
+      Ptr<LoraNetDevice> loraNetDevice = (*i)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      NS_ASSERT (loraNetDevice != 0);
+      app->AddDevice (loraNetDevice->GetMac ());
+    }
+
+  NS_LOG_DEBUG ("Created an application for " << app->GetNDevices () << " devices");
+
+  Ptr<Node> node = c.Get (0);
+  app->SetNode (node);
+  node->AddApplication (app);
+
+  return ApplicationContainer (app);
+}
+
+void
+PopulationSenderHelper::SetPattern (enum PopulationSender::Pattern pattern)
+{
+  m_pattern = pattern;
+}
+
+void
+PopulationSenderHelper::SetPeriod (Time period)
+{
+  m_period = period;
+}
+
+void
+PopulationSenderHelper::SetBurst (uint32_t size, Time spacing)
+{
+  m_burstSize = size;
+  m_burstSpacing = spacing;
+}
+
+void
+PopulationSenderHelper::SetPacketSize (uint8_t size)
+{
+  m_pktSize = size;
+}
+
+}
+}
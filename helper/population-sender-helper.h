@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef POPULATION_SENDER_HELPER_H
+#define POPULATION_SENDER_HELPER_H
+
+#include "ns3/node-container.h"
+#include "ns3/application-container.h"
+#include "ns3/population-sender.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * This class can be used to generate the traffic of many end devices with a
+ * single PopulationSender application, in place of a PeriodicSender on each
+ * of them.
+ */
+class PopulationSenderHelper
+{
+public:
+  PopulationSenderHelper ();
+
+  ~PopulationSenderHelper ();
+
+  /**
+   * Create a PopulationSender for the given end devices and install it on
+   * the first of them.
+   *
+   * \param c the end devices, whose first device is a LoraNetDevice
+   * \return a container with the single application
+   */
+  ApplicationContainer Install (NodeContainer c) const;
+
+  /**
+   * Set the traffic pattern of the devices, PERIODIC by default.
+   */
+  void SetPattern (enum PopulationSender::Pattern pattern);
+
+  /**
+   * Set the interval between two packets, or two bursts, of a device.
+   */
+  void SetPeriod (Time period);
+
+  /**
+   * Set the number of packets of a burst and the time between them, for the
+   * BURSTY pattern.
+   */
+  void SetBurst (uint32_t size, Time spacing);
+
+  void SetPacketSize (uint8_t size);
+
+private:
+  enum PopulationSender::Pattern m_pattern;
+
+  Time m_period;
+
+  uint32_t m_burstSize;
+
+  Time m_burstSpacing;
+
+  uint8_t m_pktSize;
+};
+
+}
+}
+#endif /* POPULATION_SENDER_HELPER_H */
@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/shadowing-raster-helper.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("ShadowingRasterHelper");
+
+ShadowingRasterHelper::ShadowingRasterHelper () :
+  m_xMin (0),
+  m_yMin (0),
+  m_xMax (0),
+  m_yMax (0),
+  m_correlationDistance (110),
+  m_resolution (0),
+  m_stream (-1)
+{
+}
+
+void
+ShadowingRasterHelper::SetArea (double xMin, double yMin, double xMax, double yMax)
+{
+  m_xMin = std::min (xMin, xMax);
+  m_yMin = std::min (yMin, yMax);
+  m_xMax = std::max (xMin, xMax);
+  m_yMax = std::max (yMin, yMax);
+}
+
+void
+ShadowingRasterHelper::SetCorrelationDistance (double distance)
+{
+  m_correlationDistance = distance;
+}
+
+void
+ShadowingRasterHelper::SetResolution (double resolution)
+{
+  m_resolution = resolution;
+}
+
+int64_t
+ShadowingRasterHelper::AssignStreams (int64_t stream)
+{
+  m_stream = stream;
+  return 1;
+}
+
+bool
+ShadowingRasterHelper::Write (std::string fileName) const
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  double distance = m_correlationDistance;
+  double resolution = m_resolution > 0 ? m_resolution : distance;
+
+  // The independent values of the ShadowingMap are at (i * d - d / 2)
+  RasterShadowingPropagationLossModel::RasterHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, "LSR1", 4);
+  header.xMin = std::floor ((m_xMin + distance / 2) / distance) * distance - distance / 2;
+  header.yMin = std::floor ((m_yMin + distance / 2) / distance) * distance - distance / 2;
+  header.resolution = resolution;
+  header.nx = std::ceil ((m_xMax - header.xMin) / resolution) + 1;
+  header.ny = std::ceil ((m_yMax - header.yMin) / resolution) + 1;
+
+  std::ofstream file (fileName.c_str (), std::ios::binary | std::ios::trunc);
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Cannot open " << fileName);
+      return false;
+    }
+  file.write (reinterpret_cast<const char*> (&header), sizeof (header));
+
+  // Interpolated positions are never asked twice, but the map drops the
+  // vertices of the grid with the last position using them. Keeping one row
+  // of positions keeps the vertices that the next row shares with it, so
+  // that they are not drawn again.
+  Ptr<CorrelatedShadowingPropagationLossModel::ShadowingMap> map =
+    Create<CorrelatedShadowingPropagationLossModel::ShadowingMap> (distance, header.nx);
+  if (m_stream >= 0)
+    {
+      map->AssignStreams (m_stream);
+    }
+
+  std::vector<float> row (header.nx);
+  for (uint32_t j = 0; j < header.ny; j++)
+    {
+      double y = header.yMin + j * resolution;
+      for (uint32_t i = 0; i < header.nx; i++)
+        {
+          double x = header.xMin + i * resolution;
+          row[i] = map->GetLoss (CorrelatedShadowingPropagationLossModel::Position (x, y));
+        }
+      file.write (reinterpret_cast<const char*> (row.data ()), row.size () * sizeof (float));
+    }
+
+  file.close ();
+  if (file.fail ())
+    {
+      NS_LOG_ERROR ("Cannot write " << fileName);
+      return false;
+    }
+
+  NS_LOG_INFO ("Wrote a " << header.nx << "x" << header.ny << " shadowing raster to "
+                          << fileName);
+  return true;
+}
+
+}
+}
@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef SHADOWING_RASTER_HELPER_H
+#define SHADOWING_RASTER_HELPER_H
+
+#include "ns3/raster-shadowing-propagation-loss-model.h"
+
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Writes the shadowing rasters read by RasterShadowingPropagationLossModel
+ *
+ * The field is sampled from a CorrelatedShadowingPropagationLossModel
+ * ShadowingMap, so it has the same statistics as the shadowing generated on
+ * the fly. The origin of the raster is aligned to the grid of independent
+ * values of the ShadowingMap, hence with the default resolution (the
+ * correlation distance) the raster holds exactly those values and the
+ * bilinear interpolation of the model does the rest.
+ *
+ * The values are drawn from the current seed and run of the RngSeedManager,
+ * and from the stream set with AssignStreams if any.
+ */
+class ShadowingRasterHelper
+{
+public:
+  ShadowingRasterHelper ();
+
+  /**
+   * Set the area covered by the raster, in m
+   */
+  void SetArea (double xMin, double yMin, double xMax, double yMax);
+
+  /**
+   * Set the correlation distance of the field, 110 m by default
+   */
+  void SetCorrelationDistance (double distance);
+
+  /**
+   * Set the distance between two values of the raster, the correlation
+   * distance if not set or set to 0
+   */
+  void SetResolution (double resolution);
+
+  /**
+   * Sample the field and write it
+   *
+   * \return whether the file was written
+   */
+  bool Write (std::string fileName) const;
+
+  /**
+   * Fix the stream of the random variable drawing the field
+   *
+   * \param stream the first stream index to use
+   * \return the number of stream indices used
+   */
+  int64_t AssignStreams (int64_t stream);
+
+private:
+  double m_xMin;
+  double m_yMin;
+  double m_xMax;
+  double m_yMax;
+  double m_correlationDistance;
+  double m_resolution;
+  int64_t m_stream;     //!< The stream of the field, -1 if not fixed
+};
+
+}
+}
+
+#endif /* SHADOWING_RASTER_HELPER_H */
@@ -0,0 +1,290 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/background-traffic.h"
+#include "ns3/lora-mac-header.h"
+#include "ns3/lora-phy.h"
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("BackgroundTraffic");
+
+NS_OBJECT_ENSURE_REGISTERED (BackgroundTraffic);
+
+TypeId
+BackgroundTraffic::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BackgroundTraffic")
+    .SetParent<Object> ()
+    .AddConstructor<BackgroundTraffic> ()
+    .SetGroupName ("lorawan")
+    .AddAttribute ("Interval", "The interval between the packets of each device",
+                   TimeValue (Seconds (600)),
+                   MakeTimeAccessor (&BackgroundTraffic::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("DutyCycle", "The duty cycle the devices are limited to",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&BackgroundTraffic::m_dutyCycle),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("TxPower", "The transmission power of the devices, in dBm",
+                   DoubleValue (14),
+                   MakeDoubleAccessor (&BackgroundTraffic::m_txPowerDbm),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("PacketSize", "The size of the packets, including the MAC header",
+                   UintegerValue (23),
+                   MakeUintegerAccessor (&BackgroundTraffic::m_pktSize),
+                   MakeUintegerChecker<uint8_t> (1));
+  return tid;
+}
+
+BackgroundTraffic::BackgroundTraffic ()
+  : m_interval (Seconds (600)),
+  m_dutyCycle (0.01),
+  m_txPowerDbm (14),
+  m_pktSize (23),
+  m_nTransmissions (0),
+  m_nDelayedTransmissions (0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  m_frequencies.push_back (868.1);
+  m_frequencies.push_back (868.3);
+  m_frequencies.push_back (868.5);
+
+  m_mobility = CreateObject<ConstantPositionMobilityModel> ();
+  m_phaseRv = CreateObject<UniformRandomVariable> ();
+  m_frequencyRv = CreateObject<UniformRandomVariable> ();
+}
+
+BackgroundTraffic::~BackgroundTraffic ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+bool
+BackgroundTraffic::Later::operator() (const struct Entry& a, const struct Entry& b) const
+{
+  return a.time > b.time || (a.time == b.time && a.device > b.device);
+}
+
+void
+BackgroundTraffic::SetChannel (Ptr<LoraChannel> channel)
+{
+  NS_LOG_FUNCTION (this << channel);
+  m_channel = channel;
+}
+
+void
+BackgroundTraffic::SetFrequencies (std::vector<double> frequenciesMHz)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT_MSG (!frequenciesMHz.empty (), "The devices need at least one frequency");
+  m_frequencies = frequenciesMHz;
+}
+
+void
+BackgroundTraffic::Reserve (uint32_t nDevices)
+{
+  NS_LOG_FUNCTION (this << nDevices);
+
+  m_devices.reserve (nDevices);
+  m_calendar.reserve (nDevices);
+}
+
+uint32_t
+BackgroundTraffic::AddDevice (Vector position, uint8_t sf)
+{
+  NS_LOG_FUNCTION (this << position << unsigned (sf));
+
+  NS_ASSERT_MSG (sf >= 7 && sf <= 12, "Invalid spreading factor " << unsigned (sf));
+
+  struct Device device;
+  device.offUntil = Seconds (0);
+  device.x = position.x;
+  device.y = position.y;
+  device.z = position.z;
+  device.sf = sf;
+  m_devices.push_back (device);
+
+  return m_devices.size () - 1;
+}
+
+uint32_t
+BackgroundTraffic::GetNDevices (void) const
+{
+  return m_devices.size ();
+}
+
+uint32_t
+BackgroundTraffic::GetDeviceSize (void)
+{
+  return sizeof (struct Device) + sizeof (struct Entry);
+}
+
+void
+BackgroundTraffic::Start (Time start)
+{
+  NS_LOG_FUNCTION (this << start);
+
+  Simulator::Cancel (m_startEvent);
+  m_startEvent = Simulator::Schedule (start, &BackgroundTraffic::DoStart, this);
+}
+
+void
+BackgroundTraffic::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_startEvent);
+  Simulator::Cancel (m_sendEvent);
+}
+
+uint64_t
+BackgroundTraffic::GetNTransmissions (void) const
+{
+  return m_nTransmissions;
+}
+
+uint64_t
+BackgroundTraffic::GetNDelayedTransmissions (void) const
+{
+  return m_nDelayedTransmissions;
+}
+
+int64_t
+BackgroundTraffic::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+
+  m_phaseRv->SetStream (stream);
+  m_frequencyRv->SetStream (stream + 1);
+  return 2;
+}
+
+void
+BackgroundTraffic::DoStart (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT_MSG (m_channel != 0, "The background traffic has no channel");
+  NS_ASSERT_MSG (m_interval > Seconds (0), "The interval has to be positive");
+  NS_ASSERT_MSG (m_dutyCycle > 0, "The duty cycle has to be positive");
+
+  // All the packets are copies of the same PROPRIETARY frame
+  LoraMacHeader macHdr;
+  macHdr.SetMType (LoraMacHeader::PROPRIETARY);
+  m_payload = Create<Packet> (m_pktSize - 1);
+  m_payload->AddHeader (macHdr);
+
+  // The packets only differ in the spreading factor, so the time on air is
+  // computed once for each of them
+  LoraTxParameters params;
+  for (uint8_t sf = 7; sf <= 12; sf++)
+    {
+      params.sf = sf;
+      m_duration[sf - 7] = LoraPhy::GetOnAirTime (m_payload, params);
+    }
+
+  Time now = Simulator::Now ();
+  m_calendar.clear ();
+  m_calendar.reserve (m_devices.size ());
+  for (uint32_t i = 0; i < m_devices.size (); i++)
+    {
+      struct Entry entry;
+      entry.time = now + Seconds (m_phaseRv->GetValue (0, m_interval.GetSeconds ()));
+      entry.device = i;
+      m_calendar.push_back (entry);
+    }
+  std::make_heap (m_calendar.begin (), m_calendar.end (), Later ());
+
+  NS_LOG_DEBUG ("Starting up the traffic of " << m_devices.size () << " background devices");
+
+  Simulator::Cancel (m_sendEvent);
+  if (!m_calendar.empty ())
+    {
+      m_sendEvent = Simulator::Schedule (m_calendar.front ().time - now,
+                                         &BackgroundTraffic::SendPackets, this);
+    }
+}
+
+void
+BackgroundTraffic::SendPackets (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+
+  while (m_calendar.front ().time <= now)
+    {
+      std::pop_heap (m_calendar.begin (), m_calendar.end (), Later ());
+      struct Entry& entry = m_calendar.back ();
+      struct Device& device = m_devices[entry.device];
+
+      if (device.offUntil > now)
+        {
+          // Send at the end of the off period instead
+          entry.time = device.offUntil;
+          m_nDelayedTransmissions++;
+        }
+      else
+        {
+          Send (device);
+          entry.time = now + m_interval;
+        }
+      std::push_heap (m_calendar.begin (), m_calendar.end (), Later ());
+    }
+
+  m_sendEvent = Simulator::Schedule (m_calendar.front ().time - now,
+                                     &BackgroundTraffic::SendPackets, this);
+}
+
+void
+BackgroundTraffic::Send (struct Device& device)
+{
+  LoraTxParameters params;
+  params.sf = device.sf;
+  Time duration = m_duration[device.sf - 7];
+
+  double frequencyMHz = m_frequencies[m_frequencyRv->GetInteger (0, m_frequencies.size () - 1)];
+
+  NS_LOG_DEBUG ("Background device at (" << device.x << ", " << device.y << ", " <<
+                device.z << ") sending with SF" << unsigned (device.sf) << " on " <<
+                frequencyMHz << " MHz");
+
+  m_mobility->SetPosition (Vector (device.x, device.y, device.z));
+  m_channel->Send (m_mobility, m_payload->Copy (), m_txPowerDbm, params, duration,
+                   frequencyMHz);
+  m_nTransmissions++;
+
+  // The same off time as the LogicalLoraChannelHelper
+  double timeOnAir = duration.GetSeconds ();
+  device.offUntil = Simulator::Now () + Seconds (timeOnAir / m_dutyCycle - timeOnAir);
+}
+
+}
+}
@@ -0,0 +1,208 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef BACKGROUND_TRAFFIC_H
+#define BACKGROUND_TRAFFIC_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+#include "ns3/packet.h"
+#include "ns3/event-id.h"
+#include "ns3/lora-channel.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/random-variable-stream.h"
+
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * The uplink traffic of a population of end devices that only load the
+ * channel
+ *
+ * A full end device costs a Node, a LoraNetDevice, a PHY, an
+ * EndDeviceLoraMac, an application and a mobility model. The devices of this
+ * class have none of them: each one is a record of a flat array with its
+ * position, its spreading factor and the end of its duty-cycle off period,
+ * and the next send time of every device is kept in a single calendar (a
+ * binary min-heap), as in PopulationSender. When a device is due, its packet
+ * is sent on the LoraChannel from the position of the device, on a frequency
+ * drawn from the frequency plan, so that the gateways receive it, and are
+ * interfered by it, like the packet of any other device.
+ *
+ * The packets are PROPRIETARY frames of the configured size, which the
+ * gateways receive but do not forward to the network server, as they would do
+ * with the packets of the devices of another network. A device whose
+ * duty-cycle off period is not over when it is due sends its packet at the
+ * end of the period instead.
+ *
+ * The loss is computed by the loss model of the channel for a mobility model
+ * that is moved to the position of each sending device, so models that need
+ * other objects aggregated to the mobility model, like
+ * BuildingPenetrationLoss, cannot be used with this class.
+ */
+class BackgroundTraffic : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  BackgroundTraffic ();
+  virtual ~BackgroundTraffic ();
+
+  /**
+   * Set the channel the devices send their packets on
+   */
+  void SetChannel (Ptr<LoraChannel> channel);
+
+  /**
+   * Set the frequencies the devices can send on, the three default channels
+   * of the EU868 band by default
+   */
+  void SetFrequencies (std::vector<double> frequenciesMHz);
+
+  /**
+   * Reserve the memory for the given number of devices
+   */
+  void Reserve (uint32_t nDevices);
+
+  /**
+   * Add a device
+   *
+   * \param position the position of the device
+   * \param sf the spreading factor the device sends with
+   * \return the index of the device
+   */
+  uint32_t AddDevice (Vector position, uint8_t sf);
+
+  /**
+   * \return the number of devices
+   */
+  uint32_t GetNDevices (void) const;
+
+  /**
+   * \return the memory used by a device, in bytes
+   */
+  static uint32_t GetDeviceSize (void);
+
+  /**
+   * Start the traffic of the devices, each one sending its first packet at a
+   * phase drawn uniformly in [0, interval) after the start time
+   */
+  void Start (Time start);
+
+  /**
+   * Stop the traffic of the devices
+   */
+  void Stop (void);
+
+  /**
+   * \return the number of packets sent so far
+   */
+  uint64_t GetNTransmissions (void) const;
+
+  /**
+   * \return the number of packets that were delayed by the duty cycle
+   */
+  uint64_t GetNDelayedTransmissions (void) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this object
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this object
+   */
+  int64_t AssignStreams (int64_t stream);
+
+private:
+  /// A device, kept as small as possible
+  struct Device
+  {
+    Time offUntil;      ///< The end of the duty-cycle off period
+    float x;
+    float y;
+    float z;
+    uint8_t sf;
+  };
+
+  /// An entry of the calendar
+  struct Entry
+  {
+    Time time;
+    uint32_t device;
+  };
+
+  /**
+   * Order the calendar as a min-heap on the time, then on the device
+   */
+  struct Later
+  {
+    bool operator() (const struct Entry& a, const struct Entry& b) const;
+  };
+
+  /**
+   * Draw the phases of the devices and schedule the first send event
+   */
+  void DoStart (void);
+
+  /**
+   * Send the packets of all the devices that are due and schedule the next
+   * event
+   */
+  void SendPackets (void);
+
+  /**
+   * Send the packet of a device on the channel
+   */
+  void Send (struct Device& device);
+
+  std::vector<struct Device> m_devices;
+  std::vector<struct Entry> m_calendar; ///< A binary min-heap
+
+  Ptr<LoraChannel> m_channel;
+  std::vector<double> m_frequencies;
+
+  /**
+   * The mobility model that is moved to the position of the sending device
+   */
+  Ptr<ConstantPositionMobilityModel> m_mobility;
+
+  Time m_interval;
+  double m_dutyCycle;
+  double m_txPowerDbm;
+  uint8_t m_pktSize;
+
+  Ptr<Packet> m_payload;     ///< Each packet is a copy of it
+  Time m_duration[6];        ///< The time on air for each spreading factor
+
+  Ptr<UniformRandomVariable> m_phaseRv;
+  Ptr<UniformRandomVariable> m_frequencyRv;
+
+  EventId m_startEvent;
+  EventId m_sendEvent;
+  uint64_t m_nTransmissions;
+  uint64_t m_nDelayedTransmissions;
+};
+
+}
+}
+#endif /* BACKGROUND_TRAFFIC_H */
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/beacon-clock.h"
+#include "ns3/end-device-lora-mac.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("BeaconClock");
+
+NS_OBJECT_ENSURE_REGISTERED (BeaconClock);
+
+TypeId
+BeaconClock::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::BeaconClock")
+    .SetParent<Object> ()
+    .SetGroupName ("lorawan")
+    .AddConstructor<BeaconClock> ();
+  return tid;
+}
+
+BeaconClock::BeaconClock () :
+  m_nScheduledEvents (0),
+  m_nNotifiedEvents (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+BeaconClock::~BeaconClock ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+BeaconClock::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // The pending simulator events are dropped by Simulator::Destroy
+  m_subscribers.clear ();
+
+  Object::DoDispose ();
+}
+
+void
+BeaconClock::Schedule (Time delay, Ptr<EndDeviceLoraMac> mac, enum Event event,
+                       uint8_t slotIndex, uint32_t epoch)
+{
+  NS_LOG_FUNCTION (this << delay << mac << event << unsigned (slotIndex) << epoch);
+
+  Time time = Simulator::Now () + delay;
+
+  std::map<Time, std::vector<struct Subscriber> >::iterator it = m_subscribers.find (time);
+  if (it == m_subscribers.end ())
+    {
+      it = m_subscribers.insert (std::make_pair (time, std::vector<struct Subscriber> ())).first;
+      Simulator::Schedule (delay, &BeaconClock::Notify, this, time);
+      m_nScheduledEvents++;
+    }
+
+  struct Subscriber subscriber;
+  subscriber.mac = PeekPointer (mac);
+  subscriber.event = event;
+  subscriber.slotIndex = slotIndex;
+  subscriber.epoch = epoch;
+  it->second.push_back (subscriber);
+}
+
+void
+BeaconClock::Notify (Time time)
+{
+  NS_LOG_FUNCTION (this << time);
+
+  std::map<Time, std::vector<struct Subscriber> >::iterator it = m_subscribers.find (time);
+  if (it == m_subscribers.end ())
+    {
+      return;
+    }
+
+  // Take the list out first, events scheduled now with no delay go to a new one
+  std::vector<struct Subscriber> subscribers;
+  subscribers.swap (it->second);
+  m_subscribers.erase (it);
+
+  NS_LOG_DEBUG ("Notifying " << subscribers.size () << " events");
+
+  for (std::vector<struct Subscriber>::iterator s = subscribers.begin (); s != subscribers.end (); ++s)
+    {
+      s->mac->HandleBeaconClockEvent (s->event, s->slotIndex, s->epoch);
+    }
+  m_nNotifiedEvents += subscribers.size ();
+}
+
+uint64_t
+BeaconClock::GetNScheduledEvents (void) const
+{
+  return m_nScheduledEvents;
+}
+
+uint64_t
+BeaconClock::GetNNotifiedEvents (void) const
+{
+  return m_nNotifiedEvents;
+}
+
+}
+}
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef BEACON_CLOCK_H
+#define BEACON_CLOCK_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+
+#include <map>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+class EndDeviceLoraMac;
+
+/**
+ * A clock shared by the class B end devices of a simulation
+ *
+ * Class B devices schedule the same beacon guard, beacon reserved and beacon
+ * receive window events every beacon period, and the devices of a multicast
+ * group also share their ping slots. Instead of one simulator event per
+ * device, the MACs registered with a clock hand their beacon period events
+ * to it. The clock keeps one list of subscribers for each instant and
+ * schedules a single simulator event for it, which notifies the subscribers
+ * in the order they were added.
+ *
+ * The logic of each device is unchanged: the clock calls the same MAC
+ * methods, at the same times, that the MAC would otherwise schedule itself.
+ * Only the order with respect to the other events of the same instant
+ * changes. All the subscribers of an instant run within the event scheduled
+ * by the first of them. So a subscriber added after another event of that
+ * instant was scheduled, for instance a downlink of the network server or
+ * the end of a reception, now runs before that event and not after it.
+ * Scenarios whose outcome depends on this ordering should not share a clock.
+ */
+class BeaconClock : public Object
+{
+public:
+  /// The beacon period events of a MAC
+  enum Event
+  {
+    SEARCH_BEACON_GUARD,    ///< First beacon guard, when searching the beacon
+    NEXT_BEACON_GUARD,      ///< Beacon guard of the next period, cancelled when leaving class B
+    END_BEACON_GUARD,
+    START_BEACON_RESERVED,
+    CLOSE_BEACON_WINDOW,
+    END_BEACON_RESERVED,
+    PING_SLOT               ///< Opening of a ping slot, cancelled when leaving class B
+  };
+
+  static TypeId GetTypeId (void);
+
+  BeaconClock ();
+  virtual ~BeaconClock ();
+
+  /**
+   * Schedule an event of a MAC
+   *
+   * \param delay the delay after which the event fires
+   * \param mac the MAC to notify
+   * \param event the event
+   * \param slotIndex the index of the ping slot, for PING_SLOT events
+   * \param epoch the epoch of the MAC when the event was scheduled, used to
+   *        drop cancelled events
+   */
+  void Schedule (Time delay, Ptr<EndDeviceLoraMac> mac, enum Event event,
+                 uint8_t slotIndex, uint32_t epoch);
+
+  /**
+   * \return the number of simulator events scheduled by the clock so far
+   */
+  uint64_t GetNScheduledEvents (void) const;
+
+  /**
+   * \return the number of MAC events notified by the clock so far
+   */
+  uint64_t GetNNotifiedEvents (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * An event of a subscriber. The clock does not hold a reference to the
+   * MAC, which holds one to the clock: the MACs live as long as their nodes,
+   * that is until Simulator::Destroy drops the pending events.
+   */
+  struct Subscriber
+  {
+    EndDeviceLoraMac *mac;
+    enum Event event;
+    uint8_t slotIndex;
+    uint32_t epoch;
+  };
+
+  /**
+   * Notify the subscribers of an instant
+   *
+   * \param time the instant
+   */
+  void Notify (Time time);
+
+  std::map<Time, std::vector<struct Subscriber> > m_subscribers; ///< Subscribers of each pending instant
+  uint64_t m_nScheduledEvents;
+  uint64_t m_nNotifiedEvents;
+};
+
+}
+}
+#endif /* BEACON_CLOCK_H */
@@ -19,6 +19,8 @@
 #include "ns3/building-penetration-loss.h"
 #include "ns3/mobility-building-info.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
 #include "ns3/log.h"
 #include <cmath>
 
@@ -36,11 +38,25 @@ BuildingPenetrationLoss::GetTypeId (void)
     .SetParent<PropagationLossModel> ()
     .SetGroupName ("Lora")
     .AddConstructor<BuildingPenetrationLoss> ()
+    .AddAttribute ("CacheLinkLoss",
+                   "Whether the loss of each pair of nodes is drawn once and "
+                   "then reused, instead of being drawn for every packet",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&BuildingPenetrationLoss::m_cacheLinkLoss),
+                   MakeBooleanChecker ())
+    .AddAttribute ("RedrawInterval",
+                   "The age after which a cached link loss is drawn again, "
+                   "0 to keep it for the whole simulation",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&BuildingPenetrationLoss::m_redrawInterval),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
 
-BuildingPenetrationLoss::BuildingPenetrationLoss ()
+BuildingPenetrationLoss::BuildingPenetrationLoss () :
+  m_cacheLinkLoss (false),
+  m_redrawInterval (Seconds (0))
 {
   NS_LOG_FUNCTION_NOARGS ();
 
@@ -60,6 +76,41 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
 {
   NS_LOG_FUNCTION (this << txPowerDbm << a << b);
 
+  if (!m_cacheLinkLoss)
+    {
+      return txPowerDbm - GetLoss (a, b);
+    }
+
+  // The same entry is used in both directions
+  std::pair<Ptr<MobilityModel>, Ptr<MobilityModel> > link =
+    a < b ? std::make_pair (a, b) : std::make_pair (b, a);
+
+  std::map<std::pair<Ptr<MobilityModel>, Ptr<MobilityModel> >, LinkLoss>::iterator it;
+  it = m_linkLossMap.find (link);
+  if (it == m_linkLossMap.end ())
+    {
+      LinkLoss linkLoss;
+      linkLoss.loss = GetLoss (a, b);
+      linkLoss.drawTime = Simulator::Now ();
+      it = m_linkLossMap.insert (std::make_pair (link, linkLoss)).first;
+      NS_LOG_DEBUG ("Drew the loss of a new link: " << linkLoss.loss);
+    }
+  else if (!m_redrawInterval.IsZero ()
+           && Simulator::Now () - it->second.drawTime >= m_redrawInterval)
+    {
+      it->second.loss = GetLoss (a, b);
+      it->second.drawTime = Simulator::Now ();
+      NS_LOG_DEBUG ("Drew the loss of the link again: " << it->second.loss);
+    }
+
+  return txPowerDbm - it->second.loss;
+}
+
+double
+BuildingPenetrationLoss::GetLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+  NS_LOG_FUNCTION (this << a << b);
+
   Ptr<MobilityBuildingInfo> a1 = a->GetObject<MobilityBuildingInfo> ();
   Ptr<MobilityBuildingInfo> b1 = b->GetObject<MobilityBuildingInfo> ();
 
@@ -127,7 +178,7 @@ BuildingPenetrationLoss::DoCalcRxPower (double txPowerDbm,
 
   NS_LOG_DEBUG ("Total loss due to building penetration: " << loss);
 
-  return txPowerDbm - loss;
+  return loss;
 }
 
 int64_t
@@ -23,6 +23,7 @@
 #include "ns3/mobility-model.h"
 #include "ns3/vector.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 class MobilityModel;
@@ -31,6 +32,12 @@ namespace lorawan {
 
 /**
  * A class implementing the TR 45.820 model for building losses
+ *
+ * By default, the random parts of the loss are drawn again for every packet.
+ * With the CacheLinkLoss attribute, the loss of each pair of nodes is drawn
+ * once and then reused in both directions, optionally drawing it again every
+ * RedrawInterval. Since the indoor or outdoor state of the nodes is then only
+ * looked up when the loss is drawn, caching is meant for static nodes.
  */
 class BuildingPenetrationLoss : public PropagationLossModel
 {
@@ -52,6 +59,12 @@ private:
 
   virtual int64_t DoAssignStreams (int64_t stream);
 
+  /**
+   * Draw the building penetration loss between two nodes.
+   * \returns The loss in dB.
+   */
+  double GetLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b) const;
+
   /**
    * Generate a random p value.
    * The distribution of the returned value is as specified in TR 45.820.
@@ -94,6 +107,25 @@ private:
    * loss.
    */
   mutable std::map<Ptr<MobilityModel>, int> m_wallLossMap;
+
+  /**
+   * A loss drawn for a link and the time at which it was drawn
+   */
+  struct LinkLoss
+  {
+    double loss;
+    Time drawTime;
+  };
+
+  /**
+   * A map linking each pair of mobility models, in pointer order, to the
+   * loss of their link. Only used if m_cacheLinkLoss is set.
+   */
+  mutable std::map<std::pair<Ptr<MobilityModel>, Ptr<MobilityModel> >, LinkLoss> m_linkLossMap;
+
+  bool m_cacheLinkLoss;     //!< Whether the loss of each link is drawn once
+
+  Time m_redrawInterval;    //!< The age after which a cached loss is drawn again, 0 for never
 };
 }
 }
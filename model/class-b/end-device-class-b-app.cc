@@ -49,7 +49,17 @@ EndDeviceClassBApp::GetTypeId (void)
                      "Current Fragments missed and total number of fragments missed in case of fragmented data",
                      MakeTraceSourceAccessor 
                       (&EndDeviceClassBApp::m_fragmentsMissed),
-                     "ns3::EndDeviceClassBApp::FragmentsMissed");
+                     "ns3::EndDeviceClassBApp::FragmentsMissed")
+    .AddTraceSource ("ImageComplete",
+                     "The image of the fragmentation session is decoded",
+                     MakeTraceSourceAccessor 
+                      (&EndDeviceClassBApp::m_imageComplete),
+                     "ns3::EndDeviceClassBApp::ImageCompleteCallback")
+    .AddTraceSource ("ImageCorrupt",
+                     "The image of the fragmentation session is decoded but does not match the one sent",
+                     MakeTraceSourceAccessor 
+                      (&EndDeviceClassBApp::m_imageCorrupt),
+                     "ns3::EndDeviceClassBApp::ImageCompleteCallback");
   // .AddAttribute ("PacketSizeRandomVariable", "The random variable that determines the shape of the packet size, in bytes",
   //                StringValue ("ns3::UniformRandomVariable[Min=0,Max=10]"),
   //                MakePointerAccessor (&EndDeviceClassBApp::m_pktSizeRV),
@@ -66,7 +76,9 @@ EndDeviceClassBApp::EndDeviceClassBApp ()
   m_nAttempt (0),
   m_countAttempt (0),
   m_uplinkEnabled (false),
-  m_maxAppPayloadForDataRate {51,51,51,115,222,222,222,222}  //Max MacPayload for EU863-870, taking FOpt to be empty
+  m_maxAppPayloadForDataRate {51,51,51,115,222,222,222,222},  //Max MacPayload for EU863-870, taking FOpt to be empty
+  m_fragmentationNbFrag (0),
+  m_fragmentationNbParity (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
   
@@ -122,6 +134,13 @@ void
 EndDeviceClassBApp::ClassBDownlinkCallback (EndDeviceLoraMac::ServiceType serviceType, Ptr<const Packet> packet, uint8_t pingIndex)
 {
   NS_LOG_FUNCTION (this << serviceType << packet << pingIndex);
+  
+  //The fragments are only sent to the multicast group
+  if (m_fragmentationNbFrag > 0 && serviceType == EndDeviceLoraMac::MULTICAST)
+    {
+      SessionFragmentReceived (packet);
+    }
+  
   //Check if the fragment packet decoder is enabled
   if (m_enableFragmentedPacketDecoder.enable)
     { 
@@ -265,6 +284,79 @@ EndDeviceClassBApp::EnableFragmentedDataReception (uint32_t first, uint32_t last
   m_enableFragmentedPacketDecoder.last = last;
 }
 
+void 
+EndDeviceClassBApp::EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity)
+{
+  NS_LOG_FUNCTION (this << nbFrag << nbParity);
+  m_fragmentationNbFrag = nbFrag;
+  m_fragmentationNbParity = nbParity;
+}
+
+Ptr<const FragmentDecoder>
+EndDeviceClassBApp::GetFragmentDecoder (void) const
+{
+  return m_fragmentDecoder;
+}
+
+void
+EndDeviceClassBApp::SessionFragmentReceived (Ptr<const Packet> packet)
+{
+  NS_LOG_FUNCTION (this << packet);
+  
+  if (packet->GetSize () <= SequenceHeader::MAX_SIZE)
+    {
+      NS_LOG_DEBUG ("The packet is too small to be a fragment");
+      return;
+    }
+  
+  SequenceHeader sequenceHeader;
+  packet->PeekHeader (sequenceHeader);
+  uint8_t fragSize = packet->GetSize () - sequenceHeader.GetSerializedSize ();
+  
+  //The fragment size is only known with the first fragment
+  if (m_fragmentDecoder == 0)
+    {
+      Ptr<FragmentationSession> session = Create<FragmentationSession> (m_fragmentationNbFrag,
+                                                                        m_fragmentationNbParity,
+                                                                        fragSize);
+      m_fragmentDecoder = Create<FragmentDecoder> (session);
+      m_firstFragmentTime = Simulator::Now ();
+    }
+  
+  if (m_fragmentDecoder->IsComplete ())
+    {
+      return;
+    }
+  
+  uint8_t buffer[256];
+  packet->CopyData (buffer, packet->GetSize ());
+  uint32_t index = sequenceHeader.GetSequence () % (uint32_t (m_fragmentationNbFrag) + m_fragmentationNbParity);
+  m_fragmentDecoder->AddFragment (index, buffer + sequenceHeader.GetSerializedSize ());
+  
+  NS_LOG_DEBUG ("Fragment " << index << " received, rank " << m_fragmentDecoder->GetRank ());
+  
+  if (m_fragmentDecoder->IsComplete ())
+    {
+      NS_LOG_INFO ("Image complete after " << m_fragmentDecoder->GetNReceived () << " fragments");
+      
+      if (m_fragmentDecoder->CheckImage ())
+        {
+          m_imageComplete (m_endDeviceLoraMac->GetMulticastDeviceAddress (),
+                           m_endDeviceLoraMac->GetDeviceAddress (),
+                           Simulator::Now () - m_firstFragmentTime,
+                           m_fragmentDecoder->GetNReceived ());
+        }
+      else
+        {
+          NS_LOG_WARN ("The image is not decoded correctly");
+          m_imageCorrupt (m_endDeviceLoraMac->GetMulticastDeviceAddress (),
+                          m_endDeviceLoraMac->GetDeviceAddress (),
+                          Simulator::Now () - m_firstFragmentTime,
+                          m_fragmentDecoder->GetNReceived ());
+        }
+    }
+}
+
 void
 EndDeviceClassBApp::SendPacket (void)
 {
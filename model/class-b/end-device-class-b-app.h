@@ -26,6 +26,8 @@
 #include "ns3/lora-mac.h"
 #include "ns3/attribute.h"
 #include "ns3/end-device-lora-mac.h"
+#include "ns3/sequence-header.h"
+#include "ns3/fragmentation-session.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -128,6 +130,25 @@ public:
    */
   void EnableFragmentedDataReception (uint32_t first, uint32_t last=0);
 
+  /**
+   * Enable the reception of a fragmentation session sent by the network
+   * server, with NetworkServer::EnableFragmentationSession
+   * 
+   * The fragments received through the multicast ping slots are given to a
+   * FragmentDecoder, and the ImageComplete trace source is fired once the
+   * image is decoded, or ImageCorrupt if it does not match the one sent.
+   * 
+   * \param nbFrag the number of data fragments of the image
+   * \param nbParity the number of parity fragments sent after them
+   */
+  void EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity);
+
+  /**
+   * \return the decoder of the fragmentation session, 0 until the first
+   * fragment is received
+   */
+  Ptr<const FragmentDecoder> GetFragmentDecoder (void) const;
+
   /**
    * Set if using randomness in the packet size
    */
@@ -170,6 +191,20 @@ public:
    */
   void (*FragmentsMissed) (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress, uint32_t currentNumberOfFragmentsMissed, uint32_t totalNumberOfFragmentsMissed);
 
+  /**
+   * TracedCallback signature for the completion of the image of a
+   * fragmentation session
+   * 
+   * \param mcAddress multicast address of this device
+   * \param ucAddress unicast address of this device
+   * \param timeToComplete the time from the first fragment received to the
+   * decoding of the image
+   * \param fragmentsReceived the number of fragments, data and parity,
+   * received until then
+   */
+  typedef void (* ImageCompleteCallback) (LoraDeviceAddress mcAddress, LoraDeviceAddress ucAddress,
+                                          Time timeToComplete, uint32_t fragmentsReceived);
+
 private:
   /**
    * The interval between to consecutive send events
@@ -276,23 +311,14 @@ private:
      */
     uint FragmentReceived (Ptr<Packet const> packet, uint32_t& fragmentReceived)
     {
-      //maxSize could also be the size of the final fragement
-      uint8_t *buff = new uint8_t[maxSize] ();
-      
-      Ptr<Packet> copyPacket = packet->Copy ();
-      //Work on copy of the packet
-      copyPacket->CopyData (buff, maxSize);
-      //If packet is sequenced generate a packet with a data corresponding to 
-      //to the current sequence of a packet
-      uint32_t sequence = 0;
-      //divide sequence to byte stream backward side
-       //Should be reconstructed in the application side by redoing the process
-       for (uint8_t i = 0; i < maxSize; i++)
+      //The sequence is in the SequenceHeader at the start of the payload
+      SequenceHeader sequenceHeader;
+      if (packet->GetSize () > 0)
         {
-          uint8_t seq = buff[i];
-          sequence += (uint)seq*(std::pow (10, i));
-          //\TODO Terminate the loop if it is too much zero or reach the final fragment equivalent number
+          sequenceHeader.SetSize (packet->GetSize ());
+          packet->PeekHeader (sequenceHeader);
         }
+      uint32_t sequence = sequenceHeader.GetSequence ();
        
       fragmentReceived = sequence;
        //std::cerr << "ExpectedFragment = " << expectedFragment << std::endl;
@@ -312,7 +338,7 @@ private:
       //Store all the missed fragements and adjust fragments
       for ( ; (int32_t)sequence - (int32_t)expectedFragment > 0; expectedFragment++ )
       {
-        missedFragments.push_back (expectedFragment);
+        nMissedFragments++;
         lastNumberOfFragmentMissed++;
       }
       //adjust next expected fragment
@@ -323,13 +349,11 @@ private:
         std::cout << "Limit is approaching  " << expectedFragment << std::endl; 
       }
       
-      delete [] buff;
-      
-      return missedFragments.size();
+      return nMissedFragments;
     }
     
     //Missed packets
-    std::list<uint32_t> missedFragments;
+    uint32_t nMissedFragments = 0;
     //First fragment 
     uint32_t startingFragment; 
     //Final fragment
@@ -370,6 +394,27 @@ private:
   };
   
   EnableFragmentedPacketDecoder m_enableFragmentedPacketDecoder;
+  
+  /**
+   * Give a fragment of the fragmentation session to the decoder
+   */
+  void SessionFragmentReceived (Ptr<const Packet> packet);
+  
+  uint16_t m_fragmentationNbFrag; ///< Data fragments of the session, 0 if disabled
+  uint16_t m_fragmentationNbParity; ///< Parity fragments of the session
+  Ptr<FragmentDecoder> m_fragmentDecoder; ///< Created with the first fragment
+  Time m_firstFragmentTime; ///< The time the first fragment was received
+  
+  /**
+   * Tracedcallback when the image of the fragmentation session is complete
+   */
+  TracedCallback <LoraDeviceAddress, LoraDeviceAddress, Time, uint32_t> m_imageComplete;
+  
+  /**
+   * Tracedcallback when the image of the fragmentation session is decoded
+   * but does not match the image of the session
+   */
+  TracedCallback <LoraDeviceAddress, LoraDeviceAddress, Time, uint32_t> m_imageCorrupt;
 
 
 };
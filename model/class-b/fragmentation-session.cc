@@ -0,0 +1,327 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/fragmentation-session.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("FragmentationSession");
+
+//////////////////////////
+// FragmentationSession //
+//////////////////////////
+
+FragmentationSession::FragmentationSession (uint16_t nbFrag, uint16_t nbParity,
+                                            uint8_t fragSize)
+  : m_nbFrag (nbFrag),
+  m_nbParity (nbParity),
+  m_fragSize (fragSize)
+{
+  NS_LOG_FUNCTION (this << nbFrag << nbParity << unsigned (fragSize));
+
+  NS_ASSERT_MSG (nbFrag > 0, "A session has at least one data fragment");
+  NS_ASSERT_MSG (fragSize > 0, "A fragment has at least one byte");
+}
+
+uint16_t
+FragmentationSession::GetNbFrag (void) const
+{
+  return m_nbFrag;
+}
+
+uint16_t
+FragmentationSession::GetNbParity (void) const
+{
+  return m_nbParity;
+}
+
+uint8_t
+FragmentationSession::GetFragSize (void) const
+{
+  return m_fragSize;
+}
+
+uint32_t
+FragmentationSession::GetNFragments (void) const
+{
+  return uint32_t (m_nbFrag) + m_nbParity;
+}
+
+uint32_t
+FragmentationSession::GetNWords (void) const
+{
+  return (m_nbFrag + 63) / 64;
+}
+
+uint8_t
+FragmentationSession::GetImageByte (uint32_t position)
+{
+  // Multiplicative hashing, so that neighbouring fragments differ
+  return uint8_t ((position * 2654435761u) >> 24);
+}
+
+uint32_t
+FragmentationSession::Prbs23 (uint32_t x)
+{
+  uint32_t b0 = x & 1;
+  uint32_t b1 = (x & 32) / 32;
+  return (x >> 1) + ((b0 ^ b1) << 22);
+}
+
+void
+FragmentationSession::GetLine (uint32_t index, std::vector<uint64_t> &line) const
+{
+  NS_ASSERT (index < GetNFragments ());
+
+  line.assign (GetNWords (), 0);
+
+  if (index < m_nbFrag)
+    {
+      line[index / 64] = uint64_t (1) << (index % 64);
+      return;
+    }
+
+  // Line N of the parity matrix, N starting from 1, has up to nbFrag / 2
+  // data fragments drawn with the PRBS23 generator
+  uint32_t n = index - m_nbFrag + 1;
+  uint32_t m = ((m_nbFrag & (m_nbFrag - 1)) == 0) ? 1 : 0;
+  uint32_t x = 1 + 1001 * n;
+  uint32_t nbCoeff = std::max (m_nbFrag / 2, 1);
+  for (uint32_t coeff = 0; coeff < nbCoeff; coeff++)
+    {
+      uint32_t r = 1 << 16;
+      while (r >= m_nbFrag)
+        {
+          x = Prbs23 (x);
+          r = x % (m_nbFrag + m);
+        }
+      line[r / 64] |= uint64_t (1) << (r % 64);
+    }
+}
+
+void
+FragmentationSession::GetFragment (uint32_t index, uint8_t *buffer) const
+{
+  NS_LOG_FUNCTION (this << index);
+
+  if (index < m_nbFrag)
+    {
+      for (uint32_t i = 0; i < m_fragSize; i++)
+        {
+          buffer[i] = GetImageByte (index * m_fragSize + i);
+        }
+      return;
+    }
+
+  std::fill (buffer, buffer + m_fragSize, 0);
+  std::vector<uint64_t> line;
+  GetLine (index, line);
+  for (uint32_t frag = 0; frag < m_nbFrag; frag++)
+    {
+      if (line[frag / 64] & (uint64_t (1) << (frag % 64)))
+        {
+          for (uint32_t i = 0; i < m_fragSize; i++)
+            {
+              buffer[i] ^= GetImageByte (frag * m_fragSize + i);
+            }
+        }
+    }
+}
+
+/////////////////////
+// FragmentDecoder //
+/////////////////////
+
+FragmentDecoder::FragmentDecoder (Ptr<const FragmentationSession> session)
+  : m_session (session),
+  m_nReceived (0),
+  m_nDataReceived (0)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_received.assign ((session->GetNFragments () + 63) / 64, 0);
+  m_pivots.assign (session->GetNbFrag (), -1);
+  m_rows.reserve (session->GetNbFrag ());
+}
+
+bool
+FragmentDecoder::TestBit (const std::vector<uint64_t> &line, uint32_t bit)
+{
+  return line[bit / 64] & (uint64_t (1) << (bit % 64));
+}
+
+void
+FragmentDecoder::XorRow (struct Row &row, const struct Row &other)
+{
+  for (uint32_t w = 0; w < row.line.size (); w++)
+    {
+      row.line[w] ^= other.line[w];
+    }
+  for (uint32_t i = 0; i < row.data.size (); i++)
+    {
+      row.data[i] ^= other.data[i];
+    }
+}
+
+bool
+FragmentDecoder::AddFragment (uint32_t index, const uint8_t *data)
+{
+  NS_LOG_FUNCTION (this << index);
+
+  NS_ASSERT (index < m_session->GetNFragments ());
+
+  if (TestBit (m_received, index))
+    {
+      NS_LOG_DEBUG ("Fragment " << index << " was already received");
+      return false;
+    }
+  m_received[index / 64] |= uint64_t (1) << (index % 64);
+  m_nReceived++;
+  if (index < m_session->GetNbFrag ())
+    {
+      m_nDataReceived++;
+    }
+
+  if (IsComplete ())
+    {
+      return false;
+    }
+
+  struct Row row;
+  m_session->GetLine (index, row.line);
+  row.data.assign (data, data + m_session->GetFragSize ());
+
+  // Remove the data fragments that already have a row, lowest first; each
+  // row only contains data fragments above its own
+  int32_t pivot = -1;
+  for (uint32_t frag = 0; frag < m_session->GetNbFrag (); frag++)
+    {
+      if (!TestBit (row.line, frag))
+        {
+          continue;
+        }
+      if (m_pivots[frag] < 0)
+        {
+          pivot = frag;
+          break;
+        }
+      XorRow (row, m_rows[m_pivots[frag]]);
+    }
+
+  if (pivot < 0)
+    {
+      NS_LOG_DEBUG ("Fragment " << index << " brings no new information");
+      return false;
+    }
+
+  m_pivots[pivot] = m_rows.size ();
+  m_rows.push_back (row);
+  NS_LOG_DEBUG ("Rank " << m_rows.size () << " of " << m_session->GetNbFrag ());
+
+  if (IsComplete ())
+    {
+      Solve ();
+    }
+  return true;
+}
+
+void
+FragmentDecoder::Solve (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // From the highest data fragment down, remove the fragments above the
+  // pivot, which are already solved
+  for (int32_t frag = m_session->GetNbFrag () - 1; frag >= 0; frag--)
+    {
+      struct Row &row = m_rows[m_pivots[frag]];
+      for (uint32_t other = frag + 1; other < m_session->GetNbFrag (); other++)
+        {
+          if (TestBit (row.line, other))
+            {
+              XorRow (row, m_rows[m_pivots[other]]);
+            }
+        }
+    }
+}
+
+bool
+FragmentDecoder::IsComplete (void) const
+{
+  return m_rows.size () == m_session->GetNbFrag ();
+}
+
+uint32_t
+FragmentDecoder::GetRank (void) const
+{
+  return m_rows.size ();
+}
+
+uint32_t
+FragmentDecoder::GetNReceived (void) const
+{
+  return m_nReceived;
+}
+
+uint32_t
+FragmentDecoder::GetNMissingDataFragments (void) const
+{
+  return m_session->GetNbFrag () - m_nDataReceived;
+}
+
+void
+FragmentDecoder::GetDataFragment (uint32_t index, uint8_t *buffer) const
+{
+  NS_ASSERT_MSG (IsComplete (), "The image is not complete");
+  NS_ASSERT (index < m_session->GetNbFrag ());
+
+  const struct Row &row = m_rows[m_pivots[index]];
+  std::copy (row.data.begin (), row.data.end (), buffer);
+}
+
+bool
+FragmentDecoder::CheckImage (void) const
+{
+  if (!IsComplete ())
+    {
+      return false;
+    }
+
+  uint8_t fragSize = m_session->GetFragSize ();
+  for (uint32_t frag = 0; frag < m_session->GetNbFrag (); frag++)
+    {
+      const struct Row &row = m_rows[m_pivots[frag]];
+      for (uint32_t i = 0; i < fragSize; i++)
+        {
+          if (row.data[i] != FragmentationSession::GetImageByte (frag * fragSize + i))
+            {
+              return false;
+            }
+        }
+    }
+  return true;
+}
+
+}
+}
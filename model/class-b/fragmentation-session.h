@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef FRAGMENTATION_SESSION_H
+#define FRAGMENTATION_SESSION_H
+
+#include "ns3/simple-ref-count.h"
+#include "ns3/ptr.h"
+
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A fragmentation session, in the spirit of the LoRaWAN Fragmented Data
+ * Block Transport, used to send an image to a multicast group through the
+ * ping slots.
+ *
+ * The image is cut in nbFrag data fragments of fragSize bytes, which are
+ * followed by nbParity parity fragments. Fragment nbFrag + j - 1 is the XOR of
+ * the data fragments of line j of the parity matrix, which is drawn with the
+ * PRBS23 generator of the specification, so that the network server and the
+ * devices build the same matrix from the session parameters alone. A device
+ * can rebuild the image from any nbFrag fragments that are linearly
+ * independent, whatever the data fragments it missed.
+ *
+ * The content of the image is a fixed function of the byte position, so that
+ * a device can check the image it decoded.
+ */
+class FragmentationSession : public SimpleRefCount<FragmentationSession>
+{
+public:
+  /**
+   * \param nbFrag The number of data fragments of the image.
+   * \param nbParity The number of parity fragments sent after them.
+   * \param fragSize The size of a fragment in bytes.
+   */
+  FragmentationSession (uint16_t nbFrag, uint16_t nbParity, uint8_t fragSize);
+
+  uint16_t GetNbFrag (void) const;
+  uint16_t GetNbParity (void) const;
+  uint8_t GetFragSize (void) const;
+
+  /**
+   * \return the number of fragments of the session, data and parity.
+   */
+  uint32_t GetNFragments (void) const;
+
+  /**
+   * Write a fragment of the session.
+   *
+   * \param index The index of the fragment, from 0 to GetNFragments () - 1.
+   * \param buffer The buffer to fill, of at least fragSize bytes.
+   */
+  void GetFragment (uint32_t index, uint8_t *buffer) const;
+
+  /**
+   * Get the data fragments a fragment is made of, as a bitmap.
+   *
+   * \param index The index of the fragment.
+   * \param line The bitmap to fill, with bit i of word i / 64 set if data
+   * fragment i is in the fragment. It is resized to GetNWords ().
+   */
+  void GetLine (uint32_t index, std::vector<uint64_t> &line) const;
+
+  /**
+   * \return the number of 64 bit words of a bitmap of the data fragments.
+   */
+  uint32_t GetNWords (void) const;
+
+  /**
+   * \param position The position of a byte in the image.
+   * \return the value of the byte.
+   */
+  static uint8_t GetImageByte (uint32_t position);
+
+private:
+  /**
+   * The PRBS23 pseudo random generator of the parity matrix.
+   */
+  static uint32_t Prbs23 (uint32_t x);
+
+  uint16_t m_nbFrag;
+  uint16_t m_nbParity;
+  uint8_t m_fragSize;
+};
+
+/**
+ * The decoder of a fragmentation session at an end device.
+ *
+ * The fragments received are kept in a bitmap, so that repeated fragments are
+ * dropped. Each new fragment is reduced, by XOR, against the fragments kept
+ * so far, which are stored in row echelon form by the lowest data fragment
+ * they contain. A fragment that is not reduced to nothing adds one to the
+ * rank of the decoder; once the rank is nbFrag, the data fragments are solved
+ * by back substitution and the image is complete.
+ */
+class FragmentDecoder : public SimpleRefCount<FragmentDecoder>
+{
+public:
+  FragmentDecoder (Ptr<const FragmentationSession> session);
+
+  /**
+   * Add a received fragment.
+   *
+   * \param index The index of the fragment in the session.
+   * \param data The fragSize bytes of the fragment.
+   * \return true if the fragment brought new information.
+   */
+  bool AddFragment (uint32_t index, const uint8_t *data);
+
+  /**
+   * \return true if all the data fragments are known.
+   */
+  bool IsComplete (void) const;
+
+  /**
+   * \return the number of linearly independent fragments received.
+   */
+  uint32_t GetRank (void) const;
+
+  /**
+   * \return the number of different fragments received, data and parity.
+   */
+  uint32_t GetNReceived (void) const;
+
+  /**
+   * \return the number of data fragments that were not received as such.
+   */
+  uint32_t GetNMissingDataFragments (void) const;
+
+  /**
+   * Read a data fragment of a complete image.
+   *
+   * \param index The index of the data fragment.
+   * \param buffer The buffer to fill, of at least fragSize bytes.
+   */
+  void GetDataFragment (uint32_t index, uint8_t *buffer) const;
+
+  /**
+   * \return true if the image is complete and matches the image of the
+   * session.
+   */
+  bool CheckImage (void) const;
+
+private:
+  /// A fragment, as the data fragments it contains and its bytes
+  struct Row
+  {
+    std::vector<uint64_t> line;
+    std::vector<uint8_t> data;
+  };
+
+  /**
+   * Solve the data fragments once the rank is full.
+   */
+  void Solve (void);
+
+  static bool TestBit (const std::vector<uint64_t> &line, uint32_t bit);
+
+  /**
+   * XOR a row into another one.
+   */
+  static void XorRow (struct Row &row, const struct Row &other);
+
+  Ptr<const FragmentationSession> m_session;
+  std::vector<uint64_t> m_received; ///< Bitmap of the fragments received
+  uint32_t m_nReceived;
+  uint32_t m_nDataReceived;
+
+  std::vector<struct Row> m_rows;
+  std::vector<int32_t> m_pivots; ///< The row of each data fragment, -1 if none
+};
+
+}
+}
+#endif /* FRAGMENTATION_SESSION_H */
@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/sequence-header.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("SequenceHeader");
+
+const uint8_t SequenceHeader::MAX_SIZE;
+
+TypeId
+SequenceHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("SequenceHeader")
+    .SetParent<Header> ()
+    .AddConstructor<SequenceHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+SequenceHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+SequenceHeader::SequenceHeader ()
+  : m_sequence (0),
+  m_size (MAX_SIZE)
+{
+}
+
+SequenceHeader::~SequenceHeader ()
+{
+}
+
+uint32_t
+SequenceHeader::GetSerializedSize (void) const
+{
+  return m_size;
+}
+
+void
+SequenceHeader::Serialize (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this << m_sequence);
+
+  for (int8_t i = m_size - 1; i >= 0; i--)
+    {
+      start.WriteU8 (uint8_t (m_sequence >> (8 * i)));
+    }
+}
+
+uint32_t
+SequenceHeader::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_sequence = 0;
+  for (uint8_t i = 0; i < m_size; i++)
+    {
+      m_sequence = (m_sequence << 8) | start.ReadU8 ();
+    }
+  return m_size;
+}
+
+void
+SequenceHeader::Print (std::ostream &os) const
+{
+  os << "Sequence=" << m_sequence;
+}
+
+void
+SequenceHeader::SetSize (uint32_t payloadSize)
+{
+  NS_ASSERT_MSG (payloadSize > 0, "The payload has to hold at least one byte");
+
+  m_size = std::min<uint32_t> (payloadSize, MAX_SIZE);
+}
+
+void
+SequenceHeader::SetSequence (uint32_t sequence)
+{
+  m_sequence = sequence;
+}
+
+uint32_t
+SequenceHeader::GetSequence (void) const
+{
+  return m_sequence;
+}
+
+}
+}
@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef SEQUENCE_HEADER_H
+#define SEQUENCE_HEADER_H
+
+#include "ns3/header.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * This class represents the sequence number at the start of the payload of
+ * the sequenced ping downlinks.
+ *
+ * The sequence number is written in binary, most significant byte first, in
+ * the first 4 bytes of the payload. Payloads shorter than that only carry the
+ * low-order bytes of the sequence number, hence the size of the header has to
+ * be set to the size of the payload, with SetSize, before it is deserialized.
+ */
+class SequenceHeader : public Header
+{
+public:
+  /**
+   * The size of the header when the payload is large enough to hold it.
+   */
+  static const uint8_t MAX_SIZE = 4;
+
+  static TypeId GetTypeId (void);
+
+  SequenceHeader ();
+  ~SequenceHeader ();
+
+  // Pure virtual methods from Header that need to be implemented by this class
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+  /**
+   * Set the number of bytes of the header from the size of the payload.
+   *
+   * \param payloadSize The size of the payload, at least 1 byte.
+   */
+  void SetSize (uint32_t payloadSize);
+
+  /**
+   * Set the sequence number.
+   *
+   * \param sequence The sequence number.
+   */
+  void SetSequence (uint32_t sequence);
+
+  /**
+   * Get the sequence number.
+   *
+   * \return The sequence number, truncated to the size of the header.
+   */
+  uint32_t GetSequence (void) const;
+
+private:
+  uint32_t m_sequence; ///< The sequence number of the packet
+  uint8_t m_size; ///< The number of bytes of the header, 1 to MAX_SIZE
+};
+
+}
+}
+#endif /* SEQUENCE_HEADER_H */
@@ -18,6 +18,7 @@
 
 #include "ns3/correlated-shadowing-propagation-loss-model.h"
 #include "ns3/double.h"
+#include "ns3/uinteger.h"
 #include "ns3/log.h"
 #include <cmath>
 
@@ -41,14 +42,57 @@ CorrelatedShadowingPropagationLossModel::GetTypeId (void)
                    DoubleValue (110.0),
                    MakeDoubleAccessor
                      (&CorrelatedShadowingPropagationLossModel::m_correlationDistance),
-                   MakeDoubleChecker<double> ());
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("MaxShadowingMaps",
+                   "The maximum number of grid squares for which a shadowing "
+                   "map is kept, the least recently used one being dropped "
+                   "first. A dropped square gets a new, independent map when "
+                   "it is used again. 0 means no limit",
+                   UintegerValue (0),
+                   MakeUintegerAccessor
+                     (&CorrelatedShadowingPropagationLossModel::m_maxShadowingMaps),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxPositionsPerMap",
+                   "The maximum number of interpolated positions cached by "
+                   "each shadowing map, the least recently used one being "
+                   "dropped first. The vertices of the grid are dropped with "
+                   "the last position using them, so a dropped position is "
+                   "interpolated again to the same value only if its vertices "
+                   "are still used. 0 means no limit",
+                   UintegerValue (0),
+                   MakeUintegerAccessor
+                     (&CorrelatedShadowingPropagationLossModel::m_maxPositionsPerMap),
+                   MakeUintegerChecker<uint32_t> ());
   return tid;
 }
 
-CorrelatedShadowingPropagationLossModel::CorrelatedShadowingPropagationLossModel ()
+CorrelatedShadowingPropagationLossModel::CorrelatedShadowingPropagationLossModel () :
+  m_maxShadowingMaps (0),
+  m_maxPositionsPerMap (0)
 {
 }
 
+std::size_t
+CorrelatedShadowingPropagationLossModel::GetNShadowingMaps (void) const
+{
+  return m_shadowingGrid.size ();
+}
+
+int
+CorrelatedShadowingPropagationLossModel::GetSquareIndex (double coordinate,
+                                                         double correlationDistance)
+{
+  // (x > 0) - (x < 0) is the sign function
+  return ((coordinate > 0) - (coordinate < 0))
+         * ((std::fabs (coordinate) + correlationDistance / 2) / correlationDistance);
+}
+
+uint64_t
+CorrelatedShadowingPropagationLossModel::GetKey (int i, int j)
+{
+  return (uint64_t (uint32_t (i)) << 32) | uint32_t (j);
+}
+
 double
 CorrelatedShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
                                                         Ptr<MobilityModel> a,
@@ -66,20 +110,15 @@ CorrelatedShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
   double y = position.y;
 
   // Compute the coordinates of the grid square (i.e., round the raw position)
-  // (x > 0) - (x < 0) is the sign function
-  int xcoord =
-    ((x > 0) - (x < 0)) * ((std::fabs (x) + m_correlationDistance / 2) / m_correlationDistance);
-  int ycoord =
-    ((y > 0) - (y < 0)) * ((std::fabs (y) + m_correlationDistance / 2) / m_correlationDistance);
-
-  // Wrap coordinates up in a pair
-  std::pair<int, int> coordinates (xcoord, ycoord);
+  int xcoord = GetSquareIndex (x, m_correlationDistance);
+  int ycoord = GetSquareIndex (y, m_correlationDistance);
+  uint64_t coordinates = GetKey (xcoord, ycoord);
 
   NS_LOG_DEBUG ("x " << x << ", y " << y);
   NS_LOG_DEBUG ("xcoord " << xcoord << ", ycoord " << ycoord);
 
   // Look for the computed coordinates in the shadowingGrid
-  std::map<std::pair<int,int>, Ptr<ShadowingMap> >::const_iterator it;
+  std::unordered_map<uint64_t, std::pair<Ptr<ShadowingMap>, std::list<uint64_t>::iterator> >::iterator it;
 
   it = m_shadowingGrid.find (coordinates);
 
@@ -87,20 +126,37 @@ CorrelatedShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
     {
       // If this shadowing grid was not found, create it
       NS_LOG_DEBUG ("Creating a new shadowing map to be used at coordinates "
-                    << coordinates.first << " " << coordinates.second);
+                    << xcoord << " " << ycoord);
+
+      if (m_maxShadowingMaps > 0 && m_shadowingGrid.size () >= m_maxShadowingMaps)
+        {
+          NS_LOG_DEBUG ("Dropping the least recently used shadowing map");
+          m_shadowingGrid.erase (m_recentSquares.back ());
+          m_recentSquares.pop_back ();
+        }
 
       Ptr<ShadowingMap> shadowingMap =
-        Create<CorrelatedShadowingPropagationLossModel::ShadowingMap> ();
+        Create<CorrelatedShadowingPropagationLossModel::ShadowingMap>
+          (m_correlationDistance, m_maxPositionsPerMap);
 
-      m_shadowingGrid[coordinates] = shadowingMap;
+      std::list<uint64_t>::iterator recent = m_recentSquares.end ();
+      if (m_maxShadowingMaps > 0)
+        {
+          recent = m_recentSquares.insert (m_recentSquares.begin (), coordinates);
+        }
+      it = m_shadowingGrid.insert
+          (std::make_pair (coordinates, std::make_pair (shadowingMap, recent))).first;
     }
   else
     {
       NS_LOG_DEBUG ("This square already has its shadowingMap!");
-    }
 
-  // Place the iterator on the coordinates
-  it = m_shadowingGrid.find (coordinates);
+      if (m_maxShadowingMaps > 0)
+        {
+          m_recentSquares.splice (m_recentSquares.begin (), m_recentSquares,
+                                  it->second.second);
+        }
+    }
 
   // Get b's position in a's ShadowingMap
   CorrelatedShadowingPropagationLossModel::Position bPosition
@@ -108,7 +164,7 @@ CorrelatedShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
 
   // Use the map of the a MobilityModel to determine the value of shadowing
   // that corresponds to the position of the MobilityModel b.
-  double loss = it->second->GetLoss (bPosition);
+  double loss = it->second.first->GetLoss (bPosition);
 
   NS_LOG_INFO ("Shadowing loss: " << loss);
 
@@ -135,10 +191,23 @@ const double CorrelatedShadowingPropagationLossModel::ShadowingMap::m_kInv[4][4]
 };
 
 CorrelatedShadowingPropagationLossModel::ShadowingMap::ShadowingMap () :
+  m_maxPositions (0),
   m_correlationDistance (110)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+  m_shadowingValue = CreateObject<NormalRandomVariable> ();
+  m_shadowingValue->SetAttribute ("Mean", DoubleValue (0.0));
+  m_shadowingValue->SetAttribute ("Variance", DoubleValue (16.0));
+}
+
+CorrelatedShadowingPropagationLossModel::ShadowingMap::ShadowingMap
+  (double correlationDistance, uint32_t maxPositions) :
+  m_maxPositions (maxPositions),
+  m_correlationDistance (correlationDistance)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
   // The generation of new variables and positions along the grid is handled
   // by the GetLoss function. Here, we only create the normal random variable.
   m_shadowingValue = CreateObject<NormalRandomVariable> ();
@@ -151,110 +220,178 @@ CorrelatedShadowingPropagationLossModel::ShadowingMap::~ShadowingMap ()
   NS_LOG_FUNCTION_NOARGS ();
 }
 
+std::size_t
+CorrelatedShadowingPropagationLossModel::ShadowingMap::GetNPositions (void) const
+{
+  return m_shadowingMap.size ();
+}
+
+std::size_t
+CorrelatedShadowingPropagationLossModel::ShadowingMap::GetNVertices (void) const
+{
+  return m_vertices.size ();
+}
+
+std::size_t
+CorrelatedShadowingPropagationLossModel::ShadowingMap::PositionHash::operator()
+  (const std::pair<double, double> &position) const
+{
+  // 0 and -0 are equal, hence they must have the same hash
+  std::hash<double> hash;
+  std::size_t x = hash (position.first == 0 ? 0.0 : position.first);
+  std::size_t y = hash (position.second == 0 ? 0.0 : position.second);
+  return x ^ (y + 0x9e3779b9 + (x << 6) + (x >> 2));
+}
+
+int64_t
+CorrelatedShadowingPropagationLossModel::ShadowingMap::AssignStreams (int64_t stream)
+{
+  m_shadowingValue->SetStream (stream);
+  return 1;
+}
+
+double
+CorrelatedShadowingPropagationLossModel::ShadowingMap::GetVertexValue (int i, int j)
+{
+  uint64_t key = GetKey (i, j);
+
+  std::unordered_map<uint64_t, std::pair<double, uint32_t> >::iterator it = m_vertices.find (key);
+  if (it == m_vertices.end ())
+    {
+      it = m_vertices.insert
+          (std::make_pair (key, std::make_pair (m_shadowingValue->GetValue (), 0))).first;
+    }
+
+  it->second.second++;
+  return it->second.first;
+}
+
+void
+CorrelatedShadowingPropagationLossModel::ShadowingMap::ReleaseVertices (int xcoord, int ycoord)
+{
+  for (int i = xcoord; i <= xcoord + 1; i++)
+    {
+      for (int j = ycoord; j <= ycoord + 1; j++)
+        {
+          std::unordered_map<uint64_t, std::pair<double, uint32_t> >::iterator it =
+            m_vertices.find (GetKey (i, j));
+          NS_ASSERT (it != m_vertices.end ());
+          if (--it->second.second == 0)
+            {
+              m_vertices.erase (it);
+            }
+        }
+    }
+}
+
 double
 CorrelatedShadowingPropagationLossModel::ShadowingMap::GetLoss
   (CorrelatedShadowingPropagationLossModel::Position position)
 {
   NS_LOG_FUNCTION (this << position.x << position.y);
 
-  // Verify whether this position is already in the shadowingMap. Since the
-  // Position implementation overloads the == operator, this comparison
-  // between doubles is ok and we can use std::map's find function.
-  std::map<CorrelatedShadowingPropagationLossModel::Position,
-           double>::const_iterator it;
-  it = m_shadowingMap.find (position);
+  std::pair<double, double> key (position.x, position.y);
 
-  // If it's not found (i.e, if find returns the end of the map), we need to
-  // generate the value at the specified position.
-  if (it == m_shadowingMap.end ())
-    {
-      // Get the coordinates of the position
-      double x = position.x;
-      double y = position.y;
-      int xcoord =
-        ((x > 0) - (x < 0)) * ((std::fabs (x) + m_correlationDistance / 2) / m_correlationDistance);
-      int ycoord =
-        ((y > 0) - (y < 0)) * ((std::fabs (y) + m_correlationDistance / 2) / m_correlationDistance);
-
-      // Verify whether there already are the 4 surrounding positions in the
-      // map
-      double xmin = xcoord * m_correlationDistance - m_correlationDistance / 2;
-      double xmax = xcoord * m_correlationDistance + m_correlationDistance / 2;
-      double ymin = ycoord * m_correlationDistance - m_correlationDistance / 2;
-      double ymax = ycoord * m_correlationDistance + m_correlationDistance / 2;
-
-      CorrelatedShadowingPropagationLossModel::Position lowerLeft (xmin, ymin);
-      CorrelatedShadowingPropagationLossModel::Position upperLeft (xmin, ymax);
-      CorrelatedShadowingPropagationLossModel::Position lowerRight (xmax, ymin);
-      CorrelatedShadowingPropagationLossModel::Position upperRight (xmax, ymax);
-
-      NS_LOG_DEBUG ("Generating a new shadowing value in the following quadrant:");
-      NS_LOG_DEBUG ("xmin " << xmin << ", xmax " << xmax <<
-                    ", ymin " << ymin << ", ymax " << ymax);
-
-      // Use the map's insert method to insert the coordinates of the 4
-      // surrounding positions (if they are already there, they won't be
-      // substituted thanks to the map's implementation).
-      // TODO: Avoid useless generation of ShadowingMap values. This can be
-      // done by performing some checks (and not leveraging the map
-      // implementation)
-      double q11 = m_shadowingValue->GetValue ();
-      NS_LOG_DEBUG ("Lower left corner: " << q11);
-      m_shadowingMap[lowerLeft] = q11;
-      double q12 = m_shadowingValue->GetValue ();
-      NS_LOG_DEBUG ("Upper left corner: " << q12);
-      m_shadowingMap[upperLeft] = q12;
-      double q21 = m_shadowingValue->GetValue ();
-      NS_LOG_DEBUG ("Lower right corner: " << q21);
-      m_shadowingMap[lowerRight] = q21;
-      double q22 = m_shadowingValue->GetValue ();
-      NS_LOG_DEBUG ("Upper right corner: " << q22);
-      m_shadowingMap[upperRight] = q22;
-
-      NS_LOG_DEBUG (q11 << " " << q12 << " " << q21 << " " << q22 << " ");
-
-      // The c matrix contains the positions of the 4 vertices
-      double c[2][4] = {{xmin, xmax, xmax, xmin}, {ymin, ymin, ymax, ymax}};
-
-      // For the following procedure, reference:
-      // S. Schlegel et al., "On the Interpolation of Data with Normally
-      // Distributed Uncertainty for Visualization", IEEE Transactions on
-      // Visualization and Computer Graphics, vol. 18, no. 12, Dec. 2012.
-
-      // Compute the phi coefficients
-      double phi1 = 0;
-      double phi2 = 0;
-      double phi3 = 0;
-      double phi4 = 0;
-
-      for (int j = 0; j < 4; j++)
-        {
-          double distance = sqrt ((c[0][j] - x) * (c[0][j] - x) + (c[1][j] - y) * (c[1][j] - y));
+  std::unordered_map<std::pair<double, double>, CachedPosition, PositionHash>::iterator it;
+  it = m_shadowingMap.find (key);
 
-          NS_LOG_DEBUG ("Distance: " << distance);
+  if (it != m_shadowingMap.end ())
+    {
+      NS_LOG_DEBUG ("Shadowing map for this location already exists");
 
-          double k = std::exp (-distance / m_correlationDistance);
-          phi1 = phi1 + m_kInv[0][j] * k;
-          phi2 = phi2 + m_kInv[1][j] * k;
-          phi3 = phi3 + m_kInv[2][j] * k;
-          phi4 = phi4 + m_kInv[3][j] * k;
+      if (m_maxPositions > 0)
+        {
+          m_recentPositions.splice (m_recentPositions.begin (), m_recentPositions,
+                                    it->second.recent);
         }
+      return it->second.loss;
+    }
 
-      NS_LOG_DEBUG ("Phi: " << phi1 << " " << phi2 << " " << phi3 << " " <<
-                    phi4 << " ");
+  // The value is not there, we need to generate it at the specified position.
+  // Get the coordinates of the position
+  double x = position.x;
+  double y = position.y;
+  int xcoord = GetSquareIndex (x, m_correlationDistance);
+  int ycoord = GetSquareIndex (y, m_correlationDistance);
+
+  // The 4 surrounding vertices of the grid. The vertex of indices (i, j) is
+  // at (i * d - d / 2, j * d - d / 2).
+  double xmin = xcoord * m_correlationDistance - m_correlationDistance / 2;
+  double xmax = xcoord * m_correlationDistance + m_correlationDistance / 2;
+  double ymin = ycoord * m_correlationDistance - m_correlationDistance / 2;
+  double ymax = ycoord * m_correlationDistance + m_correlationDistance / 2;
+
+  NS_LOG_DEBUG ("Generating a new shadowing value in the following quadrant:");
+  NS_LOG_DEBUG ("xmin " << xmin << ", xmax " << xmax <<
+                ", ymin " << ymin << ", ymax " << ymax);
+
+  // Only the vertices that don't have a value yet get a new one
+  double q11 = GetVertexValue (xcoord, ycoord);
+  NS_LOG_DEBUG ("Lower left corner: " << q11);
+  double q12 = GetVertexValue (xcoord, ycoord + 1);
+  NS_LOG_DEBUG ("Upper left corner: " << q12);
+  double q21 = GetVertexValue (xcoord + 1, ycoord);
+  NS_LOG_DEBUG ("Lower right corner: " << q21);
+  double q22 = GetVertexValue (xcoord + 1, ycoord + 1);
+  NS_LOG_DEBUG ("Upper right corner: " << q22);
+
+  NS_LOG_DEBUG (q11 << " " << q12 << " " << q21 << " " << q22 << " ");
+
+  // The c matrix contains the positions of the 4 vertices
+  double c[2][4] = {{xmin, xmax, xmax, xmin}, {ymin, ymin, ymax, ymax}};
+
+  // For the following procedure, reference:
+  // S. Schlegel et al., "On the Interpolation of Data with Normally
+  // Distributed Uncertainty for Visualization", IEEE Transactions on
+  // Visualization and Computer Graphics, vol. 18, no. 12, Dec. 2012.
+
+  // Compute the phi coefficients
+  double phi1 = 0;
+  double phi2 = 0;
+  double phi3 = 0;
+  double phi4 = 0;
+
+  for (int j = 0; j < 4; j++)
+    {
+      double distance = sqrt ((c[0][j] - x) * (c[0][j] - x) + (c[1][j] - y) * (c[1][j] - y));
 
-      double shadowing = q11 * phi1 + q21 * phi2 + q22 * phi3 + q12 * phi4;
+      NS_LOG_DEBUG ("Distance: " << distance);
 
-      // Add the newly computed shadowing value to the shadowing map
-      m_shadowingMap[position] = shadowing;
-      NS_LOG_DEBUG ("Created new shadowing map: " << shadowing);
+      double k = std::exp (-distance / m_correlationDistance);
+      phi1 = phi1 + m_kInv[0][j] * k;
+      phi2 = phi2 + m_kInv[1][j] * k;
+      phi3 = phi3 + m_kInv[2][j] * k;
+      phi4 = phi4 + m_kInv[3][j] * k;
     }
-  else
+
+  NS_LOG_DEBUG ("Phi: " << phi1 << " " << phi2 << " " << phi3 << " " <<
+                phi4 << " ");
+
+  double shadowing = q11 * phi1 + q21 * phi2 + q22 * phi3 + q12 * phi4;
+
+  // Add the newly computed shadowing value to the shadowing map. The vertices
+  // of the evicted position are released only now, so that the ones it
+  // shares with the new position are kept.
+  CachedPosition cached;
+  cached.loss = shadowing;
+  cached.xcoord = xcoord;
+  cached.ycoord = ycoord;
+  cached.recent = m_recentPositions.end ();
+  if (m_maxPositions > 0)
     {
-      NS_LOG_DEBUG ("Shadowing map for this location already exists");
+      if (m_shadowingMap.size () >= m_maxPositions)
+        {
+          it = m_shadowingMap.find (m_recentPositions.back ());
+          ReleaseVertices (it->second.xcoord, it->second.ycoord);
+          m_shadowingMap.erase (it);
+          m_recentPositions.pop_back ();
+        }
+      cached.recent = m_recentPositions.insert (m_recentPositions.begin (), key);
     }
+  m_shadowingMap[key] = cached;
+  NS_LOG_DEBUG ("Created new shadowing map: " << shadowing);
 
-  return m_shadowingMap[position];
+  return shadowing;
 }
 
 /*****************************
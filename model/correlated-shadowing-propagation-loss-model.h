@@ -23,6 +23,9 @@
 #include "ns3/mobility-model.h"
 #include "ns3/vector.h"
 #include "ns3/random-variable-stream.h"
+#include <list>
+#include <unordered_map>
+#include <utility>
 
 namespace ns3 {
 class MobilityModel;
@@ -70,23 +73,106 @@ public:
      */
     ShadowingMap ();
 
+    /**
+     * Constructor.
+     *
+     * \param correlationDistance the spacing of the grid of independent
+     * shadowing values
+     * \param maxPositions the maximum number of interpolated positions that
+     * are kept, the least recently used one being evicted first, together
+     * with the vertices that only it used. 0 means no limit.
+     */
+    ShadowingMap (double correlationDistance, uint32_t maxPositions);
+
     ~ShadowingMap ();
 
     /**
      * Get the loss for a certain position.
      * If this position is not already in the map, add it by computing the
      * interpolation of neighboring shadowing values belonging to the grid.
+     * Vertices of the grid that already have a value are reused, so that
+     * neighboring squares share their common edges.
      */
     double GetLoss (CorrelatedShadowingPropagationLossModel::Position position);
 
+    /**
+     * Get the number of interpolated positions currently kept in the map.
+     */
+    std::size_t GetNPositions (void) const;
+
+    /**
+     * Get the number of vertices of the grid that have a shadowing value.
+     */
+    std::size_t GetNVertices (void) const;
+
+    /**
+     * Set the stream of the random variable drawing the shadowing values.
+     *
+     * \param stream the first stream index to use
+     * \return the number of stream indices used
+     */
+    int64_t AssignStreams (int64_t stream);
+
 private:
     /**
-     * For each Position, this map gives a corresponding loss.
-     * The map contains a basic grid that is initialized at construction
-     * time, and then newly computed values are added as they are created.
+     * A position kept in m_shadowingMap
+     */
+    struct CachedPosition
+    {
+      double loss;                            //!< The shadowing value at the position
+      int xcoord;                             //!< The index of the grid square along x
+      int ycoord;                             //!< The index of the grid square along y
+      std::list<std::pair<double, double> >::iterator recent;   //!< The entry of the position in m_recentPositions
+    };
+
+    /**
+     * Hash of the exact coordinates of a position
+     */
+    struct PositionHash
+    {
+      std::size_t operator() (const std::pair<double, double> &position) const;
+    };
+
+    /**
+     * Get the shadowing value at a vertex of the grid, drawing it if the
+     * vertex does not have one yet, and count one more cached position using
+     * it.
+     */
+    double GetVertexValue (int i, int j);
+
+    /**
+     * Release the 4 vertices of a grid square after one of its positions was
+     * evicted, dropping the ones no cached position uses anymore.
+     */
+    void ReleaseVertices (int xcoord, int ycoord);
+
+    /**
+     * For each Position, this map gives a corresponding loss, together with
+     * its grid square and its entry in m_recentPositions. Positions are keyed
+     * by their exact coordinates, so only the same position gets the same
+     * value without being interpolated again.
      */
-    std::map<CorrelatedShadowingPropagationLossModel::Position, double>
-    m_shadowingMap;
+    std::unordered_map<std::pair<double, double>, CachedPosition, PositionHash> m_shadowingMap;
+
+    /**
+     * The keys of m_shadowingMap, most recently used first. Only maintained
+     * when m_maxPositions is not 0.
+     */
+    std::list<std::pair<double, double> > m_recentPositions;
+
+    /**
+     * The maximum number of entries of m_shadowingMap, 0 for no limit
+     */
+    uint32_t m_maxPositions;
+
+    /**
+     * The independent shadowing values at the vertices of the grid, keyed by
+     * the indices of the vertex, together with the number of cached positions
+     * using each vertex. A vertex is dropped with the last of these positions,
+     * so that the vertices don't outgrow the positions when m_maxPositions is
+     * not 0.
+     */
+    std::unordered_map<uint64_t, std::pair<double, uint32_t> > m_vertices;
 
     /**
      * The distance after which two samples are to be considered almost
@@ -124,6 +210,11 @@ private:
    */
   double GetCorrelationDistance (void);
 
+  /**
+   * Get the number of grid squares that currently have a ShadowingMap.
+   */
+  std::size_t GetNShadowingMaps (void) const;
+
 private:
   virtual double DoCalcRxPower (double txPowerDbm,
                                 Ptr<MobilityModel> a,
@@ -131,8 +222,22 @@ private:
 
   virtual int64_t DoAssignStreams (int64_t stream);
 
+  /**
+   * Get the index of the grid square containing a coordinate
+   */
+  static int GetSquareIndex (double coordinate, double correlationDistance);
+
+  /**
+   * Pack a pair of indices of the grid in a single key for the hash maps
+   */
+  static uint64_t GetKey (int i, int j);
+
   double m_correlationDistance;     //!< The correlation distance for the ShadowingMap
 
+  uint32_t m_maxShadowingMaps;      //!< The maximum size of m_shadowingGrid, 0 for no limit
+
+  uint32_t m_maxPositionsPerMap;    //!< The maximum number of positions of each ShadowingMap
+
   /**
    * Map linking a square to a ShadowingMap.
    * Each square of the shadowing grid has a corresponding ShadowingMap, and a
@@ -169,8 +274,18 @@ private:
    *  Further, the ShadowingMap will be "smooth": when transmitting from point
    *  a to points b and c, the shadowing experienced by b and c will be similar
    *  if they are close (ideally, within a correlation distance).
+   *
+   *  The coordinates are packed with GetKey. Next to each ShadowingMap, its
+   *  entry in m_recentSquares is kept.
+   */
+  mutable std::unordered_map<uint64_t, std::pair<Ptr<ShadowingMap>, std::list<uint64_t>::iterator> >
+  m_shadowingGrid;
+
+  /**
+   * The keys of m_shadowingGrid, most recently used first. Only maintained
+   * when m_maxShadowingMaps is not 0.
    */
-  mutable std::map<std::pair<int, int>, Ptr<ShadowingMap> > m_shadowingGrid;
+  mutable std::list<uint64_t> m_recentSquares;
 };
 
 }
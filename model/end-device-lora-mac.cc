@@ -28,6 +28,7 @@
 #include "src/core/model/log-macros-enabled.h"
 #include "src/core/model/assert.h"
 #include "ns3/hop-count-tag.h"
+#include "ns3/lora-header-view.h"
 #include <algorithm>
 #include <complex>
 
@@ -195,7 +196,9 @@ EndDeviceLoraMac::EndDeviceLoraMac ()
   m_enableMulticast (false),
   m_relayActivated (false),
   m_relayPending (false),
-  maxHop (2)
+  maxHop (2),
+  m_beaconClock (0),
+  m_beaconClockEpoch (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -472,7 +475,7 @@ EndDeviceLoraMac::SendToPhy (Ptr<Packet> packetToSend)
 //////////////////////////
 
 void
-EndDeviceLoraMac::Receive (Ptr<Packet const> packet)
+EndDeviceLoraMac::Receive (Ptr<Packet const> packet, LoraTxMetadata metadata)
 {
   NS_LOG_FUNCTION (this << packet);
 
@@ -1619,16 +1622,19 @@ EndDeviceLoraMac::ResolveWithClassBAndGetTime(Ptr<const Packet> packet)
     if (m_macState == MAC_BEACON_GUARD)
       {
         NS_LOG_LOGIC ("Collision with beacon guard! implement Algorithm 1");
-        return  Simulator::GetDelayLeft (m_beaconInfo.endBeaconGuardEvent)
+        return  GetBeaconEventDelayLeft (m_beaconInfo.endBeaconGuardEvent,
+                                         m_beaconInfo.endBeaconGuardTime)
                 +
-                Simulator::GetDelayLeft (m_beaconInfo.endBeaconReservedEvent)
+                GetBeaconEventDelayLeft (m_beaconInfo.endBeaconReservedEvent,
+                                         m_beaconInfo.endBeaconReservedTime)
                 + 
                 Seconds (m_uniformRV->GetValue (0, (m_pingSlotInfo.pingOffset)*m_pingSlotInfo.slotLen.GetSeconds()));
       }
     else if (m_macState == MAC_BEACON_RESERVED)
       {
         NS_LOG_LOGIC ("Collision with beacon reserved! implement Algorithm 1");
-        return Simulator::GetDelayLeft(m_beaconInfo.endBeaconReservedEvent)
+        return GetBeaconEventDelayLeft (m_beaconInfo.endBeaconReservedEvent,
+                                        m_beaconInfo.endBeaconReservedTime)
                +
                Seconds (m_uniformRV->GetValue (0, (m_pingSlotInfo.pingOffset)*m_pingSlotInfo.slotLen.GetSeconds()));
       }
@@ -1650,7 +1656,8 @@ EndDeviceLoraMac::ResolveWithClassBAndGetTime(Ptr<const Packet> packet)
        //Variation of this with perfect airtime calculation could be tried.
       
        //Calculating the time when the beacon will start   
-       Time nextGuard = Simulator::GetDelayLeft (m_beaconInfo.nextBeaconGuardEvent);
+       Time nextGuard = GetBeaconEventDelayLeft (m_beaconInfo.nextBeaconGuardEvent,
+                                                 m_beaconInfo.nextBeaconGuardTime);
        
        //Calculating the total time required for TX+RX1+RX2 time
        //The Longest Tx time on SF 12 is 2,465.79ms (2.457seconds)
@@ -1767,9 +1774,7 @@ EndDeviceLoraMac::SwitchToClassB (void)
   Time nextBeaconGuard = nextAbsoluteBeaconGuardTime - Simulator::Now ();
   
   // Schedule the beaconGuard 
-  Simulator::Schedule (nextBeaconGuard,
-                       &EndDeviceLoraMac::StartBeaconGuard,
-                       this);
+  ScheduleBeaconEvent (nextBeaconGuard, BeaconClock::SEARCH_BEACON_GUARD);
   
   // Update beaconState
   m_beaconState = BEACON_SEARCH;
@@ -1811,6 +1816,10 @@ EndDeviceLoraMac::SwitchFromClassB (void)
   // Cancel upcoming beacon guard if any
   Simulator::Cancel(m_beaconInfo.nextBeaconGuardEvent);
   
+  // Drop the ping slots and beacon guard pending in the beacon clock if any
+  m_beaconClockEpoch++;
+  m_beaconInfo.nextBeaconGuardTime = Simulator::Now ();
+  
   NS_LOG_DEBUG ("Beacon unlocked, ping slot canceled, beaconGuard canceled and device switched to class A");
   //\todo Schedule an uplink with class B field set
 }
@@ -1863,9 +1872,9 @@ EndDeviceLoraMac::StartBeaconGuard (void)
         }
     }
   
-  m_beaconInfo.endBeaconGuardEvent = Simulator::Schedule (m_beaconInfo.beaconGuard,
-                                                          &EndDeviceLoraMac::EndBeaconGuard,
-                                                          this);
+  m_beaconInfo.endBeaconGuardTime = Simulator::Now () + m_beaconInfo.beaconGuard;
+  m_beaconInfo.endBeaconGuardEvent = ScheduleBeaconEvent (m_beaconInfo.beaconGuard,
+                                                          BeaconClock::END_BEACON_GUARD);
 }
 
 void
@@ -1873,9 +1882,7 @@ EndDeviceLoraMac::EndBeaconGuard (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
   //Now Start the Beacon_reserved period as the beacon guard is done
-  Simulator::Schedule (Seconds (0),
-                       &EndDeviceLoraMac::StartBeaconReserved,
-                       this);
+  ScheduleBeaconEvent (Seconds (0), BeaconClock::START_BEACON_RESERVED);
 }
 
 void
@@ -1911,17 +1918,16 @@ EndDeviceLoraMac::StartBeaconReserved (void)
                 GetBandwidthFromDataRate (m_classBReceiveWindowInfo.beaconReceiveWindowDataRate);
     
   // Schedule return to sleep after current beacon slot receive window duration
-  Simulator::Schedule (Seconds (m_classBReceiveWindowInfo.beaconReceiveWindowDurationInSymbols*tSym),
-                       &EndDeviceLoraMac::CloseBeaconReceiveWindow, 
-                       this);
+  ScheduleBeaconEvent (Seconds (m_classBReceiveWindowInfo.beaconReceiveWindowDurationInSymbols*tSym),
+                       BeaconClock::CLOSE_BEACON_WINDOW);
   
   NS_LOG_DEBUG ("The receive window opened for : " << Seconds (m_classBReceiveWindowInfo.beaconReceiveWindowDurationInSymbols*tSym));
   
   //Schedule release from beacon reserved so that the mac could start using the 
   //device for transmission and also schedule ping slots
-  m_beaconInfo.endBeaconReservedEvent = Simulator::Schedule (m_beaconInfo.beaconReserved,
-                                                             &EndDeviceLoraMac::EndBeaconReserved,
-                                                             this);
+  m_beaconInfo.endBeaconReservedTime = Simulator::Now () + m_beaconInfo.beaconReserved;
+  m_beaconInfo.endBeaconReservedEvent = ScheduleBeaconEvent (m_beaconInfo.beaconReserved,
+                                                             BeaconClock::END_BEACON_RESERVED);
   
   NS_LOG_DEBUG ("The beacon reserved finishes at: " << (Simulator::Now() + m_beaconInfo.beaconReserved));
 }
@@ -2026,9 +2032,9 @@ EndDeviceLoraMac::EndBeaconReserved (void)
         // The time gap between the end of Beacon_reserved and the start of 
         // the next Beacon_guard is after Beacon_window.
         // Need to store the event to cancel incase a switch to class A is requested in the middle
-        m_beaconInfo.nextBeaconGuardEvent = Simulator::Schedule (m_beaconInfo.beaconWindow,  
-                                                                 &EndDeviceLoraMac::StartBeaconGuard,
-                                                                 this);
+        m_beaconInfo.nextBeaconGuardTime = Simulator::Now () + m_beaconInfo.beaconWindow;
+        m_beaconInfo.nextBeaconGuardEvent = ScheduleBeaconEvent (m_beaconInfo.beaconWindow,  
+                                                                 BeaconClock::NEXT_BEACON_GUARD);
           
         break;
       case CLASS_C:
@@ -2103,10 +2109,7 @@ EndDeviceLoraMac::SchedulePingSlots (void)
     //When switch back to class A is requested cancel all the non expired events 
     
      Time slotTime = (m_pingSlotInfo.pingOffset+ slotIndex*m_pingSlotInfo.pingPeriod)*m_pingSlotInfo.slotLen; 
-     ping = Simulator::Schedule( slotTime, 
-                                 &EndDeviceLoraMac::OpenPingSlotReceiveWindow,
-                                 this,
-                                 slotIndex);
+     ping = ScheduleBeaconEvent (slotTime, BeaconClock::PING_SLOT, slotIndex);
      NS_ASSERT_MSG (slotTime < m_beaconInfo.beaconWindow, "A slot should only be placed within a beaconWindow duration!");
      NS_LOG_DEBUG ("Ping scheduled for index " << (int)slotIndex << " after " << slotTime.GetSeconds () << " seconds");
      slotIndex++;
@@ -2114,6 +2117,111 @@ EndDeviceLoraMac::SchedulePingSlots (void)
 }
 
 
+void
+EndDeviceLoraMac::SetBeaconClock (Ptr<BeaconClock> clock)
+{
+  NS_LOG_FUNCTION (this << clock);
+  
+  NS_ASSERT_MSG (m_deviceClass != CLASS_B && m_beaconState == BEACON_UNLOCKED,
+                 "The beacon clock can't be changed while operating in Class B");
+  
+  m_beaconClock = clock;
+}
+
+Ptr<BeaconClock>
+EndDeviceLoraMac::GetBeaconClock (void) const
+{
+  return m_beaconClock;
+}
+
+int64_t
+EndDeviceLoraMac::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  
+  m_uniformRV->SetStream (stream);
+  m_relayPower.decisionForRelayingRandomNumber->SetStream (stream + 1);
+  m_relayPower.relayPowerRandomNumber->SetStream (stream + 2);
+  return 3;
+}
+
+EventId
+EndDeviceLoraMac::ScheduleBeaconEvent (Time delay, enum BeaconClock::Event event, uint8_t slotIndex)
+{
+  if (m_beaconClock != 0)
+    {
+      m_beaconClock->Schedule (delay, this, event, slotIndex, m_beaconClockEpoch);
+      return EventId ();
+    }
+  
+  switch (event)
+    {
+    case BeaconClock::SEARCH_BEACON_GUARD:
+    case BeaconClock::NEXT_BEACON_GUARD:
+      return Simulator::Schedule (delay, &EndDeviceLoraMac::StartBeaconGuard, this);
+    case BeaconClock::END_BEACON_GUARD:
+      return Simulator::Schedule (delay, &EndDeviceLoraMac::EndBeaconGuard, this);
+    case BeaconClock::START_BEACON_RESERVED:
+      return Simulator::Schedule (delay, &EndDeviceLoraMac::StartBeaconReserved, this);
+    case BeaconClock::CLOSE_BEACON_WINDOW:
+      return Simulator::Schedule (delay, &EndDeviceLoraMac::CloseBeaconReceiveWindow, this);
+    case BeaconClock::END_BEACON_RESERVED:
+      return Simulator::Schedule (delay, &EndDeviceLoraMac::EndBeaconReserved, this);
+    case BeaconClock::PING_SLOT:
+      return Simulator::Schedule (delay, &EndDeviceLoraMac::OpenPingSlotReceiveWindow, this, slotIndex);
+    }
+  return EventId ();
+}
+
+void
+EndDeviceLoraMac::HandleBeaconClockEvent (enum BeaconClock::Event event, uint8_t slotIndex, uint32_t epoch)
+{
+  NS_LOG_FUNCTION (this << event << unsigned (slotIndex) << epoch);
+  
+  switch (event)
+    {
+    case BeaconClock::SEARCH_BEACON_GUARD:
+      StartBeaconGuard ();
+      break;
+    case BeaconClock::NEXT_BEACON_GUARD:
+      // Cancelled by a switch to Class A after it was scheduled
+      if (epoch == m_beaconClockEpoch)
+        {
+          StartBeaconGuard ();
+        }
+      break;
+    case BeaconClock::END_BEACON_GUARD:
+      EndBeaconGuard ();
+      break;
+    case BeaconClock::START_BEACON_RESERVED:
+      StartBeaconReserved ();
+      break;
+    case BeaconClock::CLOSE_BEACON_WINDOW:
+      CloseBeaconReceiveWindow ();
+      break;
+    case BeaconClock::END_BEACON_RESERVED:
+      EndBeaconReserved ();
+      break;
+    case BeaconClock::PING_SLOT:
+      if (epoch == m_beaconClockEpoch)
+        {
+          OpenPingSlotReceiveWindow (slotIndex);
+        }
+      break;
+    }
+}
+
+Time
+EndDeviceLoraMac::GetBeaconEventDelayLeft (const EventId& event, Time time) const
+{
+  if (m_beaconClock == 0)
+    {
+      return Simulator::GetDelayLeft (event);
+    }
+  
+  return time > Simulator::Now () ? time - Simulator::Now () : Seconds (0);
+}
+
 void
 EndDeviceLoraMac::BeaconMissed (void)
 {
@@ -2460,12 +2568,10 @@ EndDeviceLoraMac::PingReceived(Ptr<Packet const> packet)
   NS_ASSERT_MSG ((m_macState == MAC_PING_SLOT || m_macState == MAC_PING_SLOT_BEACON_GUARD), 
                  "Mac should has stayed in MAC_PING_SLOT!");
 
-  //Working on the copy of the packet 
-  Ptr<Packet> packetCopy = packet->Copy ();
-  
-  // Remove the Mac Header to get some information
+  // Peek at the headers, the packet is only copied if it is for us
   LoraMacHeader mHdr;
-  packetCopy->RemoveHeader (mHdr);
+  LoraFrameHeader fHdr;
+  LoraHeaderView::Peek (packet, mHdr, fHdr);
 
   NS_LOG_DEBUG ("Mac Header: " << mHdr);
 
@@ -2478,11 +2584,6 @@ EndDeviceLoraMac::PingReceived(Ptr<Packet const> packet)
     {
       NS_LOG_INFO ("Found a downlink packet.");
       
-      // Remove the Frame Header
-      LoraFrameHeader fHdr;
-      fHdr.SetAsDownlink ();
-      packetCopy->RemoveHeader (fHdr);
-      
      NS_LOG_DEBUG ("Frame Header: " << fHdr);
      
      // Determine whether this packet is for us
@@ -2491,6 +2592,14 @@ EndDeviceLoraMac::PingReceived(Ptr<Packet const> packet)
      // Is it a multicast message
      bool multicastMessage = (m_mcAddress == fHdr.GetAddress ());
      
+     // The payload that is passed up, without the headers
+     Ptr<Packet> packetCopy;
+     if (unicastMessage || multicastMessage)
+       {
+         packetCopy = packet->Copy ();
+         packetCopy->RemoveAtStart (mHdr.GetSerializedSize () + fHdr.GetSerializedSize ());
+       }
+     
      if (unicastMessage)
        {
           NS_LOG_INFO ("Unicast Ping Message!");
@@ -30,6 +30,7 @@
 #include "ns3/lora-device-address.h"
 #include "ns3/traced-value.h"
 #include "ns3/aes.h"
+#include "ns3/beacon-clock.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -91,8 +92,9 @@ public:
    * layer so that it's called when a packet is going up the stack.
    *
    * \param packet the received packet.
+   * \param metadata the spreading factor, frequency and power of the reception.
    */
-  virtual void Receive (Ptr<Packet const> packet);
+  virtual void Receive (Ptr<Packet const> packet, LoraTxMetadata metadata);
 
   virtual void FailedReception (Ptr<Packet const> packet);
 
@@ -543,6 +545,41 @@ public:
    */
   void BeaconReceived (Ptr<Packet const> packet);
   
+  /**
+   * \brief Set the clock that schedules the beacon period events
+   * 
+   * If set, the beacon guard, beacon reserved, beacon receive window and ping
+   * slot events are scheduled through the clock, which shares a single
+   * simulator event between all the devices that need it at the same time.
+   * It can only be changed while the device is not in class B.
+   * 
+   * \param clock the clock, 0 for the device to schedule its own events
+   */
+  void SetBeaconClock (Ptr<BeaconClock> clock);
+  
+  /**
+   * \return the clock that schedules the beacon period events, 0 if none
+   */
+  Ptr<BeaconClock> GetBeaconClock (void) const;
+  
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this MAC
+   * 
+   * \param stream the first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+  
+  /**
+   * \brief Handle an event scheduled through the BeaconClock
+   * 
+   * \param event the event
+   * \param slotIndex the index of the ping slot, for BeaconClock::PING_SLOT
+   * \param epoch the value of the epoch when the event was scheduled
+   */
+  void HandleBeaconClockEvent (enum BeaconClock::Event event, uint8_t slotIndex, uint32_t epoch);
+  
   
   
   ////////////////////////////////////////
@@ -882,6 +919,9 @@ private:
     Time beaconGuard = Seconds (3.0); ///< Beacon_guard, default 3.0 Seconds
     Time beaconWindow = Seconds (122.88); ///< Beacon_window, default 122.88 Seconds  
     Time tBeaconDelay = Seconds (0.015); ///< TBeaconDelay = 0.015 Seconds, not including +/-1uSec jitter
+    Time endBeaconGuardTime; ///< End of the beacon guard, when scheduled through a BeaconClock
+    Time endBeaconReservedTime; ///< End of the beacon reserved, when scheduled through a BeaconClock
+    Time nextBeaconGuardTime; ///< Upcoming beacon guard, when scheduled through a BeaconClock
   };
   
   /**
@@ -1299,6 +1339,31 @@ TracedValue<uint8_t> m_requiredTx;
   
   std::list<Ptr<Packet>> m_packetToRelay; ///< Packet to be relayed to the next
   
+  ///////////////////////////////////////////
+  // Shared beacon clock                  //
+  /////////////////////////////////////////
+  
+  /**
+   * \brief Schedule a beacon period event, through the BeaconClock if set
+   * 
+   * \param delay the delay after which the event fires
+   * \param event the event
+   * \param slotIndex the index of the ping slot, for BeaconClock::PING_SLOT
+   * \return the id of the event, which is void if the clock is used
+   */
+  EventId ScheduleBeaconEvent (Time delay, enum BeaconClock::Event event, uint8_t slotIndex = 0);
+  
+  /**
+   * \return the delay left before a beacon period event, either from its id
+   * or, if the BeaconClock is used, from its time
+   */
+  Time GetBeaconEventDelayLeft (const EventId& event, Time time) const;
+  
+  Ptr<BeaconClock> m_beaconClock; ///< The shared clock, 0 if none
+  
+  /// Incremented to drop the pending ping slots and beacon guard from the clock
+  uint32_t m_beaconClockEpoch;
+  
 };
 
 
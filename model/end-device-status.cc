@@ -23,6 +23,7 @@
 #include "ns3/simulator.h"
 #include "ns3/lora-mac-header.h"
 #include "ns3/lora-frame-header.h"
+#include "ns3/lora-header-view.h"
 #include "ns3/log.h"
 #include "ns3/pointer.h"
 #include "ns3/command-line.h"
@@ -240,20 +241,14 @@ EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket,
 
   NS_LOG_DEBUG (*this);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = receivedPacket->Copy ();
-
-  // Extract the headers
+  // Read the headers
   LoraMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
-
   LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
+  LoraHeaderView::Peek (receivedPacket, macHdr, frameHdr);
 
   // Update current parameters
   LoraTag tag;
-  myPacket->RemovePacketTag (tag);
+  receivedPacket->PeekPacketTag (tag);
   SetFirstReceiveWindowSpreadingFactor (tag.GetSpreadingFactor ());
   SetFirstReceiveWindowFrequency (tag.GetFrequency ());
 
@@ -274,12 +269,9 @@ EndDeviceStatus::InsertReceivedPacket (Ptr<Packet const> receivedPacket,
     {
       // Get the frame counter of the current packet to compare it with the
       // newly received one
-      Ptr<Packet> packetCopy = ((*it).first)->Copy ();
       LoraMacHeader currentMacHdr;
-      packetCopy->RemoveHeader (currentMacHdr);
       LoraFrameHeader currentFrameHdr;
-      frameHdr.SetAsUplink ();
-      packetCopy->RemoveHeader (currentFrameHdr);
+      LoraHeaderView::Peek ((*it).first, currentMacHdr, currentFrameHdr);
 
       NS_LOG_DEBUG ("Received packet's frame counter: " <<
                     unsigned(frameHdr.GetFCnt ()) <<
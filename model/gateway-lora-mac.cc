@@ -63,7 +63,7 @@ GatewayLoraMac::Send (Ptr<Packet> packet)
   
   // Get DataRate to send this packet with
   LoraTag tag;
-  packet->RemovePacketTag (tag);
+  packet->PeekPacketTag (tag);
   uint8_t dataRate = tag.GetDataRate ();
   double frequency = tag.GetFrequency ();
   bool beaconPacket = tag.IsBeaconPacket ();
@@ -84,7 +84,6 @@ GatewayLoraMac::Send (Ptr<Packet> packet)
   NS_LOG_DEBUG ("SF: " << unsigned (GetSfFromDataRate (dataRate)));
   NS_LOG_DEBUG ("BW: " << GetBandwidthFromDataRate (dataRate));
   NS_LOG_DEBUG ("Freq: " << frequency << " MHz");
-  packet->AddPacketTag (tag);
 
   LoraTxParameters params;
   params.sf = GetSfFromDataRate (dataRate);
@@ -120,15 +119,13 @@ GatewayLoraMac::IsTransmitting (void)
 }
 
 void
-GatewayLoraMac::Receive (Ptr<Packet const> packet)
+GatewayLoraMac::Receive (Ptr<Packet const> packet, LoraTxMetadata metadata)
 {
   NS_LOG_FUNCTION (this << packet);
 
-  // Make a copy of the packet to work on
-  Ptr<Packet> packetCopy = packet->Copy ();
-
+  // Peek at the received packet, it is only copied if it is forwarded
   BcnPayload bcnPayload;
-  packetCopy->PeekHeader (bcnPayload);
+  packet->PeekHeader (bcnPayload);
   
   //Drop right here if it is a beacon packet
   if (bcnPayload.GetBcnTime() != 0)
@@ -139,10 +136,19 @@ GatewayLoraMac::Receive (Ptr<Packet const> packet)
   
   // Only forward the packet if it's uplink
   LoraMacHeader macHdr;
-  packetCopy->PeekHeader (macHdr);
+  packet->PeekHeader (macHdr);
 
   if (macHdr.IsUplink ())
     {
+      Ptr<Packet> packetCopy = packet->Copy ();
+
+      // The metadata leaves the LoRa stack with the packet, towards the
+      // network server, so it is written in a LoraTag here, once
+      LoraTag tag (metadata.sf);
+      tag.SetFrequency (metadata.frequencyMHz);
+      tag.SetReceivePower (metadata.rxPowerDbm);
+      packetCopy->AddPacketTag (tag);
+
       m_device->GetObject<LoraNetDevice> ()->Receive (packetCopy);
 
       NS_LOG_DEBUG ("Received packet: " << packet);
@@ -179,6 +185,12 @@ GatewayLoraMac::GetWaitingTime (double frequency)
                                            (frequency));
 }
 
+Ptr<SubBand>
+GatewayLoraMac::GetSubBand (double frequency)
+{
+  return m_channelHelper.GetSubBandFromFrequency (frequency);
+}
+
 
 void
 GatewayLoraMac::EnableBeaconTransmission (void)
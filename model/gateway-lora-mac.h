@@ -44,7 +44,7 @@ public:
   bool IsTransmitting (void);
 
   // Implementation of the LoraMac interface
-  virtual void Receive (Ptr<Packet const> packet);
+  virtual void Receive (Ptr<Packet const> packet, LoraTxMetadata metadata);
 
   // Implementation of the LoraMac interface
   virtual void FailedReception (Ptr<Packet const> packet);
@@ -58,6 +58,14 @@ public:
    * \return The next transmission time.
    */
   Time GetWaitingTime (double frequency);
+
+  /**
+   * Get the SubBand whose duty cycle applies to the transmissions on a
+   * frequency.
+   *
+   * \return The SubBand, or 0 if the frequency is outside all of them.
+   */
+  Ptr<SubBand> GetSubBand (double frequency);
   
   //////////////////////////////
   // LoRaWAN Class B related //
@@ -19,8 +19,11 @@
  */
 
 #include "ns3/gateway-status.h"
+#include "ns3/lora-phy.h"
 #include "ns3/log.h"
 
+#include <algorithm>
+
 namespace ns3 {
 namespace lorawan {
 
@@ -51,7 +54,7 @@ GatewayStatus::GatewayStatus (Address address, Ptr<NetDevice> netDevice,
   m_address (address),
   m_netDevice (netDevice),
   m_gatewayMac (gwMac),
-  m_nextTransmissionTime (Seconds (0))
+  m_maxSpan (Seconds (0))
 {
   NS_LOG_FUNCTION (this);
 }
@@ -95,13 +98,6 @@ GatewayStatus::IsAvailableForTransmission (double frequency)
 {
   // We can't send multiple packets at once, see SX1301 V2.01 page 29
 
-  // Check that the gateway was not already "booked"
-  if (m_nextTransmissionTime > Simulator::Now () - MilliSeconds (1))
-    {
-      NS_LOG_INFO ("This gateway is already booked for a transmission");
-      return false;
-    }
-
   // Check that the gateway is not already in TX mode
   if (m_gatewayMac->IsTransmitting ())
     {
@@ -123,10 +119,204 @@ GatewayStatus::IsAvailableForTransmission (double frequency)
   return true;
 }
 
+bool
+GatewayStatus::Reserve (Time start, Time duration, double frequency,
+                        enum DownlinkClass downlinkClass, LoraDeviceAddress owner)
+{
+  NS_LOG_FUNCTION (this << start << duration << frequency << downlinkClass << owner);
+
+  Time now = Simulator::Now ();
+  NS_ASSERT (start >= now);
+  NS_ASSERT (duration > Seconds (0));
+
+  // Forget the downlinks whose off period is over
+  while (!m_calendar.empty () && m_calendar.begin ()->second.offEnd <= now)
+    {
+      m_calendar.erase (m_calendar.begin ());
+    }
+
+  if (start < GetSubBandAvailableTime (frequency))
+    {
+      NS_LOG_INFO ("The sub-band is still off at " << start.GetSeconds ());
+      return false;
+    }
+
+  struct Reservation reservation = MakeReservation (start, duration, frequency,
+                                                    downlinkClass, owner);
+  std::vector<Time> preempted;
+  Calendar::const_iterator blocking = GetBlockingReservation (start, reservation, preempted);
+  if (blocking != m_calendar.end ())
+    {
+      NS_LOG_INFO ("The gateway is already reserved for " << blocking->second.owner
+                                                          << " at " << blocking->first.GetSeconds ());
+      return false;
+    }
+
+  for (auto it = preempted.begin (); it != preempted.end (); ++it)
+    {
+      struct Reservation& other = m_calendar.at (*it);
+      NS_LOG_INFO ("Preempting the downlink to " << other.owner
+                                                 << " at " << it->GetSeconds ());
+      m_nPreempted[other.downlinkClass]++;
+      m_calendar.erase (*it);
+    }
+
+  m_calendar[start] = reservation;
+  m_maxSpan = std::max (m_maxSpan, reservation.offEnd - start);
+  return true;
+}
+
+Time
+GatewayStatus::GetEarliestStart (Time after, Time duration, double frequency,
+                                 enum DownlinkClass downlinkClass)
+{
+  NS_LOG_FUNCTION (this << after << duration << frequency << downlinkClass);
+
+  NS_ASSERT (duration > Seconds (0));
+
+  Time start = std::max (std::max (after, Simulator::Now ()),
+                         GetSubBandAvailableTime (frequency));
+  std::vector<Time> preempted;
+  while (true)
+    {
+      struct Reservation reservation = MakeReservation (start, duration, frequency,
+                                                        downlinkClass, LoraDeviceAddress ());
+      Calendar::const_iterator blocking = GetBlockingReservation (start, reservation, preempted);
+      if (blocking == m_calendar.end ())
+        {
+          return start;
+        }
+
+      // The downlink conflicts with the blocking reservation until it is over
+      // on air, or until the end of its off period on the same sub-band
+      if (reservation.subBand != 0 && blocking->second.subBand == reservation.subBand)
+        {
+          start = blocking->second.offEnd;
+        }
+      else
+        {
+          start = blocking->second.end;
+        }
+    }
+}
+
 void
-GatewayStatus::SetNextTransmissionTime (Time nextTransmissionTime)
+GatewayStatus::CancelReservation (Time start, LoraDeviceAddress owner)
 {
-  m_nextTransmissionTime = nextTransmissionTime;
+  NS_LOG_FUNCTION (this << start << owner);
+
+  if (IsReserved (start, owner))
+    {
+      m_calendar.erase (start);
+    }
+}
+
+bool
+GatewayStatus::IsReserved (Time start, LoraDeviceAddress owner) const
+{
+  auto it = m_calendar.find (start);
+  return it != m_calendar.end () && it->second.owner == owner;
+}
+
+bool
+GatewayStatus::ClaimReservation (Time duration, double frequency,
+                                 enum DownlinkClass downlinkClass, LoraDeviceAddress owner)
+{
+  NS_LOG_FUNCTION (this << duration << frequency << downlinkClass << owner);
+
+  Time now = Simulator::Now ();
+  return IsReserved (now, owner) || Reserve (now, duration, frequency, downlinkClass, owner);
+}
+
+uint32_t
+GatewayStatus::GetNPreempted (enum DownlinkClass downlinkClass) const
+{
+  auto it = m_nPreempted.find (downlinkClass);
+  return it == m_nPreempted.end () ? 0 : it->second;
+}
+
+Time
+GatewayStatus::GetOnAirTime (uint8_t dataRate, uint32_t size, bool isBeacon)
+{
+  // The same parameters as the ones of GatewayLoraMac::Send
+  LoraTxParameters params;
+  params.sf = m_gatewayMac->GetSfFromDataRate (dataRate);
+  params.headerDisabled = false;
+  params.codingRate = 1;
+  params.bandwidthHz = m_gatewayMac->GetBandwidthFromDataRate (dataRate);
+  params.nPreamble = (isBeacon ? 10 : 8);
+  params.crcEnabled = 1;
+  params.lowDataRateOptimizationEnabled = 0;
+
+  return LoraPhy::GetOnAirTime (size, params);
+}
+
+GatewayStatus::Calendar::const_iterator
+GatewayStatus::GetBlockingReservation (Time start, const struct Reservation& reservation,
+                                       std::vector<Time>& preempted)
+{
+  Time now = Simulator::Now ();
+  preempted.clear ();
+
+  // Only the reservations that start less than the longest span before the
+  // downlink can still be on air or off when it starts
+  for (Calendar::const_iterator it = m_calendar.lower_bound (start - m_maxSpan);
+       it != m_calendar.end () && it->first < reservation.offEnd; ++it)
+    {
+      bool onAir = it->first < reservation.end && start < it->second.end;
+      bool off = reservation.subBand != 0 && it->second.subBand == reservation.subBand
+        && start < it->second.offEnd;
+      if (!onAir && !off)
+        {
+          continue;
+        }
+
+      if (it->first <= now || it->second.downlinkClass <= reservation.downlinkClass)
+        {
+          return it;
+        }
+      preempted.push_back (it->first);
+    }
+
+  return m_calendar.end ();
+}
+
+struct GatewayStatus::Reservation
+GatewayStatus::MakeReservation (Time start, Time duration, double frequency,
+                                enum DownlinkClass downlinkClass, LoraDeviceAddress owner)
+{
+  struct Reservation reservation;
+  reservation.end = start + duration;
+  reservation.offEnd = reservation.end;
+  reservation.downlinkClass = downlinkClass;
+  reservation.owner = owner;
+
+  // Without a MAC, the gateway is not bound by any duty cycle
+  if (m_gatewayMac != 0)
+    {
+      reservation.subBand = m_gatewayMac->GetSubBand (frequency);
+    }
+  if (reservation.subBand != 0)
+    {
+      // The same off period as LogicalLoraChannelHelper::AddEvent
+      double timeOnAir = duration.GetSeconds ();
+      Time offEnd = start + Seconds (timeOnAir / reservation.subBand->GetDutyCycle ()
+                                     - timeOnAir);
+      reservation.offEnd = std::max (reservation.end, offEnd);
+    }
+
+  return reservation;
+}
+
+Time
+GatewayStatus::GetSubBandAvailableTime (double frequency)
+{
+  Time now = Simulator::Now ();
+  if (m_gatewayMac == 0 || m_gatewayMac->GetSubBand (frequency) == 0)
+    {
+      return now;
+    }
+  return now + m_gatewayMac->GetWaitingTime (frequency);
 }
 }
 }
@@ -25,13 +25,44 @@
 #include "ns3/address.h"
 #include "ns3/net-device.h"
 #include "ns3/gateway-lora-mac.h"
+#include "ns3/lora-device-address.h"
+
+#include <map>
+#include <vector>
 
 namespace ns3 {
 namespace lorawan {
 
+/**
+ * The knowledge of the network server about a gateway
+ *
+ * Besides the addresses of the gateway, it keeps the calendar of the
+ * downlinks the gateway is reserved for. Beacons, class A replies and class B
+ * ping slot downlinks are reserved in the calendar as soon as their time is
+ * known, so that a downlink of a higher priority is not blocked by one of a
+ * lower priority that is sent just before it.
+ *
+ * A reservation holds the gateway for the time on air of the downlink and its
+ * sub-band for the off period the duty cycle imposes after it, as the
+ * LogicalLoraChannelHelper of the gateway will count it once the downlink is
+ * sent. Two downlinks on the same sub-band are then only reserved if the
+ * duty cycle allows to send both.
+ */
 class GatewayStatus : public Object
 {
 public:
+  /**
+   * The classes of downlinks that share the gateway, from the highest to the
+   * lowest priority
+   */
+  enum DownlinkClass
+  {
+    BEACON,
+    CLASS_A_REPLY,
+    CLASS_B_UNICAST,
+    CLASS_B_MULTICAST
+  };
+
   static TypeId GetTypeId (void);
 
   GatewayStatus ();
@@ -72,23 +103,148 @@ public:
    * Query whether or not this gateway is available for immediate transmission
    * on this frequency.
    *
+   * Downlinks are booked through the calendar, this only checks the state of
+   * the gateway itself.
+   *
    * \param frequency The frequency at which the gateway's availability should
    * be queried.
    * \return True if the gateway's available, false otherwise.
    */
   bool IsAvailableForTransmission (double frequency);
 
-  void SetNextTransmissionTime (Time nextTransmissionTime);
-  // Time GetNextTransmissionTime (void);
+  /**
+   * Reserve the gateway for a downlink
+   *
+   * The downlink conflicts with the reservations it overlaps on air and with
+   * the ones on the same sub-band whose off period it overlaps, or that its
+   * own off period overlaps. The reservation is refused if the sub-band is
+   * still off because of the downlinks already sent, or if it conflicts with
+   * a downlink that has already started or with a reservation of the same or
+   * a higher priority. Otherwise, the reservations of a lower priority it
+   * conflicts with are preempted: they are removed from the calendar.
+   *
+   * \param start the time at which the downlink starts, not in the past
+   * \param duration the time on air of the downlink
+   * \param frequency the frequency of the downlink
+   * \param downlinkClass the class of the downlink, which gives its priority
+   * \param owner the device or the multicast group the downlink is sent to
+   * \return true if the gateway is reserved for the downlink
+   */
+  bool Reserve (Time start, Time duration, double frequency,
+                enum DownlinkClass downlinkClass, LoraDeviceAddress owner);
+
+  /**
+   * Get the earliest time, at or after a given one, at which the gateway can
+   * be reserved for a downlink, possibly by preempting downlinks of a lower
+   * priority.
+   *
+   * \param after the earliest time the downlink can start
+   * \param duration the time on air of the downlink
+   * \param frequency the frequency of the downlink
+   * \param downlinkClass the class of the downlink, which gives its priority
+   * \return the time at which Reserve would accept the downlink
+   */
+  Time GetEarliestStart (Time after, Time duration, double frequency,
+                         enum DownlinkClass downlinkClass);
+
+  /**
+   * Cancel the reservation of a downlink that is not going to be sent, if it
+   * is still in the calendar.
+   */
+  void CancelReservation (Time start, LoraDeviceAddress owner);
+
+  /**
+   * \return true if the reservation of a downlink is in the calendar, that is
+   * if it was made and was not preempted
+   */
+  bool IsReserved (Time start, LoraDeviceAddress owner) const;
+
+  /**
+   * Claim the gateway for a downlink that starts now, either with the
+   * reservation made for it in advance or, if there is none, with a new one.
+   *
+   * \return true if the downlink holds a reservation and can be sent
+   */
+  bool ClaimReservation (Time duration, double frequency, enum DownlinkClass downlinkClass,
+                         LoraDeviceAddress owner);
+
+  /**
+   * \return the number of reservations of a class that were preempted
+   */
+  uint32_t GetNPreempted (enum DownlinkClass downlinkClass) const;
+
+  /**
+   * Get the time on air of a downlink sent by this gateway.
+   *
+   * \param dataRate the data rate of the downlink
+   * \param size the size of the downlink, headers included, in bytes
+   * \param isBeacon whether the downlink is a beacon, which has a longer
+   * preamble
+   */
+  Time GetOnAirTime (uint8_t dataRate, uint32_t size, bool isBeacon = false);
 
 private:
+  /// A downlink the gateway is reserved for
+  struct Reservation
+  {
+    Time end;
+    Ptr<SubBand> subBand;
+    Time offEnd;          ///< The end of the off period of the sub-band
+    enum DownlinkClass downlinkClass;
+    LoraDeviceAddress owner;
+  };
+
+  typedef std::map<Time, struct Reservation> Calendar;
+
+  /**
+   * Get the first reservation a downlink would conflict with and could not
+   * preempt.
+   *
+   * \param start the time at which the downlink starts
+   * \param reservation the downlink
+   * \param preempted filled with the start times of the reservations the
+   * downlink would preempt
+   * \return the first reservation that blocks the downlink, or the end of
+   * the calendar if there is none
+   */
+  Calendar::const_iterator GetBlockingReservation (Time start,
+                                                   const struct Reservation& reservation,
+                                                   std::vector<Time>& preempted);
+
+  /**
+   * Describe a downlink as a reservation, with the off period its sub-band
+   * will have after it.
+   */
+  struct Reservation MakeReservation (Time start, Time duration, double frequency,
+                                      enum DownlinkClass downlinkClass,
+                                      LoraDeviceAddress owner);
+
+  /**
+   * \return the time before which the sub-band of a frequency is still off
+   * because of the downlinks already sent
+   */
+  Time GetSubBandAvailableTime (double frequency);
+
   Address m_address;   //!< The Address of the P2PNetDevice of this gateway
 
   Ptr<NetDevice> m_netDevice;     //!< The NetDevice through which to reach this gateway from the server
 
   Ptr<GatewayLoraMac> m_gatewayMac;     //!< The Mac layer of the gateway
 
-  Time m_nextTransmissionTime;   //!< This gateway's next transmission time
+  /**
+   * The reservations of the gateway by start time. They never overlap on air,
+   * so they are also ordered by end time.
+   */
+  Calendar m_calendar;
+
+  /**
+   * The longest time from the start of a reservation to the end of its off
+   * period, which bounds how far before a downlink the reservations it can
+   * conflict with start.
+   */
+  Time m_maxSpan;
+
+  std::map<enum DownlinkClass, uint32_t> m_nPreempted; //!< Preempted reservations by class
 };
 }
 
@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/link-budget-matrix.h"
+#include "ns3/log.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LinkBudgetMatrix");
+
+LinkBudgetMatrix::LinkBudgetMatrix ()
+{
+}
+
+LinkBudgetMatrix::LinkBudgetMatrix (std::vector<uint32_t> devices,
+                                    std::vector<uint32_t> gateways) :
+  m_devices (devices),
+  m_gateways (gateways),
+  m_losses (devices.size () * gateways.size (), 0)
+{
+}
+
+const std::vector<uint32_t>&
+LinkBudgetMatrix::GetDevices (void) const
+{
+  return m_devices;
+}
+
+const std::vector<uint32_t>&
+LinkBudgetMatrix::GetGateways (void) const
+{
+  return m_gateways;
+}
+
+void
+LinkBudgetMatrix::SetLoss (uint32_t device, uint32_t gateway, double lossDb)
+{
+  NS_ASSERT (device < m_devices.size () && gateway < m_gateways.size ());
+  m_losses[std::size_t (device) * m_gateways.size () + gateway] = lossDb;
+}
+
+double
+LinkBudgetMatrix::GetLoss (uint32_t device, uint32_t gateway) const
+{
+  NS_ASSERT (device < m_devices.size () && gateway < m_gateways.size ());
+  return m_losses[std::size_t (device) * m_gateways.size () + gateway];
+}
+
+bool
+LinkBudgetMatrix::Save (std::string fileName) const
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  std::ofstream file (fileName.c_str (), std::ios::binary | std::ios::trunc);
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Cannot open " << fileName);
+      return false;
+    }
+
+  uint32_t sizes[3] = {uint32_t (m_devices.size ()), uint32_t (m_gateways.size ()), 0};
+  file.write ("LLB1", 4);
+  file.write (reinterpret_cast<const char*> (sizes), sizeof (sizes));
+  file.write (reinterpret_cast<const char*> (m_devices.data ()),
+              m_devices.size () * sizeof (uint32_t));
+  file.write (reinterpret_cast<const char*> (m_gateways.data ()),
+              m_gateways.size () * sizeof (uint32_t));
+  file.write (reinterpret_cast<const char*> (m_losses.data ()),
+              m_losses.size () * sizeof (double));
+  file.close ();
+
+  if (file.fail ())
+    {
+      NS_LOG_ERROR ("Cannot write " << fileName);
+      return false;
+    }
+  return true;
+}
+
+Ptr<LinkBudgetMatrix>
+LinkBudgetMatrix::Load (std::string fileName)
+{
+  NS_LOG_FUNCTION (fileName);
+
+  std::ifstream file (fileName.c_str (), std::ios::binary);
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Cannot open " << fileName);
+      return 0;
+    }
+
+  char magic[4];
+  uint32_t sizes[3];
+  file.read (magic, 4);
+  file.read (reinterpret_cast<char*> (sizes), sizeof (sizes));
+  if (!file || std::memcmp (magic, "LLB1", 4) != 0)
+    {
+      NS_LOG_ERROR (fileName << " is not a link budget matrix");
+      return 0;
+    }
+
+  Ptr<LinkBudgetMatrix> matrix = Create<LinkBudgetMatrix> ();
+  matrix->m_devices.resize (sizes[0]);
+  matrix->m_gateways.resize (sizes[1]);
+  matrix->m_losses.resize (std::size_t (sizes[0]) * sizes[1]);
+  file.read (reinterpret_cast<char*> (matrix->m_devices.data ()),
+             matrix->m_devices.size () * sizeof (uint32_t));
+  file.read (reinterpret_cast<char*> (matrix->m_gateways.data ()),
+             matrix->m_gateways.size () * sizeof (uint32_t));
+  file.read (reinterpret_cast<char*> (matrix->m_losses.data ()),
+             matrix->m_losses.size () * sizeof (double));
+  if (!file)
+    {
+      NS_LOG_ERROR (fileName << " is truncated");
+      return 0;
+    }
+
+  NS_LOG_INFO ("Loaded the losses of " << sizes[0] << " end devices to "
+                                       << sizes[1] << " gateways from " << fileName);
+  return matrix;
+}
+
+}
+}
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef LINK_BUDGET_MATRIX_H
+#define LINK_BUDGET_MATRIX_H
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * The path loss between each end device and each gateway
+ *
+ * The matrix is computed by LinkBudgetHelper, and can be given to a
+ * LoraChannel so that the losses of the covered links are looked up instead
+ * of being computed for every packet. Nodes are identified by their node id,
+ * so a saved matrix can be loaded by any run that builds the same topology in
+ * the same order.
+ *
+ * The file holds, in host byte order, the magic string "LLB1", the number of
+ * end devices and of gateways as uint32_t, a reserved uint32_t, the node ids
+ * of the end devices and of the gateways as uint32_t, and then the losses in
+ * dB as doubles, row by row for each end device.
+ */
+class LinkBudgetMatrix : public SimpleRefCount<LinkBudgetMatrix>
+{
+public:
+  LinkBudgetMatrix ();
+
+  /**
+   * Constructor, with all the losses set to 0
+   *
+   * \param devices the node ids of the end devices
+   * \param gateways the node ids of the gateways
+   */
+  LinkBudgetMatrix (std::vector<uint32_t> devices, std::vector<uint32_t> gateways);
+
+  /**
+   * \return the node ids of the end devices
+   */
+  const std::vector<uint32_t>& GetDevices (void) const;
+
+  /**
+   * \return the node ids of the gateways
+   */
+  const std::vector<uint32_t>& GetGateways (void) const;
+
+  /**
+   * Set the loss between the device-th end device and the gateway-th gateway
+   */
+  void SetLoss (uint32_t device, uint32_t gateway, double lossDb);
+
+  /**
+   * \return the loss between the device-th end device and the gateway-th
+   * gateway, in dB
+   */
+  double GetLoss (uint32_t device, uint32_t gateway) const;
+
+  /**
+   * Write the matrix to a file
+   *
+   * \return whether the file was written
+   */
+  bool Save (std::string fileName) const;
+
+  /**
+   * Read a matrix written by Save
+   *
+   * \return the matrix, 0 if the file could not be read
+   */
+  static Ptr<LinkBudgetMatrix> Load (std::string fileName);
+
+private:
+  std::vector<uint32_t> m_devices;    //!< The node ids of the end devices
+  std::vector<uint32_t> m_gateways;   //!< The node ids of the gateways
+  std::vector<double> m_losses;       //!< The losses, row by row for each end device
+};
+
+}
+}
+
+#endif /* LINK_BUDGET_MATRIX_H */
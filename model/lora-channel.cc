@@ -26,6 +26,8 @@
 #include "ns3/simulator.h"
 #include "ns3/end-device-lora-phy.h"
 #include "ns3/gateway-lora-phy.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/node-list.h"
 #include <algorithm>
 
 namespace ns3 {
@@ -55,7 +57,11 @@ LoraChannel::GetTypeId (void)
     .AddTraceSource ("PacketSent",
                      "Trace source fired whenever a packet goes out on the channel",
                      MakeTraceSourceAccessor (&LoraChannel::m_packetSent),
-                     "ns3::Packet::TracedCallback");
+                     "ns3::Packet::TracedCallback")
+    .AddTraceSource ("TransmissionStarted",
+                     "Trace source fired once whenever a transmission starts on the channel",
+                     MakeTraceSourceAccessor (&LoraChannel::m_transmissionStarted),
+                     "ns3::LoraChannel::TransmissionStartedTracedCallback");
   return tid;
 }
 
@@ -118,6 +124,35 @@ LoraChannel::Send (Ptr< LoraPhy > sender, Ptr< Packet > packet,
 
   NS_ASSERT (senderMobility != 0);     // Make sure it's available
 
+  DoSend (sender, senderMobility, packet, txPowerDbm, txParams, duration,
+          frequencyMHz);
+}
+
+void
+LoraChannel::Send (Ptr<MobilityModel> senderMobility, Ptr<Packet> packet,
+                   double txPowerDbm, LoraTxParameters txParams,
+                   Time duration, double frequencyMHz) const
+{
+  NS_LOG_FUNCTION (this << senderMobility << packet << txPowerDbm << txParams <<
+                   duration << frequencyMHz);
+
+  NS_ASSERT (senderMobility != 0);
+
+  DoSend (0, senderMobility, packet, txPowerDbm, txParams, duration,
+          frequencyMHz);
+}
+
+void
+LoraChannel::DoSend (Ptr<LoraPhy> sender, Ptr<MobilityModel> senderMobility,
+                     Ptr<Packet> packet, double txPowerDbm,
+                     LoraTxParameters txParams, Time duration,
+                     double frequencyMHz) const
+{
+  LORA_PROFILE_SCOPE (CHANNEL_SEND);
+  LORA_PROFILE_ITEMS (m_phyList.size ());
+
+  m_transmissionStarted (packet, txParams.sf, frequencyMHz, duration);
+
   NS_LOG_INFO ("Starting cycle over all " << m_phyList.size () << " PHYs");
   NS_LOG_INFO ("Sender mobility: " << senderMobility->GetPosition ());
 
@@ -195,9 +230,83 @@ double
 LoraChannel::GetRxPower (double txPowerDbm, Ptr<MobilityModel> senderMobility,
                          Ptr<MobilityModel> receiverMobility) const
 {
+  if (m_linkBudget != 0)
+    {
+      std::unordered_map<const MobilityModel*, uint32_t>::const_iterator device;
+      std::unordered_map<const MobilityModel*, uint32_t>::const_iterator gateway;
+
+      // Look for the link in both directions
+      device = m_linkBudgetDevices.find (PeekPointer (senderMobility));
+      gateway = m_linkBudgetGateways.find (PeekPointer (receiverMobility));
+      if (device == m_linkBudgetDevices.end () || gateway == m_linkBudgetGateways.end ())
+        {
+          device = m_linkBudgetDevices.find (PeekPointer (receiverMobility));
+          gateway = m_linkBudgetGateways.find (PeekPointer (senderMobility));
+        }
+
+      if (device != m_linkBudgetDevices.end () && gateway != m_linkBudgetGateways.end ())
+        {
+          double rxPowerDbm = txPowerDbm - m_linkBudget->GetLoss (device->second,
+                                                                  gateway->second);
+          if (m_residualLoss != 0)
+            {
+              rxPowerDbm = m_residualLoss->CalcRxPower (rxPowerDbm, senderMobility,
+                                                        receiverMobility);
+            }
+          return rxPowerDbm;
+        }
+    }
+
   return m_loss->CalcRxPower (txPowerDbm, senderMobility, receiverMobility);
 }
 
+void
+LoraChannel::SetLinkBudget (Ptr<LinkBudgetMatrix> linkBudget,
+                            Ptr<PropagationLossModel> residual)
+{
+  NS_LOG_FUNCTION (this << linkBudget << residual);
+
+  m_linkBudget = linkBudget;
+  m_residualLoss = residual;
+  m_linkBudgetDevices.clear ();
+  m_linkBudgetGateways.clear ();
+
+  if (linkBudget == 0)
+    {
+      return;
+    }
+
+  const std::vector<uint32_t>& devices = linkBudget->GetDevices ();
+  for (uint32_t i = 0; i < devices.size (); i++)
+    {
+      if (devices[i] < NodeList::GetNNodes ())
+        {
+          Ptr<MobilityModel> mobility = NodeList::GetNode (devices[i])->GetObject<MobilityModel> ();
+          if (mobility != 0)
+            {
+              m_linkBudgetDevices[PeekPointer (mobility)] = i;
+              continue;
+            }
+        }
+      NS_LOG_WARN ("End device " << devices[i] << " of the link budget has no mobility model");
+    }
+
+  const std::vector<uint32_t>& gateways = linkBudget->GetGateways ();
+  for (uint32_t i = 0; i < gateways.size (); i++)
+    {
+      if (gateways[i] < NodeList::GetNNodes ())
+        {
+          Ptr<MobilityModel> mobility = NodeList::GetNode (gateways[i])->GetObject<MobilityModel> ();
+          if (mobility != 0)
+            {
+              m_linkBudgetGateways[PeekPointer (mobility)] = i;
+              continue;
+            }
+        }
+      NS_LOG_WARN ("Gateway " << gateways[i] << " of the link budget has no mobility model");
+    }
+}
+
 std::ostream &operator << (std::ostream &os, const LoraChannelParameters &params)
 {
   os << "(rxPowerDbm: " << params.rxPowerDbm << ", SF: " << unsigned(params.sf) <<
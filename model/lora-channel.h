@@ -25,6 +25,7 @@
 #define LORA_CHANNEL_H
 
 #include <vector>
+#include <unordered_map>
 #include "ns3/lora-phy.h"
 #include "ns3/mobility-model.h"
 #include "ns3/channel.h"
@@ -32,6 +33,7 @@
 #include "ns3/propagation-loss-model.h"
 #include "ns3/propagation-delay-model.h"
 #include "ns3/logical-lora-channel.h"
+#include "ns3/link-budget-matrix.h"
 #include "ns3/packet.h"
 #include "ns3/nstime.h"
 
@@ -138,6 +140,25 @@ public:
              LoraTxParameters txParams, Time duration, double frequencyMHz)
   const;
 
+  /**
+    * Send a packet in the channel from a position that is not the one of a
+    * connected PHY.
+    *
+    * This method is used by senders that do not have a PHY, like the devices
+    * of BackgroundTraffic. All connected PHYs are notified of the packet as in
+    * the Send method above.
+    *
+    * \param senderMobility The mobility model giving the sender's position.
+    * \param packet The PHY layer packet that is being sent over the channel.
+    * \param txPowerDbm The power of the transmission.
+    * \param txParams The set of parameters that are used by the transmitter.
+    * \param duration The on-air duration of this packet.
+    * \param frequencyMHz The frequency this transmission will happen at.
+    */
+  void Send (Ptr<MobilityModel> senderMobility, Ptr<Packet> packet,
+             double txPowerDbm, LoraTxParameters txParams, Time duration,
+             double frequencyMHz) const;
+
   /**
     * Compute the received power when transmitting from a point to another one.
     *
@@ -153,7 +174,42 @@ public:
   double GetRxPower (double txPowerDbm, Ptr<MobilityModel> senderMobility,
                      Ptr<MobilityModel> receiverMobility) const;
 
+  /**
+    * Use a precomputed LinkBudgetMatrix for the links it covers.
+    *
+    * For a link between an end device and a gateway of the matrix, in either
+    * direction, the loss is looked up in the matrix instead of being computed
+    * by the PropagationLossModel, and the residual model, if any, is applied
+    * on top of it. Other links still use the PropagationLossModel. Nodes are
+    * resolved through the NodeList when this method is called, and since the
+    * matrix is computed for fixed positions it is meant for static nodes.
+    *
+    * \param linkBudget The matrix, 0 to stop using it.
+    * \param residual The loss model for the parts of the loss that are not in
+    * the matrix, for instance the shadowing.
+    */
+  void SetLinkBudget (Ptr<LinkBudgetMatrix> linkBudget,
+                      Ptr<PropagationLossModel> residual = 0);
+
+  /**
+   * TracedCallback signature for the start of a transmission on the channel.
+   *
+   * \param packet The packet that is being sent.
+   * \param sf The Spreading Factor of the transmission.
+   * \param frequencyMHz The frequency of the transmission.
+   * \param duration The on-air duration of the transmission.
+   */
+  typedef void (* TransmissionStartedTracedCallback)
+    (Ptr<const Packet> packet, uint8_t sf, double frequencyMHz, Time duration);
+
 private:
+  /**
+    * Deliver a packet to all the connected PHYs but the sender, if any.
+    */
+  void DoSend (Ptr<LoraPhy> sender, Ptr<MobilityModel> senderMobility,
+               Ptr<Packet> packet, double txPowerDbm, LoraTxParameters txParams,
+               Time duration, double frequencyMHz) const;
+
   /**
     * Private method that is scheduled by LoraChannel's Send method to happen
     * after the channel delay, for each of the connected PHY layers.
@@ -187,11 +243,26 @@ private:
     */
   Ptr<PropagationDelayModel> m_delay;
 
+  /**
+    * The precomputed losses, if any, along with the loss model applied on top
+    * of them and the index of each end device and gateway in the matrix.
+    */
+  Ptr<LinkBudgetMatrix> m_linkBudget;
+  Ptr<PropagationLossModel> m_residualLoss;
+  std::unordered_map<const MobilityModel*, uint32_t> m_linkBudgetDevices;
+  std::unordered_map<const MobilityModel*, uint32_t> m_linkBudgetGateways;
+
   /**
    * Callback for when a packet is being sent on the channel.
    */
   TracedCallback<Ptr<const Packet> > m_packetSent;
 
+  /**
+   * Callback for when a transmission starts on the channel. Differently from
+   * m_packetSent, this is fired once per transmission.
+   */
+  TracedCallback<Ptr<const Packet>, uint8_t, double, Time> m_transmissionStarted;
+
 };
 
 } /* namespace ns3 */
@@ -37,7 +37,8 @@ LoraFrameHeader::LoraFrameHeader () :
   m_ack       (0),
   m_fPendingClassB  (0),
   m_fOptsLen  (0),
-  m_fCnt      (0)
+  m_fCnt      (0),
+  m_commandsDecoded (true)
 {
 }
 
@@ -84,22 +85,30 @@ LoraFrameHeader::Serialize (Buffer::Iterator start) const
   start.WriteU32 (m_address.Get ());
 
   // fCtrl field
+  // The FOptsLen takes the 4 low bits, as FOpts can be up to 15 bytes long
   uint8_t fCtrl = 0;
-  fCtrl |= uint8_t (m_adr << 6 & 0b1000000);
-  fCtrl |= uint8_t (m_adrAckReq << 5 & 0b100000);
-  fCtrl |= uint8_t (m_ack << 4 & 0b10000);
-  fCtrl |= uint8_t (m_fPendingClassB << 3 & 0b1000);
-  fCtrl |= m_fOptsLen & 0b111;
+  fCtrl |= uint8_t (m_adr << 7 & 0b10000000);
+  fCtrl |= uint8_t (m_adrAckReq << 6 & 0b1000000);
+  fCtrl |= uint8_t (m_ack << 5 & 0b100000);
+  fCtrl |= uint8_t (m_fPendingClassB << 4 & 0b10000);
+  fCtrl |= m_fOptsLen & 0b1111;
   start.WriteU8 (fCtrl);
 
   // FCnt field
   start.WriteU16 (m_fCnt);
 
   // FOpts field
-  for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
+  if (m_commandsDecoded)
     {
-      NS_LOG_DEBUG ("Serializing a MAC command");
-      (*it)->Serialize (start);
+      for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
+        {
+          NS_LOG_DEBUG ("Serializing a MAC command");
+          (*it)->Serialize (start);
+        }
+    }
+  else
+    {
+      start.Write (m_fOpts, m_fOptsLen);
     }
 
   // FPort
@@ -113,15 +122,16 @@ LoraFrameHeader::Deserialize (Buffer::Iterator start)
 
   // Empty the list of MAC commands
   m_macCommands.clear ();
+  m_commandsDecoded = true;
 
   // Read from buffer and save into local variables
   m_address.Set (start.ReadU32 ());
   uint8_t fCtl = start.ReadU8 ();
-  m_adr = (fCtl >> 6) & 0b1;
-  m_adrAckReq = (fCtl >> 5) & 0b1;
-  m_ack = (fCtl >> 4) & 0b1;
-  m_fPendingClassB = (fCtl >> 3) & 0b1;
-  m_fOptsLen = fCtl & 0b111;
+  m_adr = (fCtl >> 7) & 0b1;
+  m_adrAckReq = (fCtl >> 6) & 0b1;
+  m_ack = (fCtl >> 5) & 0b1;
+  m_fPendingClassB = (fCtl >> 4) & 0b1;
+  m_fOptsLen = fCtl & 0b1111;
   m_fCnt = start.ReadU16 ();
 
   NS_LOG_DEBUG ("Deserialized data: ");
@@ -133,182 +143,183 @@ LoraFrameHeader::Deserialize (Buffer::Iterator start)
   NS_LOG_DEBUG ("fOptsLen: " << unsigned (m_fOptsLen));
   NS_LOG_DEBUG ("fCnt: " << unsigned (m_fCnt));
 
+  // Keep the MAC commands as bytes, they are decoded when they are needed
+  start.Read (m_fOpts, m_fOptsLen);
+  m_commandsDecoded = (m_fOptsLen == 0);
+
+  m_fPort = uint8_t (start.ReadU8 ());
+
+  return 8 + m_fOptsLen;       // the number of bytes consumed.
+}
+
+void
+LoraFrameHeader::DecodeCommands (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  if (m_commandsDecoded)
+    {
+      return;
+    }
+  m_commandsDecoded = true;
+
   // Deserialize MAC commands
   NS_LOG_DEBUG ("Starting deserialization of MAC commands");
+  Buffer buffer;
+  buffer.AddAtStart (m_fOptsLen);
+  buffer.Begin ().Write (m_fOpts, m_fOptsLen);
+  Buffer::Iterator start = buffer.Begin ();
+
   for (uint8_t byteNumber = 0; byteNumber < m_fOptsLen;)
     {
       uint8_t cid = start.PeekU8 ();
       NS_LOG_DEBUG ("CID: " << unsigned(cid));
 
-      // Divide Uplink and Downlink messages
-      // This needs to be done because they have the same CID, and the context
-      // about where this message will be Serialized/Deserialized (i.e., at the
-      // ED or at the NS) is umportant.
-      if (m_isUplink)
+      // Uplink and downlink commands have the same CIDs, hence the context
+      // about where this message will be Serialized/Deserialized (i.e., at
+      // the ED or at the NS) is important. GetCommandType takes care of it.
+      uint8_t size;
+      enum MacCommandType type = GetCommandType (cid, m_isUplink, size);
+      if (type == INVALID || byteNumber + size > m_fOptsLen)
         {
-          switch (cid)
-            {
-            // In the case of Uplink messages, the NS will deserialize the
-            // request for a link check
-            case (0x02):
-              {
-                NS_LOG_DEBUG ("Creating a LinkCheckReq command");
-                Ptr<LinkCheckReq> command = Create <LinkCheckReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x03):
-              {
-                NS_LOG_DEBUG ("Creating a LinkAdrAns command");
-                Ptr<LinkAdrAns> command = Create <LinkAdrAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x04):
-              {
-                NS_LOG_DEBUG ("Creating a DutyCycleAns command");
-                Ptr<DutyCycleAns> command = Create <DutyCycleAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x05):
-              {
-                NS_LOG_DEBUG ("Creating a RxParamSetupAns command");
-                Ptr<RxParamSetupAns> command = Create <RxParamSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x06):
-              {
-                NS_LOG_DEBUG ("Creating a DevStatusAns command");
-                Ptr<DevStatusAns> command = Create <DevStatusAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x07):
-              {
-                NS_LOG_DEBUG ("Creating a NewChannelAns command");
-                Ptr<NewChannelAns> command = Create <NewChannelAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x08):
-              {
-                NS_LOG_DEBUG ("Creating a RxTimingSetupAns command");
-                Ptr<RxTimingSetupAns> command = Create <RxTimingSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x09):
-              {
-                NS_LOG_DEBUG ("Creating a TxParamSetupAns command");
-                Ptr<TxParamSetupAns> command = Create <TxParamSetupAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x0A):
-              {
-                NS_LOG_DEBUG ("Creating a DlChannelAns command");
-                Ptr<DlChannelAns> command = Create <DlChannelAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            default:
-              {
-                NS_LOG_ERROR ("CID not recognized during deserialization");
-              }
-            }
+          NS_LOG_ERROR ("CID not recognized or command truncated during deserialization");
+          // The size of the command is unknown, so the rest of FOpts can't be
+          // decoded. It is dropped, so that the header is serialized again
+          // with the decoded commands only.
+          m_fOptsLen = byteNumber;
+          break;
         }
-      else
+
+      Ptr<MacCommand> command = CreateMacCommand (type);
+      NS_LOG_DEBUG ("Creating a command of type " << type);
+      uint8_t read = command->Deserialize (start);
+      NS_ASSERT_MSG (read == size, "The size of the command doesn't match its CID");
+      byteNumber += read;
+      m_macCommands.push_back (command);
+    }
+}
+
+Ptr<MacCommand>
+LoraFrameHeader::CreateMacCommand (enum MacCommandType type)
+{
+  switch (type)
+    {
+    case (LINK_CHECK_REQ):
+      return Create<LinkCheckReq> ();
+    case (LINK_CHECK_ANS):
+      return Create<LinkCheckAns> ();
+    case (LINK_ADR_REQ):
+      return Create<LinkAdrReq> ();
+    case (LINK_ADR_ANS):
+      return Create<LinkAdrAns> ();
+    case (DUTY_CYCLE_REQ):
+      return Create<DutyCycleReq> ();
+    case (DUTY_CYCLE_ANS):
+      return Create<DutyCycleAns> ();
+    case (RX_PARAM_SETUP_REQ):
+      return Create<RxParamSetupReq> ();
+    case (RX_PARAM_SETUP_ANS):
+      return Create<RxParamSetupAns> ();
+    case (DEV_STATUS_REQ):
+      return Create<DevStatusReq> ();
+    case (DEV_STATUS_ANS):
+      return Create<DevStatusAns> ();
+    case (NEW_CHANNEL_REQ):
+      return Create<NewChannelReq> ();
+    case (NEW_CHANNEL_ANS):
+      return Create<NewChannelAns> ();
+    case (RX_TIMING_SETUP_REQ):
+      return Create<RxTimingSetupReq> ();
+    case (RX_TIMING_SETUP_ANS):
+      return Create<RxTimingSetupAns> ();
+    case (TX_PARAM_SETUP_REQ):
+      return Create<TxParamSetupReq> ();
+    case (TX_PARAM_SETUP_ANS):
+      return Create<TxParamSetupAns> ();
+    case (DL_CHANNEL_ANS):
+      return Create<DlChannelAns> ();
+    default:
+      NS_ASSERT_MSG (false, "No MAC command of type " << type);
+      return 0;
+    }
+}
+
+enum MacCommandType
+LoraFrameHeader::GetCommandType (uint8_t cid, bool isUplink, uint8_t &size)
+{
+  // Uplink commands are the answers of the end device, except for the
+  // LinkCheckReq, and downlink commands are the requests of the network
+  // server, except for the LinkCheckAns.
+  switch (cid)
+    {
+    case (0x02):
+      size = isUplink ? 1 : 3;
+      return isUplink ? LINK_CHECK_REQ : LINK_CHECK_ANS;
+    case (0x03):
+      size = isUplink ? 2 : 5;
+      return isUplink ? LINK_ADR_ANS : LINK_ADR_REQ;
+    case (0x04):
+      size = isUplink ? 1 : 2;
+      return isUplink ? DUTY_CYCLE_ANS : DUTY_CYCLE_REQ;
+    case (0x05):
+      size = isUplink ? 2 : 5;
+      return isUplink ? RX_PARAM_SETUP_ANS : RX_PARAM_SETUP_REQ;
+    case (0x06):
+      size = isUplink ? 3 : 1;
+      return isUplink ? DEV_STATUS_ANS : DEV_STATUS_REQ;
+    case (0x07):
+      size = isUplink ? 2 : 6;
+      return isUplink ? NEW_CHANNEL_ANS : NEW_CHANNEL_REQ;
+    case (0x08):
+      size = isUplink ? 1 : 2;
+      return isUplink ? RX_TIMING_SETUP_ANS : RX_TIMING_SETUP_REQ;
+    case (0x09):
+      size = 1;
+      return isUplink ? TX_PARAM_SETUP_ANS : TX_PARAM_SETUP_REQ;
+    case (0x0A):
+      size = isUplink ? 1 : 0;
+      return isUplink ? DL_CHANNEL_ANS : INVALID;
+    default:
+      size = 0;
+      return INVALID;
+    }
+}
+
+bool
+LoraFrameHeader::HasMacCommand (enum MacCommandType type) const
+{
+  NS_LOG_FUNCTION (this << type);
+
+  if (m_commandsDecoded)
+    {
+      for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
         {
-          switch (cid)
+          if ((*it)->GetCommandType () == type)
             {
-            // In the case of Downlink messages, the ED will deserialize the
-            // answer to a link check
-            case (0x02):
-              {
-                NS_LOG_DEBUG ("Creating a LinkCheckAns command");
-                Ptr<LinkCheckAns> command = Create <LinkCheckAns> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x03):
-              {
-                NS_LOG_DEBUG ("Creating a LinkAdrReq command");
-                Ptr<LinkAdrReq> command = Create <LinkAdrReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x04):
-              {
-                NS_LOG_DEBUG ("Creating a DutyCycleReq command");
-                Ptr<DutyCycleReq> command = Create <DutyCycleReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x05):
-              {
-                NS_LOG_DEBUG ("Creating a RxParamSetupReq command");
-                Ptr<RxParamSetupReq> command = Create <RxParamSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x06):
-              {
-                NS_LOG_DEBUG ("Creating a DevStatusReq command");
-                Ptr<DevStatusReq> command = Create <DevStatusReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x07):
-              {
-                NS_LOG_DEBUG ("Creating a NewChannelReq command");
-                Ptr<NewChannelReq> command = Create <NewChannelReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x08):
-              {
-                NS_LOG_DEBUG ("Creating a RxTimingSetupReq command");
-                Ptr<RxTimingSetupReq> command = Create <RxTimingSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            case (0x09):
-              {
-                NS_LOG_DEBUG ("Creating a TxParamSetupReq command");
-                Ptr<TxParamSetupReq> command = Create <TxParamSetupReq> ();
-                byteNumber += command->Deserialize (start);
-                m_macCommands.push_back (command);
-                break;
-              }
-            default:
-              {
-                NS_LOG_ERROR ("CID not recognized during deserialization");
-              }
+              return true;
             }
         }
+      return false;
     }
 
-  m_fPort = uint8_t (start.ReadU8 ());
-
-  return 8 + m_fOptsLen;       // the number of bytes consumed.
+  // Walk the FOpts bytes, from one CID to the next
+  uint8_t byteNumber = 0;
+  while (byteNumber < m_fOptsLen)
+    {
+      uint8_t size;
+      enum MacCommandType commandType = GetCommandType (m_fOpts[byteNumber],
+                                                        m_isUplink, size);
+      if (commandType == type)
+        {
+          return true;
+        }
+      if (size == 0)
+        {
+          return false;
+        }
+      byteNumber += size;
+    }
+  return false;
 }
 
 void
@@ -324,6 +335,7 @@ LoraFrameHeader::Print (std::ostream &os) const
   os << "FOptsLen=" << unsigned(m_fOptsLen) << std::endl;
   os << "FCnt=" << unsigned(m_fCnt) << std::endl;
 
+  DecodeCommands ();
   for (auto it = m_macCommands.begin (); it != m_macCommands.end (); it++)
     {
       (*it)->Print (os);
@@ -437,14 +449,8 @@ LoraFrameHeader::GetClassB () const
 uint8_t
 LoraFrameHeader::GetFOptsLen (void) const
 {
-  // Sum the serialized lenght of all commands in the list
-  uint8_t fOptsLen = 0;
-  std::list< Ptr< MacCommand> >::const_iterator it;
-  for (it = m_macCommands.begin (); it != m_macCommands.end (); it++)
-    {
-      fOptsLen = fOptsLen + (*it)->GetSerializedSize ();
-    }
-  return fOptsLen;
+  // Kept up to date by the Add methods and by deserialization
+  return m_fOptsLen;
 }
 
 void
@@ -465,6 +471,9 @@ LoraFrameHeader::AddLinkCheckReq (void)
   NS_LOG_FUNCTION_NOARGS ();
 
   Ptr<LinkCheckReq> command = Create<LinkCheckReq> ();
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   NS_LOG_DEBUG ("Command SerializedSize: " << unsigned(command->GetSerializedSize ()));
@@ -477,6 +486,9 @@ LoraFrameHeader::AddLinkCheckAns (uint8_t margin, uint8_t gwCnt)
   NS_LOG_FUNCTION (this << unsigned(margin) << unsigned(gwCnt));
 
   Ptr<LinkCheckAns> command = Create<LinkCheckAns> (margin, gwCnt);
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   m_fOptsLen += command->GetSerializedSize ();
@@ -498,6 +510,9 @@ LoraFrameHeader::AddLinkAdrReq (uint8_t dataRate, uint8_t txPower, std::list<int
   // TODO Implement chMaskCntl field
 
   Ptr<LinkAdrReq> command = Create<LinkAdrReq> (dataRate, txPower, channelMask, 0, repetitions);
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   m_fOptsLen += command->GetSerializedSize ();
@@ -509,6 +524,9 @@ LoraFrameHeader::AddLinkAdrAns (bool powerAck, bool dataRateAck, bool channelMas
   NS_LOG_FUNCTION (this << powerAck << dataRateAck << channelMaskAck);
 
   Ptr<LinkAdrAns> command = Create<LinkAdrAns> (powerAck, dataRateAck, channelMaskAck);
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   m_fOptsLen += command->GetSerializedSize ();
@@ -521,6 +539,9 @@ LoraFrameHeader::AddDutyCycleReq (uint8_t dutyCycle)
 
   Ptr<DutyCycleReq> command = Create<DutyCycleReq> (dutyCycle);
 
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   m_fOptsLen += command->GetSerializedSize ();
@@ -533,6 +554,9 @@ LoraFrameHeader::AddDutyCycleAns (void)
 
   Ptr<DutyCycleAns> command = Create<DutyCycleAns> ();
 
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   m_fOptsLen += command->GetSerializedSize ();
@@ -551,6 +575,9 @@ LoraFrameHeader::AddRxParamSetupReq (uint8_t rx1DrOffset, uint8_t rx2DataRate, d
                                                           rx2DataRate,
                                                           frequency);
 
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   m_fOptsLen += command->GetSerializedSize ();
@@ -563,6 +590,9 @@ LoraFrameHeader::AddRxParamSetupAns (void)
 
   Ptr<RxParamSetupAns> command = Create<RxParamSetupAns> ();
 
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   m_fOptsLen += command->GetSerializedSize ();
@@ -575,6 +605,9 @@ LoraFrameHeader::AddDevStatusReq (void)
 
   Ptr<DevStatusReq> command = Create<DevStatusReq> ();
 
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   m_fOptsLen += command->GetSerializedSize ();
@@ -589,6 +622,9 @@ LoraFrameHeader::AddNewChannelReq (uint8_t chIndex, double frequency,
   Ptr<NewChannelReq> command = Create<NewChannelReq> (chIndex, frequency,
                                                       minDataRate, maxDataRate);
 
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + command->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (command);
 
   m_fOptsLen += command->GetSerializedSize ();
@@ -599,6 +635,7 @@ LoraFrameHeader::GetCommands (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
+  DecodeCommands ();
   return m_macCommands;
 }
 
@@ -607,6 +644,9 @@ LoraFrameHeader::AddCommand (Ptr<MacCommand> macCommand)
 {
   NS_LOG_FUNCTION (this << macCommand);
 
+  DecodeCommands ();
+  NS_ASSERT_MSG (m_fOptsLen + macCommand->GetSerializedSize () <= MAX_FOPTS_LEN,
+                 "The MAC commands do not fit in FOpts");
   m_macCommands.push_back (macCommand);
   m_fOptsLen += macCommand->GetSerializedSize ();
 }
@@ -39,6 +39,12 @@ namespace lorawan {
  * header is for an uplink or downlink message. This is necessary due to the
  * fact that UL and DL messages have subtly different structure and, hence,
  * serialization and deserialization schemes.
+ *
+ * Deserialization only copies the FOpts field, at most 15 bytes, in an array
+ * inside the header. The MacCommand objects are only created when they are
+ * asked for, through GetMacCommand or GetCommands, so that reading a header
+ * does not allocate anything. HasMacCommand looks for a command in the FOpts
+ * bytes without creating the objects.
  */
 class LoraFrameHeader : public Header
 {
@@ -230,6 +236,15 @@ public:
   template<typename T>
   inline Ptr<T> GetMacCommand (void);
 
+  /**
+   * Check whether this header contains a MAC command of a given type, without
+   * creating the MacCommand objects.
+   *
+   * \param type The type of the command.
+   * \return True if the command is in this header.
+   */
+  bool HasMacCommand (enum MacCommandType type) const;
+
   /**
    * Add a LinkCheckReq command.
    */
@@ -313,7 +328,37 @@ public:
    */
   void AddCommand (Ptr<MacCommand> macCommand);
 
+  /**
+   * The maximum length of the FOpts field, in bytes.
+   */
+  static const uint8_t MAX_FOPTS_LEN = 15;
+
 private:
+  /**
+   * Create the MacCommand objects from the FOpts bytes of a deserialized
+   * header, if it was not done yet.
+   */
+  void DecodeCommands (void) const;
+
+  /**
+   * Get the type and the size of a MAC command from its CID.
+   *
+   * \param cid The CID of the command.
+   * \param isUplink Whether the command is in an uplink or a downlink.
+   * \param size The serialized size of the command, 0 if it is not known.
+   * \return The type of the command, INVALID if it is not known.
+   */
+  static enum MacCommandType GetCommandType (uint8_t cid, bool isUplink,
+                                             uint8_t &size);
+
+  /**
+   * Create an empty MAC command of a given type, to be deserialized.
+   *
+   * \param type The type of the command, not INVALID.
+   * \return The new command.
+   */
+  static Ptr<MacCommand> CreateMacCommand (enum MacCommandType type);
+
   uint8_t m_fPort;
 
   LoraDeviceAddress m_address;
@@ -322,17 +367,31 @@ private:
   bool m_adrAckReq;
   bool m_ack;
   bool m_fPendingClassB;
-  uint8_t m_fOptsLen;
+
+  /**
+   * The length of FOpts, cut to the decoded commands if DecodeCommands meets
+   * a command it doesn't know.
+   */
+  mutable uint8_t m_fOptsLen;
 
   uint16_t m_fCnt;
 
-  Buffer m_fOpts;
+  /**
+   * The FOpts bytes of a deserialized header, valid until the commands are
+   * decoded.
+   */
+  uint8_t m_fOpts[MAX_FOPTS_LEN];
 
   /**
    * List containing all the MacCommand instances that are contained in this
-   * LoraFrameHeader.
+   * LoraFrameHeader, valid once the commands are decoded.
    */
-  std::list< Ptr< MacCommand> > m_macCommands;
+  mutable std::list< Ptr< MacCommand> > m_macCommands;
+
+  /**
+   * Whether m_macCommands holds the commands, or they are still in m_fOpts.
+   */
+  mutable bool m_commandsDecoded;
 
   bool m_isUplink;
 };
@@ -342,6 +401,8 @@ template<typename T>
 Ptr<T>
 LoraFrameHeader::GetMacCommand ()
 {
+  DecodeCommands ();
+
   // Iterate on MAC commands and try casting
   std::list< Ptr< MacCommand> >::const_iterator it;
   for (it = m_macCommands.begin (); it != m_macCommands.end (); ++it)
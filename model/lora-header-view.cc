@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/lora-header-view.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("LoraHeaderView");
+
+TypeId
+LoraHeaderView::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("LoraHeaderView")
+    .SetParent<Header> ()
+  ;
+  return tid;
+}
+
+LoraHeaderView::LoraHeaderView (LoraMacHeader &macHdr, LoraFrameHeader &frameHdr)
+  : m_macHdr (&macHdr),
+  m_frameHdr (&frameHdr)
+{
+}
+
+LoraHeaderView::~LoraHeaderView ()
+{
+}
+
+void
+LoraHeaderView::Peek (Ptr<const Packet> packet, LoraMacHeader &macHdr,
+                      LoraFrameHeader &frameHdr)
+{
+  NS_LOG_FUNCTION (packet);
+
+  LoraHeaderView view (macHdr, frameHdr);
+  packet->PeekHeader (view);
+}
+
+TypeId
+LoraHeaderView::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+LoraHeaderView::GetSerializedSize (void) const
+{
+  return m_macHdr->GetSerializedSize () + m_frameHdr->GetSerializedSize ();
+}
+
+void
+LoraHeaderView::Serialize (Buffer::Iterator start) const
+{
+  m_macHdr->Serialize (start);
+  start.Next (m_macHdr->GetSerializedSize ());
+  m_frameHdr->Serialize (start);
+}
+
+uint32_t
+LoraHeaderView::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  uint32_t size = m_macHdr->Deserialize (start);
+  start.Next (size);
+
+  if (m_macHdr->IsUplink ())
+    {
+      m_frameHdr->SetAsUplink ();
+    }
+  else
+    {
+      m_frameHdr->SetAsDownlink ();
+    }
+
+  return size + m_frameHdr->Deserialize (start);
+}
+
+void
+LoraHeaderView::Print (std::ostream &os) const
+{
+  m_macHdr->Print (os);
+  os << " ";
+  m_frameHdr->Print (os);
+}
+
+}
+}
@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef LORA_HEADER_VIEW_H
+#define LORA_HEADER_VIEW_H
+
+#include "ns3/header.h"
+#include "ns3/packet.h"
+#include "ns3/lora-mac-header.h"
+#include "ns3/lora-frame-header.h"
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * A read-only view of the LoraMacHeader and LoraFrameHeader at the start of
+ * a packet.
+ *
+ * Reading the headers of a received packet used to take a copy of the packet
+ * and two RemoveHeader calls on it. Peeking this header instead deserializes
+ * both headers directly from the buffer of the packet, in the objects given
+ * to the view, without copying the packet or changing it. The direction of
+ * the frame header, which decides how its MAC commands are read, is set from
+ * the message type of the MAC header.
+ */
+class LoraHeaderView : public Header
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /**
+   * Create a view that deserializes into the given headers.
+   */
+  LoraHeaderView (LoraMacHeader &macHdr, LoraFrameHeader &frameHdr);
+  ~LoraHeaderView ();
+
+  /**
+   * Read the MAC and frame headers at the start of a packet.
+   *
+   * \param packet The packet, which is left untouched.
+   * \param macHdr The MAC header to fill.
+   * \param frameHdr The frame header to fill.
+   */
+  static void Peek (Ptr<const Packet> packet, LoraMacHeader &macHdr,
+                    LoraFrameHeader &frameHdr);
+
+  // Pure virtual methods from Header that need to be implemented by this class
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+
+private:
+  LoraMacHeader *m_macHdr;
+  LoraFrameHeader *m_frameHdr;
+};
+
+}
+}
+#endif /* LORA_HEADER_VIEW_H */
@@ -20,6 +20,8 @@
 
 #include "ns3/lora-interference-helper.h"
 #include "ns3/log.h"
+#include "ns3/lora-profiler.h"
+#include <algorithm>
 #include <limits>
 
 namespace ns3 {
@@ -125,7 +127,8 @@ LoraInterferenceHelper::GetTypeId (void)
   return tid;
 }
 
-LoraInterferenceHelper::LoraInterferenceHelper ()
+LoraInterferenceHelper::LoraInterferenceHelper () :
+  m_maxNumberOfEvents (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -182,6 +185,7 @@ LoraInterferenceHelper::Add (Time duration, double rxPower,
 
   // Add the event to the list
   m_events.push_back (event);
+  m_maxNumberOfEvents = std::max (m_maxNumberOfEvents, m_events.size ());
 
   // Clean the event list
   if (m_events.size () > 100)
@@ -214,6 +218,12 @@ LoraInterferenceHelper::GetInterferers ()
   return m_events;
 }
 
+std::size_t
+LoraInterferenceHelper::GetMaxNumberOfEvents (void) const
+{
+  return m_maxNumberOfEvents;
+}
+
 void
 LoraInterferenceHelper::PrintEvents (std::ostream &stream)
 {
@@ -236,6 +246,9 @@ LoraInterferenceHelper::IsDestroyedByInterference
 
   NS_LOG_INFO ("Current number of events in LoraInterferenceHelper: " << m_events.size ());
 
+  LORA_PROFILE_SCOPE (INTERFERENCE);
+  LORA_PROFILE_ITEMS (m_events.size ());
+
   // We want to see the interference affecting this event: cycle through events
   // that overlap with this one and see whether it survives the interference or
   // not.
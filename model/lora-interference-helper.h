@@ -157,6 +157,12 @@ private:
    */
   std::list< Ptr< LoraInterferenceHelper::Event > > GetInterferers ();
 
+  /**
+   * Get the largest number of events this InterferenceHelper kept track of
+   * at the same time.
+   */
+  std::size_t GetMaxNumberOfEvents (void) const;
+
   /**
    * Print the events that are saved in this helper in a human readable format.
    */
@@ -201,6 +207,11 @@ private:
    */
   std::list< Ptr< LoraInterferenceHelper::Event > > m_events;
 
+  /**
+   * The largest size m_events ever reached.
+   */
+  std::size_t m_maxNumberOfEvents;
+
   /**
    * The matrix containing information about how packets survive interference.
    */
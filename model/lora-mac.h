@@ -74,8 +74,9 @@ public:
    * Receive a packet from the lower layer.
    *
    * \param packet the received packet
+   * \param metadata the spreading factor, frequency and power of the reception
    */
-  virtual void Receive (Ptr<Packet const> packet) = 0;
+  virtual void Receive (Ptr<Packet const> packet, LoraTxMetadata metadata) = 0;
 
   /**
    * Function called by lower layers to inform this layer that reception of a
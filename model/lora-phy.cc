@@ -103,6 +103,12 @@ LoraPhy::GetChannel (void) const
   return m_channel;
 }
 
+const LoraInterferenceHelper&
+LoraPhy::GetInterferenceHelper (void) const
+{
+  return m_interference;
+}
+
 Ptr<MobilityModel>
 LoraPhy::GetMobility (void)
 {
@@ -158,9 +164,16 @@ LoraPhy::SetTxFinishedCallback (TxFinishedCallback callback)
 Time
 LoraPhy::GetOnAirTime (Ptr<Packet> packet, LoraTxParameters txParams)
 {
-
   NS_LOG_FUNCTION (packet << txParams);
 
+  return GetOnAirTime (packet->GetSize (), txParams);
+}
+
+Time
+LoraPhy::GetOnAirTime (uint32_t size, LoraTxParameters txParams)
+{
+  NS_LOG_FUNCTION (size << txParams);
+
   // The contents of this function are based on [1].
   // [1] SX1272 LoRa modem designer's guide.
 
@@ -172,7 +185,7 @@ LoraPhy::GetOnAirTime (Ptr<Packet> packet, LoraTxParameters txParams)
   double tPreamble = (double(txParams.nPreamble) + 4.25) * tSym;
 
   // Payload size
-  uint32_t pl = packet->GetSize ();      // Size in bytes
+  uint32_t pl = size;      // Size in bytes
   NS_LOG_DEBUG ("Packet of size " << pl << " bytes");
 
   // This step is needed since the formula deals with double values.
@@ -57,6 +57,18 @@ struct LoraTxParameters
  */
 std::ostream &operator << (std::ostream &os, const LoraTxParameters &params);
 
+/**
+ * Structure to collect the metadata of a received transmission, which is
+ * passed to the upper layer alongside the packet instead of being written in
+ * a LoraTag.
+ */
+struct LoraTxMetadata
+{
+  uint8_t sf = 0;     //!< Spreading Factor of the transmission
+  double frequencyMHz = 0;     //!< Frequency of the transmission
+  double rxPowerDbm = 0;     //!< Power the transmission was received with
+};
+
 /**
  * \ingroup lorawan
  *
@@ -84,9 +96,10 @@ public:
    * Type definition for a callback for when a packet is correctly received.
    *
    * This callback can be set by an upper layer that wishes to be informed of
-   * correct reception events.
+   * correct reception events. The metadata of the reception is passed along
+   * with the packet.
    */
-  typedef Callback<void, Ptr<const Packet> > RxOkCallback;
+  typedef Callback<void, Ptr<const Packet>, LoraTxMetadata> RxOkCallback;
 
   /**
    * Type definition for a callback for when a packet reception fails.
@@ -218,6 +231,14 @@ public:
    */
   Ptr<LoraChannel> GetChannel (void) const;
 
+  /**
+   * Get the LoraInterferenceHelper of this PHY.
+   *
+   * \return The LoraInterferenceHelper that keeps the signals impinging on
+   * this PHY.
+   */
+  const LoraInterferenceHelper& GetInterferenceHelper (void) const;
+
   /**
    * Get the NetDevice associated to this PHY.
    *
@@ -246,6 +267,16 @@ public:
    */
   static Time GetOnAirTime (Ptr<Packet> packet, LoraTxParameters txParams);
 
+  /**
+   * Compute the time that a packet of a given size will take to be
+   * transmitted, without needing the packet itself.
+   *
+   * \param size The size of the packet, in bytes, including its headers.
+   * \param txParams The set of parameters that will be used for transmission.
+   * \return The time necessary to transmit the packet.
+   */
+  static Time GetOnAirTime (uint32_t size, LoraTxParameters txParams);
+
 private:
   Ptr<MobilityModel> m_mobility;   //!< The mobility model associated to this PHY.
 
@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/lora-profiler.h"
+#include "ns3/simulator.h"
+
+#include <iomanip>
+#include <iostream>
+
+namespace ns3 {
+namespace lorawan {
+
+struct LoraProfiler::Counters LoraProfiler::m_counters[LoraProfiler::NUMBER_OF_PROBES] = {};
+bool LoraProfiler::m_destroyScheduled = false;
+bool LoraProfiler::m_printOnDestroy = true;
+
+LoraProfiler::Scope::Scope (enum Probe probe) :
+  m_probe (probe),
+  m_items (0),
+  m_start (std::chrono::steady_clock::now ())
+{
+}
+
+LoraProfiler::Scope::~Scope ()
+{
+  std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now () - m_start;
+  LoraProfiler::Record (m_probe,
+                        std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count (),
+                        m_items);
+}
+
+void
+LoraProfiler::Scope::SetItems (uint64_t items)
+{
+  m_items = items;
+}
+
+bool
+LoraProfiler::IsEnabled (void)
+{
+#ifdef LORAWAN_PROFILING
+  return true;
+#else
+  return false;
+#endif
+}
+
+void
+LoraProfiler::Record (enum Probe probe, uint64_t nanoseconds, uint64_t items)
+{
+  struct Counters& counters = m_counters[probe];
+  counters.calls++;
+  counters.nanoseconds += nanoseconds;
+  counters.items += items;
+  if (items > counters.maxItems)
+    {
+      counters.maxItems = items;
+    }
+
+  if (!m_destroyScheduled)
+    {
+      m_destroyScheduled = true;
+      Simulator::ScheduleDestroy (&LoraProfiler::DoDestroy);
+    }
+}
+
+struct LoraProfiler::Counters
+LoraProfiler::Get (enum Probe probe)
+{
+  return m_counters[probe];
+}
+
+std::string
+LoraProfiler::GetProbeName (enum Probe probe)
+{
+  switch (probe)
+    {
+    case CHANNEL_SEND:
+      return "LoraChannel::Send";
+    case INTERFERENCE:
+      return "LoraInterferenceHelper::IsDestroyedByInterference";
+    case GATEWAY_START_RECEIVE:
+      return "SimpleGatewayLoraPhy::StartReceive";
+    case GATEWAY_END_RECEIVE:
+      return "SimpleGatewayLoraPhy::EndReceive";
+    case PING_DOWNLINK:
+      return "NetworkScheduler::SendPingDownlink";
+    default:
+      return "Unknown";
+    }
+}
+
+void
+LoraProfiler::Reset (void)
+{
+  for (int i = 0; i < NUMBER_OF_PROBES; i++)
+    {
+      m_counters[i] = Counters ();
+    }
+}
+
+void
+LoraProfiler::Print (std::ostream& os)
+{
+  // The report changes the alignment and the precision of the stream, which
+  // are restored at the end
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+
+  os << std::left << std::setw (52) << "probe"
+     << std::right << std::setw (12) << "calls"
+     << std::setw (14) << "total ms"
+     << std::setw (12) << "ns/call"
+     << std::setw (12) << "avg items"
+     << std::setw (12) << "max items" << std::endl;
+
+  for (int i = 0; i < NUMBER_OF_PROBES; i++)
+    {
+      const struct Counters& counters = m_counters[i];
+      if (counters.calls == 0)
+        {
+          continue;
+        }
+      os << std::left << std::setw (52) << GetProbeName (Probe (i))
+         << std::right << std::setw (12) << counters.calls
+         << std::setw (14) << std::fixed << std::setprecision (3) << counters.nanoseconds / 1e6
+         << std::setw (12) << std::setprecision (0) << double (counters.nanoseconds) / counters.calls
+         << std::setw (12) << std::setprecision (2) << double (counters.items) / counters.calls
+         << std::setw (12) << counters.maxItems << std::endl;
+    }
+  os.flags (flags);
+  os.precision (precision);
+}
+
+void
+LoraProfiler::SetPrintOnDestroy (bool print)
+{
+  m_printOnDestroy = print;
+}
+
+void
+LoraProfiler::DoDestroy (void)
+{
+  if (m_printOnDestroy)
+    {
+      std::clog << "lorawan profiling report" << std::endl;
+      Print (std::clog);
+    }
+  Reset ();
+  m_destroyScheduled = false;
+}
+
+}
+}
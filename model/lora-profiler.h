@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef LORA_PROFILER_H
+#define LORA_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Counters of the hot paths of the lorawan module
+ *
+ * The probes are placed with the LORA_PROFILE_SCOPE and LORA_PROFILE_ITEMS
+ * macros, which expand to nothing unless the module is configured with
+ * --enable-lorawan-profiling (that is, unless LORAWAN_PROFILING is defined).
+ * Hence a normal build pays nothing for them.
+ *
+ * For each probe the number of calls, the cumulative wall time and the sum
+ * and maximum of a probe specific size (the fan-out of a transmission, the
+ * length of the interference list, ...) are kept. The counters are global,
+ * since the probed code runs in the single simulator thread.
+ *
+ * When profiling is compiled in, the report is printed to std::clog at
+ * Simulator::Destroy, after which the counters are reset. It can also be
+ * queried at any time with Get or Print.
+ */
+class LoraProfiler
+{
+public:
+  /// The instrumented code paths
+  enum Probe
+  {
+    CHANNEL_SEND,                 ///< LoraChannel::Send, items are the PHYs on the channel
+    INTERFERENCE,                 ///< LoraInterferenceHelper::IsDestroyedByInterference, items are the events in the list
+    GATEWAY_START_RECEIVE,        ///< SimpleGatewayLoraPhy::StartReceive, items are the reception paths scanned
+    GATEWAY_END_RECEIVE,          ///< SimpleGatewayLoraPhy::EndReceive
+    PING_DOWNLINK,                ///< NetworkScheduler::SendPingDownlink, items are the gateways used
+    NUMBER_OF_PROBES
+  };
+
+  /// The counters of a single probe
+  struct Counters
+  {
+    uint64_t calls;
+    uint64_t nanoseconds;   ///< Cumulative wall time
+    uint64_t items;         ///< Sum of the probe specific sizes
+    uint64_t maxItems;      ///< Maximum of the probe specific sizes
+  };
+
+  /**
+   * Measures the wall time of a scope and records it on destruction
+   */
+  class Scope
+  {
+public:
+    Scope (enum Probe probe);
+    ~Scope ();
+
+    /**
+     * Set the probe specific size of this call
+     */
+    void SetItems (uint64_t items);
+
+private:
+    enum Probe m_probe;
+    uint64_t m_items;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  /**
+   * \return whether the probes are compiled in
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * Add a call to the counters of a probe
+   */
+  static void Record (enum Probe probe, uint64_t nanoseconds, uint64_t items);
+
+  /**
+   * \return the counters of a probe
+   */
+  static struct Counters Get (enum Probe probe);
+
+  /**
+   * \return the name of a probe, as used in the report
+   */
+  static std::string GetProbeName (enum Probe probe);
+
+  /**
+   * Reset all the counters
+   */
+  static void Reset (void);
+
+  /**
+   * Print the report of all the probes that were called at least once
+   */
+  static void Print (std::ostream& os);
+
+  /**
+   * Set whether the report is printed at Simulator::Destroy, true by default
+   */
+  static void SetPrintOnDestroy (bool print);
+
+private:
+  /**
+   * Print the report and reset the counters, scheduled at Simulator::Destroy
+   */
+  static void DoDestroy (void);
+
+  static struct Counters m_counters[NUMBER_OF_PROBES];
+  static bool m_destroyScheduled;
+  static bool m_printOnDestroy;
+};
+
+}
+}
+
+#ifdef LORAWAN_PROFILING
+#define LORA_PROFILE_SCOPE(probe) \
+  ns3::lorawan::LoraProfiler::Scope loraProfilerScope (ns3::lorawan::LoraProfiler::probe)
+#define LORA_PROFILE_ITEMS(items) \
+  loraProfilerScope.SetItems (items)
+#else
+#define LORA_PROFILE_SCOPE(probe)
+#define LORA_PROFILE_ITEMS(items)
+#endif
+
+#endif /* LORA_PROFILER_H */
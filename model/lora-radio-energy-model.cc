@@ -17,6 +17,8 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
 #include "ns3/energy-source.h"
 #include "lora-radio-energy-model.h"
 
@@ -63,6 +65,13 @@ LoraRadioEnergyModel::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&LoraRadioEnergyModel::m_txCurrentModel),
                    MakePointerChecker<LoraTxCurrentModel> ())
+    .AddAttribute ("LazyEnergyUpdate",
+                   "Whether the energy source is only updated when its "
+                   "depletion threshold could be reached, instead of at "
+                   "every state change.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&LoraRadioEnergyModel::m_lazyEnergyUpdate),
+                   MakeBooleanChecker ())
     .AddTraceSource ("TotalEnergyConsumption",
                      "Total energy consumption of the radio device.",
                      MakeTraceSourceAccessor (&LoraRadioEnergyModel::m_totalEnergyConsumption),
@@ -78,6 +87,16 @@ LoraRadioEnergyModel::LoraRadioEnergyModel ()
   m_lastUpdateTime = Seconds (0.0);
   m_nPendingChangeState = 0;
   m_isSupersededChangeState = false;
+  m_lazyEnergyUpdate = false;
+  m_activity = ACTIVITY_IDLE;
+  for (int i = 0; i < NUMBER_OF_ACTIVITIES; i++)
+    {
+      m_activityEnergy[i] = 0;
+    }
+  m_pendingEnergy = 0;
+  m_lastSyncTime = Seconds (0.0);
+  m_energySinceMarginUpdate = 0;
+  m_syncMargin = 0;
   m_energyDepletionCallback.Nullify ();
   m_source = NULL;
   // set callback for EndDeviceLoraPhy listener
@@ -215,40 +234,21 @@ LoraRadioEnergyModel::ChangeState (int newState)
 {
   NS_LOG_FUNCTION (this << newState);
 
-  Time duration = Simulator::Now () - m_lastUpdateTime;
-  NS_ASSERT (duration.GetNanoSeconds () >= 0);     // check if duration is valid
-
-  // energy to decrease = current * voltage * time
-  double energyToDecrease = 0.0;
-  double supplyVoltage = m_source->GetSupplyVoltage ();
-  switch (m_currentState)
-    {
-    case EndDeviceLoraPhy::STANDBY:
-      energyToDecrease = duration.GetSeconds () * m_idleCurrentA * supplyVoltage;
-      break;
-    case EndDeviceLoraPhy::TX:
-      energyToDecrease = duration.GetSeconds () * m_txCurrentA * supplyVoltage;
-      break;
-    case EndDeviceLoraPhy::RX:
-      energyToDecrease = duration.GetSeconds () * m_rxCurrentA * supplyVoltage;
-      break;
-    case EndDeviceLoraPhy::SLEEP:
-      energyToDecrease = duration.GetSeconds () * m_sleepCurrentA * supplyVoltage;
-      break;
-    default:
-      NS_FATAL_ERROR ("LoraRadioEnergyModel:Undefined radio state: " << m_currentState);
-    }
-
   // update total energy consumption
-  m_totalEnergyConsumption += energyToDecrease;
-
-  // update last update time stamp
-  m_lastUpdateTime = Simulator::Now ();
+  m_totalEnergyConsumption += UpdateLedger ();
 
   m_nPendingChangeState++;
 
-  // notify energy source
-  m_source->UpdateEnergySource ();
+  // notify energy source, only when it could be depleted in lazy mode
+  if (!m_lazyEnergyUpdate)
+    {
+      m_source->UpdateEnergySource ();
+    }
+  else if (m_energySinceMarginUpdate >= m_syncMargin)
+    {
+      m_source->UpdateEnergySource ();
+      UpdateSyncMargin ();
+    }
 
   // in case the energy source is found to be depleted during the last update, a callback might be
   // invoked that might cause a change in the Lora PHY state (e.g., the PHY is put into SLEEP mode).
@@ -326,7 +326,39 @@ double
 LoraRadioEnergyModel::DoGetCurrentA (void) const
 {
   NS_LOG_FUNCTION (this);
-  switch (m_currentState)
+
+  double currentA = GetStateCurrentA (m_currentState);
+  if (!m_lazyEnergyUpdate)
+    {
+      return currentA;
+    }
+
+  // The source is integrating the current since its previous update: give it
+  // the average current of the energy in the ledger since then, plus the
+  // energy of the current state that is not in the ledger yet
+  Time now = Simulator::Now ();
+  Time duration = now - m_lastSyncTime;
+  if (duration.IsZero ())
+    {
+      return currentA;
+    }
+
+  double supplyVoltage = m_source->GetSupplyVoltage ();
+  double inProgress = (now - m_lastUpdateTime).GetSeconds () * currentA * supplyVoltage;
+  double averageCurrentA = (m_pendingEnergy + inProgress) / (duration.GetSeconds () * supplyVoltage);
+
+  // The energy of the current state up to now has been reported, and it will
+  // be added to the ledger with the next update
+  m_pendingEnergy = -inProgress;
+  m_lastSyncTime = now;
+
+  return averageCurrentA;
+}
+
+double
+LoraRadioEnergyModel::GetStateCurrentA (EndDeviceLoraPhy::State state) const
+{
+  switch (state)
     {
     case EndDeviceLoraPhy::STANDBY:
       return m_idleCurrentA;
@@ -337,7 +369,125 @@ LoraRadioEnergyModel::DoGetCurrentA (void) const
     case EndDeviceLoraPhy::SLEEP:
       return m_sleepCurrentA;
     default:
-      NS_FATAL_ERROR ("LoraRadioEnergyModel:Undefined radio state:" << m_currentState);
+      NS_FATAL_ERROR ("LoraRadioEnergyModel:Undefined radio state:" << state);
+    }
+}
+
+LoraRadioEnergyModel::Activity
+LoraRadioEnergyModel::GetCurrentActivity (void) const
+{
+  // Transmissions during a ping slot are relayed packets
+  if (m_activity == ACTIVITY_PING && m_currentState == EndDeviceLoraPhy::TX)
+    {
+      return ACTIVITY_RELAY;
+    }
+  return m_activity;
+}
+
+double
+LoraRadioEnergyModel::UpdateLedger (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time duration = Simulator::Now () - m_lastUpdateTime;
+  NS_ASSERT (duration.GetNanoSeconds () >= 0);     // check if duration is valid
+
+  // energy to decrease = current * voltage * time
+  double energy = duration.GetSeconds () * GetStateCurrentA (m_currentState)
+    * m_source->GetSupplyVoltage ();
+
+  m_stateDuration[m_currentState] += duration;
+  m_activityEnergy[GetCurrentActivity ()] += energy;
+  m_pendingEnergy += energy;
+  m_energySinceMarginUpdate += energy;
+
+  // update last update time stamp
+  m_lastUpdateTime = Simulator::Now ();
+
+  return energy;
+}
+
+void
+LoraRadioEnergyModel::UpdateSyncMargin (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  DoubleValue threshold (0);
+  m_source->GetAttributeFailSafe ("BasicEnergyLowBatteryThreshold", threshold);
+
+  double available = m_source->GetRemainingEnergy ()
+    - threshold.Get () * m_source->GetInitialEnergy ();
+  m_syncMargin = std::max (available, 0.0) / 2;
+  m_energySinceMarginUpdate = 0;
+
+  NS_LOG_DEBUG ("LoraRadioEnergyModel:Next source update after " << m_syncMargin << " J");
+}
+
+void
+LoraRadioEnergyModel::SetActivity (enum Activity activity)
+{
+  NS_LOG_FUNCTION (this << activity);
+
+  if (activity == m_activity)
+    {
+      return;
+    }
+
+  // The energy up to now goes to the previous activity
+  m_totalEnergyConsumption += UpdateLedger ();
+  m_activity = activity;
+}
+
+LoraRadioEnergyModel::Activity
+LoraRadioEnergyModel::GetActivity (void) const
+{
+  return m_activity;
+}
+
+double
+LoraRadioEnergyModel::GetActivityEnergy (enum Activity activity) const
+{
+  double energy = m_activityEnergy[activity];
+  if (activity == GetCurrentActivity () && m_source != 0)
+    {
+      energy += (Simulator::Now () - m_lastUpdateTime).GetSeconds ()
+        * GetStateCurrentA (m_currentState) * m_source->GetSupplyVoltage ();
+    }
+  return energy;
+}
+
+Time
+LoraRadioEnergyModel::GetStateDuration (EndDeviceLoraPhy::State state) const
+{
+  Time duration = m_stateDuration[state];
+  if (state == m_currentState)
+    {
+      duration += Simulator::Now () - m_lastUpdateTime;
+    }
+  return duration;
+}
+
+std::string
+LoraRadioEnergyModel::GetActivityName (enum Activity activity)
+{
+  switch (activity)
+    {
+    case ACTIVITY_IDLE:
+      return "Idle";
+    case ACTIVITY_UPLINK_TX:
+      return "UplinkTx";
+    case ACTIVITY_RX1:
+      return "Rx1";
+    case ACTIVITY_RX2:
+      return "Rx2";
+    case ACTIVITY_BEACON:
+      return "Beacon";
+    case ACTIVITY_PING:
+      return "Ping";
+    case ACTIVITY_RELAY:
+      return "Relay";
+    default:
+      return "Unknown";
     }
 }
 
@@ -123,6 +123,20 @@ private:
  * object. The EnergySource object will query this model for the total current.
  * Then the EnergySource object uses the total current to calculate energy.
  *
+ * With the LazyEnergyUpdate attribute, transactions only update a ledger of
+ * the time spent in each state and of the energy of each activity, and the
+ * EnergySource is notified only when the energy consumed since the last check
+ * could bring it down to its depletion threshold. When the EnergySource
+ * updates on its own (periodically, or because its remaining energy is
+ * queried) this model reports the average current since the previous update,
+ * so that the energy of the source is the same as with an update at every
+ * transaction. This assumes that the EnergySource is the only caller of
+ * GetCurrentA and that the model is the only one drawing from its source
+ * (the margin is halved to leave some room for others).
+ *
+ * The activity the energy is spent on (beacon, ping slot, uplink, receive
+ * windows, relaying) is set by the LoraRadioEnergyModelHelper from the MAC
+ * state of the device.
  */
 class LoraRadioEnergyModel : public DeviceEnergyModel
 {
@@ -137,6 +151,19 @@ public:
    */
   typedef Callback<void> LoraRadioEnergyRechargedCallback;
 
+  /// The activities the energy is accounted to
+  enum Activity
+  {
+    ACTIVITY_IDLE,        ///< Outside of any of the windows below
+    ACTIVITY_UPLINK_TX,   ///< Uplink transmission
+    ACTIVITY_RX1,         ///< First class A receive window
+    ACTIVITY_RX2,         ///< Second class A receive window
+    ACTIVITY_BEACON,      ///< Beacon guard and reserved
+    ACTIVITY_PING,        ///< Ping slot reception
+    ACTIVITY_RELAY,       ///< Transmission during a ping slot
+    NUMBER_OF_ACTIVITIES
+  };
+
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -280,6 +307,36 @@ public:
    */
   LoraRadioEnergyModelPhyListener * GetPhyListener (void);
 
+  /**
+   * \brief Sets the activity the following energy is accounted to.
+   *
+   * \param activity the new activity
+   */
+  void SetActivity (enum Activity activity);
+
+  /**
+   * \returns the current activity.
+   */
+  enum Activity GetActivity (void) const;
+
+  /**
+   * \param activity the activity
+   * \returns the energy consumed by an activity up to now, in J.
+   */
+  double GetActivityEnergy (enum Activity activity) const;
+
+  /**
+   * \param state the radio state
+   * \returns the time spent in a radio state up to now.
+   */
+  Time GetStateDuration (EndDeviceLoraPhy::State state) const;
+
+  /**
+   * \param activity the activity
+   * \returns the name of an activity.
+   */
+  static std::string GetActivityName (enum Activity activity);
+
 
 private:
   void DoDispose (void);
@@ -299,6 +356,30 @@ private:
    */
   void SetLoraRadioState (const EndDeviceLoraPhy::State state);
 
+  /**
+   * \returns the current of a radio state.
+   */
+  double GetStateCurrentA (EndDeviceLoraPhy::State state) const;
+
+  /**
+   * \returns the activity the energy of the current radio state goes to.
+   */
+  enum Activity GetCurrentActivity (void) const;
+
+  /**
+   * Account the energy since the last update to the current state and
+   * activity.
+   *
+   * \returns the energy since the last update, in J.
+   */
+  double UpdateLedger (void);
+
+  /**
+   * Compute the energy the source can still give before its depletion
+   * threshold, halved. Used in lazy mode after each update of the source.
+   */
+  void UpdateSyncMargin (void);
+
   Ptr<EnergySource> m_source; ///< energy source
 
   // Member variables for current draw in different radio modes.
@@ -317,6 +398,20 @@ private:
   Time m_lastUpdateTime;          ///< time stamp of previous energy update
 
   uint8_t m_nPendingChangeState; ///< pending state change
+
+  bool m_lazyEnergyUpdate;        ///< whether the energy source is updated lazily
+  enum Activity m_activity;       ///< current activity
+  Time m_stateDuration[4];        ///< time spent in each radio state
+  double m_activityEnergy[NUMBER_OF_ACTIVITIES]; ///< energy of each activity
+
+  /// energy in the ledger that was not reported to the source yet
+  mutable double m_pendingEnergy;
+  /// time of the last update of the source
+  mutable Time m_lastSyncTime;
+  /// energy in the ledger since the last computation of m_syncMargin
+  double m_energySinceMarginUpdate;
+  /// energy after which the source must be updated
+  double m_syncMargin;
   bool m_isSupersededChangeState; ///< superseded change state
 
   /// Energy depletion callback
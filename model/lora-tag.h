@@ -29,6 +29,12 @@ namespace lorawan {
 /**
  * Tag used to save various data about a packet, like its Spreading Factor and
  * data about interference.
+ *
+ * Within the LoRa stack, the metadata of a reception is passed alongside the
+ * packet as a LoraTxMetadata. This tag only carries it where the packet leaves
+ * the stack: gateways write it on the uplinks they forward to the network
+ * server, and the network server writes the data rate and frequency of the
+ * downlinks it sends to the gateways.
  */
 class LoraTag : public Tag
 {
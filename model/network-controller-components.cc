@@ -19,6 +19,7 @@
  */
 
 #include "ns3/network-controller-components.h"
+#include "ns3/lora-header-view.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -75,10 +76,7 @@ ConfirmedMessagesComponent::OnReceivedPacket (Ptr<const Packet> packet,
   // Check whether the received packet requires an acknowledgment.
   LoraMacHeader mHdr;
   LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  Ptr<Packet> myPacket = packet->Copy ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
+  LoraHeaderView::Peek (packet, mHdr, fHdr);
 
   NS_LOG_INFO ("Received packet Mac Header: " << mHdr);
   NS_LOG_INFO ("Received packet Frame Header: " << fHdr);
@@ -159,17 +157,12 @@ LinkCheckComponent::BeforeSendingReply (Ptr<EndDeviceStatus> status,
 {
   NS_LOG_FUNCTION (this << status << networkStatus);
 
-  Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice ()->Copy ();
   LoraMacHeader mHdr;
   LoraFrameHeader fHdr;
-  fHdr.SetAsUplink ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
+  LoraHeaderView::Peek (status->GetLastPacketReceivedFromDevice (), mHdr, fHdr);
 
-  Ptr<LinkCheckReq> command = fHdr.GetMacCommand<LinkCheckReq> ();
-
-  // GetMacCommand returns 0 if no command is found
-  if (command)
+  // Look for the command without creating the MacCommand objects
+  if (fHdr.HasMacCommand (LINK_CHECK_REQ))
     {
       status->m_reply.needsReply = true;
 
@@ -2,6 +2,8 @@
 #include "src/core/model/log-macros-enabled.h"
 #include "ns3/aes.h"
 #include "ns3/hop-count-tag.h"
+#include "ns3/lora-profiler.h"
+#include "ns3/lora-header-view.h"
 #include "src/core/model/assert.h"
 
 namespace ns3 {
@@ -46,6 +48,16 @@ NetworkScheduler::GetTypeId (void)
                      MakeTraceSourceAccessor
                        (&NetworkScheduler::m_totalByteSent),
                      "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("PendingReplies",
+                     "The number of class A replies waiting for a receive window",
+                     MakeTraceSourceAccessor
+                       (&NetworkScheduler::m_pendingReplies),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("DownlinkOutcome",
+                     "A downlink was either sent or not sent, with its class",
+                     MakeTraceSourceAccessor
+                       (&NetworkScheduler::m_downlinkOutcome),
+                     "ns3::NetworkScheduler::DownlinkOutcomeCallback")
     .AddTraceSource ("BeaconStatusCallback",
                      "Shows the continuity of the missed or sent beacons", 
                      MakeTraceSourceAccessor 
@@ -69,7 +81,10 @@ NetworkScheduler::NetworkScheduler () :
   m_totalBeaconsBlocked (0),
   m_maxAppPayloadForDataRate {51,51,51,115,222,222,222,222},  //Max MacPayload for EU863-870, taking FOpt to be empty
   m_enableSequencedPacketGeneration (false),
+  m_fragmentationNbFrag (0),
+  m_fragmentationNbParity (0),
   m_totalByteSent (0),
+  m_pendingReplies (0),
   m_beaconStatus (NetworkScheduler::BeaconStatus()),
   m_beaconRelatedConstants (NetworkScheduler::BeaconRelatedConstants())
 {
@@ -85,7 +100,10 @@ NetworkScheduler::NetworkScheduler (Ptr<NetworkStatus> status,
   m_totalBeaconsBlocked (0),
   m_maxAppPayloadForDataRate {51,51,51,115,222,222,222,222}, //Max AppPayload for EU863-870, taking FOpt to be empty
   m_enableSequencedPacketGeneration (false),
+  m_fragmentationNbFrag (0),
+  m_fragmentationNbParity (0),
   m_totalByteSent (0),
+  m_pendingReplies (0),
   m_beaconStatus (NetworkScheduler::BeaconStatus()),
   m_beaconRelatedConstants (NetworkScheduler::BeaconRelatedConstants())    
 {
@@ -101,19 +119,50 @@ NetworkScheduler::OnReceivedPacket (Ptr<const Packet> packet)
 {
   NS_LOG_FUNCTION (packet);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
-
   // TODO Check if this packet is a duplicate:
   // It's possible that we already received the same packet from another
   // gateway.
   // - Extract the address
   LoraMacHeader macHeader;
   LoraFrameHeader frameHeader;
-  myPacket->RemoveHeader (macHeader);
-  myPacket->RemoveHeader (frameHeader);
+  LoraHeaderView::Peek (packet, macHeader, frameHeader);
   LoraDeviceAddress deviceAddress = frameHeader.GetAddress ();
 
+  // The copies of the uplink received by the other gateways share its
+  // receive windows
+  if (m_replyGateways.find (deviceAddress) != m_replyGateways.end ())
+    {
+      NS_LOG_DEBUG ("A reply is already pending for device " << deviceAddress);
+      return;
+    }
+
+  // If a reply is already known to be needed, reserve the best gateway for
+  // it, in the first receive window if possible and otherwise in the second.
+  // Only this copy is known yet, the window elects the gateway again.
+  Address gwAddress = Address ();
+  if (m_status->NeedsReply (deviceAddress))
+    {
+      Address bestGwAddress = m_status->GetBestGatewayForDevice (deviceAddress);
+      if (bestGwAddress != Address ())
+        {
+          Ptr<GatewayStatus> gwStatus = m_status->m_gatewayStatuses.at (bestGwAddress);
+          Time now = Simulator::Now ();
+          if (gwStatus->Reserve (now + Seconds (1), GetReplyDuration (gwStatus, deviceAddress, 1),
+                                 GetReplyFrequency (deviceAddress, 1),
+                                 GatewayStatus::CLASS_A_REPLY, deviceAddress)
+              || gwStatus->Reserve (now + Seconds (2), GetReplyDuration (gwStatus, deviceAddress, 2),
+                                    GetReplyFrequency (deviceAddress, 2),
+                                    GatewayStatus::CLASS_A_REPLY, deviceAddress))
+            {
+              gwAddress = bestGwAddress;
+            }
+        }
+    }
+  m_replyGateways[deviceAddress] = gwAddress;
+
+  // The reply is pending until one of the receive windows is dealt with
+  m_pendingReplies++;
+
   // Schedule OnReceiveWindowOpportunity event
   Simulator::Schedule (Seconds (1),
                        &NetworkScheduler::OnReceiveWindowOpportunity,
@@ -130,15 +179,62 @@ NetworkScheduler::OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, i
   NS_LOG_DEBUG ("Opening receive window number " << window << " for device "
                                                  << deviceAddress);
 
-  // Check whether we can send a reply to the device, again by using
-  // NetworkStatus
+  // Before the first window, let the controller prepare the reply
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (deviceAddress);
+  if (window == 1)
+    {
+      m_controller->BeforeSendingReply (edStatus);
+    }
+
+  // Check whether this device needs a response by querying m_status
+  if (!m_status->NeedsReply (deviceAddress))
+    {
+      ReleaseReply (deviceAddress, window);
+      return;
+    }
+
+  // All the copies of the uplink are in by now, so the best gateway may not
+  // be the one reserved when the first copy arrived: prefer it, and keep the
+  // reserved one in case the best one cannot be claimed
+  Address reservedGwAddress = m_replyGateways[deviceAddress];
   Address gwAddress = m_status->GetBestGatewayForDevice (deviceAddress);
 
-  NS_LOG_DEBUG ("Found available gateway with address: " << gwAddress);
+  NS_LOG_DEBUG ("Found gateway with address: " << gwAddress);
+
+  // The gateway has to hold a reservation for the reply in this window
+  bool reserved = ClaimReply (gwAddress, deviceAddress, window);
+  if (!reserved && reservedGwAddress != gwAddress)
+    {
+      gwAddress = reservedGwAddress;
+      reserved = ClaimReply (gwAddress, deviceAddress, window);
+    }
+
+  // The reply moved to another gateway, free the one it was reserved on
+  if (reserved && reservedGwAddress != Address () && reservedGwAddress != gwAddress)
+    {
+      NS_LOG_DEBUG ("Moving the reply from gateway " << reservedGwAddress);
+      m_status->m_gatewayStatuses.at (reservedGwAddress)->CancelReservation (Simulator::Now (),
+                                                                             deviceAddress);
+    }
+
+  if (reserved)
+    {
+      NS_LOG_INFO ("A reply is needed");
+
+      // Send the reply through that gateway
+      m_status->SendThroughGateway (m_status->GetReplyForDevice
+                                      (deviceAddress, window),
+                                    gwAddress);
+
+      // Reset the reply
+      edStatus->InitializeReply ();
 
-  if (gwAddress == Address () && window == 1)
+      CountDownlink (GatewayStatus::CLASS_A_REPLY, true);
+      ReleaseReply (deviceAddress, window);
+    }
+  else if (window == 1)
     {
-      // No suitable GW was found
+      // No gateway could be reserved
       // Schedule OnReceiveWindowOpportunity event
       Simulator::Schedule (Seconds (1),
                            &NetworkScheduler::OnReceiveWindowOpportunity,
@@ -146,39 +242,81 @@ NetworkScheduler::OnReceiveWindowOpportunity (LoraDeviceAddress deviceAddress, i
                            deviceAddress,
                            2);     // This will be the second receive window
     }
-  else if (gwAddress == Address () && window == 2)
+  else
     {
-      // No suitable GW was found
+      // No gateway could be reserved
       // Simply give up.
-      NS_LOG_INFO ("Giving up on reply: no suitable gateway was found " <<
+      NS_LOG_INFO ("Giving up on reply: no gateway could be reserved " <<
                    "on the second receive window");
 
       // Reset the reply
       // XXX Should we reset it here or keep it for the next opportunity?
-      m_status->GetEndDeviceStatus (deviceAddress)->InitializeReply ();
+      edStatus->InitializeReply ();
+
+      CountDownlink (GatewayStatus::CLASS_A_REPLY, false);
+      ReleaseReply (deviceAddress, window);
     }
-  else
+}
+
+bool
+NetworkScheduler::ClaimReply (Address gwAddress, LoraDeviceAddress deviceAddress, int window)
+{
+  NS_LOG_FUNCTION (this << gwAddress << deviceAddress << window);
+
+  if (gwAddress == Address ())
     {
-      // A gateway was found
-      m_controller->BeforeSendingReply (m_status->GetEndDeviceStatus
-                                          (deviceAddress));
+      return false;
+    }
 
-      // Check whether this device needs a response by querying m_status
-      bool needsReply = m_status->NeedsReply (deviceAddress);
+  Ptr<GatewayStatus> gwStatus = m_status->m_gatewayStatuses.at (gwAddress);
+  return gwStatus->ClaimReservation (GetReplyDuration (gwStatus, deviceAddress, window),
+                                     GetReplyFrequency (deviceAddress, window),
+                                     GatewayStatus::CLASS_A_REPLY, deviceAddress);
+}
 
-      if (needsReply)
-        {
-          NS_LOG_INFO ("A reply is needed");
+void
+NetworkScheduler::ReleaseReply (LoraDeviceAddress deviceAddress, int window)
+{
+  NS_LOG_FUNCTION (this << deviceAddress << window);
+
+  // The second window is not needed if the reply is dealt with in the first
+  Address gwAddress = m_replyGateways[deviceAddress];
+  if (gwAddress != Address () && window == 1)
+    {
+      m_status->m_gatewayStatuses.at (gwAddress)->CancelReservation (Simulator::Now () + Seconds (1),
+                                                                     deviceAddress);
+    }
+
+  m_replyGateways.erase (deviceAddress);
+  m_pendingReplies--;
+}
 
-          // Send the reply through that gateway
-          m_status->SendThroughGateway (m_status->GetReplyForDevice
-                                          (deviceAddress, window),
-                                        gwAddress);
+Time
+NetworkScheduler::GetReplyDuration (Ptr<GatewayStatus> gwStatus, LoraDeviceAddress deviceAddress,
+                                    int window)
+{
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (deviceAddress);
 
-          // Reset the reply
-          m_status->GetEndDeviceStatus (deviceAddress)->InitializeReply ();
-        }
+  // The size of the reply as GetCompleteReplyPacket builds it
+  uint32_t size = edStatus->m_reply.macHeader.GetSerializedSize ()
+    + edStatus->m_reply.frameHeader.GetSerializedSize ();
+  if (edStatus->m_reply.payload)
+    {
+      size += edStatus->m_reply.payload->GetSize ();
     }
+
+  uint8_t dataRate = (window == 1 ? edStatus->GetMac ()->GetFirstReceiveWindowDataRate ()
+                      : edStatus->GetMac ()->GetSecondReceiveWindowDataRate ());
+  return gwStatus->GetOnAirTime (dataRate, size);
+}
+
+double
+NetworkScheduler::GetReplyFrequency (LoraDeviceAddress deviceAddress, int window)
+{
+  // The frequencies GetReplyForDevice tags the reply with
+  Ptr<EndDeviceStatus> edStatus = m_status->GetEndDeviceStatus (deviceAddress);
+  return (window == 1 ? edStatus->GetFirstReceiveWindowFrequency ()
+          : edStatus->GetSecondReceiveWindowFrequency ());
 }
 
 void
@@ -209,6 +347,9 @@ NetworkScheduler::BroadcastBeacon (bool enable)
       
       Time bT = Seconds (k*128) + tBeaconDelay; 
       
+      // Keep the gateways for the beacon, before any other downlink
+      m_status->ReserveBeacon (Simulator::Now () + bT);
+      
       Simulator::Schedule (bT, 
                            &NetworkScheduler::BroadcastBeacon, 
                            this,
@@ -220,6 +361,7 @@ NetworkScheduler::BroadcastBeacon (bool enable)
       NS_LOG_DEBUG ("BroadcastBeacon at " << Simulator::Now ().GetSeconds ());
       
       uint32_t bcnTime = m_status->BroadcastBeacon ();
+      CountDownlink (GatewayStatus::BEACON, bcnTime != 0);
      
       //bcnTime is zero if no gateway transmitted beacon and it will contain 
       //the time stamp if at least one gateway transmitted beacon
@@ -282,6 +424,8 @@ NetworkScheduler::BroadcastBeacon (bool enable)
       
       Time beaconPeriod = Seconds (128); ///< Beacon_period, default 128 Seconds
       
+      m_status->ReserveBeacon (Simulator::Now () + beaconPeriod);
+      
       Simulator::Schedule (beaconPeriod, 
                            &NetworkScheduler::BroadcastBeacon, 
                            this,
@@ -380,14 +524,35 @@ NetworkScheduler::ScheduleClassBDownlink (uint32_t bcnTime)
           NS_LOG_DEBUG ("Ping Downlink Packet Size to be used for multicast group address " << address << " is " << (int)sizeOfAppPayload);
             
           enum DownlinkType downlinkType = m_enableSequencedPacketGeneration ? DownlinkType::SEQUENCED : DownlinkType::EMPTY;
+          if (m_fragmentationNbFrag > 0)
+            {
+              downlinkType = DownlinkType::FRAGMENTED;
+            }
           Ptr<DownlinkPacketGenerator> downlinkPacket = Create<DownlinkPacketGenerator> (downlinkType, 
                                                                                          sizeOfAppPayload, 
                                                                                          0); //Start from sequence 0
+          if (downlinkType == DownlinkType::FRAGMENTED)
+            {
+              NS_ASSERT_MSG (sizeOfAppPayload > SequenceHeader::MAX_SIZE,
+                             "The ping downlinks are too small to carry fragments");
+              downlinkPacket->m_session = Create<FragmentationSession> (m_fragmentationNbFrag,
+                                                                        m_fragmentationNbParity,
+                                                                        sizeOfAppPayload - SequenceHeader::MAX_SIZE);
+            }
           //No packet generator yet for the device address so add
           m_downlinkPacket.insert (std::pair<LoraDeviceAddress, Ptr<DownlinkPacketGenerator> > (address, downlinkPacket));
         }
       //downlinkPacket generator already is included if the address is found
       
+      //Reserve the gateways of the group for all the ping slots of the beacon
+      //period, a class A reply or a beacon can still preempt them
+      uint8_t packetSize = m_downlinkPacket.find (address)->second->m_packetSize;
+      for (uint slotIndex = 0; slotIndex < pingNb; slotIndex++)
+        {
+          m_status->ReserveMulticastPing (Simulator::Now () + (offset + slotIndex*pingPeriod)*slotLen,
+                                          address, packetSize);
+        }
+      
       Simulator::Schedule (offset*slotLen,
                            &NetworkScheduler::SendPingDownlink,
                            this, 
@@ -448,10 +613,13 @@ void
 NetworkScheduler::SendPingDownlink (LoraDeviceAddress address, bool isMulticast, uint pingPeriod, uint8_t pingNb, uint8_t slotIndex)
 {
   NS_LOG_FUNCTION (this << address << isMulticast << pingPeriod << pingNb << slotIndex);
+
+  LORA_PROFILE_SCOPE (PING_DOWNLINK);
   
   NS_ASSERT_MSG (m_downlinkPacket.find (address) != m_downlinkPacket.end (), "DownlinkPacketGenerator is not included for this devAddress");
   
-  //\TODO If there is conflict with class A donwlink or reply, resolve here (Give priority for class A)  
+  // Conflicts with beacons and class A replies are resolved by the
+  // reservations of the gateways, see GatewayStatus::Reserve
   
   // Resends on the next slot as far as there is gateway remaining and on ping periodicity
   Ptr<Packet> downlinkPacket = m_downlinkPacket.find (address)-> second->GetPacket ();
@@ -468,6 +636,8 @@ NetworkScheduler::SendPingDownlink (LoraDeviceAddress address, bool isMulticast,
       uint8_t successfulGateways = m_status->MulticastPacket (downlinkPacket, address);
       
       NS_LOG_DEBUG ("Multicast Packet sent on " << (int)successfulGateways << " Gateways");
+      CountDownlink (GatewayStatus::CLASS_B_MULTICAST, successfulGateways > 0);
+      LORA_PROFILE_ITEMS (successfulGateways);
       NS_LOG_DEBUG ("Multicast Packet sent to " << address.Print ());
       
       //To generate next packet, condition for now is: 
@@ -477,7 +647,7 @@ NetworkScheduler::SendPingDownlink (LoraDeviceAddress address, bool isMulticast,
           Time now = Simulator::Now ();
          
           //Information on the downlink packet sent
-          bool isSequencialPacket = (m_downlinkPacket.find (address)->second->m_downlinkType == DownlinkType::SEQUENCED);
+          bool isSequencialPacket = (m_downlinkPacket.find (address)->second->m_downlinkType != DownlinkType::EMPTY);
           uint32_t packetSequenceNumber = isSequencialPacket ? m_downlinkPacket.find (address)->second->m_sequence : 0;
           
           //Update the packet generator
@@ -509,13 +679,18 @@ NetworkScheduler::SendPingDownlink (LoraDeviceAddress address, bool isMulticast,
      
       Ptr<GatewayLoraMac> gwLoraMac =  gwStatus->GetGatewayMac ();
       
+      //The downlink has to hold a reservation of the gateway
+      Ptr<EndDeviceLoraMac> edMac = m_status->GetEndDeviceStatus (address)->GetMac ();
+      uint32_t size = downlinkPacket->GetSize () + LoraMacHeader ().GetSerializedSize ()
+        + LoraFrameHeader ().GetSerializedSize ();
+      double frequency = edMac->GetPingSlotRecieveWindowFrequency ();
+      bool reserved = gwLoraMac->IsClassBTransmissionEnabled ()
+        && gwStatus->ClaimReservation (gwStatus->GetOnAirTime (edMac->GetPingSlotReceiveWindowDataRate (), size),
+                                       frequency, GatewayStatus::CLASS_B_UNICAST, address);
+      
       //Check if the gateway is class B enabled and available for transmission
-      if (gwLoraMac->IsClassBTransmissionEnabled () && 
-          gwStatus->IsAvailableForTransmission ( m_status-> GetEndDeviceStatus (address)-> GetMac ()->GetPingSlotRecieveWindowFrequency ()))
+      if (reserved && gwStatus->IsAvailableForTransmission (frequency))
         {
-          //Reserve the Gateway for transmission
-          gwStatus->SetNextTransmissionTime (Simulator::Now ());
-          
           //\TODO Packet header has to be added here as the following method do no do that
           //Prepare header and send packet
           LoraFrameHeader frameHeader;
@@ -545,10 +720,11 @@ NetworkScheduler::SendPingDownlink (LoraDeviceAddress address, bool isMulticast,
                                          gwAddress);
            
            NS_LOG_DEBUG ("Unicast Packet Sent to " << address);
+           LORA_PROFILE_ITEMS (1);
            
            // Information on the downlink packet sent
            Time now = Simulator::Now ();
-           bool isSequencialPacket = (m_downlinkPacket.find (address)->second->m_downlinkType == DownlinkType::SEQUENCED);
+           bool isSequencialPacket = (m_downlinkPacket.find (address)->second->m_downlinkType != DownlinkType::EMPTY);
            uint32_t packetSequenceNumber = isSequencialPacket ? m_downlinkPacket.find (address)->second->m_sequence : 0; 
            
            //If packet is successfully sent then update the packet generator
@@ -557,10 +733,16 @@ NetworkScheduler::SendPingDownlink (LoraDeviceAddress address, bool isMulticast,
                     
            //Fire tracesource of the sent unicast packet with out the mac header
            m_ucPingSent(address, pingNb, slotIndex, now, downlinkPacket, isSequencialPacket, packetSequenceNumber);
+           CountDownlink (GatewayStatus::CLASS_B_UNICAST, true);
         }
       else 
         {
           NS_LOG_DEBUG ("Unicast Packet Not Sent to " << address);
+          if (reserved)
+            {
+              gwStatus->CancelReservation (Simulator::Now (), address);
+            }
+          CountDownlink (GatewayStatus::CLASS_B_UNICAST, false);
         }
     }
   
@@ -580,6 +762,39 @@ NetworkScheduler::SendPingDownlink (LoraDeviceAddress address, bool isMulticast,
   
 }
 
+void
+NetworkScheduler::CountDownlink (enum GatewayStatus::DownlinkClass downlinkClass, bool isSent)
+{
+  struct DownlinkCount &count = m_downlinkCounts[downlinkClass];
+  count.attempted++;
+  if (isSent)
+    {
+      count.sent++;
+    }
+  m_downlinkOutcome (downlinkClass, isSent);
+}
+
+uint32_t
+NetworkScheduler::GetNDownlinks (enum GatewayStatus::DownlinkClass downlinkClass) const
+{
+  auto it = m_downlinkCounts.find (downlinkClass);
+  return it == m_downlinkCounts.end () ? 0 : it->second.attempted;
+}
+
+uint32_t
+NetworkScheduler::GetNSentDownlinks (enum GatewayStatus::DownlinkClass downlinkClass) const
+{
+  auto it = m_downlinkCounts.find (downlinkClass);
+  return it == m_downlinkCounts.end () ? 0 : it->second.sent;
+}
+
+double
+NetworkScheduler::GetDownlinkSuccessRate (enum GatewayStatus::DownlinkClass downlinkClass) const
+{
+  uint32_t attempted = GetNDownlinks (downlinkClass);
+  return attempted == 0 ? 0 : (double) GetNSentDownlinks (downlinkClass) / attempted;
+}
+
 void
 NetworkScheduler::SetMaxAppPayloadForDataRate (std::vector<uint32_t> maxAppPayloadForDataRate)
 {
@@ -592,6 +807,14 @@ NetworkScheduler::EnableSequencedPacketGeneration (bool enable)
   m_enableSequencedPacketGeneration = enable;
 }
 
+void
+NetworkScheduler::EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity)
+{
+  NS_LOG_FUNCTION (this << nbFrag << nbParity);
+  m_fragmentationNbFrag = nbFrag;
+  m_fragmentationNbParity = nbParity;
+}
+
 void
 NetworkScheduler::SetPingDownlinkPacketSize (uint8_t pingDownlinkPacketSize)
 {
@@ -600,6 +823,15 @@ NetworkScheduler::SetPingDownlinkPacketSize (uint8_t pingDownlinkPacketSize)
   m_pingDownlinkPacketSize = pingDownlinkPacketSize;
 }
 
+int64_t
+NetworkScheduler::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  
+  m_randomPacketSize->SetStream (stream);
+  return 1;
+}
+
 uint8_t
 NetworkScheduler::GetPingDownlinkPacketSize () const
 {
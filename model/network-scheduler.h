@@ -29,6 +29,9 @@
 #include "ns3/lora-frame-header.h"
 #include "ns3/network-controller.h"
 #include "ns3/network-status.h"
+#include "ns3/gateway-status.h"
+#include "ns3/sequence-header.h"
+#include "ns3/fragmentation-session.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -48,8 +51,9 @@ public:
 
   /**
    * Method called by NetworkServer to inform the Scheduler of a newly arrived
-   * uplink packet. This function schedules the OnReceiveWindowOpportunity
-   * events 1 and 2 seconds later.
+   * uplink packet, after the NetworkStatus and the NetworkController. This
+   * function reserves a gateway for the reply, if one is already needed, and
+   * schedules the OnReceiveWindowOpportunity event 1 second later.
    */
   void OnReceivedPacket (Ptr<const Packet> packet);
 
@@ -97,6 +101,19 @@ public:
    */
   void EnableSequencedPacketGeneration (bool enable);
   
+  /**
+   * Send a fragmentation session to every multicast group, in place of the
+   * sequenced packets
+   * 
+   * The fragments, data then parity, are sent in a loop on the ping slots,
+   * with their index in the SequenceHeader. The size of a fragment is the
+   * ping downlink packet size of the group without the SequenceHeader.
+   * 
+   * \param nbFrag the number of data fragments of the image, 0 to disable
+   * \param nbParity the number of parity fragments sent after them
+   */
+  void EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity);
+  
     
   /**
    * Set the packet size for the ping downlink
@@ -108,6 +125,15 @@ public:
    */
   void SetPingDownlinkPacketSize (uint8_t pingDownlinkPacketSize);
   
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by the scheduler
+   * 
+   * \param stream the first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+  
   /**
    * Get the packet size set for the ping downlinks
    * 
@@ -117,6 +143,24 @@ public:
    */
   uint8_t GetPingDownlinkPacketSize (void) const;
   
+  /**
+   * \return the number of downlinks of a class that the scheduler tried to
+   * send, that is the number of beacons, of class A replies or of ping slots
+   */
+  uint32_t GetNDownlinks (enum GatewayStatus::DownlinkClass downlinkClass) const;
+  
+  /**
+   * \return the number of downlinks of a class that were sent on at least
+   * one gateway
+   */
+  uint32_t GetNSentDownlinks (enum GatewayStatus::DownlinkClass downlinkClass) const;
+  
+  /**
+   * \return the ratio of the downlinks of a class that were sent, 0 if none
+   * was tried
+   */
+  double GetDownlinkSuccessRate (enum GatewayStatus::DownlinkClass downlinkClass) const;
+  
   
   /****************************
    * TracedCallback Signatures
@@ -173,8 +217,55 @@ public:
    * continuously skipped. If there, it means it is the first beacon.
    */  
    typedef void (* BeaconStatusCallback) (bool isSent, uint32_t continuousCount);
+   
+  /**
+   * The trace source fired each time the scheduler either sends a downlink
+   * or gives up on it.
+   * 
+   * \param downlinkClass the class of the downlink
+   * \param isSent true if the downlink was sent on at least one gateway
+   */
+   typedef void (* DownlinkOutcomeCallback) (GatewayStatus::DownlinkClass downlinkClass, bool isSent);
 
 private:
+  /**
+   * Forget the pending reply of a device, once it is either sent or given up
+   * 
+   * The reservation of the second receive window, if any, is canceled.
+   * 
+   * \param deviceAddress the device of the reply
+   * \param window the receive window in which the reply was dealt with
+   */
+  void ReleaseReply (LoraDeviceAddress deviceAddress, int window);
+  
+  /**
+   * Claim a gateway for the reply of a device in the receive window that
+   * opens now
+   *
+   * \return true if the gateway holds a reservation for the reply
+   */
+  bool ClaimReply (Address gwAddress, LoraDeviceAddress deviceAddress, int window);
+  
+  /**
+   * Get the time on air of the reply of a device, as it is now
+   * 
+   * \param gwStatus the gateway that is going to send the reply
+   * \param deviceAddress the device of the reply
+   * \param window the receive window of the reply, which gives its data rate
+   */
+  Time GetReplyDuration (Ptr<GatewayStatus> gwStatus, LoraDeviceAddress deviceAddress, int window);
+  
+  /**
+   * Get the frequency of the reply of a device in a receive window
+   */
+  double GetReplyFrequency (LoraDeviceAddress deviceAddress, int window);
+  
+  /**
+   * Count a downlink of a class for the success rates, and fire the
+   * DownlinkOutcome trace source
+   */
+  void CountDownlink (enum GatewayStatus::DownlinkClass downlinkClass, bool isSent);
+  
     /**
    * Get a ping-offset for a device-address and ping-period for a given beacon time
    * 
@@ -208,7 +299,8 @@ private:
   enum DownlinkType
   {
     SEQUENCED, ///< For unicast and multicast fragemented data block 
-    EMPTY      ///< For creaing an empty packet with what ever size you want 
+    EMPTY,     ///< For creaing an empty packet with what ever size you want 
+    FRAGMENTED ///< For the fragments of a FragmentationSession
   };
   
   /// Structure for Generating Downlink Packet
@@ -250,34 +342,55 @@ private:
     /**
      * Generate packet to send for downlink
      * 
+     * The packets are copies of a template payload created once, which share
+     * its buffer. For SEQUENCED, only the SequenceHeader of the current
+     * sequence is written in front of the copy. For FRAGMENTED, each fragment
+     * of the session is built once and is the template of its own packets.
+     * 
      * \return the packet to sent  
      */
     Ptr<Packet> GetPacket ()
     {
-      if (m_downlinkType == SEQUENCED)
+      if (m_downlinkType == FRAGMENTED)
       {
-        //If packet is sequenced generate a packet with a data corresponding to 
-        //to the current sequence of a packet
-        uint8_t *buff = new uint8_t[m_packetSize];
-        uint32_t sequence = m_sequence;
-        //divide sequence to byte stream backward side
-        //Should be reconstructed in the application side by redoing the process
-        for (int i = 0; i < m_packetSize; i++)
+        //The fragments are sent in a loop, the sequence gives the index
+        SequenceHeader sequenceHeader;
+        sequenceHeader.SetSequence (m_sequence);
+        uint32_t index = m_sequence % m_session->GetNFragments ();
+        m_fragments.resize (m_session->GetNFragments ());
+        if (m_fragments[index] == 0)
         {
-          buff[i] = sequence%10;
-          sequence = sequence/10;
+          std::vector<uint8_t> fragment (m_session->GetFragSize ());
+          m_session->GetFragment (index, fragment.data ());
+          m_fragments[index] = Create<Packet> (fragment.data (), fragment.size ());
         }
-        Ptr<Packet> packet =  Create<Packet> (buff, m_packetSize);
-        //remove buff as it is already copied to the packet
-        delete [] buff;
+        Ptr<Packet> packet = m_fragments[index]->Copy ();
+        packet->AddHeader (sequenceHeader);
         
         return packet;
       }
-      else
+      else if (m_downlinkType == SEQUENCED)
       {
-        Ptr<Packet> packet = Create<Packet> (m_packetSize);
+        SequenceHeader sequenceHeader;
+        sequenceHeader.SetSize (m_packetSize);
+        sequenceHeader.SetSequence (m_sequence);
+        if (m_template == 0)
+        {
+          m_template = Create<Packet> (m_packetSize - sequenceHeader.GetSerializedSize ());
+        }
+        Ptr<Packet> packet = m_template->Copy ();
+        packet->AddHeader (sequenceHeader);
+        
         return packet;
       }
+      else
+      {
+        if (m_template == 0)
+        {
+          m_template = Create<Packet> (m_packetSize);
+        }
+        return m_template->Copy ();
+      }
     }
     
     /**
@@ -301,6 +414,9 @@ private:
     enum DownlinkType m_downlinkType; ///< type of packet created for downlinks
     uint8_t m_packetSize; ///< Size of a packet for which we are going to generate sequenced downlink
     uint32_t m_sequence; ///< For SEQUENCED, the current packets sequence number to generate
+    Ptr<Packet> m_template; ///< The payload the packets are copied from, without the SequenceHeader
+    Ptr<FragmentationSession> m_session; ///< For FRAGMENTED, the session that is sent
+    std::vector<Ptr<Packet> > m_fragments; ///< For FRAGMENTED, the payload of each fragment, built when first sent
   };
   
   /**
@@ -328,6 +444,13 @@ private:
    */
   bool m_enableSequencedPacketGeneration;
   
+  /**
+   * The number of data and parity fragments of the fragmentation session, if
+   * m_fragmentationNbFrag is not 0
+   */
+  uint16_t m_fragmentationNbFrag;
+  uint16_t m_fragmentationNbParity;
+  
   /**
    * Downlink packet size in bytes
    * 
@@ -371,6 +494,34 @@ private:
    */
   TracedValue<uint32_t> m_totalByteSent;
   
+  /**
+   * The number of class A replies waiting for their receive window, that is
+   * uplinks for which neither RX1 nor RX2 has been dealt with yet.
+   */
+  TracedValue<uint32_t> m_pendingReplies;
+  
+  /**
+   * The devices with a pending class A reply, with the gateway reserved for
+   * the reply or Address () if none could be reserved in advance
+   */
+  std::map<LoraDeviceAddress, Address> m_replyGateways;
+  
+  /// The number of downlinks of a class tried and sent
+  struct DownlinkCount
+  {
+    uint32_t attempted = 0;
+    uint32_t sent = 0;
+  };
+  std::map<enum GatewayStatus::DownlinkClass, struct DownlinkCount> m_downlinkCounts;
+  
+  /**
+   * The trace source fired each time the scheduler either sends a downlink
+   * or gives up on it.
+   * 
+   * \see ns3::NetworkScheduler::DownlinkOutcomeCallback
+   */
+  TracedCallback<GatewayStatus::DownlinkClass, bool> m_downlinkOutcome;
+  
   /**
    * The trace source fired when beacon status changes from continuously transmitting beacon 
    * to continuously skipping or vise versa
@@ -159,21 +159,19 @@ NetworkServer::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
 {
   NS_LOG_FUNCTION (this << packet << protocol << address);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
-
   // Fire the trace source
   m_receivedPacket (packet);
 
-  // Inform the scheduler of the newly arrived packet
-  m_scheduler->OnReceivedPacket (packet);
-
   // Inform the status of the newly arrived packet
   m_status->OnReceivedPacket (packet, address);
 
   // Inform the controller of the newly arrived packet
   m_controller->OnNewPacket (packet);
 
+  // Inform the scheduler of the newly arrived packet, last so that it knows
+  // whether a reply is needed when it reserves a gateway for it
+  m_scheduler->OnReceivedPacket (packet);
+
   return true;
 }
 
@@ -215,6 +213,12 @@ NetworkServer::EnableSequencedPacketGeneration (bool enable)
   m_scheduler->EnableSequencedPacketGeneration (enable);
 }
 
+void 
+NetworkServer::EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity)
+{
+  m_scheduler->EnableFragmentationSession (nbFrag, nbParity);
+}
+
 void
 NetworkServer::SetPingDownlinkPacketSize (uint8_t pingDownlinkPacketSize)
 {
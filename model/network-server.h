@@ -127,6 +127,14 @@ public:
    * \param enable if true it enables the sequenced packet generation
    */
   void EnableSequencedPacketGeneration (bool enable);
+
+  /**
+   * Send a fragmentation session to the multicast groups
+   * 
+   * \param nbFrag the number of data fragments of the image, 0 to disable
+   * \param nbParity the number of parity fragments sent after them
+   */
+  void EnableFragmentationSession (uint16_t nbFrag, uint16_t nbParity);
   
   /**
    * Set the packet size for the ping downlink
@@ -31,6 +31,7 @@
 #include "ns3/pointer.h"
 
 #include "ns3/bcn-payload.h"
+#include "ns3/lora-header-view.h"
 namespace ns3 {
 namespace lorawan {
 
@@ -152,15 +153,10 @@ NetworkStatus::OnReceivedPacket (Ptr<const Packet> packet,
 {
   NS_LOG_FUNCTION (this << packet << gwAddress);
 
-  // Create a copy of the packet
-  Ptr<Packet> myPacket = packet->Copy ();
-
-  // Extract the headers
+  // Read the headers
   LoraMacHeader macHdr;
-  myPacket->RemoveHeader (macHdr);
   LoraFrameHeader frameHdr;
-  frameHdr.SetAsUplink ();
-  myPacket->RemoveHeader (frameHdr);
+  LoraHeaderView::Peek (packet, macHdr, frameHdr);
 
   // Update the correct EndDeviceStatus object
   LoraDeviceAddress edAddr = frameHdr.GetAddress ();
@@ -233,9 +229,7 @@ NetworkStatus::GetEndDeviceStatus (Ptr<Packet const> packet)
   // Get the address
   LoraMacHeader mHdr;
   LoraFrameHeader fHdr;
-  Ptr<Packet> myPacket = packet->Copy ();
-  myPacket->RemoveHeader (mHdr);
-  myPacket->RemoveHeader (fHdr);
+  LoraHeaderView::Peek (packet, mHdr, fHdr);
   auto it = m_endDeviceStatuses.find (fHdr.GetAddress ());
   if (it != m_endDeviceStatuses.end ())
     {
@@ -282,17 +276,19 @@ NetworkStatus::BroadcastBeacon ()
          Ptr<GatewayLoraMac>  gwLoraMac = gwStatus->GetGatewayMac ();
          if (gwLoraMac->IsBeaconTransmissionEnabled ())
            {
-             if (gwStatus->IsAvailableForTransmission (m_beaconFrequency))
+             // The beacon normally holds the reservation made a beacon period
+             // before, which no other downlink can preempt
+             BcnPayload bcnPayload;
+             Time duration = gwStatus->GetOnAirTime (m_beaconDr, bcnPayload.GetSerializedSize (), true);
+             bool reserved = gwStatus->ClaimReservation (duration, m_beaconFrequency,
+                                                         GatewayStatus::BEACON, LoraDeviceAddress ());
+             if (reserved && gwStatus->IsAvailableForTransmission (m_beaconFrequency))
               {
-                //Reserve Gateway for transmission
-                gwStatus->SetNextTransmissionTime (Simulator::Now ());
-               
                 NS_LOG_DEBUG ("Transmit beacon at on Gateway " << it->first);
                 // Create an empty packet
                 Ptr<Packet> bcnPacket = Create<Packet> (0);
                 
                 // Create the header that is that contains the beacon payload
-                BcnPayload bcnPayload;
                 // Generate the time stamp
                 bcnTime = static_cast<uint32_t>(Simulator::Now ().GetSeconds());
                 bcnPayload.SetBcnTime (bcnTime);
@@ -313,6 +309,7 @@ NetworkStatus::BroadcastBeacon ()
              else
               {
                 NS_LOG_INFO ("Gateway " << it->first << "Is not available for beacon transmission!");
+                gwStatus->CancelReservation (Simulator::Now (), LoraDeviceAddress ());
               }           
            }
         }
@@ -322,6 +319,24 @@ NetworkStatus::BroadcastBeacon ()
   return bcnTime;  
 }
 
+void
+NetworkStatus::ReserveBeacon (Time start)
+{
+  NS_LOG_FUNCTION (this << start);
+
+  BcnPayload bcnPayload;
+  for (auto it = m_gatewayStatuses.begin (); it != m_gatewayStatuses.end (); ++it)
+    {
+      Ptr<GatewayStatus> gwStatus = it->second;
+      if (gwStatus->GetGatewayMac ()->IsBeaconTransmissionEnabled ())
+        {
+          Time duration = gwStatus->GetOnAirTime (m_beaconDr, bcnPayload.GetSerializedSize (), true);
+          gwStatus->Reserve (start, duration, m_beaconFrequency, GatewayStatus::BEACON,
+                             LoraDeviceAddress ());
+        }
+    }
+}
+
 uint8_t
 NetworkStatus::MulticastPacket (Ptr<const Packet> packet, LoraDeviceAddress mcAddress)
 {
@@ -337,21 +352,21 @@ NetworkStatus::MulticastPacket (Ptr<const Packet> packet, LoraDeviceAddress mcAd
       Ptr<GatewayLoraMac> gwLoraMac = (it)->second->GetGatewayMac ();
       if (gwLoraMac->IsClassBTransmissionEnabled () && gwLoraMac->CheckMulticastGroup (mcAddress))
         {
-          //Get the device status of one of the end devices in the multicast group.
-          //This works because an end devices class B parameter is for multicast if multicast is enabled
-          McEndDeviceStatusMap::iterator it2 = m_mcEndDeviceStatuses.find (mcAddress);
-          if (it2 != m_mcEndDeviceStatuses.end ())
+          Ptr<EndDeviceStatus> devStatus = GetMulticastGroupStatus (mcAddress);
+          if (devStatus != 0)
             {
-              //Getting one of the devices device status from the ones available in the list
-              EndDeviceStatusMap::iterator devStatusIterator = (it2)->second.begin ();
-              Ptr<EndDeviceStatus> devStatus = devStatusIterator->second;
+              //The downlink normally holds the reservation made for the ping
+              //slot, unless it was preempted by a downlink of a higher priority
+              uint32_t size = packet->GetSize () + LoraMacHeader ().GetSerializedSize ()
+                + LoraFrameHeader ().GetSerializedSize ();
+              Time duration = (it)->second->GetOnAirTime (devStatus->GetMac ()->GetPingSlotReceiveWindowDataRate (), size);
+              double frequency = devStatus->GetMac ()->GetPingSlotRecieveWindowFrequency ();
+              bool reserved = (it)->second->ClaimReservation (duration, frequency,
+                                                              GatewayStatus::CLASS_B_MULTICAST, mcAddress);
               
               //For gateways that are classB enabled and match the address check availability
-              if ((it)->second->IsAvailableForTransmission ( devStatus->GetMac ()->GetPingSlotRecieveWindowFrequency () ))
+              if (reserved && (it)->second->IsAvailableForTransmission (frequency))
                 {
-                  //Reserve Gateway for transmission
-                  (it)->second->SetNextTransmissionTime (Simulator::Now ());
-                
                   //Prepare header and send packet
                   LoraFrameHeader frameHeader;
                   frameHeader.SetAsDownlink ();
@@ -383,6 +398,10 @@ NetworkStatus::MulticastPacket (Ptr<const Packet> packet, LoraDeviceAddress mcAd
                 {
                 //\TODO fire tracesource for number of gateways that were not available for transmission.
                 // Reasons can be that the gateway is busy, or that the duty cycle limitation or it is reserved. 
+                  if (reserved)
+                    {
+                      (it)->second->CancelReservation (Simulator::Now (), mcAddress);
+                    }
                 }
               
             }
@@ -397,5 +416,47 @@ NetworkStatus::MulticastPacket (Ptr<const Packet> packet, LoraDeviceAddress mcAd
   return successfulGateways; // Number of gateways for which the multicast transmission was successfully sent
 }
 
+uint8_t
+NetworkStatus::ReserveMulticastPing (Time start, LoraDeviceAddress mcAddress, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << start << mcAddress << size);
+
+  Ptr<EndDeviceStatus> devStatus = GetMulticastGroupStatus (mcAddress);
+  if (devStatus == 0)
+    {
+      return 0;
+    }
+
+  uint8_t dataRate = devStatus->GetMac ()->GetPingSlotReceiveWindowDataRate ();
+  double frequency = devStatus->GetMac ()->GetPingSlotRecieveWindowFrequency ();
+  size += LoraMacHeader ().GetSerializedSize () + LoraFrameHeader ().GetSerializedSize ();
+
+  uint8_t reservedGateways = 0;
+  for (auto it = m_gatewayStatuses.begin (); it != m_gatewayStatuses.end (); ++it)
+    {
+      Ptr<GatewayLoraMac> gwLoraMac = it->second->GetGatewayMac ();
+      if (gwLoraMac->IsClassBTransmissionEnabled () && gwLoraMac->CheckMulticastGroup (mcAddress)
+          && it->second->Reserve (start, it->second->GetOnAirTime (dataRate, size), frequency,
+                                  GatewayStatus::CLASS_B_MULTICAST, mcAddress))
+        {
+          reservedGateways++;
+        }
+    }
+  return reservedGateways;
+}
+
+Ptr<EndDeviceStatus>
+NetworkStatus::GetMulticastGroupStatus (LoraDeviceAddress mcAddress)
+{
+  //Get the device status of one of the end devices in the multicast group.
+  //This works because an end devices class B parameter is for multicast if multicast is enabled
+  McEndDeviceStatusMap::iterator it = m_mcEndDeviceStatuses.find (mcAddress);
+  if (it == m_mcEndDeviceStatuses.end ())
+    {
+      return 0;
+    }
+  return it->second.begin ()->second;
+}
+
 }
 }
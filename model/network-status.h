@@ -115,6 +115,13 @@ public:
    * \return the time stamp included in the bcnPayload, 0 if beacon is not sent
    */
   uint32_t BroadcastBeacon (void);
+
+  /**
+   * Reserve the beacon enabled gateways for a beacon
+   *
+   * \param start the time at which the beacon is going to be broadcasted
+   */
+  void ReserveBeacon (Time start);
   
   /**
    * Multicasts a packet to a multicast group using the geteways assigned to that group
@@ -126,6 +133,17 @@ public:
    */
   uint8_t MulticastPacket (Ptr<Packet const> packet, LoraDeviceAddress mcAddress);
 
+  /**
+   * Reserve the gateways of a multicast group for a downlink on a ping slot
+   *
+   * \param start the time at which the ping slot starts
+   * \param mcAddress the multicast address of the group
+   * \param size the size of the appPayload of the downlink
+   *
+   * \return the number of gateways that are reserved for the downlink
+   */
+  uint8_t ReserveMulticastPing (Time start, LoraDeviceAddress mcAddress, uint32_t size);
+
 public:
   typedef std::map<LoraDeviceAddress, Ptr<EndDeviceStatus> > EndDeviceStatusMap;
   typedef std::map<LoraDeviceAddress, EndDeviceStatusMap > McEndDeviceStatusMap;
@@ -136,6 +154,14 @@ public:
   McEndDeviceStatusMap m_mcEndDeviceStatuses; ///< For corsponding the unicast and the multicat address
 
 private:  
+  /**
+   * Get the status of one of the devices of a multicast group, whose class B
+   * parameters are the ones of the whole group
+   *
+   * \return the status of the device, 0 if there is no such group
+   */
+  Ptr<EndDeviceStatus> GetMulticastGroupStatus (LoraDeviceAddress mcAddress);
+
   uint8_t m_beaconDr; ///< beacon DR to be used, default is 3
   double m_beaconFrequency; ///< beacon Frequency to be used, default is 869.525
 
@@ -0,0 +1,265 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/population-sender.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("PopulationSender");
+
+NS_OBJECT_ENSURE_REGISTERED (PopulationSender);
+
+TypeId
+PopulationSender::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PopulationSender")
+    .SetParent<Application> ()
+    .AddConstructor<PopulationSender> ()
+    .SetGroupName ("lorawan")
+    .AddAttribute ("Interval", "The interval between packets, or bursts, of each device",
+                   TimeValue (Seconds (600)),
+                   MakeTimeAccessor (&PopulationSender::GetInterval,
+                                     &PopulationSender::SetInterval),
+                   MakeTimeChecker ());
+  return tid;
+}
+
+PopulationSender::PopulationSender ()
+  : m_pattern (PERIODIC),
+  m_interval (Seconds (600)),
+  m_burstSize (1),
+  m_burstSpacing (Seconds (0)),
+  m_pktSize (10),
+  m_nScheduledEvents (0),
+  m_nSentPackets (0)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  m_phaseRv = CreateObject<UniformRandomVariable> ();
+  m_intervalRv = CreateObject<ExponentialRandomVariable> ();
+}
+
+PopulationSender::~PopulationSender ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+}
+
+bool
+PopulationSender::Later::operator() (const struct Entry& a, const struct Entry& b) const
+{
+  // Devices due at the same time send in the order they were added
+  return a.time > b.time || (a.time == b.time && a.device > b.device);
+}
+
+void
+PopulationSender::AddDevice (Ptr<LoraMac> mac)
+{
+  NS_LOG_FUNCTION (this << mac);
+
+  NS_ASSERT (mac != 0);
+
+  struct Device device;
+  device.mac = mac;
+  device.burstLeft = 0;
+  m_devices.push_back (device);
+}
+
+uint32_t
+PopulationSender::GetNDevices (void) const
+{
+  return m_devices.size ();
+}
+
+void
+PopulationSender::SetPattern (enum Pattern pattern)
+{
+  NS_LOG_FUNCTION (this << pattern);
+  m_pattern = pattern;
+}
+
+void
+PopulationSender::SetInterval (Time interval)
+{
+  NS_LOG_FUNCTION (this << interval);
+  m_interval = interval;
+}
+
+Time
+PopulationSender::GetInterval (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_interval;
+}
+
+void
+PopulationSender::SetBurst (uint32_t size, Time spacing)
+{
+  NS_LOG_FUNCTION (this << size << spacing);
+
+  NS_ASSERT_MSG (size > 0, "A burst has at least one packet");
+  m_burstSize = size;
+  m_burstSpacing = spacing;
+}
+
+void
+PopulationSender::SetPacketSize (uint8_t size)
+{
+  m_pktSize = size;
+}
+
+Time
+PopulationSender::GetPhase (uint32_t device) const
+{
+  NS_ASSERT (device < m_devices.size ());
+  return m_devices[device].phase;
+}
+
+uint64_t
+PopulationSender::GetNScheduledEvents (void) const
+{
+  return m_nScheduledEvents;
+}
+
+uint64_t
+PopulationSender::GetNSentPackets (void) const
+{
+  return m_nSentPackets;
+}
+
+int64_t
+PopulationSender::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+
+  m_phaseRv->SetStream (stream);
+  m_intervalRv->SetStream (stream + 1);
+  return 2;
+}
+
+Time
+PopulationSender::GetNextDelay (struct Device& device)
+{
+  switch (m_pattern)
+    {
+    case POISSON:
+      return Seconds (m_intervalRv->GetValue (m_interval.GetSeconds (), 0));
+    case BURSTY:
+      if (--device.burstLeft > 0)
+        {
+          return m_burstSpacing;
+        }
+      // The next burst starts an interval after the start of this one
+      device.burstLeft = m_burstSize;
+      return m_interval - (m_burstSize - 1) * m_burstSpacing;
+    case PERIODIC:
+    default:
+      return m_interval;
+    }
+}
+
+void
+PopulationSender::SendPackets (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Time now = Simulator::Now ();
+  uint32_t nSent = 0;
+
+  while (!m_calendar.empty () && m_calendar.front ().time <= now)
+    {
+      std::pop_heap (m_calendar.begin (), m_calendar.end (), Later ());
+      struct Entry& entry = m_calendar.back ();
+      struct Device& device = m_devices[entry.device];
+
+      // The copies share the payload until the MAC adds its headers
+      device.mac->Send (m_payload->Copy ());
+      nSent++;
+
+      entry.time = now + GetNextDelay (device);
+      std::push_heap (m_calendar.begin (), m_calendar.end (), Later ());
+    }
+
+  m_nSentPackets += nSent;
+  NS_LOG_DEBUG ("Sent " << nSent << " packets");
+
+  ScheduleNext ();
+}
+
+void
+PopulationSender::ScheduleNext (void)
+{
+  if (m_calendar.empty ())
+    {
+      return;
+    }
+
+  m_sendEvent = Simulator::Schedule (m_calendar.front ().time - Simulator::Now (),
+                                     &PopulationSender::SendPackets, this);
+  m_nScheduledEvents++;
+}
+
+void
+PopulationSender::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_ASSERT_MSG (m_interval > Seconds (0), "The interval has to be positive");
+  NS_ASSERT_MSG (m_pattern != BURSTY || (m_burstSize - 1) * m_burstSpacing < m_interval,
+                 "A burst has to be shorter than the interval");
+
+  m_payload = Create<Packet> (m_pktSize);
+
+  // Draw the phases in the order the devices were added
+  Time now = Simulator::Now ();
+  m_calendar.clear ();
+  m_calendar.reserve (m_devices.size ());
+  for (uint32_t i = 0; i < m_devices.size (); i++)
+    {
+      struct Device& device = m_devices[i];
+      device.phase = Seconds (m_phaseRv->GetValue (0, m_interval.GetSeconds ()));
+      device.burstLeft = m_burstSize;
+
+      struct Entry entry;
+      entry.time = now + device.phase;
+      entry.device = i;
+      m_calendar.push_back (entry);
+    }
+  std::make_heap (m_calendar.begin (), m_calendar.end (), Later ());
+
+  NS_LOG_DEBUG ("Starting up the traffic of " << m_devices.size () << " devices");
+
+  Simulator::Cancel (m_sendEvent);
+  ScheduleNext ();
+}
+
+void
+PopulationSender::StopApplication (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  Simulator::Cancel (m_sendEvent);
+}
+
+}
+}
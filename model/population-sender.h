@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef POPULATION_SENDER_H
+#define POPULATION_SENDER_H
+
+#include "ns3/application.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/lora-mac.h"
+#include "ns3/random-variable-stream.h"
+
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * An application that generates the uplink traffic of a whole population of
+ * end devices
+ *
+ * Instead of one PeriodicSender per device, each with its own pending send
+ * event, this application keeps the next send time of every device in a
+ * single calendar (a binary min-heap) and schedules one simulator event for
+ * the earliest time in it. When the event fires, all the devices that are due
+ * send a packet through their MAC and are put back in the calendar with their
+ * next send time.
+ *
+ * The traffic of each device follows one of the patterns:
+ *  - PERIODIC: a packet every interval,
+ *  - POISSON: exponentially distributed times between packets, with the
+ *    interval as mean,
+ *  - BURSTY: every interval, a burst of packets separated by the burst
+ *    spacing.
+ *
+ * The phase of each device, the time of its first packet after the start of
+ * the application, is drawn uniformly in [0, interval) in the order the
+ * devices were added, so that it only depends on the random stream of the
+ * application and on the position of the device in the population.
+ *
+ * The application only needs to be installed on one node; its start and stop
+ * times apply to the whole population.
+ */
+class PopulationSender : public Application
+{
+public:
+  /// The traffic patterns of the devices
+  enum Pattern
+  {
+    PERIODIC,
+    POISSON,
+    BURSTY
+  };
+
+  PopulationSender ();
+  ~PopulationSender ();
+
+  static TypeId GetTypeId (void);
+
+  /**
+   * Add a device to the population
+   *
+   * \param mac the MAC layer of the device
+   */
+  void AddDevice (Ptr<LoraMac> mac);
+
+  /**
+   * \return the number of devices in the population
+   */
+  uint32_t GetNDevices (void) const;
+
+  /**
+   * Set the traffic pattern of the devices
+   */
+  void SetPattern (enum Pattern pattern);
+
+  /**
+   * Set the interval between two packets, or between two bursts
+   */
+  void SetInterval (Time interval);
+
+  /**
+   * Get the interval between two packets, or between two bursts
+   */
+  Time GetInterval (void) const;
+
+  /**
+   * Set the number of packets of a burst and the time between them, for the
+   * BURSTY pattern
+   */
+  void SetBurst (uint32_t size, Time spacing);
+
+  /**
+   * Set packet size
+   */
+  void SetPacketSize (uint8_t size);
+
+  /**
+   * \param device the index of a device, in the order it was added
+   * \return the phase of the device, valid after the application started
+   */
+  Time GetPhase (uint32_t device) const;
+
+  /**
+   * \return the number of simulator events scheduled so far
+   */
+  uint64_t GetNScheduledEvents (void) const;
+
+  /**
+   * \return the number of packets sent so far
+   */
+  uint64_t GetNSentPackets (void) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this application
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this application
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * Send the packets of all the devices that are due and schedule the next
+   * event
+   */
+  void SendPackets (void);
+
+  /**
+   * Start the application by drawing the phases and scheduling the first
+   * SendPackets event
+   */
+  void StartApplication (void);
+
+  /**
+   * Stop the application
+   */
+  void StopApplication (void);
+
+private:
+  /// A device of the population
+  struct Device
+  {
+    Ptr<LoraMac> mac;
+    Time phase;
+    uint32_t burstLeft;   ///< Packets left in the current burst
+  };
+
+  /// An entry of the calendar
+  struct Entry
+  {
+    Time time;
+    uint32_t device;
+  };
+
+  /**
+   * Order the calendar as a min-heap on the time, then on the device
+   */
+  struct Later
+  {
+    bool operator() (const struct Entry& a, const struct Entry& b) const;
+  };
+
+  /**
+   * \return the time from the current packet of a device to its next one
+   */
+  Time GetNextDelay (struct Device& device);
+
+  /**
+   * Schedule the SendPackets event for the earliest entry of the calendar
+   */
+  void ScheduleNext (void);
+
+  std::vector<struct Device> m_devices;
+  std::vector<struct Entry> m_calendar; ///< A binary min-heap
+
+  enum Pattern m_pattern;
+  Time m_interval;
+  uint32_t m_burstSize;
+  Time m_burstSpacing;
+
+  Ptr<UniformRandomVariable> m_phaseRv;
+  Ptr<ExponentialRandomVariable> m_intervalRv;
+
+  /**
+   * The payload shared by all the packets, each packet is a copy of it
+   */
+  Ptr<Packet> m_payload;
+  uint8_t m_pktSize;
+
+  EventId m_sendEvent;
+  uint64_t m_nScheduledEvents;
+  uint64_t m_nSentPackets;
+};
+
+}
+}
+#endif /* POPULATION_SENDER_H */
@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/raster-shadowing-propagation-loss-model.h"
+#include "ns3/string.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("RasterShadowingPropagationLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (RasterShadowingPropagationLossModel);
+
+TypeId
+RasterShadowingPropagationLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RasterShadowingPropagationLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Lora")
+    .AddConstructor<RasterShadowingPropagationLossModel> ()
+    .AddAttribute ("FileName",
+                   "The shadowing raster to map, as written by "
+                   "ShadowingRasterHelper",
+                   StringValue (""),
+                   MakeStringAccessor
+                     (&RasterShadowingPropagationLossModel::SetFileName),
+                   MakeStringChecker ());
+  return tid;
+}
+
+RasterShadowingPropagationLossModel::RasterShadowingPropagationLossModel () :
+  m_mapping (0),
+  m_mappingSize (0),
+  m_values (0)
+{
+  std::memset (&m_header, 0, sizeof (m_header));
+}
+
+RasterShadowingPropagationLossModel::~RasterShadowingPropagationLossModel ()
+{
+  Unload ();
+}
+
+void
+RasterShadowingPropagationLossModel::DoDispose (void)
+{
+  Unload ();
+  PropagationLossModel::DoDispose ();
+}
+
+void
+RasterShadowingPropagationLossModel::SetFileName (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  if (fileName.empty ())
+    {
+      Unload ();
+    }
+  else if (!Load (fileName))
+    {
+      NS_FATAL_ERROR ("RasterShadowingPropagationLossModel: cannot map raster " << fileName);
+    }
+}
+
+bool
+RasterShadowingPropagationLossModel::Load (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  Unload ();
+
+  int fd = open (fileName.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_ERROR ("Cannot open " << fileName);
+      return false;
+    }
+
+  struct stat fileStat;
+  if (fstat (fd, &fileStat) != 0 || std::size_t (fileStat.st_size) < sizeof (RasterHeader))
+    {
+      NS_LOG_ERROR ("Cannot read the header of " << fileName);
+      close (fd);
+      return false;
+    }
+
+  std::size_t size = fileStat.st_size;
+  void* mapping = mmap (0, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the file is closed
+  close (fd);
+  if (mapping == MAP_FAILED)
+    {
+      NS_LOG_ERROR ("Cannot map " << fileName);
+      return false;
+    }
+
+  RasterHeader header;
+  std::memcpy (&header, mapping, sizeof (header));
+
+  if (std::memcmp (header.magic, "LSR1", 4) != 0
+      || header.nx == 0 || header.ny == 0 || !(header.resolution > 0)
+      || size < sizeof (RasterHeader) + std::size_t (header.nx) * header.ny * sizeof (float))
+    {
+      NS_LOG_ERROR (fileName << " is not a valid shadowing raster");
+      munmap (mapping, size);
+      return false;
+    }
+
+  m_mapping = mapping;
+  m_mappingSize = size;
+  m_header = header;
+  m_values = reinterpret_cast<const float*> (static_cast<const char*> (mapping) + sizeof (RasterHeader));
+
+  NS_LOG_INFO ("Mapped a " << header.nx << "x" << header.ny << " raster with resolution "
+                           << header.resolution << " m from " << fileName);
+  return true;
+}
+
+void
+RasterShadowingPropagationLossModel::Unload (void)
+{
+  if (m_mapping != 0)
+    {
+      munmap (m_mapping, m_mappingSize);
+      m_mapping = 0;
+      m_mappingSize = 0;
+      m_values = 0;
+      std::memset (&m_header, 0, sizeof (m_header));
+    }
+}
+
+bool
+RasterShadowingPropagationLossModel::IsLoaded (void) const
+{
+  return m_values != 0;
+}
+
+double
+RasterShadowingPropagationLossModel::GetShadowing (double x, double y) const
+{
+  if (m_values == 0)
+    {
+      return 0;
+    }
+
+  // Position in units of the raster, clamped to its edges
+  double gx = std::min (std::max ((x - m_header.xMin) / m_header.resolution, 0.0),
+                        double (m_header.nx - 1));
+  double gy = std::min (std::max ((y - m_header.yMin) / m_header.resolution, 0.0),
+                        double (m_header.ny - 1));
+
+  // Lower left corner of the cell, kept inside the raster so that the upper
+  // right corner exists too (unless the raster is a single row or column)
+  uint32_t i = std::min (uint32_t (gx), m_header.nx > 1 ? m_header.nx - 2 : 0);
+  uint32_t j = std::min (uint32_t (gy), m_header.ny > 1 ? m_header.ny - 2 : 0);
+  uint32_t i1 = std::min (i + 1, m_header.nx - 1);
+  uint32_t j1 = std::min (j + 1, m_header.ny - 1);
+  double fx = gx - i;
+  double fy = gy - j;
+
+  const float* row = m_values + std::size_t (j) * m_header.nx;
+  const float* nextRow = m_values + std::size_t (j1) * m_header.nx;
+
+  return (1 - fy) * ((1 - fx) * row[i] + fx * row[i1])
+         + fy * ((1 - fx) * nextRow[i] + fx * nextRow[i1]);
+}
+
+double
+RasterShadowingPropagationLossModel::DoCalcRxPower (double txPowerDbm,
+                                                    Ptr<MobilityModel> a,
+                                                    Ptr<MobilityModel> b) const
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << a << b);
+
+  Vector aPosition = a->GetPosition ();
+  Vector bPosition = b->GetPosition ();
+
+  double loss = (GetShadowing (aPosition.x, aPosition.y)
+                 + GetShadowing (bPosition.x, bPosition.y)) / std::sqrt (2.0);
+
+  NS_LOG_INFO ("Shadowing loss: " << loss);
+
+  return txPowerDbm - loss;
+}
+
+int64_t
+RasterShadowingPropagationLossModel::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+}
+}
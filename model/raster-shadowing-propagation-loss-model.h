@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef RASTER_SHADOWING_PROPAGATION_LOSS_MODEL_H
+#define RASTER_SHADOWING_PROPAGATION_LOSS_MODEL_H
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/mobility-model.h"
+
+#include <string>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Shadowing read from a precomputed raster
+ *
+ * Instead of generating the shadowing on the fly like
+ * CorrelatedShadowingPropagationLossModel, this model reads a shadowing field
+ * written by ShadowingRasterHelper. The file is memory-mapped read only, so
+ * that parallel runs using the same raster share the same pages of the page
+ * cache, and the environment does not depend on the seed of the run.
+ *
+ * The shadowing at a point is the bilinear interpolation of the 4 raster
+ * values around it, points outside of the raster take the value of the
+ * nearest edge. Since the field depends on the position only, the loss of a
+ * link is (S(a) + S(b)) / sqrt (2), which keeps the variance of the field and
+ * makes the link reciprocal.
+ *
+ * The file holds, in host byte order, a RasterHeader followed by nx * ny
+ * float values in dB, row by row starting from yMin.
+ */
+class RasterShadowingPropagationLossModel : public PropagationLossModel
+{
+public:
+  /// The header of a raster file
+  struct RasterHeader
+  {
+    char magic[4];          ///< "LSR1"
+    uint32_t nx;            ///< Number of values along x
+    uint32_t ny;            ///< Number of values along y
+    uint32_t reserved;
+    double xMin;            ///< x of the first value of each row, in m
+    double yMin;            ///< y of the first row, in m
+    double resolution;      ///< Distance between two neighboring values, in m
+  };
+
+  static TypeId GetTypeId (void);
+
+  RasterShadowingPropagationLossModel ();
+  virtual ~RasterShadowingPropagationLossModel ();
+
+  /**
+   * Map a raster file, unmapping the previous one if any
+   *
+   * \return whether the file is a valid raster
+   */
+  bool Load (std::string fileName);
+
+  /**
+   * \return whether a raster is mapped
+   */
+  bool IsLoaded (void) const;
+
+  /**
+   * Get the interpolated shadowing of the field at a position
+   *
+   * \return the shadowing in dB, 0 if no raster is mapped
+   */
+  double GetShadowing (double x, double y) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  /**
+   * Set the raster file through the attribute system
+   */
+  void SetFileName (std::string fileName);
+
+  /**
+   * Unmap the raster, if any
+   */
+  void Unload (void);
+
+  void* m_mapping;              //!< The mapped file
+  std::size_t m_mappingSize;    //!< The size of the mapped file
+  const float* m_values;        //!< The values of the raster, inside m_mapping
+  RasterHeader m_header;        //!< A copy of the header of the raster
+};
+
+}
+}
+
+#endif /* RASTER_SHADOWING_PROPAGATION_LOSS_MODEL_H */
@@ -21,7 +21,6 @@
 #include <algorithm>
 #include "ns3/simple-end-device-lora-phy.h"
 #include "ns3/simulator.h"
-#include "ns3/lora-tag.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -73,12 +72,6 @@ SimpleEndDeviceLoraPhy::Send (Ptr<Packet> packet, LoraTxParameters txParams,
   // We can send the packet: switch to the TX state
   SwitchToTx (txPowerDbm);
 
-  // Tag the packet with information about its Spreading Factor
-  LoraTag tag;
-  packet->RemovePacketTag (tag);
-  tag.SetSpreadingFactor (txParams.sf);
-  packet->AddPacketTag (tag);
-
   // Send the packet over the channel
   NS_LOG_INFO ("Sending the packet in the channel");
   m_channel->Send (this, packet, txPowerDbm, txParams, duration, frequencyMHz);
@@ -304,7 +297,11 @@ SimpleEndDeviceLoraPhy::EndReceive (Ptr<Packet> packet,
       // If there is one, perform the callback to inform the upper layer
       if (!m_rxOkCallback.IsNull ())
         {
-          m_rxOkCallback (packet);
+          LoraTxMetadata metadata;
+          metadata.sf = event->GetSpreadingFactor ();
+          metadata.frequencyMHz = event->GetFrequency ();
+          metadata.rxPowerDbm = event->GetRxPowerdBm ();
+          m_rxOkCallback (packet, metadata);
         }
 
     }
@@ -19,9 +19,9 @@
  */
 
 #include "ns3/simple-gateway-lora-phy.h"
-#include "ns3/lora-tag.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/lora-profiler.h"
 
 namespace ns3 {
 namespace lorawan {
@@ -119,6 +119,9 @@ SimpleGatewayLoraPhy::StartReceive (Ptr<Packet> packet, double rxPowerDbm,
 {
   NS_LOG_FUNCTION (this << packet << rxPowerDbm << duration << frequencyMHz);
 
+  LORA_PROFILE_SCOPE (GATEWAY_START_RECEIVE);
+  LORA_PROFILE_ITEMS (m_receptionPaths.size ());
+
   // Fire the trace source
   m_phyRxBeginTrace (packet);
 
@@ -231,6 +234,8 @@ SimpleGatewayLoraPhy::EndReceive (Ptr<Packet> packet,
 {
   NS_LOG_FUNCTION (this << packet << *event);
 
+  LORA_PROFILE_SCOPE (GATEWAY_END_RECEIVE);
+
   // Call the trace source
   m_phyRxEndTrace (packet);
 
@@ -245,12 +250,6 @@ SimpleGatewayLoraPhy::EndReceive (Ptr<Packet> packet,
     {
       NS_LOG_DEBUG ("packetDestroyed by " << unsigned(packetDestroyed));
 
-      // Update the packet's LoraTag
-      LoraTag tag;
-      packet->RemovePacketTag (tag);
-      tag.SetDestroyedBy (packetDestroyed);
-      packet->AddPacketTag (tag);
-
       // Fire the trace source
       if (m_device)
         {
@@ -280,19 +279,14 @@ SimpleGatewayLoraPhy::EndReceive (Ptr<Packet> packet,
       // Forward the packet to the upper layer
       if (!m_rxOkCallback.IsNull ())
         {
-          // Make a copy of the packet
-          // Ptr<Packet> packetCopy = packet->Copy ();
-
-          // Set the receive power and frequency of this packet in the LoraTag: this
-          // information can be useful for upper layers trying to control link
-          // quality.
-          LoraTag tag;
-          packet->RemovePacketTag (tag);
-          tag.SetReceivePower (event->GetRxPowerdBm ());
-          tag.SetFrequency (event->GetFrequency ());
-          packet->AddPacketTag (tag);
-
-          m_rxOkCallback (packet);
+          // Pass the receive power and frequency of this packet along with
+          // it: this information can be useful for upper layers trying to
+          // control link quality.
+          LoraTxMetadata metadata;
+          metadata.sf = event->GetSpreadingFactor ();
+          metadata.frequencyMHz = event->GetFrequency ();
+          metadata.rxPowerDbm = event->GetRxPowerdBm ();
+          m_rxOkCallback (packet, metadata);
         }
 
     }
@@ -169,7 +169,7 @@ SimpleNetworkServer::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
   frameHdr.SetAsUplink ();
   myPacket->RemoveHeader (frameHdr);
   LoraTag tag;
-  myPacket->RemovePacketTag (tag);
+  myPacket->PeekPacketTag (tag);
 
   // Register which gateway this packet came from
   double rcvPower = tag.GetReceivePower ();
@@ -234,7 +234,8 @@ SimpleNetworkServer::SendOnFirstWindow (LoraDeviceAddress address)
       (address).GetFirstReceiveWindowFrequency ();
 
   Address gatewayForReply = GetGatewayForReply (address,
-                                                firstReceiveWindowFrequency);
+                                                firstReceiveWindowFrequency,
+                                                m_deviceStatuses.at (address).GetFirstReceiveWindowDataRate ());
 
   if (gatewayForReply != Address ())
     {
@@ -281,7 +282,8 @@ SimpleNetworkServer::SendOnSecondWindow (LoraDeviceAddress address)
       (address).GetSecondReceiveWindowFrequency ();
 
   // Decide on which gateway we'll transmit our reply
-  Address gatewayForReply = GetGatewayForReply (address, secondReceiveWindowFrequency);
+  Address gatewayForReply = GetGatewayForReply (address, secondReceiveWindowFrequency,
+                                                m_deviceStatuses.at (address).GetSecondReceiveWindowDataRate ());
 
   if (gatewayForReply != Address ())
     {
@@ -317,7 +319,7 @@ SimpleNetworkServer::SendOnSecondWindow (LoraDeviceAddress address)
 
 Address
 SimpleNetworkServer::GetGatewayForReply (LoraDeviceAddress deviceAddress,
-                                         double frequency)
+                                         double frequency, uint8_t dataRate)
 {
   NS_LOG_FUNCTION (this);
 
@@ -325,12 +327,15 @@ SimpleNetworkServer::GetGatewayForReply (LoraDeviceAddress deviceAddress,
   // Go in the order suggested by the DeviceStatus
   std::list<Address> addresses = m_deviceStatuses.at
       (deviceAddress).GetSortedGatewayAddresses ();
+  uint32_t size = m_deviceStatuses.at (deviceAddress).GetReplyPacket ()->GetSize ();
 
   for (auto it = addresses.begin (); it != addresses.end (); ++it)
     {
-      if (m_gatewayStatuses.at (*it).IsAvailableForTransmission (frequency))
+      GatewayStatus& gwStatus = m_gatewayStatuses.at (*it);
+      if (gwStatus.IsAvailableForTransmission (frequency)
+          && gwStatus.ClaimReservation (gwStatus.GetOnAirTime (dataRate, size), frequency,
+                                        GatewayStatus::CLASS_A_REPLY, deviceAddress))
         {
-          m_gatewayStatuses.at (*it).SetNextTransmissionTime (Simulator::Now ());
           return *it;
         }
     }
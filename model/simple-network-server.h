@@ -111,9 +111,10 @@ public:
    * Get the best gateway that is available to reply to this device.
    *
    * This method assumes the gateway needs to be available at the time that
-   * it is called.
+   * it is called, and reserves the gateway for the reply.
    */
-  Address GetGatewayForReply (LoraDeviceAddress deviceAddress, double frequency);
+  Address GetGatewayForReply (LoraDeviceAddress deviceAddress, double frequency,
+                              uint8_t dataRate);
 
   /**
    * Initialize the hasReply value of the device to the given value, so that the
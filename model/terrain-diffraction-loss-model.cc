@@ -0,0 +1,350 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#include "ns3/terrain-diffraction-loss-model.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace ns3 {
+namespace lorawan {
+
+NS_LOG_COMPONENT_DEFINE ("TerrainDiffractionLossModel");
+
+NS_OBJECT_ENSURE_REGISTERED (TerrainDiffractionLossModel);
+
+const uint32_t TerrainDiffractionLossModel::m_tileSize;
+
+TypeId
+TerrainDiffractionLossModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TerrainDiffractionLossModel")
+    .SetParent<PropagationLossModel> ()
+    .SetGroupName ("Lora")
+    .AddConstructor<TerrainDiffractionLossModel> ()
+    .AddAttribute ("Frequency",
+                   "The carrier frequency, in Hz",
+                   DoubleValue (868e6),
+                   MakeDoubleAccessor (&TerrainDiffractionLossModel::m_frequency),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxCachedTiles",
+                   "The maximum number of tiles of the elevation raster kept "
+                   "in memory, the least recently used one being dropped first",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&TerrainDiffractionLossModel::m_maxCachedTiles),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FileName",
+                   "The elevation raster to read",
+                   StringValue (""),
+                   MakeStringAccessor (&TerrainDiffractionLossModel::SetFileName),
+                   MakeStringChecker ());
+  return tid;
+}
+
+TerrainDiffractionLossModel::TerrainDiffractionLossModel () :
+  m_frequency (868e6),
+  m_maxCachedTiles (64)
+{
+  std::memset (&m_header, 0, sizeof (m_header));
+}
+
+TerrainDiffractionLossModel::~TerrainDiffractionLossModel ()
+{
+}
+
+void
+TerrainDiffractionLossModel::DoDispose (void)
+{
+  m_tiles.clear ();
+  m_recentTiles.clear ();
+  m_links.clear ();
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  PropagationLossModel::DoDispose ();
+}
+
+void
+TerrainDiffractionLossModel::SetFileName (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  if (!fileName.empty () && !Open (fileName))
+    {
+      NS_FATAL_ERROR ("TerrainDiffractionLossModel: cannot read elevation raster " << fileName);
+    }
+}
+
+bool
+TerrainDiffractionLossModel::Open (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  m_tiles.clear ();
+  m_recentTiles.clear ();
+  m_links.clear ();
+  std::memset (&m_header, 0, sizeof (m_header));
+  if (m_file.is_open ())
+    {
+      m_file.close ();
+    }
+  m_file.clear ();
+
+  m_file.open (fileName.c_str (), std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      NS_LOG_ERROR ("Cannot open " << fileName);
+      return false;
+    }
+
+  ElevationHeader header;
+  m_file.read (reinterpret_cast<char*> (&header), sizeof (header));
+  if (!m_file || std::memcmp (header.magic, "LDM1", 4) != 0
+      || header.nx == 0 || header.ny == 0 || !(header.resolution > 0))
+    {
+      NS_LOG_ERROR (fileName << " is not a valid elevation raster");
+      m_file.close ();
+      return false;
+    }
+
+  // Check that the file holds all the values
+  m_file.seekg (0, std::ios::end);
+  std::streamoff size = m_file.tellg ();
+  if (size < std::streamoff (sizeof (header) + std::size_t (header.nx) * header.ny * sizeof (float)))
+    {
+      NS_LOG_ERROR (fileName << " is truncated");
+      m_file.close ();
+      return false;
+    }
+
+  m_header = header;
+  NS_LOG_INFO ("Opened a " << header.nx << "x" << header.ny << " elevation raster with resolution "
+                           << header.resolution << " m from " << fileName);
+  return true;
+}
+
+bool
+TerrainDiffractionLossModel::WriteElevations (std::string fileName, uint32_t nx, uint32_t ny,
+                                              double xMin, double yMin, double resolution,
+                                              const std::vector<float>& elevations)
+{
+  NS_LOG_FUNCTION (fileName << nx << ny << xMin << yMin << resolution);
+  NS_ASSERT (elevations.size () == std::size_t (nx) * ny);
+
+  ElevationHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, "LDM1", 4);
+  header.nx = nx;
+  header.ny = ny;
+  header.xMin = xMin;
+  header.yMin = yMin;
+  header.resolution = resolution;
+
+  std::ofstream file (fileName.c_str (), std::ios::binary | std::ios::trunc);
+  if (!file.is_open ())
+    {
+      NS_LOG_ERROR ("Cannot open " << fileName);
+      return false;
+    }
+  file.write (reinterpret_cast<const char*> (&header), sizeof (header));
+  file.write (reinterpret_cast<const char*> (elevations.data ()),
+              elevations.size () * sizeof (float));
+  file.close ();
+  return !file.fail ();
+}
+
+float
+TerrainDiffractionLossModel::GetSample (uint32_t i, uint32_t j) const
+{
+  uint32_t tileI = i / m_tileSize;
+  uint32_t tileJ = j / m_tileSize;
+  uint64_t key = (uint64_t (tileI) << 32) | tileJ;
+
+  std::unordered_map<uint64_t, Tile>::iterator it = m_tiles.find (key);
+  if (it != m_tiles.end ())
+    {
+      m_recentTiles.splice (m_recentTiles.begin (), m_recentTiles, it->second.recent);
+    }
+  else
+    {
+      if (m_tiles.size () >= m_maxCachedTiles)
+        {
+          m_tiles.erase (m_recentTiles.back ());
+          m_recentTiles.pop_back ();
+        }
+
+      it = m_tiles.insert (std::make_pair (key, Tile ())).first;
+      Tile& tile = it->second;
+      tile.recent = m_recentTiles.insert (m_recentTiles.begin (), key);
+      tile.elevations.assign (m_tileSize * m_tileSize, 0);
+
+      // Read the part of each row of the raster that belongs to the tile
+      uint32_t firstI = tileI * m_tileSize;
+      uint32_t width = std::min (m_tileSize, m_header.nx - firstI);
+      uint32_t firstJ = tileJ * m_tileSize;
+      uint32_t height = std::min (m_tileSize, m_header.ny - firstJ);
+      for (uint32_t row = 0; row < height; row++)
+        {
+          std::size_t offset = std::size_t (firstJ + row) * m_header.nx + firstI;
+          m_file.seekg (sizeof (ElevationHeader) + offset * sizeof (float));
+          m_file.read (reinterpret_cast<char*> (&tile.elevations[row * m_tileSize]),
+                       width * sizeof (float));
+        }
+      if (!m_file)
+        {
+          NS_LOG_ERROR ("Cannot read the tile " << tileI << " " << tileJ);
+          m_file.clear ();
+        }
+      NS_LOG_DEBUG ("Read the tile " << tileI << " " << tileJ);
+    }
+
+  return it->second.elevations[(j % m_tileSize) * m_tileSize + i % m_tileSize];
+}
+
+double
+TerrainDiffractionLossModel::GetElevation (double x, double y) const
+{
+  if (m_header.nx == 0)
+    {
+      return 0;
+    }
+
+  // Position in units of the raster, clamped to its edges
+  double gx = std::min (std::max ((x - m_header.xMin) / m_header.resolution, 0.0),
+                        double (m_header.nx - 1));
+  double gy = std::min (std::max ((y - m_header.yMin) / m_header.resolution, 0.0),
+                        double (m_header.ny - 1));
+
+  uint32_t i = std::min (uint32_t (gx), m_header.nx > 1 ? m_header.nx - 2 : 0);
+  uint32_t j = std::min (uint32_t (gy), m_header.ny > 1 ? m_header.ny - 2 : 0);
+  uint32_t i1 = std::min (i + 1, m_header.nx - 1);
+  uint32_t j1 = std::min (j + 1, m_header.ny - 1);
+  double fx = gx - i;
+  double fy = gy - j;
+
+  return (1 - fy) * ((1 - fx) * GetSample (i, j) + fx * GetSample (i1, j))
+         + fy * ((1 - fx) * GetSample (i, j1) + fx * GetSample (i1, j1));
+}
+
+double
+TerrainDiffractionLossModel::GetDiffractionLoss (Vector a, Vector b) const
+{
+  NS_LOG_FUNCTION (this << a << b);
+
+  double distance = std::sqrt ((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+  if (m_header.nx == 0 || distance <= m_header.resolution)
+    {
+      return 0;
+    }
+
+  // Heights of the antennas above the sea level
+  double heightA = GetElevation (a.x, a.y) + a.z;
+  double heightB = GetElevation (b.x, b.y) + b.z;
+
+  double wavelength = 299792458.0 / m_frequency;
+  double effectiveEarthRadius = 4.0 / 3.0 * 6371e3;
+
+  // Look for the obstacle with the largest Fresnel-Kirchhoff parameter
+  double maxV = -std::numeric_limits<double>::infinity ();
+  uint32_t nSteps = std::ceil (distance / m_header.resolution);
+  for (uint32_t k = 1; k < nSteps; k++)
+    {
+      double d1 = distance * k / nSteps;
+      double d2 = distance - d1;
+      double x = a.x + (b.x - a.x) * k / nSteps;
+      double y = a.y + (b.y - a.y) * k / nSteps;
+
+      double ground = GetElevation (x, y) + d1 * d2 / (2 * effectiveEarthRadius);
+      double lineOfSight = heightA + (heightB - heightA) * d1 / distance;
+      double v = (ground - lineOfSight) * std::sqrt (2 * distance / (wavelength * d1 * d2));
+      maxV = std::max (maxV, v);
+    }
+
+  // Knife edge diffraction loss, ITU-R P.526 approximation
+  if (maxV <= -0.78)
+    {
+      return 0;
+    }
+  return 6.9 + 20 * std::log10 (std::sqrt ((maxV - 0.1) * (maxV - 0.1) + 1) + maxV - 0.1);
+}
+
+double
+TerrainDiffractionLossModel::DoCalcRxPower (double txPowerDbm,
+                                            Ptr<MobilityModel> a,
+                                            Ptr<MobilityModel> b) const
+{
+  NS_LOG_FUNCTION (this << txPowerDbm << a << b);
+
+  // The loss is reciprocal, so the same entry is used in both directions
+  const MobilityModel* first = PeekPointer (a);
+  const MobilityModel* second = PeekPointer (b);
+  Vector firstPosition = a->GetPosition ();
+  Vector secondPosition = b->GetPosition ();
+  if (second < first)
+    {
+      std::swap (first, second);
+      std::swap (firstPosition, secondPosition);
+    }
+
+  std::pair<std::map<std::pair<const MobilityModel*, const MobilityModel*>, Link>::iterator, bool>
+  inserted = m_links.insert (std::make_pair (std::make_pair (first, second), Link ()));
+  Link& link = inserted.first->second;
+
+  // Compute the loss of new links and of links whose nodes moved
+  if (inserted.second
+      || link.a.x != firstPosition.x || link.a.y != firstPosition.y || link.a.z != firstPosition.z
+      || link.b.x != secondPosition.x || link.b.y != secondPosition.y || link.b.z != secondPosition.z)
+    {
+      link.a = firstPosition;
+      link.b = secondPosition;
+      link.loss = GetDiffractionLoss (firstPosition, secondPosition);
+      NS_LOG_DEBUG ("Computed the diffraction loss of the link: " << link.loss);
+    }
+
+  return txPowerDbm - link.loss;
+}
+
+int64_t
+TerrainDiffractionLossModel::DoAssignStreams (int64_t stream)
+{
+  return 0;
+}
+
+std::size_t
+TerrainDiffractionLossModel::GetNCachedTiles (void) const
+{
+  return m_tiles.size ();
+}
+
+std::size_t
+TerrainDiffractionLossModel::GetNCachedLinks (void) const
+{
+  return m_links.size ();
+}
+
+}
+}
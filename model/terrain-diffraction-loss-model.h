@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2019 Delft University of Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+#ifndef TERRAIN_DIFFRACTION_LOSS_MODEL_H
+#define TERRAIN_DIFFRACTION_LOSS_MODEL_H
+
+#include "ns3/propagation-loss-model.h"
+#include "ns3/mobility-model.h"
+#include "ns3/vector.h"
+
+#include <fstream>
+#include <list>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+namespace lorawan {
+
+/**
+ * Diffraction loss over the terrain read from a digital elevation model
+ *
+ * The elevation profile between the two nodes is sampled at the resolution
+ * of the elevation raster, taking the curvature of the earth into account
+ * with the usual 4/3 effective radius, and the loss of the dominant knife
+ * edge is computed as in ITU-R P.526. The z coordinate of the nodes is their
+ * antenna height above the ground. The model only adds the diffraction loss,
+ * so it is meant to be chained after a distance based model, like
+ * LogDistancePropagationLossModel.
+ *
+ * The raster is read in square tiles, which are kept in a cache with least
+ * recently used eviction, so only the parts of the area that are used are in
+ * memory. The loss of each pair of nodes is kept too, and computed again only
+ * if one of the nodes moved: the elevation profile is walked once per link,
+ * not once per packet.
+ *
+ * The raster file holds, in host byte order, an ElevationHeader followed by
+ * nx * ny float elevations in m, row by row starting from yMin. Points
+ * outside of the raster take the elevation of the nearest edge.
+ */
+class TerrainDiffractionLossModel : public PropagationLossModel
+{
+public:
+  /// The header of an elevation raster file
+  struct ElevationHeader
+  {
+    char magic[4];          ///< "LDM1"
+    uint32_t nx;            ///< Number of values along x
+    uint32_t ny;            ///< Number of values along y
+    uint32_t reserved;
+    double xMin;            ///< x of the first value of each row, in m
+    double yMin;            ///< y of the first row, in m
+    double resolution;      ///< Distance between two neighboring values, in m
+  };
+
+  static TypeId GetTypeId (void);
+
+  TerrainDiffractionLossModel ();
+  virtual ~TerrainDiffractionLossModel ();
+
+  /**
+   * Open an elevation raster, dropping the cached tiles and links
+   *
+   * \return whether the file is a valid raster
+   */
+  bool Open (std::string fileName);
+
+  /**
+   * Write an elevation raster
+   *
+   * \param elevations the nx * ny elevations, row by row starting from yMin
+   * \return whether the file was written
+   */
+  static bool WriteElevations (std::string fileName, uint32_t nx, uint32_t ny,
+                               double xMin, double yMin, double resolution,
+                               const std::vector<float>& elevations);
+
+  /**
+   * Get the interpolated elevation of the ground at a point
+   *
+   * \return the elevation in m, 0 if no raster is open
+   */
+  double GetElevation (double x, double y) const;
+
+  /**
+   * Compute the diffraction loss between two points, without the link cache
+   *
+   * \return the loss in dB
+   */
+  double GetDiffractionLoss (Vector a, Vector b) const;
+
+  /**
+   * \return the number of tiles in the cache
+   */
+  std::size_t GetNCachedTiles (void) const;
+
+  /**
+   * \return the number of links in the cache
+   */
+  std::size_t GetNCachedLinks (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm,
+                                Ptr<MobilityModel> a,
+                                Ptr<MobilityModel> b) const;
+
+  virtual int64_t DoAssignStreams (int64_t stream);
+
+  /**
+   * Set the raster file through the attribute system
+   */
+  void SetFileName (std::string fileName);
+
+  /**
+   * Get a value of the raster, reading its tile if it is not cached
+   */
+  float GetSample (uint32_t i, uint32_t j) const;
+
+  /// A tile of the raster, along with its entry in m_recentTiles
+  struct Tile
+  {
+    std::vector<float> elevations;
+    std::list<uint64_t>::iterator recent;
+  };
+
+  /// The cached loss of a link, along with the positions it was computed for
+  struct Link
+  {
+    Vector a;
+    Vector b;
+    double loss;
+  };
+
+  static const uint32_t m_tileSize = 64;    //!< The side of a tile, in samples
+
+  double m_frequency;               //!< The carrier frequency, in Hz
+  uint32_t m_maxCachedTiles;        //!< The maximum number of cached tiles
+
+  mutable std::ifstream m_file;     //!< The raster file
+  ElevationHeader m_header;         //!< The header of the raster, nx is 0 if none is open
+
+  /**
+   * The cached tiles, keyed by their packed indices
+   */
+  mutable std::unordered_map<uint64_t, Tile> m_tiles;
+
+  /**
+   * The keys of m_tiles, most recently used first
+   */
+  mutable std::list<uint64_t> m_recentTiles;
+
+  /**
+   * The cached losses, keyed by the pair of mobility models in pointer order
+   */
+  mutable std::map<std::pair<const MobilityModel*, const MobilityModel*>, Link> m_links;
+};
+
+}
+}
+
+#endif /* TERRAIN_DIFFRACTION_LOSS_MODEL_H */
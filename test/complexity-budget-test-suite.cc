@@ -0,0 +1,628 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This file includes the complexity budget tests of the lorawan module. They
+ * run small deterministic scenarios and bound:
+ * - the total number of simulator events, as a function of the number of
+ *   transmissions, PHYs and gateways, so that an algorithmic regression on a
+ *   per-transmission path fails even if the results stay correct,
+ * - the peak number of events kept by the LoraInterferenceHelper of any PHY,
+ * - the number of Packet objects created per delivered frame. Copies are
+ *   counted as the distinct (uid, Packet) pairs seen at the trace sources of
+ *   the delivery path, hence copies made and released between two trace
+ *   sources are not counted.
+ *
+ * Author: Yonatan Woldeleul Shiferaw <yoniwt@gmail.com>
+ */
+
+// Include headers of classes to test
+#include "ns3/log.h"
+#include "utilities.h"
+#include "ns3/core-module.h"
+#include "ns3/callback.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/network-server.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/end-device-lora-mac.h"
+#include "ns3/end-device-class-b-app-helper.h"
+
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+
+// An essential include is test.h
+#include "ns3/test.h"
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE ("ComplexityBudgetTestSuite");
+
+// Budget of events of a transmission, on top of one reception per PHY
+static const uint64_t eventsPerTransmission = 30;
+// Budget of events of a transmission for each gateway that receives it
+static const uint64_t eventsPerGatewayReception = 15;
+// Budget of the events that are not related to transmissions, per node
+static const uint64_t eventsPerNode = 20;
+// Budget of the events of a ping slot, on top of one reception per PHY
+static const uint64_t eventsPerPingSlot = 50;
+// Budget of the events kept by an interference helper: the list is cleaned
+// when it grows beyond 100 events
+static const std::size_t maxInterferenceEvents = 110;
+// Budget of the Packet objects per delivered frame
+static const double maxPacketsPerDeliveredFrame = 8;
+
+//////////////////////////
+// ComplexityBudgetTest //
+//////////////////////////
+
+/**
+ * Base class of the complexity budget tests: it connects the counters to the
+ * trace sources of the nodes and checks the budgets.
+ */
+class ComplexityBudgetTest : public TestCase
+{
+public:
+  ComplexityBudgetTest (std::string name);
+  virtual ~ComplexityBudgetTest ();
+
+  void StartSending (Ptr<const Packet> packet, uint32_t index);
+  void SeenPacket (Ptr<const Packet> packet);
+  void DeliveredPacket (Ptr<const Packet> packet);
+  void DeliveredPingPacket (LoraDeviceAddress mcAddress, LoraDeviceAddress address,
+                            Ptr<const Packet> packet, uint8_t slotIndex);
+
+protected:
+  /**
+   * Connect the counters to the devices and to the network server
+   *
+   * \param nodes the end devices and gateways
+   * \param nsNode the network server node
+   */
+  void ConnectCounters (NodeContainer nodes, Ptr<Node> nsNode);
+
+  /**
+   * Collect the peak size of the interference lists, to be called before
+   * Simulator::Destroy
+   */
+  void CollectInterferenceEvents (NodeContainer nodes);
+
+  /**
+   * Check the budgets of the run
+   *
+   * \param eventBudget the maximum number of simulator events
+   */
+  void CheckBudgets (uint64_t eventBudget);
+
+  uint64_t m_transmissions = 0;
+  uint64_t m_deliveredFrames = 0;
+  std::size_t m_maxInterferenceEvents = 0;
+  std::set<std::pair<uint64_t, const Packet*> > m_packets;
+};
+
+ComplexityBudgetTest::ComplexityBudgetTest (std::string name)
+  : TestCase (name)
+{
+}
+
+ComplexityBudgetTest::~ComplexityBudgetTest ()
+{
+}
+
+void
+ComplexityBudgetTest::StartSending (Ptr<const Packet> packet, uint32_t index)
+{
+  m_transmissions++;
+  SeenPacket (packet);
+}
+
+void
+ComplexityBudgetTest::SeenPacket (Ptr<const Packet> packet)
+{
+  m_packets.insert (std::make_pair (packet->GetUid (), PeekPointer (packet)));
+}
+
+void
+ComplexityBudgetTest::DeliveredPacket (Ptr<const Packet> packet)
+{
+  m_deliveredFrames++;
+  SeenPacket (packet);
+}
+
+void
+ComplexityBudgetTest::DeliveredPingPacket (LoraDeviceAddress mcAddress, LoraDeviceAddress address,
+                                           Ptr<const Packet> packet, uint8_t slotIndex)
+{
+  DeliveredPacket (packet);
+}
+
+void
+ComplexityBudgetTest::ConnectCounters (NodeContainer nodes, Ptr<Node> nsNode)
+{
+  for (NodeContainer::Iterator it = nodes.Begin (); it != nodes.End (); ++it)
+    {
+      Ptr<LoraNetDevice> loraNetDevice = (*it)->GetDevice (0)->GetObject<LoraNetDevice> ();
+      Ptr<LoraPhy> phy = loraNetDevice->GetPhy ();
+      phy->TraceConnectWithoutContext ("StartSending",
+                                       MakeCallback (&ComplexityBudgetTest::StartSending, this));
+      phy->TraceConnectWithoutContext ("PhyRxBegin",
+                                       MakeCallback (&ComplexityBudgetTest::SeenPacket, this));
+      loraNetDevice->GetMac ()->TraceConnectWithoutContext
+        ("ReceivedPacket", MakeCallback (&ComplexityBudgetTest::SeenPacket, this));
+    }
+}
+
+void
+ComplexityBudgetTest::CollectInterferenceEvents (NodeContainer nodes)
+{
+  for (NodeContainer::Iterator it = nodes.Begin (); it != nodes.End (); ++it)
+    {
+      Ptr<LoraPhy> phy = (*it)->GetDevice (0)->GetObject<LoraNetDevice> ()->GetPhy ();
+      m_maxInterferenceEvents = std::max (m_maxInterferenceEvents,
+                                          phy->GetInterferenceHelper ().GetMaxNumberOfEvents ());
+    }
+}
+
+void
+ComplexityBudgetTest::CheckBudgets (uint64_t eventBudget)
+{
+  uint64_t events = Simulator::GetEventCount ();
+
+  NS_LOG_DEBUG ("Events: " << events << " (budget " << eventBudget << "), "
+                           << "transmissions: " << m_transmissions << ", "
+                           << "delivered frames: " << m_deliveredFrames << ", "
+                           << "packets: " << m_packets.size () << ", "
+                           << "peak interference events: " << m_maxInterferenceEvents);
+
+  NS_TEST_EXPECT_MSG_GT (m_deliveredFrames, uint64_t (0), "The scenario didn't deliver any frame");
+  NS_TEST_EXPECT_MSG_EQ (events <= eventBudget, true,
+                         "The number of simulator events exceeds its budget");
+  NS_TEST_EXPECT_MSG_EQ (m_maxInterferenceEvents <= maxInterferenceEvents, true,
+                         "An interference list grew beyond its budget");
+  if (m_deliveredFrames > 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (double (m_packets.size ()) / m_deliveredFrames <= maxPacketsPerDeliveredFrame,
+                             true, "The packet copies per delivered frame exceed their budget");
+    }
+}
+
+////////////////////////////
+// ClassAUplinkBudgetTest //
+////////////////////////////
+
+class ClassAUplinkBudgetTest : public ComplexityBudgetTest
+{
+public:
+  ClassAUplinkBudgetTest (int nDevices, int nGateways, int nPackets);
+  virtual ~ClassAUplinkBudgetTest ();
+
+  void SendPacket (Ptr<Node> endDevice);
+
+private:
+  virtual void DoRun (void);
+
+  int m_nDevices;
+  int m_nGateways;
+  int m_nPackets;
+};
+
+ClassAUplinkBudgetTest::ClassAUplinkBudgetTest (int nDevices, int nGateways, int nPackets)
+  : ComplexityBudgetTest ("Verify the complexity budget of a class A uplink burst with "
+                          + std::to_string (nDevices) + " devices and "
+                          + std::to_string (nGateways) + " gateways"),
+  m_nDevices (nDevices),
+  m_nGateways (nGateways),
+  m_nPackets (nPackets)
+{
+}
+
+ClassAUplinkBudgetTest::~ClassAUplinkBudgetTest ()
+{
+}
+
+void
+ClassAUplinkBudgetTest::SendPacket (Ptr<Node> endDevice)
+{
+  endDevice->GetDevice (0)->Send (Create<Packet> (20), Address (), 0);
+}
+
+void
+ClassAUplinkBudgetTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("ClassAUplinkBudgetTest");
+
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  NetworkComponents components = InitializeNetwork (m_nDevices, m_nGateways);
+
+  NodeContainer nodes;
+  nodes.Add (components.endDevices);
+  nodes.Add (components.gateways);
+
+  ConnectCounters (nodes, components.nsNode);
+  components.nsNode->GetApplication (0)->TraceConnectWithoutContext
+    ("ReceivedPacket", MakeCallback (&ComplexityBudgetTest::DeliveredPacket, this));
+
+  // Bursts of one packet per device, far enough apart for the duty cycle
+  for (int packet = 0; packet < m_nPackets; packet++)
+    {
+      for (int device = 0; device < m_nDevices; device++)
+        {
+          Simulator::Schedule (Seconds (1 + 200 * packet + 2 * device),
+                               &ClassAUplinkBudgetTest::SendPacket, this,
+                               components.endDevices.Get (device));
+        }
+    }
+
+  Simulator::Stop (Seconds (200 * m_nPackets + 2 * m_nDevices + 10));
+  Simulator::Run ();
+
+  uint64_t nPhys = nodes.GetN ();
+  uint64_t eventBudget = m_transmissions * (nPhys + eventsPerTransmission
+                                            + m_nGateways * eventsPerGatewayReception)
+    + (nPhys + 1) * eventsPerNode;
+
+  CollectInterferenceEvents (nodes);
+  CheckBudgets (eventBudget);
+
+  Simulator::Destroy ();
+}
+
+///////////////////////////////
+// ClassBMulticastBudgetTest //
+///////////////////////////////
+
+class ClassBMulticastBudgetTest : public ComplexityBudgetTest
+{
+public:
+  ClassBMulticastBudgetTest (bool beaconClock);
+  virtual ~ClassBMulticastBudgetTest ();
+
+private:
+  virtual void DoRun (void);
+
+  bool m_beaconClock;
+};
+
+ClassBMulticastBudgetTest::ClassBMulticastBudgetTest (bool beaconClock)
+  : ComplexityBudgetTest ("Verify the complexity budget of class B multicast beacon periods"
+                          + std::string (beaconClock ? " with a shared beacon clock" : "")),
+  m_beaconClock (beaconClock)
+{
+}
+
+ClassBMulticastBudgetTest::~ClassBMulticastBudgetTest ()
+{
+}
+
+void
+ClassBMulticastBudgetTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("ClassBMulticastBudgetTest");
+
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+
+  int nDevices = 4;
+  int nBeaconPeriods = 4;
+  // Ping slot periodicity 0 opens 128 ping slots per beacon period
+  int nPingSlots = 128;
+
+  Ptr<LoraChannel> channel = CreateChannel ();
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator ("ns3::UniformDiscPositionAllocator",
+                                 "rho", DoubleValue (1000),
+                                 "X", DoubleValue (0.0),
+                                 "Y", DoubleValue (0.0));
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  // The multicast group needs addressed end devices
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LoraMacHelper macHelper = LoraMacHelper ();
+  macHelper.SetAddressGenerator (CreateObject<LoraDeviceAddressGenerator> (54, 1864));
+  Ptr<BeaconClock> beaconClock = 0;
+  if (m_beaconClock)
+    {
+      beaconClock = CreateObject<BeaconClock> ();
+      macHelper.SetBeaconClock (beaconClock);
+    }
+  LoraHelper helper = LoraHelper ();
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  mobility.Install (endDevices);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LoraMacHelper::ED);
+  helper.Install (phyHelper, macHelper, endDevices);
+
+  NodeContainer gateways = CreateGateways (1, mobility, channel);
+
+  macHelper.EnableBeaconTransmission (gateways);
+  macHelper.EnableClassBDownlinkTransmission (gateways);
+  macHelper.CreateNMulticastGroup (endDevices, gateways, nDevices, 3, 0, 0);
+  macHelper.SetSpreadingFactorsUp (endDevices, gateways, channel);
+
+  EndDeviceClassBAppHelper appHelper = EndDeviceClassBAppHelper ();
+  appHelper.SetPacketSize (10);
+  ApplicationContainer appContainer = appHelper.Install (endDevices);
+  appContainer.Start (Seconds (0));
+  appContainer.Stop (Seconds (128 * nBeaconPeriods));
+
+  NetworkServerHelper networkServerHelper = NetworkServerHelper ();
+  networkServerHelper.EnableBeaconTransmission (true);
+  networkServerHelper.SetPingDownlinkPacketSize (20);
+  networkServerHelper.SetEndDevices (endDevices);
+  networkServerHelper.SetGateways (gateways);
+  Ptr<Node> nsNode = CreateObject<Node> ();
+  networkServerHelper.Install (nsNode);
+
+  ForwarderHelper forwarderHelper;
+  forwarderHelper.Install (gateways);
+
+  NodeContainer nodes;
+  nodes.Add (endDevices);
+  nodes.Add (gateways);
+
+  ConnectCounters (nodes, nsNode);
+  for (NodeContainer::Iterator it = endDevices.Begin (); it != endDevices.End (); ++it)
+    {
+      Ptr<EndDeviceLoraMac> mac = GetMacLayerFromNode<EndDeviceLoraMac> (*it);
+      mac->TraceConnectWithoutContext
+        ("ReceivedPingMessages", MakeCallback (&ComplexityBudgetTest::DeliveredPingPacket, this));
+    }
+
+  Simulator::Stop (Seconds (128 * nBeaconPeriods));
+  Simulator::Run ();
+
+  // Every ping slot may carry a downlink, every beacon period a beacon, and
+  // the devices may send uplinks to switch to class B
+  uint64_t nPhys = nodes.GetN ();
+  uint64_t eventBudget = nBeaconPeriods * (nPingSlots + 1) * (nPhys + eventsPerPingSlot)
+    + m_transmissions * (nPhys + eventsPerTransmission + eventsPerGatewayReception)
+    + (nPhys + 1) * eventsPerNode;
+
+  CollectInterferenceEvents (nodes);
+  CheckBudgets (eventBudget);
+
+  // The devices of the group share the events of their beacon periods
+  if (beaconClock != 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((beaconClock->GetNNotifiedEvents () >= 2 * beaconClock->GetNScheduledEvents ()),
+                             true, "The beacon clock events are not shared by the multicast group");
+    }
+
+  Simulator::Destroy ();
+}
+
+/////////////////////
+// BeaconClockTest //
+/////////////////////
+
+/**
+ * Run the same class B multicast scenario with and without a shared
+ * BeaconClock and compare the outcomes of each device.
+ */
+class BeaconClockTest : public TestCase
+{
+public:
+  BeaconClockTest ();
+  virtual ~BeaconClockTest ();
+
+  void ReceivedPing (LoraDeviceAddress mcAddress, LoraDeviceAddress address,
+                     Ptr<const Packet> packet, uint8_t slotIndex);
+  void ReceivedBeacon (LoraDeviceAddress mcAddress, LoraDeviceAddress address, uint32_t count);
+  void MissedBeacon (LoraDeviceAddress mcAddress, LoraDeviceAddress address, uint32_t count);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Run the scenario
+   *
+   * \return the outcomes of each device, in the order they happened
+   */
+  std::map<LoraDeviceAddress, std::vector<std::string> > Run (bool beaconClock);
+
+  /**
+   * Record an outcome of a device at the current time
+   */
+  void Record (LoraDeviceAddress address, std::string outcome);
+
+  std::map<LoraDeviceAddress, std::vector<std::string> > m_outcomes;
+};
+
+// Add some help text to this case to describe what it is intended to test
+BeaconClockTest::BeaconClockTest ()
+  : TestCase ("Verify that a shared beacon clock does not change the class B outcomes of the devices")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BeaconClockTest::~BeaconClockTest ()
+{
+}
+
+void
+BeaconClockTest::Record (LoraDeviceAddress address, std::string outcome)
+{
+  std::ostringstream os;
+  os << Simulator::Now ().GetNanoSeconds () << " " << outcome;
+  m_outcomes[address].push_back (os.str ());
+}
+
+void
+BeaconClockTest::ReceivedPing (LoraDeviceAddress mcAddress, LoraDeviceAddress address,
+                               Ptr<const Packet> packet, uint8_t slotIndex)
+{
+  std::ostringstream os;
+  os << "ping " << unsigned (slotIndex) << " " << packet->GetSize ();
+  Record (address, os.str ());
+}
+
+void
+BeaconClockTest::ReceivedBeacon (LoraDeviceAddress mcAddress, LoraDeviceAddress address,
+                                 uint32_t count)
+{
+  std::ostringstream os;
+  os << "beacon " << count;
+  Record (address, os.str ());
+}
+
+void
+BeaconClockTest::MissedBeacon (LoraDeviceAddress mcAddress, LoraDeviceAddress address,
+                               uint32_t count)
+{
+  std::ostringstream os;
+  os << "missed " << count;
+  Record (address, os.str ());
+}
+
+std::map<LoraDeviceAddress, std::vector<std::string> >
+BeaconClockTest::Run (bool beaconClock)
+{
+  RngSeedManager::SetSeed (1);
+  RngSeedManager::SetRun (1);
+  m_outcomes.clear ();
+
+  int nDevices = 4;
+  int nBeaconPeriods = 4;
+
+  Ptr<LoraChannel> channel = CreateChannel ();
+
+  // The automatic stream numbers keep growing from one run to the next: fix
+  // the streams of the random variables so that both runs draw the same
+  // numbers
+  int64_t stream = 0;
+  Ptr<UniformDiscPositionAllocator> allocator = CreateObject<UniformDiscPositionAllocator> ();
+  allocator->SetRho (1000);
+  allocator->SetX (0.0);
+  allocator->SetY (0.0);
+  stream += allocator->AssignStreams (stream);
+
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator (allocator);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+
+  LoraPhyHelper phyHelper = LoraPhyHelper ();
+  phyHelper.SetChannel (channel);
+  LoraMacHelper macHelper = LoraMacHelper ();
+  macHelper.SetAddressGenerator (CreateObject<LoraDeviceAddressGenerator> (54, 1864));
+  if (beaconClock)
+    {
+      macHelper.SetBeaconClock (CreateObject<BeaconClock> ());
+    }
+  LoraHelper helper = LoraHelper ();
+
+  NodeContainer endDevices;
+  endDevices.Create (nDevices);
+  mobility.Install (endDevices);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  macHelper.SetDeviceType (LoraMacHelper::ED);
+  helper.Install (phyHelper, macHelper, endDevices);
+  for (NodeContainer::Iterator it = endDevices.Begin (); it != endDevices.End (); ++it)
+    {
+      stream += GetMacLayerFromNode<EndDeviceLoraMac> (*it)->AssignStreams (stream);
+    }
+
+  NodeContainer gateways = CreateGateways (1, mobility, channel);
+
+  macHelper.EnableBeaconTransmission (gateways);
+  macHelper.EnableClassBDownlinkTransmission (gateways);
+  macHelper.CreateNMulticastGroup (endDevices, gateways, nDevices, 3, 0, 0);
+  macHelper.SetSpreadingFactorsUp (endDevices, gateways, channel);
+
+  EndDeviceClassBAppHelper appHelper = EndDeviceClassBAppHelper ();
+  appHelper.SetPacketSize (10);
+  stream += appHelper.AssignStreams (stream);
+  ApplicationContainer appContainer = appHelper.Install (endDevices);
+  appContainer.Start (Seconds (0));
+  appContainer.Stop (Seconds (128 * nBeaconPeriods));
+
+  NetworkServerHelper networkServerHelper = NetworkServerHelper ();
+  networkServerHelper.EnableBeaconTransmission (true);
+  networkServerHelper.SetPingDownlinkPacketSize (20);
+  networkServerHelper.SetEndDevices (endDevices);
+  networkServerHelper.SetGateways (gateways);
+  Ptr<Node> nsNode = CreateObject<Node> ();
+  networkServerHelper.Install (nsNode);
+  nsNode->GetApplication (0)->GetObject<NetworkServer> ()->GetNetworkScheduler ()->AssignStreams (stream);
+
+  ForwarderHelper forwarderHelper;
+  forwarderHelper.Install (gateways);
+
+  for (NodeContainer::Iterator it = endDevices.Begin (); it != endDevices.End (); ++it)
+    {
+      Ptr<EndDeviceLoraMac> mac = GetMacLayerFromNode<EndDeviceLoraMac> (*it);
+      mac->TraceConnectWithoutContext
+        ("ReceivedPingMessages", MakeCallback (&BeaconClockTest::ReceivedPing, this));
+      mac->TraceConnectWithoutContext
+        ("TotalSuccessfulBeaconPacketsTracedCallback",
+        MakeCallback (&BeaconClockTest::ReceivedBeacon, this));
+      mac->TraceConnectWithoutContext
+        ("MissedBeaconTracedCallback", MakeCallback (&BeaconClockTest::MissedBeacon, this));
+    }
+
+  Simulator::Stop (Seconds (128 * nBeaconPeriods));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  return m_outcomes;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BeaconClockTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BeaconClockTest");
+
+  std::map<LoraDeviceAddress, std::vector<std::string> > withoutClock = Run (false);
+  std::map<LoraDeviceAddress, std::vector<std::string> > withClock = Run (true);
+
+  NS_TEST_ASSERT_MSG_EQ (withClock.size (), withoutClock.size (),
+                         "Not the same devices have class B outcomes");
+  NS_TEST_EXPECT_MSG_GT (withoutClock.size (), std::size_t (0), "No device has class B outcomes");
+  for (auto it = withoutClock.begin (); it != withoutClock.end (); ++it)
+    {
+      std::vector<std::string>& outcomes = withClock[it->first];
+      NS_TEST_ASSERT_MSG_EQ (outcomes.size (), it->second.size (),
+                             "Device " << it->first << " has a different number of outcomes");
+      for (std::size_t i = 0; i < outcomes.size (); i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (outcomes[i], it->second[i],
+                                 "Device " << it->first << " has a different outcome");
+        }
+    }
+}
+
+/**************
+ * Test Suite *
+ **************/
+
+// The TestSuite class names the TestSuite, identifies what type of TestSuite,
+// and enables the TestCases to be run. Typically, only the constructor for
+// this class must be defined
+
+class ComplexityBudgetTestSuite : public TestSuite
+{
+public:
+  ComplexityBudgetTestSuite ();
+};
+
+ComplexityBudgetTestSuite::ComplexityBudgetTestSuite ()
+  : TestSuite ("lorawan-complexity-budget", UNIT)
+{
+  LogComponentEnable ("ComplexityBudgetTestSuite", LOG_LEVEL_DEBUG);
+
+  AddTestCase (new ClassAUplinkBudgetTest (30, 1, 4), TestCase::QUICK);
+  AddTestCase (new ClassAUplinkBudgetTest (20, 4, 2), TestCase::QUICK);
+  AddTestCase (new ClassBMulticastBudgetTest (false), TestCase::QUICK);
+  AddTestCase (new ClassBMulticastBudgetTest (true), TestCase::QUICK);
+  AddTestCase (new BeaconClockTest, TestCase::QUICK);
+}
+
+// Do not forget to allocate an instance of this TestSuite
+static ComplexityBudgetTestSuite lorawanTestSuite;
@@ -8,6 +8,29 @@
 #include "ns3/mobility-helper.h"
 #include "ns3/one-shot-sender-helper.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/correlated-shadowing-propagation-loss-model.h"
+#include "ns3/raster-shadowing-propagation-loss-model.h"
+#include "ns3/shadowing-raster-helper.h"
+#include "ns3/link-budget-helper.h"
+#include "ns3/terrain-diffraction-loss-model.h"
+#include "ns3/building-penetration-loss.h"
+#include "ns3/building.h"
+#include "ns3/buildings-helper.h"
+#include "ns3/mobility-building-info.h"
+#include "ns3/lora-radio-energy-model.h"
+#include "ns3/basic-energy-source.h"
+#include "ns3/boolean.h"
+#include "ns3/basic-energy-source-helper.h"
+#include "ns3/lora-radio-energy-model-helper.h"
+#include "ns3/battery-lifetime-helper.h"
+#include "ns3/population-sender.h"
+#include "ns3/background-traffic.h"
+#include "ns3/lora-tag.h"
+#include "ns3/lora-header-view.h"
+#include "ns3/sequence-header.h"
+#include "ns3/fragmentation-session.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -1291,6 +1314,420 @@ PhyConnectivityTest::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (edPhy2->GetState (), SimpleEndDeviceLoraPhy::STANDBY, "State didn't switch to STANDBY as expected");
 }
 
+/*****************
+ * ShadowingTest *
+ *****************/
+
+class ShadowingTest : public TestCase
+{
+public:
+  ShadowingTest ();
+  virtual ~ShadowingTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+ShadowingTest::ShadowingTest ()
+  : TestCase ("Verify that the correlated shadowing grid behaves as expected")
+{
+}
+
+// Reminder that the test case should clean up after itself
+ShadowingTest::~ShadowingTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ShadowingTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("ShadowingTest");
+
+  typedef CorrelatedShadowingPropagationLossModel::Position Position;
+
+  /////////////////////////////////////////
+  // Test the ShadowingMap interpolation //
+  /////////////////////////////////////////
+
+  Ptr<CorrelatedShadowingPropagationLossModel::ShadowingMap> map =
+    Create<CorrelatedShadowingPropagationLossModel::ShadowingMap> (110, 2);
+
+  // The same position keeps the same value
+  double loss = map->GetLoss (Position (10, 10));
+  NS_TEST_EXPECT_MSG_EQ (map->GetLoss (Position (10, 10)), loss,
+                         "The same position has different shadowing values");
+
+  // Two squares sharing an edge reuse its two vertices
+  map->GetLoss (Position (60, 10));
+  NS_TEST_EXPECT_MSG_EQ (map->GetNVertices (), 6, "Vertices of the grid were drawn twice");
+
+  // The least recently used position is evicted, but it is interpolated
+  // again to the same value
+  map->GetLoss (Position (-60, 10));
+  NS_TEST_EXPECT_MSG_EQ (map->GetNPositions (), 2, "Positions were not evicted");
+  NS_TEST_EXPECT_MSG_EQ (map->GetLoss (Position (10, 10)), loss,
+                         "An evicted position got a different shadowing value");
+
+  // The vertices only used by the evicted positions are dropped with them
+  NS_TEST_EXPECT_MSG_EQ (map->GetNVertices (), 6, "Vertices of evicted positions were kept");
+
+  /////////////////////////////////////
+  // Test the grid of the loss model //
+  /////////////////////////////////////
+
+  Ptr<CorrelatedShadowingPropagationLossModel> shadowing =
+    CreateObject<CorrelatedShadowingPropagationLossModel> ();
+  shadowing->SetAttribute ("MaxShadowingMaps", UintegerValue (2));
+
+  Ptr<ConstantPositionMobilityModel> receiver = CreateObject<ConstantPositionMobilityModel> ();
+  receiver->SetPosition (Vector (0, 0, 0));
+  Ptr<ConstantPositionMobilityModel> sender = CreateObject<ConstantPositionMobilityModel> ();
+
+  for (int i = 0; i < 4; i++)
+    {
+      sender->SetPosition (Vector (1000 * i, 0, 0));
+      shadowing->CalcRxPower (14, sender, receiver);
+    }
+  NS_TEST_EXPECT_MSG_EQ (shadowing->GetNShadowingMaps (), 2, "Shadowing maps were not evicted");
+
+  // Senders in the same square share the same map
+  sender->SetPosition (Vector (3010, 0, 0));
+  double first = shadowing->CalcRxPower (14, sender, receiver);
+  sender->SetPosition (Vector (3020, 0, 0));
+  NS_TEST_EXPECT_MSG_EQ (shadowing->CalcRxPower (14, sender, receiver), first,
+                         "Senders in the same square see a different shadowing");
+}
+
+/***********************
+ * RasterShadowingTest *
+ ***********************/
+
+class RasterShadowingTest : public TestCase
+{
+public:
+  RasterShadowingTest ();
+  virtual ~RasterShadowingTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+RasterShadowingTest::RasterShadowingTest ()
+  : TestCase ("Verify that precomputed shadowing rasters are written and read back")
+{
+}
+
+// Reminder that the test case should clean up after itself
+RasterShadowingTest::~RasterShadowingTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+RasterShadowingTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("RasterShadowingTest");
+
+  std::string fileName = CreateTempDirFilename ("shadowing.lsr");
+
+  ShadowingRasterHelper helper;
+  helper.SetArea (-500, -500, 500, 500);
+  helper.SetCorrelationDistance (100);
+  NS_TEST_ASSERT_MSG_EQ (helper.Write (fileName), true, "The raster could not be written");
+
+  Ptr<RasterShadowingPropagationLossModel> shadowing =
+    CreateObject<RasterShadowingPropagationLossModel> ();
+  NS_TEST_EXPECT_MSG_EQ (shadowing->Load (fileName + ".missing"), false, "A missing raster was mapped");
+  NS_TEST_ASSERT_MSG_EQ (shadowing->Load (fileName), true, "The raster could not be mapped");
+  NS_TEST_EXPECT_MSG_EQ (shadowing->IsLoaded (), true, "The raster is not mapped");
+
+  // The raster values are at (i * 100 - 50, j * 100 - 50), and the middle
+  // of a cell is the average of its 4 corners
+  double average = (shadowing->GetShadowing (50, 50) + shadowing->GetShadowing (150, 50)
+                    + shadowing->GetShadowing (50, 150) + shadowing->GetShadowing (150, 150)) / 4;
+  NS_TEST_EXPECT_MSG_EQ_TOL (shadowing->GetShadowing (100, 100), average, 1e-4,
+                             "The raster is not interpolated bilinearly");
+
+  // Positions outside of the raster take the value of its edge
+  NS_TEST_EXPECT_MSG_EQ_TOL (shadowing->GetShadowing (10000, 50), shadowing->GetShadowing (550, 50),
+                             1e-4, "Positions outside of the raster are not clamped");
+
+  // Links are reciprocal
+  Ptr<ConstantPositionMobilityModel> first = CreateObject<ConstantPositionMobilityModel> ();
+  first->SetPosition (Vector (-320, 45, 0));
+  Ptr<ConstantPositionMobilityModel> second = CreateObject<ConstantPositionMobilityModel> ();
+  second->SetPosition (Vector (210, -130, 0));
+  NS_TEST_EXPECT_MSG_EQ_TOL (shadowing->CalcRxPower (14, first, second),
+                             shadowing->CalcRxPower (14, second, first),
+                             1e-9, "The shadowing of a link is not reciprocal");
+
+  shadowing->Dispose ();
+  NS_TEST_EXPECT_MSG_EQ (shadowing->IsLoaded (), false, "The raster is still mapped after Dispose");
+
+  // With a finer resolution most samples, like (25, 75), lie between the
+  // vertices of the grid. A map that keeps all of its vertices, drawn from
+  // the same stream and queried in the same order as the raster, gives the
+  // expected values.
+  std::string fineFileName = CreateTempDirFilename ("shadowing-fine.lsr");
+  helper.SetArea (-200, -200, 200, 200);
+  helper.SetResolution (25);
+  helper.AssignStreams (10);
+  NS_TEST_ASSERT_MSG_EQ (helper.Write (fineFileName), true, "The fine raster could not be written");
+
+  Ptr<RasterShadowingPropagationLossModel> fine = CreateObject<RasterShadowingPropagationLossModel> ();
+  NS_TEST_ASSERT_MSG_EQ (fine->Load (fineFileName), true, "The fine raster could not be mapped");
+
+  // The raster starts at the vertex (-250, -250) and has 19 x 19 samples
+  Ptr<CorrelatedShadowingPropagationLossModel::ShadowingMap> map =
+    Create<CorrelatedShadowingPropagationLossModel::ShadowingMap> (100, 0);
+  map->AssignStreams (10);
+  for (double y = -250; y <= 200; y += 25)
+    {
+      for (double x = -250; x <= 200; x += 25)
+        {
+          double expected = map->GetLoss (CorrelatedShadowingPropagationLossModel::Position (x, y));
+          NS_TEST_EXPECT_MSG_EQ_TOL (fine->GetShadowing (x, y), expected, 1e-4,
+                                     "A sample of the fine raster doesn't match the ShadowingMap");
+        }
+    }
+
+  fine->Dispose ();
+}
+
+/******************
+ * LinkBudgetTest *
+ ******************/
+
+class LinkBudgetTest : public TestCase
+{
+public:
+  LinkBudgetTest ();
+  virtual ~LinkBudgetTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+LinkBudgetTest::LinkBudgetTest ()
+  : TestCase ("Verify that precomputed link budgets match the loss model")
+{
+}
+
+// Reminder that the test case should clean up after itself
+LinkBudgetTest::~LinkBudgetTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LinkBudgetTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("LinkBudgetTest");
+
+  NodeContainer endDevices;
+  endDevices.Create (20);
+  NodeContainer gateways;
+  gateways.Create (3);
+
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "DeltaX", DoubleValue (250),
+                                 "DeltaY", DoubleValue (250),
+                                 "GridWidth", UintegerValue (5));
+  mobility.Install (endDevices);
+  mobility.Install (gateways);
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  loss->SetPathLossExponent (3.76);
+  loss->SetReference (1, 7.7);
+
+  LinkBudgetHelper helper;
+  helper.SetNThreads (4);
+  Ptr<LinkBudgetMatrix> matrix = helper.Compute (endDevices, gateways, loss);
+
+  std::string fileName = CreateTempDirFilename ("link-budget.llb");
+  NS_TEST_ASSERT_MSG_EQ (matrix->Save (fileName), true, "The matrix could not be saved");
+  Ptr<LinkBudgetMatrix> loaded = LinkBudgetMatrix::Load (fileName);
+  NS_TEST_ASSERT_MSG_EQ ((loaded != 0), true, "The matrix could not be loaded");
+
+  // A channel using the loaded matrix gives the same powers as the model
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, CreateObject<ConstantSpeedPropagationDelayModel> ());
+  channel->SetLinkBudget (loaded);
+  for (uint32_t d = 0; d < endDevices.GetN (); d++)
+    {
+      Ptr<MobilityModel> device = endDevices.Get (d)->GetObject<MobilityModel> ();
+      for (uint32_t g = 0; g < gateways.GetN (); g++)
+        {
+          Ptr<MobilityModel> gateway = gateways.Get (g)->GetObject<MobilityModel> ();
+          double expected = loss->CalcRxPower (14, device, gateway);
+          NS_TEST_EXPECT_MSG_EQ_TOL (14 - matrix->GetLoss (d, g), expected, 1e-9,
+                                     "The computed loss doesn't match the model");
+          NS_TEST_EXPECT_MSG_EQ_TOL (channel->GetRxPower (14, device, gateway), expected, 1e-9,
+                                     "The uplink power doesn't match the model");
+          NS_TEST_EXPECT_MSG_EQ_TOL (channel->GetRxPower (14, gateway, device), expected, 1e-9,
+                                     "The downlink power doesn't match the model");
+        }
+    }
+}
+
+/*************************
+ * TerrainDiffractionTest *
+ *************************/
+
+class TerrainDiffractionTest : public TestCase
+{
+public:
+  TerrainDiffractionTest ();
+  virtual ~TerrainDiffractionTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+TerrainDiffractionTest::TerrainDiffractionTest ()
+  : TestCase ("Verify that the terrain diffraction loss follows the elevation raster")
+{
+}
+
+// Reminder that the test case should clean up after itself
+TerrainDiffractionTest::~TerrainDiffractionTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+TerrainDiffractionTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("TerrainDiffractionTest");
+
+  // A flat area of 2 km by 1 km with a 100 m high ridge at x = 1 km
+  uint32_t nx = 200;
+  uint32_t ny = 100;
+  std::vector<float> elevations (nx * ny, 0);
+  for (uint32_t j = 0; j < ny; j++)
+    {
+      for (uint32_t i = 95; i < 105; i++)
+        {
+          elevations[j * nx + i] = 100;
+        }
+    }
+  std::string fileName = CreateTempDirFilename ("terrain.ldm");
+  NS_TEST_ASSERT_MSG_EQ (TerrainDiffractionLossModel::WriteElevations (fileName, nx, ny, 0, 0, 10, elevations),
+                         true, "The elevation raster could not be written");
+
+  Ptr<TerrainDiffractionLossModel> terrain = CreateObject<TerrainDiffractionLossModel> ();
+  terrain->SetAttribute ("MaxCachedTiles", UintegerValue (2));
+  NS_TEST_ASSERT_MSG_EQ (terrain->Open (fileName), true, "The elevation raster could not be read");
+
+  NS_TEST_EXPECT_MSG_EQ_TOL (terrain->GetElevation (1000, 500), 100, 1e-6, "Wrong elevation on the ridge");
+
+  // In front of the ridge only the ground near the device obstructs the path
+  double flatLoss = terrain->GetDiffractionLoss (Vector (100, 500, 1.2), Vector (900, 500, 15));
+  NS_TEST_EXPECT_MSG_EQ ((flatLoss < 6), true, "Too much diffraction loss over flat terrain");
+
+  // Behind the ridge the loss of the knife edge dominates
+  Ptr<ConstantPositionMobilityModel> device = CreateObject<ConstantPositionMobilityModel> ();
+  device->SetPosition (Vector (100, 500, 1.2));
+  Ptr<ConstantPositionMobilityModel> gateway = CreateObject<ConstantPositionMobilityModel> ();
+  gateway->SetPosition (Vector (1900, 500, 15));
+  double uplink = terrain->CalcRxPower (14, device, gateway);
+  NS_TEST_EXPECT_MSG_EQ ((uplink < 14 - 20), true, "Too little diffraction loss behind the ridge");
+  NS_TEST_EXPECT_MSG_EQ_TOL (terrain->CalcRxPower (14, gateway, device), uplink, 1e-9,
+                             "The diffraction loss is not reciprocal");
+
+  // The link is cached, and computed again when a node moves
+  NS_TEST_EXPECT_MSG_EQ (terrain->GetNCachedLinks (), 1, "The link was not cached once");
+  device->SetPosition (Vector (1100, 500, 1.2));
+  NS_TEST_EXPECT_MSG_EQ ((terrain->CalcRxPower (14, device, gateway) > uplink), true,
+                         "The loss was not computed again after the device moved");
+  NS_TEST_EXPECT_MSG_EQ ((terrain->GetNCachedTiles () <= 2), true, "Tiles were not evicted");
+}
+
+/*******************************
+ * BuildingPenetrationLossTest *
+ *******************************/
+
+class BuildingPenetrationLossTest : public TestCase
+{
+public:
+  BuildingPenetrationLossTest ();
+  virtual ~BuildingPenetrationLossTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+BuildingPenetrationLossTest::BuildingPenetrationLossTest ()
+  : TestCase ("Verify that the cached building penetration loss is redrawn as expected")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BuildingPenetrationLossTest::~BuildingPenetrationLossTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BuildingPenetrationLossTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BuildingPenetrationLossTest");
+
+  // An indoor device and an outdoor gateway, so that the wall loss is drawn
+  // from a continuous distribution
+  Ptr<Building> building = CreateObject<Building> ();
+  building->SetBoundaries (Box (0, 100, 0, 100, 0, 10));
+
+  Ptr<ConstantPositionMobilityModel> device = CreateObject<ConstantPositionMobilityModel> ();
+  device->SetPosition (Vector (50, 50, 1.5));
+  device->AggregateObject (CreateObject<MobilityBuildingInfo> ());
+  BuildingsHelper::MakeConsistent (device);
+  Ptr<ConstantPositionMobilityModel> gateway = CreateObject<ConstantPositionMobilityModel> ();
+  gateway->SetPosition (Vector (1000, 1000, 15));
+  gateway->AggregateObject (CreateObject<MobilityBuildingInfo> ());
+  BuildingsHelper::MakeConsistent (gateway);
+
+  Ptr<BuildingPenetrationLoss> loss = CreateObject<BuildingPenetrationLoss> ();
+  loss->SetAttribute ("CacheLinkLoss", BooleanValue (true));
+  loss->SetAttribute ("RedrawInterval", TimeValue (Seconds (10)));
+
+  // The loss of the link is drawn once and used in both directions
+  double uplink = loss->CalcRxPower (14, device, gateway);
+  NS_TEST_EXPECT_MSG_EQ ((uplink < 14), true, "The indoor device has no penetration loss");
+  NS_TEST_EXPECT_MSG_EQ (loss->CalcRxPower (14, gateway, device), uplink,
+                         "The cached loss is not reciprocal");
+
+  // Within the interval the cached loss is kept
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (loss->CalcRxPower (14, device, gateway), uplink,
+                         "The cached loss changed within the redraw interval");
+
+  // After the interval it is drawn again, and then kept again
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+  double redrawn = loss->CalcRxPower (14, device, gateway);
+  NS_TEST_EXPECT_MSG_NE (redrawn, uplink, "The cached loss was not redrawn after the interval");
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (loss->CalcRxPower (14, gateway, device), redrawn,
+                         "The redrawn loss was not cached");
+
+  Simulator::Destroy ();
+}
+
 /*****************
  * LoraMacTest *
  *****************/
@@ -1325,6 +1762,1000 @@ LoraMacTest::DoRun (void)
 
 }
 
+/*****************
+ * Energy Ledger *
+ *****************/
+
+class EnergyLedgerTest : public TestCase
+{
+public:
+  EnergyLedgerTest ();
+  virtual ~EnergyLedgerTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+EnergyLedgerTest::EnergyLedgerTest ()
+  : TestCase ("Verify that the lazy energy accounting drains the source like the eager one")
+{
+}
+
+// Reminder that the test case should clean up after itself
+EnergyLedgerTest::~EnergyLedgerTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+EnergyLedgerTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("EnergyLedgerTest");
+
+  // Two identical devices, the second one with lazy energy updates
+  Ptr<LoraRadioEnergyModel> models[2];
+  Ptr<BasicEnergySource> sources[2];
+  for (int i = 0; i < 2; i++)
+    {
+      sources[i] = CreateObject<BasicEnergySource> ();
+      sources[i]->SetAttribute ("BasicEnergySourceInitialEnergyJ", DoubleValue (10));
+      models[i] = CreateObject<LoraRadioEnergyModel> ();
+      models[i]->SetAttribute ("LazyEnergyUpdate", BooleanValue (i == 1));
+      models[i]->SetEnergySource (sources[i]);
+      sources[i]->AppendDeviceEnergyModel (models[i]);
+
+      // Every 10 s, an uplink with its two receive windows and then a ping
+      // slot with a relayed transmission
+      for (int period = 0; period < 20; period++)
+        {
+          Time start = Seconds (10 * period);
+          Simulator::Schedule (start, &LoraRadioEnergyModel::SetActivity, models[i],
+                               LoraRadioEnergyModel::ACTIVITY_UPLINK_TX);
+          Simulator::Schedule (start, &LoraRadioEnergyModel::ChangeState, models[i],
+                               EndDeviceLoraPhy::TX);
+          Simulator::Schedule (start + Seconds (0.5), &LoraRadioEnergyModel::ChangeState,
+                               models[i], EndDeviceLoraPhy::STANDBY);
+          Simulator::Schedule (start + Seconds (1.5), &LoraRadioEnergyModel::SetActivity,
+                               models[i], LoraRadioEnergyModel::ACTIVITY_RX1);
+          Simulator::Schedule (start + Seconds (1.5), &LoraRadioEnergyModel::ChangeState,
+                               models[i], EndDeviceLoraPhy::RX);
+          Simulator::Schedule (start + Seconds (1.6), &LoraRadioEnergyModel::ChangeState,
+                               models[i], EndDeviceLoraPhy::SLEEP);
+          Simulator::Schedule (start + Seconds (2.5), &LoraRadioEnergyModel::SetActivity,
+                               models[i], LoraRadioEnergyModel::ACTIVITY_RX2);
+          Simulator::Schedule (start + Seconds (2.5), &LoraRadioEnergyModel::ChangeState,
+                               models[i], EndDeviceLoraPhy::RX);
+          Simulator::Schedule (start + Seconds (2.6), &LoraRadioEnergyModel::ChangeState,
+                               models[i], EndDeviceLoraPhy::SLEEP);
+          Simulator::Schedule (start + Seconds (2.6), &LoraRadioEnergyModel::SetActivity,
+                               models[i], LoraRadioEnergyModel::ACTIVITY_IDLE);
+          Simulator::Schedule (start + Seconds (5), &LoraRadioEnergyModel::SetActivity,
+                               models[i], LoraRadioEnergyModel::ACTIVITY_PING);
+          Simulator::Schedule (start + Seconds (5), &LoraRadioEnergyModel::ChangeState,
+                               models[i], EndDeviceLoraPhy::RX);
+          Simulator::Schedule (start + Seconds (5.1), &LoraRadioEnergyModel::ChangeState,
+                               models[i], EndDeviceLoraPhy::TX);
+          Simulator::Schedule (start + Seconds (5.4), &LoraRadioEnergyModel::ChangeState,
+                               models[i], EndDeviceLoraPhy::SLEEP);
+          Simulator::Schedule (start + Seconds (5.4), &LoraRadioEnergyModel::SetActivity,
+                               models[i], LoraRadioEnergyModel::ACTIVITY_IDLE);
+        }
+    }
+
+  Simulator::Stop (Seconds (200));
+  Simulator::Run ();
+
+  // The source of the lazy model is exact once it is queried
+  NS_TEST_EXPECT_MSG_EQ_TOL (sources[1]->GetRemainingEnergy (),
+                             sources[0]->GetRemainingEnergy (), 1e-9,
+                             "The lazy model drained its source differently");
+  NS_TEST_EXPECT_MSG_EQ_TOL (models[1]->GetTotalEnergyConsumption (),
+                             models[0]->GetTotalEnergyConsumption (), 1e-9,
+                             "The lazy model consumed a different energy");
+
+  // The activities and the states cover all the consumption and all the time
+  double activityEnergy = 0;
+  for (int activity = 0; activity < LoraRadioEnergyModel::NUMBER_OF_ACTIVITIES; activity++)
+    {
+      activityEnergy +=
+        models[1]->GetActivityEnergy (LoraRadioEnergyModel::Activity (activity));
+    }
+  NS_TEST_EXPECT_MSG_EQ_TOL (activityEnergy, models[1]->GetTotalEnergyConsumption (), 1e-9,
+                             "The activities do not add up to the total consumption");
+
+  Time stateDuration = models[1]->GetStateDuration (EndDeviceLoraPhy::SLEEP)
+    + models[1]->GetStateDuration (EndDeviceLoraPhy::STANDBY)
+    + models[1]->GetStateDuration (EndDeviceLoraPhy::TX)
+    + models[1]->GetStateDuration (EndDeviceLoraPhy::RX);
+  NS_TEST_EXPECT_MSG_EQ (stateDuration, Seconds (200), "The states do not cover the whole time");
+
+  // 20 uplinks of 0.5 s and 20 relayed transmissions of 0.3 s
+  NS_TEST_EXPECT_MSG_EQ (models[1]->GetStateDuration (EndDeviceLoraPhy::TX), Seconds (16),
+                         "Wrong time in TX");
+  NS_TEST_EXPECT_MSG_EQ_TOL (models[1]->GetActivityEnergy (LoraRadioEnergyModel::ACTIVITY_RELAY)
+                             / models[1]->GetActivityEnergy (LoraRadioEnergyModel::ACTIVITY_UPLINK_TX),
+                             0.6, 1e-9, "Wrong energy of the relayed transmissions");
+
+  Simulator::Destroy ();
+}
+
+/********************
+ * Battery Lifetime *
+ ********************/
+
+class BatteryLifetimeTest : public TestCase
+{
+public:
+  BatteryLifetimeTest ();
+  virtual ~BatteryLifetimeTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+BatteryLifetimeTest::BatteryLifetimeTest ()
+  : TestCase ("Verify that the battery lifetime is projected from the energy per beacon period")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BatteryLifetimeTest::~BatteryLifetimeTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BatteryLifetimeTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BatteryLifetimeTest");
+
+  // A single idle end device, which consumes the same energy in each period
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  NodeContainer endDevices;
+  endDevices.Create (1);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (endDevices);
+
+  LoraPhyHelper phyHelper;
+  phyHelper.SetChannel (channel);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  LoraMacHelper macHelper;
+  macHelper.SetDeviceType (LoraMacHelper::ED);
+  LoraHelper helper;
+  NetDeviceContainer devices = helper.Install (phyHelper, macHelper, endDevices);
+
+  BasicEnergySourceHelper sourceHelper;
+  sourceHelper.Set ("BasicEnergySourceInitialEnergyJ", DoubleValue (100));
+  EnergySourceContainer sources = sourceHelper.Install (endDevices);
+  LoraRadioEnergyModelHelper radioEnergyHelper;
+  DeviceEnergyModelContainer models = radioEnergyHelper.Install (devices, sources);
+
+  BatteryLifetimeHelper lifetimeHelper;
+  lifetimeHelper.Install (endDevices);
+  lifetimeHelper.Start (Seconds (0));
+
+  Simulator::Stop (Seconds (128 * 10 + 1));
+  Simulator::Run ();
+
+  uint32_t nodeId = endDevices.Get (0)->GetId ();
+  BatteryLifetimeHelper::Projection projection = lifetimeHelper.GetProjection (nodeId);
+  NS_TEST_EXPECT_MSG_EQ (projection.periods, 8u, "The warm-up periods were not dropped");
+  NS_TEST_EXPECT_MSG_EQ (projection.converged, true, "A constant consumption did not converge");
+
+  double energyPerPeriod = models.Get (0)->GetTotalEnergyConsumption () / Simulator::Now ().GetSeconds () * 128;
+  NS_TEST_EXPECT_MSG_EQ_TOL (projection.energyPerPeriod, energyPerPeriod, energyPerPeriod * 1e-3,
+                             "Wrong energy per period");
+
+  double lifetime = Simulator::Now ().GetSeconds ()
+    + sources.Get (0)->GetRemainingEnergy () / projection.energyPerPeriod * 128;
+  NS_TEST_EXPECT_MSG_EQ_TOL (projection.lifetime.GetSeconds (), lifetime, lifetime * 1e-6,
+                             "Wrong lifetime");
+  NS_TEST_EXPECT_MSG_EQ ((projection.lifetimeLow <= projection.lifetime), true,
+                         "The confidence interval does not contain the lifetime");
+  NS_TEST_EXPECT_MSG_EQ ((projection.lifetimeHigh >= projection.lifetime), true,
+                         "The confidence interval does not contain the lifetime");
+
+  // A full battery lasts in proportion to its energy
+  lifetimeHelper.SetBatteryEnergy (1000);
+  projection = lifetimeHelper.GetProjection (nodeId);
+  NS_TEST_EXPECT_MSG_EQ_TOL (projection.lifetime.GetSeconds (), 1000 / energyPerPeriod * 128,
+                             1000 / energyPerPeriod * 128 * 1e-3, "Wrong lifetime of a full battery");
+
+  // Beacon-less periods that were never observed cannot be projected
+  lifetimeHelper.SetBeaconlessFraction (0.1);
+  projection = lifetimeHelper.GetProjection (nodeId);
+  NS_TEST_EXPECT_MSG_EQ (projection.converged, false,
+                         "Beacon-less periods were projected without observing any");
+
+  lifetimeHelper.Stop ();
+  Simulator::Destroy ();
+}
+
+/*********************
+ * Population Sender *
+ *********************/
+
+/**
+ * A MAC layer that only counts the packets it is asked to send
+ */
+class CountingLoraMac : public LoraMac
+{
+public:
+  virtual void Send (Ptr<Packet> packet)
+  {
+    m_sendTimes.push_back (Simulator::Now ());
+  }
+  virtual void Receive (Ptr<Packet const> packet, LoraTxMetadata metadata)
+  {
+  }
+  virtual void FailedReception (Ptr<Packet const> packet)
+  {
+  }
+  virtual void TxFinished (Ptr<const Packet> packet)
+  {
+  }
+
+  std::vector<Time> m_sendTimes;
+};
+
+class PopulationSenderTest : public TestCase
+{
+public:
+  PopulationSenderTest ();
+  virtual ~PopulationSenderTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Run a population of devices for 1000 s
+   *
+   * \return the MACs of the devices
+   */
+  std::vector<Ptr<CountingLoraMac> > RunPopulation (enum PopulationSender::Pattern pattern,
+                                                    uint32_t nDevices,
+                                                    Ptr<PopulationSender>& app);
+};
+
+// Add some help text to this case to describe what it is intended to test
+PopulationSenderTest::PopulationSenderTest ()
+  : TestCase ("Verify that the population sender follows the traffic patterns of the devices")
+{
+}
+
+// Reminder that the test case should clean up after itself
+PopulationSenderTest::~PopulationSenderTest ()
+{
+}
+
+std::vector<Ptr<CountingLoraMac> >
+PopulationSenderTest::RunPopulation (enum PopulationSender::Pattern pattern, uint32_t nDevices,
+                                     Ptr<PopulationSender>& app)
+{
+  app = CreateObject<PopulationSender> ();
+  app->SetPattern (pattern);
+  app->SetInterval (Seconds (100));
+  app->SetBurst (3, Seconds (1));
+  app->AssignStreams (0);
+
+  std::vector<Ptr<CountingLoraMac> > macs;
+  for (uint32_t i = 0; i < nDevices; i++)
+    {
+      macs.push_back (CreateObject<CountingLoraMac> ());
+      app->AddDevice (macs.back ());
+    }
+
+  Ptr<Node> node = CreateObject<Node> ();
+  node->AddApplication (app);
+  app->SetStartTime (Seconds (0));
+  app->SetStopTime (Seconds (1000));
+
+  Simulator::Stop (Seconds (1000));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  return macs;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PopulationSenderTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("PopulationSenderTest");
+
+  Ptr<PopulationSender> app;
+
+  // Periodic: one packet every interval, starting at the phase of the device
+  std::vector<Ptr<CountingLoraMac> > macs = RunPopulation (PopulationSender::PERIODIC, 20, app);
+  for (uint32_t i = 0; i < macs.size (); i++)
+    {
+      std::vector<Time>& times = macs[i]->m_sendTimes;
+      NS_TEST_EXPECT_MSG_EQ (times.size (), 10u, "Wrong number of periodic packets");
+      NS_TEST_EXPECT_MSG_EQ (times.front (), app->GetPhase (i), "The first packet is not at the phase");
+      for (uint32_t j = 1; j < times.size (); j++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (times[j] - times[j - 1], Seconds (100), "Wrong interval");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (app->GetNSentPackets (), 200u, "Wrong number of sent packets");
+  NS_TEST_EXPECT_MSG_EQ ((app->GetNScheduledEvents () <= 201), true,
+                         "More than one event per batch of packets");
+
+  // The phases only depend on the stream and on the order of the devices
+  Time phase = app->GetPhase (5);
+  RunPopulation (PopulationSender::PERIODIC, 30, app);
+  NS_TEST_EXPECT_MSG_EQ (app->GetPhase (5), phase, "The phases are not reproducible");
+
+  // Bursty: three packets one second apart every interval
+  macs = RunPopulation (PopulationSender::BURSTY, 5, app);
+  for (uint32_t i = 0; i < macs.size (); i++)
+    {
+      std::vector<Time>& times = macs[i]->m_sendTimes;
+      uint32_t expected = 0;
+      for (int k = 0; k < 10; k++)
+        {
+          for (int j = 0; j < 3; j++)
+            {
+              expected += (app->GetPhase (i) + Seconds (100 * k + j) < Seconds (1000));
+            }
+        }
+      NS_TEST_EXPECT_MSG_EQ (times.size (), expected, "Wrong number of bursty packets");
+      NS_TEST_EXPECT_MSG_EQ (times[1] - times[0], Seconds (1), "Wrong spacing in a burst");
+      NS_TEST_EXPECT_MSG_EQ (times[3] - times[0], Seconds (100), "Wrong interval between bursts");
+    }
+
+  // Poisson: about one packet every interval on average
+  macs = RunPopulation (PopulationSender::POISSON, 100, app);
+  NS_TEST_EXPECT_MSG_EQ_TOL (app->GetNSentPackets () / 100.0, 10, 2, "Wrong Poisson rate");
+}
+
+/**********************
+ * Background Traffic *
+ **********************/
+
+class BackgroundTrafficTest : public TestCase
+{
+public:
+  BackgroundTrafficTest ();
+  virtual ~BackgroundTrafficTest ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Run the background traffic of nDevices devices for 1000 s, towards a
+   * gateway at the origin
+   */
+  Ptr<BackgroundTraffic> RunTraffic (uint32_t nDevices, uint8_t sf, Time interval);
+
+  void ReceivedPacket (Ptr<const Packet> packet, uint32_t node);
+  void LostPacket (Ptr<const Packet> packet, uint32_t node);
+
+  uint32_t m_receivedPacketCalls;
+  uint32_t m_lostPacketCalls;
+};
+
+// Add some help text to this case to describe what it is intended to test
+BackgroundTrafficTest::BackgroundTrafficTest ()
+  : TestCase ("Verify that the background devices send their packets to the gateways")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BackgroundTrafficTest::~BackgroundTrafficTest ()
+{
+}
+
+void
+BackgroundTrafficTest::ReceivedPacket (Ptr<const Packet> packet, uint32_t node)
+{
+  m_receivedPacketCalls++;
+}
+
+void
+BackgroundTrafficTest::LostPacket (Ptr<const Packet> packet, uint32_t node)
+{
+  m_lostPacketCalls++;
+}
+
+Ptr<BackgroundTraffic>
+BackgroundTrafficTest::RunTraffic (uint32_t nDevices, uint8_t sf, Time interval)
+{
+  m_receivedPacketCalls = 0;
+  m_lostPacketCalls = 0;
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy> ();
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (Vector (0, 0, 0));
+  gatewayPhy->SetMobility (mobility);
+  gatewayPhy->AddReceptionPath (868.1);
+  gatewayPhy->AddReceptionPath (868.3);
+  gatewayPhy->AddReceptionPath (868.5);
+  gatewayPhy->TraceConnectWithoutContext ("ReceivedPacket",
+                                          MakeCallback (&BackgroundTrafficTest::ReceivedPacket, this));
+  gatewayPhy->TraceConnectWithoutContext ("LostPacketBecauseInterference",
+                                          MakeCallback (&BackgroundTrafficTest::LostPacket, this));
+  gatewayPhy->TraceConnectWithoutContext ("LostPacketBecauseNoMoreReceivers",
+                                          MakeCallback (&BackgroundTrafficTest::LostPacket, this));
+  gatewayPhy->TraceConnectWithoutContext ("LostPacketBecauseUnderSensitivity",
+                                          MakeCallback (&BackgroundTrafficTest::LostPacket, this));
+  channel->Add (gatewayPhy);
+
+  Ptr<BackgroundTraffic> traffic = CreateObject<BackgroundTraffic> ();
+  traffic->SetAttribute ("Interval", TimeValue (interval));
+  traffic->SetChannel (channel);
+  traffic->AssignStreams (0);
+  traffic->Reserve (nDevices);
+  for (uint32_t i = 0; i < nDevices; i++)
+    {
+      traffic->AddDevice (Vector (100 * (i + 1), 0, 0), sf);
+    }
+  traffic->Start (Seconds (0));
+
+  Simulator::Stop (Seconds (1000));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  return traffic;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BackgroundTrafficTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BackgroundTrafficTest");
+
+  // A device is a few tens of bytes
+  NS_TEST_EXPECT_MSG_EQ ((BackgroundTraffic::GetDeviceSize () <= 48), true,
+                         "The devices are too large");
+
+  // Every packet reaches the gateway, where it is either received or lost
+  Ptr<BackgroundTraffic> traffic = RunTraffic (10, 7, Seconds (100));
+  NS_TEST_EXPECT_MSG_EQ (traffic->GetNTransmissions (), 100u, "Wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (traffic->GetNDelayedTransmissions (), 0u,
+                         "Packets were delayed by the duty cycle");
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls + m_lostPacketCalls, 100u,
+                         "Packets did not reach the gateway");
+  NS_TEST_EXPECT_MSG_EQ ((m_receivedPacketCalls > 0), true, "No packet was received");
+
+  // With SF12 the duty cycle keeps a device from sending every 10 s
+  LoraTxParameters params;
+  params.sf = 12;
+  Ptr<Packet> packet = Create<Packet> (23);
+  double offTime = LoraPhy::GetOnAirTime (packet, params).GetSeconds () * 100;
+  traffic = RunTraffic (1, 12, Seconds (10));
+  NS_TEST_EXPECT_MSG_EQ ((traffic->GetNDelayedTransmissions () > 0), true,
+                         "No packet was delayed by the duty cycle");
+  NS_TEST_EXPECT_MSG_EQ ((traffic->GetNTransmissions () <= 1000 / offTime + 1), true,
+                         "The duty cycle was not respected");
+  NS_TEST_EXPECT_MSG_EQ (m_receivedPacketCalls, traffic->GetNTransmissions (),
+                         "A packet of a lone device was not received");
+}
+
+/****************
+ * Bulk Install *
+ ****************/
+
+class BulkInstallTest : public TestCase
+{
+public:
+  BulkInstallTest ();
+  virtual ~BulkInstallTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+BulkInstallTest::BulkInstallTest ()
+  : TestCase ("Verify that the bulk installation creates the same devices as Install")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BulkInstallTest::~BulkInstallTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BulkInstallTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("BulkInstallTest");
+
+  Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel> ();
+  Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel> ();
+  Ptr<LoraChannel> channel = CreateObject<LoraChannel> (loss, delay);
+
+  NodeContainer endDevices;
+  endDevices.Create (10);
+  NodeContainer bulkEndDevices;
+  bulkEndDevices.Create (10);
+  NodeContainer gateways;
+  gateways.Create (2);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (endDevices);
+  mobility.Install (bulkEndDevices);
+  mobility.Install (gateways);
+
+  LoraPhyHelper phyHelper;
+  phyHelper.SetChannel (channel);
+  phyHelper.SetDeviceType (LoraPhyHelper::ED);
+  LoraMacHelper macHelper;
+  macHelper.SetDeviceType (LoraMacHelper::ED);
+  LoraHelper helper;
+  helper.EnablePacketTracking ("");
+
+  macHelper.SetAddressGenerator (CreateObject<LoraDeviceAddressGenerator> (54, 1864));
+  NetDeviceContainer devices = helper.Install (phyHelper, macHelper, endDevices);
+  macHelper.SetAddressGenerator (CreateObject<LoraDeviceAddressGenerator> (54, 1864));
+  NetDeviceContainer bulkDevices = helper.InstallBulk (phyHelper, macHelper, bulkEndDevices, 3);
+
+  LoraHelper::SetupReport report = helper.GetLastSetupReport ();
+  NS_TEST_EXPECT_MSG_EQ (report.nDevices, 10u, "Wrong number of devices in the report");
+  NS_TEST_EXPECT_MSG_EQ (report.nBatches, 4u, "Wrong number of batches in the report");
+  NS_TEST_EXPECT_MSG_EQ (bulkDevices.GetN (), 10u, "Wrong number of devices");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetNDevices (), 20u, "The PHYs were not added to the channel");
+
+  for (uint32_t i = 0; i < bulkDevices.GetN (); i++)
+    {
+      Ptr<LoraNetDevice> device = bulkDevices.Get (i)->GetObject<LoraNetDevice> ();
+      NS_TEST_EXPECT_MSG_EQ ((bulkEndDevices.Get (i)->GetDevice (0) == device), true,
+                             "The device is not on its node");
+      NS_TEST_EXPECT_MSG_EQ ((device->GetMac ()->GetPhy () == device->GetPhy ()), true,
+                             "The MAC is not connected to the PHY");
+
+      Ptr<EndDeviceLoraMac> mac = device->GetMac ()->GetObject<EndDeviceLoraMac> ();
+      Ptr<EndDeviceLoraMac> expected = devices.Get (i)->GetObject<LoraNetDevice> ()->GetMac ()
+        ->GetObject<EndDeviceLoraMac> ();
+      NS_TEST_EXPECT_MSG_EQ ((mac->GetDeviceAddress () == expected->GetDeviceAddress ()), true,
+                             "The addresses differ from the ones of Install");
+    }
+
+  phyHelper.SetDeviceType (LoraPhyHelper::GW);
+  macHelper.SetDeviceType (LoraMacHelper::GW);
+  helper.InstallBulk (phyHelper, macHelper, gateways);
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLastSetupReport ().nBatches, 1u, "Wrong number of batches");
+  NS_TEST_EXPECT_MSG_EQ (channel->GetNDevices (), 22u, "The gateways were not added to the channel");
+
+  Simulator::Destroy ();
+}
+
+/***************
+ * Tx Metadata *
+ ***************/
+
+class TxMetadataTest : public TestCase
+{
+public:
+  TxMetadataTest ();
+  virtual ~TxMetadataTest ();
+
+private:
+  virtual void DoRun (void);
+  void ReceivedPacket (Ptr<const Packet> packet, LoraTxMetadata metadata);
+
+  std::vector<LoraTxMetadata> m_metadata;
+  uint32_t m_taggedPackets;
+};
+
+// Add some help text to this case to describe what it is intended to test
+TxMetadataTest::TxMetadataTest ()
+  : TestCase ("Verify that the reception metadata is passed alongside the packet")
+{
+}
+
+// Reminder that the test case should clean up after itself
+TxMetadataTest::~TxMetadataTest ()
+{
+}
+
+void
+TxMetadataTest::ReceivedPacket (Ptr<const Packet> packet, LoraTxMetadata metadata)
+{
+  m_metadata.push_back (metadata);
+
+  LoraTag tag;
+  if (packet->PeekPacketTag (tag))
+    {
+      m_taggedPackets++;
+    }
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+TxMetadataTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("TxMetadataTest");
+
+  m_taggedPackets = 0;
+
+  Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy> ();
+  gatewayPhy->AddReceptionPath (868.1);
+  gatewayPhy->AddReceptionPath (868.3);
+  gatewayPhy->SetReceiveOkCallback (MakeCallback (&TxMetadataTest::ReceivedPacket, this));
+
+  Simulator::Schedule (Seconds (1), &SimpleGatewayLoraPhy::StartReceive, gatewayPhy,
+                       Create<Packet> (20), -100, 9, Seconds (1), 868.3);
+  Simulator::Schedule (Seconds (3), &SimpleGatewayLoraPhy::StartReceive, gatewayPhy,
+                       Create<Packet> (20), -110, 7, Seconds (1), 868.1);
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_metadata.size (), 2u, "Wrong number of received packets");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (m_metadata[0].sf), 9u, "Wrong spreading factor");
+  NS_TEST_EXPECT_MSG_EQ (m_metadata[0].frequencyMHz, 868.3, "Wrong frequency");
+  NS_TEST_EXPECT_MSG_EQ (m_metadata[0].rxPowerDbm, -100, "Wrong reception power");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (m_metadata[1].sf), 7u, "Wrong spreading factor");
+  NS_TEST_EXPECT_MSG_EQ (m_metadata[1].frequencyMHz, 868.1, "Wrong frequency");
+  NS_TEST_EXPECT_MSG_EQ (m_metadata[1].rxPowerDbm, -110, "Wrong reception power");
+  NS_TEST_EXPECT_MSG_EQ (m_taggedPackets, 0u, "The PHY wrote a LoraTag");
+}
+
+/***************
+ * Header View *
+ ***************/
+
+class HeaderViewTest : public TestCase
+{
+public:
+  HeaderViewTest ();
+  virtual ~HeaderViewTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+HeaderViewTest::HeaderViewTest ()
+  : TestCase ("Verify that the headers can be peeked without changing the packet")
+{
+}
+
+// Reminder that the test case should clean up after itself
+HeaderViewTest::~HeaderViewTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+HeaderViewTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("HeaderViewTest");
+
+  // An uplink with a LinkCheckReq
+  Ptr<Packet> uplink = Create<Packet> (10);
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetAddress (LoraDeviceAddress (54, 1864));
+  frameHdr.SetFCnt (42);
+  frameHdr.AddLinkCheckReq ();
+  uplink->AddHeader (frameHdr);
+  LoraMacHeader macHdr;
+  macHdr.SetMType (LoraMacHeader::CONFIRMED_DATA_UP);
+  uplink->AddHeader (macHdr);
+  uint32_t size = uplink->GetSize ();
+
+  LoraMacHeader peekedMacHdr;
+  LoraFrameHeader peekedFrameHdr;
+  LoraHeaderView::Peek (uplink, peekedMacHdr, peekedFrameHdr);
+  NS_TEST_EXPECT_MSG_EQ (unsigned (peekedMacHdr.GetMType ()),
+                         unsigned (LoraMacHeader::CONFIRMED_DATA_UP), "Wrong message type");
+  NS_TEST_EXPECT_MSG_EQ ((peekedFrameHdr.GetAddress () == LoraDeviceAddress (54, 1864)), true,
+                         "Wrong address");
+  NS_TEST_EXPECT_MSG_EQ (peekedFrameHdr.GetFCnt (), 42, "Wrong frame counter");
+  NS_TEST_EXPECT_MSG_EQ ((peekedFrameHdr.GetMacCommand<LinkCheckReq> () != 0), true,
+                         "The uplink MAC command was not read");
+  NS_TEST_EXPECT_MSG_EQ (uplink->GetSize (), size, "The packet was changed");
+
+  // The same headers as with RemoveHeader
+  LoraMacHeader removedMacHdr;
+  LoraFrameHeader removedFrameHdr;
+  removedFrameHdr.SetAsUplink ();
+  Ptr<Packet> copy = uplink->Copy ();
+  copy->RemoveHeader (removedMacHdr);
+  copy->RemoveHeader (removedFrameHdr);
+  NS_TEST_EXPECT_MSG_EQ (peekedFrameHdr.GetSerializedSize (), removedFrameHdr.GetSerializedSize (),
+                         "Wrong frame header size");
+
+  // A downlink with a LinkCheckAns, read as a downlink
+  Ptr<Packet> downlink = Create<Packet> (10);
+  frameHdr = LoraFrameHeader ();
+  frameHdr.SetAsDownlink ();
+  frameHdr.SetAddress (LoraDeviceAddress (54, 1864));
+  frameHdr.AddLinkCheckAns (10, 2);
+  downlink->AddHeader (frameHdr);
+  macHdr.SetMType (LoraMacHeader::UNCONFIRMED_DATA_DOWN);
+  downlink->AddHeader (macHdr);
+
+  LoraHeaderView::Peek (downlink, peekedMacHdr, peekedFrameHdr);
+  Ptr<LinkCheckAns> answer = peekedFrameHdr.GetMacCommand<LinkCheckAns> ();
+  NS_TEST_ASSERT_MSG_EQ ((answer != 0), true, "The downlink MAC command was not read");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (answer->GetMargin ()), 10u, "Wrong margin");
+}
+
+/*********
+ * FOpts *
+ *********/
+
+class FOptsTest : public TestCase
+{
+public:
+  FOptsTest ();
+  virtual ~FOptsTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+FOptsTest::FOptsTest ()
+  : TestCase ("Verify that the MAC commands are kept as bytes until they are needed")
+{
+}
+
+// Reminder that the test case should clean up after itself
+FOptsTest::~FOptsTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+FOptsTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("FOptsTest");
+
+  LoraFrameHeader frameHdr;
+  frameHdr.SetAsUplink ();
+  frameHdr.SetFCnt (7);
+  frameHdr.AddLinkCheckReq ();
+  frameHdr.AddLinkAdrAns (true, false, true);
+  NS_TEST_EXPECT_MSG_EQ (unsigned (frameHdr.GetFOptsLen ()), 3u, "Wrong FOpts length");
+
+  Ptr<Packet> packet = Create<Packet> (10);
+  packet->AddHeader (frameHdr);
+
+  LoraFrameHeader readHdr;
+  readHdr.SetAsUplink ();
+  packet->RemoveHeader (readHdr);
+  NS_TEST_EXPECT_MSG_EQ (unsigned (readHdr.GetFOptsLen ()), 3u, "Wrong deserialized FOpts length");
+  NS_TEST_EXPECT_MSG_EQ (readHdr.HasMacCommand (LINK_CHECK_REQ), true, "LinkCheckReq not found");
+  NS_TEST_EXPECT_MSG_EQ (readHdr.HasMacCommand (LINK_ADR_ANS), true, "LinkAdrAns not found");
+  NS_TEST_EXPECT_MSG_EQ (readHdr.HasMacCommand (DEV_STATUS_ANS), false, "Unexpected DevStatusAns");
+
+  // Serializing the header again, before decoding, writes the same bytes
+  Ptr<Packet> first = Create<Packet> ();
+  first->AddHeader (frameHdr);
+  Ptr<Packet> second = Create<Packet> ();
+  second->AddHeader (readHdr);
+  NS_TEST_ASSERT_MSG_EQ (second->GetSize (), first->GetSize (), "Wrong serialized size");
+  uint8_t firstBytes[32];
+  uint8_t secondBytes[32];
+  first->CopyData (firstBytes, first->GetSize ());
+  second->CopyData (secondBytes, second->GetSize ());
+  for (uint32_t i = 0; i < first->GetSize (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (unsigned (secondBytes[i]), unsigned (firstBytes[i]),
+                             "The FOpts changed in the round trip");
+    }
+
+  // The commands are created on demand
+  Ptr<LinkAdrAns> linkAdrAns = readHdr.GetMacCommand<LinkAdrAns> ();
+  NS_TEST_ASSERT_MSG_EQ ((linkAdrAns != 0), true, "LinkAdrAns not decoded");
+  NS_TEST_EXPECT_MSG_EQ (readHdr.GetCommands ().size (), 2u, "Wrong number of commands");
+
+  // Commands added after deserialization follow the decoded ones
+  readHdr.AddDutyCycleAns ();
+  NS_TEST_EXPECT_MSG_EQ (unsigned (readHdr.GetFOptsLen ()), 4u, "Wrong FOpts length after adding");
+  NS_TEST_EXPECT_MSG_EQ (readHdr.GetCommands ().back ()->GetCommandType (), DUTY_CYCLE_ANS,
+                         "Wrong last command");
+
+  // More than 7 bytes of commands need the 4 bits of the FOptsLen field
+  LoraFrameHeader longHdr;
+  longHdr.SetAsUplink ();
+  longHdr.SetAck (true);
+  longHdr.SetClassB (true);
+  longHdr.AddLinkCheckReq ();
+  longHdr.AddLinkAdrAns (true, true, true);
+  longHdr.AddDutyCycleAns ();
+  longHdr.AddRxParamSetupAns ();
+  longHdr.AddLinkAdrAns (false, true, false);
+  longHdr.AddLinkCheckReq ();
+  NS_TEST_EXPECT_MSG_EQ (unsigned (longHdr.GetFOptsLen ()), 9u, "Wrong FOpts length");
+
+  packet = Create<Packet> (10);
+  packet->AddHeader (longHdr);
+  LoraFrameHeader readLongHdr;
+  readLongHdr.SetAsUplink ();
+  packet->RemoveHeader (readLongHdr);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 10u, "The FOpts were not consumed entirely");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (readLongHdr.GetFOptsLen ()), 9u,
+                         "Wrong deserialized FOpts length");
+  NS_TEST_EXPECT_MSG_EQ (readLongHdr.GetAck (), true, "Wrong ACK bit");
+  NS_TEST_EXPECT_MSG_EQ (readLongHdr.GetClassB (), true, "Wrong class B bit");
+  NS_TEST_EXPECT_MSG_EQ (readLongHdr.GetCommands ().size (), 6u, "Wrong number of commands");
+  NS_TEST_EXPECT_MSG_EQ (readLongHdr.GetCommands ().back ()->GetCommandType (), LINK_CHECK_REQ,
+                         "Wrong last command");
+
+  // An unknown CID stops the decoding, and the bytes after it are dropped so
+  // that the header is serialized consistently. The FOpts hold a
+  // LinkCheckReq, then the unknown CID 0x20 and 2 bytes of it.
+  uint8_t unknownBytes[] = {0x01, 0x02, 0x03, 0x04, 0x04, 0x05, 0x00,
+                            0x02, 0x20, 0xAA, 0xBB, 0x07, 0x11, 0x22};
+  packet = Create<Packet> (unknownBytes, sizeof (unknownBytes));
+  LoraFrameHeader unknownHdr;
+  unknownHdr.SetAsUplink ();
+  packet->RemoveHeader (unknownHdr);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 2u, "The FOpts were not consumed entirely");
+  NS_TEST_EXPECT_MSG_EQ (unknownHdr.GetCommands ().size (), 1u, "Wrong number of decoded commands");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (unknownHdr.GetFOptsLen ()), 1u,
+                         "The undecoded FOpts were not dropped");
+
+  Ptr<Packet> unknown = Create<Packet> (2);
+  unknown->AddHeader (unknownHdr);
+  NS_TEST_EXPECT_MSG_EQ (unknown->GetSize (), 11u, "Wrong serialized size after decoding");
+  LoraFrameHeader readUnknownHdr;
+  readUnknownHdr.SetAsUplink ();
+  unknown->RemoveHeader (readUnknownHdr);
+  NS_TEST_EXPECT_MSG_EQ (unknown->GetSize (), 2u, "The header was corrupted in the round trip");
+  NS_TEST_EXPECT_MSG_EQ (unsigned (readUnknownHdr.GetFPort ()), 7u, "Wrong FPort after the round trip");
+  NS_TEST_EXPECT_MSG_EQ (readUnknownHdr.GetFCnt (), 5u, "Wrong FCnt after the round trip");
+  NS_TEST_EXPECT_MSG_EQ (readUnknownHdr.HasMacCommand (LINK_CHECK_REQ), true,
+                         "LinkCheckReq lost in the round trip");
+}
+
+/*******************
+ * Sequence Header *
+ *******************/
+
+class SequenceHeaderTest : public TestCase
+{
+public:
+  SequenceHeaderTest ();
+  virtual ~SequenceHeaderTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+SequenceHeaderTest::SequenceHeaderTest ()
+  : TestCase ("Verify that the sequence number of a ping downlink is read back from its payload")
+{
+}
+
+// Reminder that the test case should clean up after itself
+SequenceHeaderTest::~SequenceHeaderTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+SequenceHeaderTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("SequenceHeaderTest");
+
+  // A full size payload carries the whole sequence number
+  Ptr<Packet> packet = Create<Packet> (51 - SequenceHeader::MAX_SIZE);
+  SequenceHeader header;
+  header.SetSize (51);
+  header.SetSequence (123456789);
+  packet->AddHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 51u, "Wrong payload size");
+
+  SequenceHeader readHeader;
+  readHeader.SetSize (packet->GetSize ());
+  packet->PeekHeader (readHeader);
+  NS_TEST_EXPECT_MSG_EQ (readHeader.GetSequence (), 123456789u, "Wrong sequence number");
+
+  // A 2 byte payload only carries the low-order bytes
+  packet = Create<Packet> ();
+  header.SetSize (2);
+  header.SetSequence (0x10203);
+  packet->AddHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (packet->GetSize (), 2u, "Wrong short payload size");
+
+  readHeader.SetSize (packet->GetSize ());
+  packet->PeekHeader (readHeader);
+  NS_TEST_EXPECT_MSG_EQ (readHeader.GetSequence (), 0x0203u, "Wrong truncated sequence number");
+}
+
+/**************************
+ * Fragmentation Session *
+ **************************/
+
+class FragmentationSessionTest : public TestCase
+{
+public:
+  FragmentationSessionTest ();
+  virtual ~FragmentationSessionTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+FragmentationSessionTest::FragmentationSessionTest ()
+  : TestCase ("Verify that the image of a fragmentation session is recovered with the parity fragments")
+{
+}
+
+// Reminder that the test case should clean up after itself
+FragmentationSessionTest::~FragmentationSessionTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+FragmentationSessionTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("FragmentationSessionTest");
+
+  Ptr<FragmentationSession> session = Create<FragmentationSession> (20, 10, 47);
+  NS_TEST_EXPECT_MSG_EQ (session->GetNFragments (), 30u, "Wrong number of fragments");
+
+  uint8_t fragment[47];
+
+  // Every data fragment received: the image is complete without parity
+  FragmentDecoder decoder (session);
+  for (uint32_t i = 0; i < 20; i++)
+    {
+      session->GetFragment (i, fragment);
+      NS_TEST_EXPECT_MSG_EQ (decoder.AddFragment (i, fragment), true, "A data fragment brings no information");
+    }
+  NS_TEST_EXPECT_MSG_EQ (decoder.IsComplete (), true, "The image is not complete");
+  NS_TEST_EXPECT_MSG_EQ (decoder.CheckImage (), true, "The image is wrong");
+
+  // Repeated fragments are dropped
+  NS_TEST_EXPECT_MSG_EQ (decoder.AddFragment (3, fragment), false, "A repeated fragment was used");
+  NS_TEST_EXPECT_MSG_EQ (decoder.GetNReceived (), 20u, "A repeated fragment was counted");
+
+  // Every third data fragment lost: the parity fragments recover them
+  FragmentDecoder lossyDecoder (session);
+  for (uint32_t i = 0; i < session->GetNFragments () && !lossyDecoder.IsComplete (); i++)
+    {
+      if (i < 20 && i % 3 == 0)
+        {
+          continue;
+        }
+      session->GetFragment (i, fragment);
+      lossyDecoder.AddFragment (i, fragment);
+    }
+  NS_TEST_EXPECT_MSG_EQ (lossyDecoder.GetNMissingDataFragments (), 7u, "Wrong number of missing data fragments");
+  NS_TEST_ASSERT_MSG_EQ (lossyDecoder.IsComplete (), true, "The lost fragments were not recovered");
+  NS_TEST_EXPECT_MSG_EQ (lossyDecoder.CheckImage (), true, "The recovered image is wrong");
+
+  uint8_t recovered[47];
+  lossyDecoder.GetDataFragment (9, recovered);
+  session->GetFragment (9, fragment);
+  for (uint32_t i = 0; i < 47; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (unsigned (recovered[i]), unsigned (fragment[i]), "Wrong recovered fragment");
+    }
+}
+
 /**************
  * Test Suite *
  **************/
@@ -1351,6 +2782,21 @@ LorawanTestSuite::LorawanTestSuite ()
   AddTestCase (new LogicalLoraChannelTest, TestCase::QUICK);
   AddTestCase (new TimeOnAirTest, TestCase::QUICK);
   AddTestCase (new PhyConnectivityTest, TestCase::QUICK);
+  AddTestCase (new ShadowingTest, TestCase::QUICK);
+  AddTestCase (new RasterShadowingTest, TestCase::QUICK);
+  AddTestCase (new LinkBudgetTest, TestCase::QUICK);
+  AddTestCase (new TerrainDiffractionTest, TestCase::QUICK);
+  AddTestCase (new BuildingPenetrationLossTest, TestCase::QUICK);
+  AddTestCase (new EnergyLedgerTest, TestCase::QUICK);
+  AddTestCase (new BatteryLifetimeTest, TestCase::QUICK);
+  AddTestCase (new PopulationSenderTest, TestCase::QUICK);
+  AddTestCase (new BackgroundTrafficTest, TestCase::QUICK);
+  AddTestCase (new BulkInstallTest, TestCase::QUICK);
+  AddTestCase (new TxMetadataTest, TestCase::QUICK);
+  AddTestCase (new HeaderViewTest, TestCase::QUICK);
+  AddTestCase (new FOptsTest, TestCase::QUICK);
+  AddTestCase (new SequenceHeaderTest, TestCase::QUICK);
+  AddTestCase (new FragmentationSessionTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
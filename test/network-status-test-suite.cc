@@ -12,6 +12,8 @@
 #include "ns3/log.h"
 #include "ns3/end-device-status.h"
 #include "ns3/network-status.h"
+#include "ns3/gateway-status.h"
+#include "ns3/logical-lora-channel-helper.h"
 #include "utilities.h"
 
 // An essential include is test.h
@@ -58,6 +60,174 @@ EndDeviceStatusTest::DoRun (void)
   EndDeviceStatus eds = EndDeviceStatus ();
 }
 
+///////////////////////////
+// GatewayStatus testing //
+///////////////////////////
+
+class GatewayStatusTest : public TestCase
+{
+public:
+  GatewayStatusTest ();
+  virtual ~GatewayStatusTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+GatewayStatusTest::GatewayStatusTest ()
+  : TestCase ("Verify that the downlink reservations of a GatewayStatus follow their priorities")
+{
+}
+
+// Reminder that the test case should clean up after itself
+GatewayStatusTest::~GatewayStatusTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+GatewayStatusTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("GatewayStatusTest");
+
+  Ptr<GatewayStatus> gwStatus = Create<GatewayStatus> ();
+  LoraDeviceAddress group1 (1);
+  LoraDeviceAddress group2 (2);
+  LoraDeviceAddress device (3);
+
+  // Two downlinks of the same priority cannot overlap
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (10), Seconds (1), 868.1,
+                                            GatewayStatus::CLASS_B_MULTICAST, group1),
+                         true, "The gateway could not be reserved");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (10.5), Seconds (1), 868.1,
+                                            GatewayStatus::CLASS_B_MULTICAST, group2),
+                         false, "Two multicast downlinks overlap");
+
+  // A class A reply preempts the multicast downlink
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (10.5), Seconds (1), 868.1,
+                                            GatewayStatus::CLASS_A_REPLY, device),
+                         true, "The class A reply did not preempt the multicast downlink");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->IsReserved (Seconds (10), group1), false,
+                         "The preempted downlink is still reserved");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->GetNPreempted (GatewayStatus::CLASS_B_MULTICAST), 1u,
+                         "Wrong number of preempted multicast downlinks");
+
+  // A downlink can start when the previous one ends
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (11.5), Seconds (1), 868.1,
+                                            GatewayStatus::CLASS_B_MULTICAST, group2),
+                         true, "Consecutive downlinks overlap");
+
+  // A beacon preempts both
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (11), Seconds (1), 868.1,
+                                            GatewayStatus::BEACON, LoraDeviceAddress ()),
+                         true, "The beacon did not preempt the other downlinks");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->IsReserved (Seconds (10.5), device), false,
+                         "The preempted reply is still reserved");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->IsReserved (Seconds (11.5), group2), false,
+                         "The preempted downlink is still reserved");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->GetNPreempted (GatewayStatus::CLASS_A_REPLY), 1u,
+                         "Wrong number of preempted replies");
+
+  // A canceled reservation frees the gateway
+  gwStatus->CancelReservation (Seconds (11), LoraDeviceAddress ());
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->IsReserved (Seconds (11), LoraDeviceAddress ()), false,
+                         "The canceled beacon is still reserved");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (10.5), Seconds (1), 868.1,
+                                            GatewayStatus::CLASS_B_MULTICAST, group1),
+                         true, "The gateway is still reserved for the canceled beacon");
+
+  // A downlink that already started cannot be preempted
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->ClaimReservation (Seconds (1), 868.1, GatewayStatus::CLASS_B_UNICAST,
+                                                     device),
+                         true, "The gateway could not be claimed");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (0.5), Seconds (1), 868.1,
+                                            GatewayStatus::BEACON, LoraDeviceAddress ()),
+                         false, "A downlink on air was preempted");
+}
+
+class GatewayCalendarTest : public TestCase
+{
+public:
+  GatewayCalendarTest ();
+  virtual ~GatewayCalendarTest ();
+
+private:
+  virtual void DoRun (void);
+};
+
+// Add some help text to this case to describe what it is intended to test
+GatewayCalendarTest::GatewayCalendarTest ()
+  : TestCase ("Verify that the calendar of a GatewayStatus accounts for the duty cycle")
+{
+}
+
+// Reminder that the test case should clean up after itself
+GatewayCalendarTest::~GatewayCalendarTest ()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+GatewayCalendarTest::DoRun (void)
+{
+  NS_LOG_DEBUG ("GatewayCalendarTest");
+
+  // A gateway with a 1% and a 10% sub-band
+  LogicalLoraChannelHelper channelHelper;
+  channelHelper.AddSubBand (868, 868.6, 0.01, 14);
+  channelHelper.AddSubBand (869.4, 869.65, 0.1, 27);
+  Ptr<GatewayLoraMac> gwMac = CreateObject<GatewayLoraMac> ();
+  gwMac->SetLogicalLoraChannelHelper (channelHelper);
+  Ptr<GatewayStatus> gwStatus = Create<GatewayStatus> (Address (), Ptr<NetDevice> (), gwMac);
+  LoraDeviceAddress group1 (1);
+  LoraDeviceAddress group2 (2);
+
+  // A downlink of 0.5 s keeps the 10% sub-band off for 4.5 s after it
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (10), Seconds (0.5), 869.525,
+                                            GatewayStatus::CLASS_B_MULTICAST, group1),
+                         true, "The gateway could not be reserved");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (12), Seconds (0.5), 869.525,
+                                            GatewayStatus::CLASS_B_MULTICAST, group2),
+                         false, "A downlink was reserved in the off period of the sub-band");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (12), Seconds (0.5), 868.1,
+                                            GatewayStatus::CLASS_B_MULTICAST, group2),
+                         true, "The off period blocks another sub-band");
+
+  // The earliest start is after the off period of the same sub-band
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->GetEarliestStart (Seconds (10), Seconds (0.5), 869.525,
+                                                     GatewayStatus::CLASS_B_MULTICAST),
+                         Seconds (14.5), "Wrong earliest start on the 10% sub-band");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->GetEarliestStart (Seconds (11), Seconds (0.5), 868.1,
+                                                     GatewayStatus::CLASS_B_MULTICAST),
+                         Seconds (61.5), "Wrong earliest start on the 1% sub-band");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->GetEarliestStart (Seconds (10), Seconds (0.5), 869.525,
+                                                     GatewayStatus::BEACON),
+                         Seconds (10), "A beacon cannot preempt the multicast downlink");
+
+  // A beacon preempts the downlink whose off period it is in
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (14), Seconds (0.5), 869.525,
+                                            GatewayStatus::BEACON, LoraDeviceAddress ()),
+                         true, "The beacon was blocked by the off period of a multicast downlink");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->IsReserved (Seconds (10), group1), false,
+                         "The downlink before the beacon is still reserved");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->IsReserved (Seconds (12), group2), true,
+                         "The downlink on the other sub-band was preempted");
+
+  // The downlinks already sent keep the sub-band off
+  channelHelper.AddEvent (Seconds (0.5), CreateObject<LogicalLoraChannel> (869.525));
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->Reserve (Seconds (2), Seconds (0.5), 869.525,
+                                            GatewayStatus::BEACON, LoraDeviceAddress ()),
+                         false, "A downlink was reserved while the sub-band is off");
+  NS_TEST_EXPECT_MSG_EQ (gwStatus->GetEarliestStart (Seconds (0), Seconds (0.5), 869.525,
+                                                     GatewayStatus::BEACON),
+                         Seconds (4.5), "Wrong earliest start after a sent downlink");
+
+  Simulator::Destroy ();
+}
+
 /////////////////////////////
 // NetworkStatus testing //
 /////////////////////////////
@@ -124,6 +294,8 @@ NetworkStatusTestSuite::NetworkStatusTestSuite ()
   LogComponentEnable ("NetworkStatusTestSuite", LOG_LEVEL_DEBUG);
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new EndDeviceStatusTest, TestCase::QUICK);
+  AddTestCase (new GatewayStatusTest, TestCase::QUICK);
+  AddTestCase (new GatewayCalendarTest, TestCase::QUICK);
   AddTestCase (new NetworkStatusTest, TestCase::QUICK);
 }
 